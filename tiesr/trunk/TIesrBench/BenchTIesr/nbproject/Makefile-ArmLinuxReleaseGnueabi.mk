@@ -0,0 +1,91 @@
+#
+# Generated Makefile - do not edit!
+#
+# Edit the Makefile in the project folder instead (../Makefile). Each target
+# has a -pre and a -post target defined where you can add customized code.
+#
+# This makefile implements configuration specific macros and targets.
+
+
+# Environment
+MKDIR=mkdir
+CP=cp
+CCADMIN=CCadmin
+RANLIB=ranlib
+CC=arm-none-linux-gnueabi-gcc
+CCC=arm-none-linux-gnueabi-g++
+CXX=arm-none-linux-gnueabi-g++
+FC=
+AS=arm-none-linux-gnueabi-as
+
+# Macros
+CND_PLATFORM=arm-none-linux-gnueabi-Linux-x86
+CND_CONF=ArmLinuxReleaseGnueabi
+CND_DISTDIR=dist
+
+# Include project Makefile
+include Makefile
+
+# Object Directory
+OBJECTDIR=build/${CND_CONF}/${CND_PLATFORM}
+
+# Object Files
+OBJECTFILES= \
+	${OBJECTDIR}/_ext/_DOTDOT/src/BenchJac.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/BenchModels.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/BenchTIesr.o
+
+# C Compiler Flags
+CFLAGS=
+
+# CC Compiler Flags
+CCFLAGS=-v
+CXXFLAGS=-v
+
+# Fortran Compiler Flags
+FFLAGS=
+
+# Assembler Flags
+ASFLAGS=
+
+# Link Libraries and Options
+LDLIBSOPTIONS=-L../../Dist/${CND_CONF}/lib -Wl,-rpath ${CND_BASEDIR}/../../Dist/${CND_CONF}/lib -lTIesrEngineSI -lTIesrEngineCore -lTIesrDict -lTIesrDT -lpthread
+
+# Build Targets
+.build-conf: ${BUILD_SUBPROJECTS}
+	${MAKE}  -f nbproject/Makefile-ArmLinuxReleaseGnueabi.mk ../../Dist/ArmLinuxReleaseGnueabi/bin/benchtiesr
+
+../../Dist/ArmLinuxReleaseGnueabi/bin/benchtiesr: ${OBJECTFILES}
+	${MKDIR} -p ../../Dist/ArmLinuxReleaseGnueabi/bin
+	${LINK.cc} -v -o ../../Dist/${CND_CONF}/bin/benchtiesr ${OBJECTFILES} ${LDLIBSOPTIONS} 
+
+${OBJECTDIR}/_ext/_DOTDOT/src/BenchTIesr.o: nbproject/Makefile-${CND_CONF}.mk ../src/BenchTIesr.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -g -Wall -DLINUX -I../src -I../../TIesrEngine/src -I../../TIesrDict/src -I../../TIesrDT/src -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/BenchTIesr.o ../src/BenchTIesr.cpp
+
+${OBJECTDIR}/_ext/_DOTDOT/src/BenchModels.o: nbproject/Makefile-${CND_CONF}.mk ../src/BenchModels.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -g -Wall -DLINUX -I../src -I../../TIesrEngine/src -I../../TIesrDict/src -I../../TIesrDT/src -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/BenchModels.o ../src/BenchModels.cpp
+
+${OBJECTDIR}/_ext/_DOTDOT/src/BenchJac.o: nbproject/Makefile-${CND_CONF}.mk ../src/BenchJac.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -g -Wall -DLINUX -I../src -I../../TIesrEngine/src -I../../TIesrDict/src -I../../TIesrDT/src -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/BenchJac.o ../src/BenchJac.cpp
+
+# Subprojects
+.build-subprojects:
+
+# Clean Targets
+.clean-conf:
+	${RM} -r build/ArmLinuxReleaseGnueabi
+	${RM} ../../Dist/ArmLinuxReleaseGnueabi/bin/benchtiesr
+
+# Subprojects
+.clean-subprojects:
+
+# Enable dependency checking
+.dep.inc: .depcheck-impl
+
+include .dep.inc
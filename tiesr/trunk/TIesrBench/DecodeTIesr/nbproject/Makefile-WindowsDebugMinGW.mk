@@ -0,0 +1,85 @@
+#
+# Generated Makefile - do not edit!
+#
+# Edit the Makefile in the project folder instead (../Makefile). Each target
+# has a -pre and a -post target defined where you can add customized code.
+#
+# This makefile implements configuration specific macros and targets.
+
+
+# Environment
+MKDIR=mkdir
+CP=cp
+CCADMIN=CCadmin
+RANLIB=ranlib
+CC=
+CCC=
+CXX=
+FC=
+AS=
+
+# Macros
+CND_PLATFORM=Cygwin-Linux-x86
+CND_CONF=WindowsDebugMinGW
+CND_DISTDIR=dist
+
+# Include project Makefile
+include Makefile
+
+# Object Directory
+OBJECTDIR=build/${CND_CONF}/${CND_PLATFORM}
+
+# Object Files
+OBJECTFILES= \
+	${OBJECTDIR}/_ext/_DOTDOT/src/DecodeTIesr.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/DecodeCorpus.o
+
+# C Compiler Flags
+CFLAGS=
+
+# CC Compiler Flags
+CCFLAGS=-v -mno-cygwin
+CXXFLAGS=-v -mno-cygwin
+
+# Fortran Compiler Flags
+FFLAGS=
+
+# Assembler Flags
+ASFLAGS=
+
+# Link Libraries and Options
+LDLIBSOPTIONS=-L../../Dist/${CND_CONF}/ -lTIesrEngineSI -lTIesrEngineCore
+
+# Build Targets
+.build-conf: ${BUILD_SUBPROJECTS}
+	${MAKE}  -f nbproject/Makefile-WindowsDebugMinGW.mk ../../Dist/WindowsDebugMinGW/decodetiesr.exe
+
+../../Dist/WindowsDebugMinGW/decodetiesr.exe: ${OBJECTFILES}
+	${MKDIR} -p ../../Dist/WindowsDebugMinGW
+	${LINK.cc} -v -mno-cygwin -o ../../Dist/${CND_CONF}/decodetiesr.exe ${OBJECTFILES} ${LDLIBSOPTIONS} 
+
+${OBJECTDIR}/_ext/_DOTDOT/src/DecodeTIesr.o: nbproject/Makefile-${CND_CONF}.mk ../src/DecodeTIesr.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -g -Wall -DWIN32 -I../src -I../../TIesrEngine/src -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/DecodeTIesr.o ../src/DecodeTIesr.cpp
+
+${OBJECTDIR}/_ext/_DOTDOT/src/DecodeCorpus.o: nbproject/Makefile-${CND_CONF}.mk ../src/DecodeCorpus.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -g -Wall -DWIN32 -I../src -I../../TIesrEngine/src -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/DecodeCorpus.o ../src/DecodeCorpus.cpp
+
+# Subprojects
+.build-subprojects:
+
+# Clean Targets
+.clean-conf:
+	${RM} -r build/WindowsDebugMinGW
+	${RM} ../../Dist/WindowsDebugMinGW/decodetiesr.exe
+
+# Subprojects
+.clean-subprojects:
+
+# Enable dependency checking
+.dep.inc: .depcheck-impl
+
+include .dep.inc
@@ -0,0 +1,56 @@
+#
+# Generated - do not edit!
+#
+# NOCDDL
+#
+CND_BASEDIR=`pwd`
+CND_BUILDDIR=build
+CND_DISTDIR=dist
+# WindowsDebugMinGW configuration
+CND_PLATFORM_WindowsDebugMinGW=Cygwin-Linux-x86
+CND_ARTIFACT_DIR_WindowsDebugMinGW=../../Dist/WindowsDebugMinGW
+CND_ARTIFACT_NAME_WindowsDebugMinGW=decodetiesr.exe
+CND_ARTIFACT_PATH_WindowsDebugMinGW=../../Dist/WindowsDebugMinGW/decodetiesr.exe
+CND_PACKAGE_DIR_WindowsDebugMinGW=dist/WindowsDebugMinGW/Cygwin-Linux-x86/package
+CND_PACKAGE_NAME_WindowsDebugMinGW=decodetiesr.tar
+CND_PACKAGE_PATH_WindowsDebugMinGW=dist/WindowsDebugMinGW/Cygwin-Linux-x86/package/decodetiesr.tar
+# WindowsReleaseMinGW configuration
+CND_PLATFORM_WindowsReleaseMinGW=Cygwin-Linux-x86
+CND_ARTIFACT_DIR_WindowsReleaseMinGW=../../Dist/WindowsReleaseMinGW
+CND_ARTIFACT_NAME_WindowsReleaseMinGW=decodetiesr.exe
+CND_ARTIFACT_PATH_WindowsReleaseMinGW=../../Dist/WindowsReleaseMinGW/decodetiesr.exe
+CND_PACKAGE_DIR_WindowsReleaseMinGW=dist/WindowsReleaseMinGW/Cygwin-Linux-x86/package
+CND_PACKAGE_NAME_WindowsReleaseMinGW=decodetiesr.tar
+CND_PACKAGE_PATH_WindowsReleaseMinGW=dist/WindowsReleaseMinGW/Cygwin-Linux-x86/package/decodetiesr.tar
+# LinuxDebugGnu configuration
+CND_PLATFORM_LinuxDebugGnu=GNU_current-Linux-x86
+CND_ARTIFACT_DIR_LinuxDebugGnu=../../Dist/LinuxDebugGnu/bin
+CND_ARTIFACT_NAME_LinuxDebugGnu=decodetiesr
+CND_ARTIFACT_PATH_LinuxDebugGnu=../../Dist/LinuxDebugGnu/bin/decodetiesr
+CND_PACKAGE_DIR_LinuxDebugGnu=dist/LinuxDebugGnu/GNU_current-Linux-x86/package
+CND_PACKAGE_NAME_LinuxDebugGnu=decodetiesr.tar
+CND_PACKAGE_PATH_LinuxDebugGnu=dist/LinuxDebugGnu/GNU_current-Linux-x86/package/decodetiesr.tar
+# LinuxReleaseGnu configuration
+CND_PLATFORM_LinuxReleaseGnu=GNU_current-Linux-x86
+CND_ARTIFACT_DIR_LinuxReleaseGnu=../../Dist/LinuxReleaseGnu/bin
+CND_ARTIFACT_NAME_LinuxReleaseGnu=decodetiesr
+CND_ARTIFACT_PATH_LinuxReleaseGnu=../../Dist/LinuxReleaseGnu/bin/decodetiesr
+CND_PACKAGE_DIR_LinuxReleaseGnu=dist/LinuxReleaseGnu/GNU_current-Linux-x86/package
+CND_PACKAGE_NAME_LinuxReleaseGnu=decodetiesr.tar
+CND_PACKAGE_PATH_LinuxReleaseGnu=dist/LinuxReleaseGnu/GNU_current-Linux-x86/package/decodetiesr.tar
+# ArmLinuxDebugGnueabi configuration
+CND_PLATFORM_ArmLinuxDebugGnueabi=arm-none-linux-gnueabi-Linux-x86
+CND_ARTIFACT_DIR_ArmLinuxDebugGnueabi=../../Dist/ArmLinuxDebugGnueabi/bin
+CND_ARTIFACT_NAME_ArmLinuxDebugGnueabi=decodetiesr
+CND_ARTIFACT_PATH_ArmLinuxDebugGnueabi=../../Dist/ArmLinuxDebugGnueabi/bin/decodetiesr
+CND_PACKAGE_DIR_ArmLinuxDebugGnueabi=dist/ArmLinuxDebugGnueabi/arm-none-linux-gnueabi-Linux-x86/package
+CND_PACKAGE_NAME_ArmLinuxDebugGnueabi=decodetiesr.tar
+CND_PACKAGE_PATH_ArmLinuxDebugGnueabi=dist/ArmLinuxDebugGnueabi/arm-none-linux-gnueabi-Linux-x86/package/decodetiesr.tar
+# ArmLinuxReleaseGnueabi configuration
+CND_PLATFORM_ArmLinuxReleaseGnueabi=arm-none-linux-gnueabi-Linux-x86
+CND_ARTIFACT_DIR_ArmLinuxReleaseGnueabi=../../Dist/ArmLinuxReleaseGnueabi/bin
+CND_ARTIFACT_NAME_ArmLinuxReleaseGnueabi=decodetiesr
+CND_ARTIFACT_PATH_ArmLinuxReleaseGnueabi=../../Dist/ArmLinuxReleaseGnueabi/bin/decodetiesr
+CND_PACKAGE_DIR_ArmLinuxReleaseGnueabi=dist/ArmLinuxReleaseGnueabi/arm-none-linux-gnueabi-Linux-x86/package
+CND_PACKAGE_NAME_ArmLinuxReleaseGnueabi=decodetiesr.tar
+CND_PACKAGE_PATH_ArmLinuxReleaseGnueabi=dist/ArmLinuxReleaseGnueabi/arm-none-linux-gnueabi-Linux-x86/package/decodetiesr.tar
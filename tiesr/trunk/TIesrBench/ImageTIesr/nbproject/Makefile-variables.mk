@@ -0,0 +1,56 @@
+#
+# Generated - do not edit!
+#
+# NOCDDL
+#
+CND_BASEDIR=`pwd`
+CND_BUILDDIR=build
+CND_DISTDIR=dist
+# WindowsDebugMinGW configuration
+CND_PLATFORM_WindowsDebugMinGW=Cygwin-Linux-x86
+CND_ARTIFACT_DIR_WindowsDebugMinGW=../../Dist/WindowsDebugMinGW
+CND_ARTIFACT_NAME_WindowsDebugMinGW=imagetiesr.exe
+CND_ARTIFACT_PATH_WindowsDebugMinGW=../../Dist/WindowsDebugMinGW/imagetiesr.exe
+CND_PACKAGE_DIR_WindowsDebugMinGW=dist/WindowsDebugMinGW/Cygwin-Linux-x86/package
+CND_PACKAGE_NAME_WindowsDebugMinGW=imagetiesr.tar
+CND_PACKAGE_PATH_WindowsDebugMinGW=dist/WindowsDebugMinGW/Cygwin-Linux-x86/package/imagetiesr.tar
+# WindowsReleaseMinGW configuration
+CND_PLATFORM_WindowsReleaseMinGW=Cygwin-Linux-x86
+CND_ARTIFACT_DIR_WindowsReleaseMinGW=../../Dist/WindowsReleaseMinGW
+CND_ARTIFACT_NAME_WindowsReleaseMinGW=imagetiesr.exe
+CND_ARTIFACT_PATH_WindowsReleaseMinGW=../../Dist/WindowsReleaseMinGW/imagetiesr.exe
+CND_PACKAGE_DIR_WindowsReleaseMinGW=dist/WindowsReleaseMinGW/Cygwin-Linux-x86/package
+CND_PACKAGE_NAME_WindowsReleaseMinGW=imagetiesr.tar
+CND_PACKAGE_PATH_WindowsReleaseMinGW=dist/WindowsReleaseMinGW/Cygwin-Linux-x86/package/imagetiesr.tar
+# LinuxDebugGnu configuration
+CND_PLATFORM_LinuxDebugGnu=GNU_current-Linux-x86
+CND_ARTIFACT_DIR_LinuxDebugGnu=../../Dist/LinuxDebugGnu/bin
+CND_ARTIFACT_NAME_LinuxDebugGnu=imagetiesr
+CND_ARTIFACT_PATH_LinuxDebugGnu=../../Dist/LinuxDebugGnu/bin/imagetiesr
+CND_PACKAGE_DIR_LinuxDebugGnu=dist/LinuxDebugGnu/GNU_current-Linux-x86/package
+CND_PACKAGE_NAME_LinuxDebugGnu=imagetiesr.tar
+CND_PACKAGE_PATH_LinuxDebugGnu=dist/LinuxDebugGnu/GNU_current-Linux-x86/package/imagetiesr.tar
+# LinuxReleaseGnu configuration
+CND_PLATFORM_LinuxReleaseGnu=GNU_current-Linux-x86
+CND_ARTIFACT_DIR_LinuxReleaseGnu=../../Dist/LinuxReleaseGnu/bin
+CND_ARTIFACT_NAME_LinuxReleaseGnu=imagetiesr
+CND_ARTIFACT_PATH_LinuxReleaseGnu=../../Dist/LinuxReleaseGnu/bin/imagetiesr
+CND_PACKAGE_DIR_LinuxReleaseGnu=dist/LinuxReleaseGnu/GNU_current-Linux-x86/package
+CND_PACKAGE_NAME_LinuxReleaseGnu=imagetiesr.tar
+CND_PACKAGE_PATH_LinuxReleaseGnu=dist/LinuxReleaseGnu/GNU_current-Linux-x86/package/imagetiesr.tar
+# ArmLinuxDebugGnueabi configuration
+CND_PLATFORM_ArmLinuxDebugGnueabi=arm-none-linux-gnueabi-Linux-x86
+CND_ARTIFACT_DIR_ArmLinuxDebugGnueabi=../../Dist/ArmLinuxDebugGnueabi/bin
+CND_ARTIFACT_NAME_ArmLinuxDebugGnueabi=imagetiesr
+CND_ARTIFACT_PATH_ArmLinuxDebugGnueabi=../../Dist/ArmLinuxDebugGnueabi/bin/imagetiesr
+CND_PACKAGE_DIR_ArmLinuxDebugGnueabi=dist/ArmLinuxDebugGnueabi/arm-none-linux-gnueabi-Linux-x86/package
+CND_PACKAGE_NAME_ArmLinuxDebugGnueabi=imagetiesr.tar
+CND_PACKAGE_PATH_ArmLinuxDebugGnueabi=dist/ArmLinuxDebugGnueabi/arm-none-linux-gnueabi-Linux-x86/package/imagetiesr.tar
+# ArmLinuxReleaseGnueabi configuration
+CND_PLATFORM_ArmLinuxReleaseGnueabi=arm-none-linux-gnueabi-Linux-x86
+CND_ARTIFACT_DIR_ArmLinuxReleaseGnueabi=../../Dist/ArmLinuxReleaseGnueabi/bin
+CND_ARTIFACT_NAME_ArmLinuxReleaseGnueabi=imagetiesr
+CND_ARTIFACT_PATH_ArmLinuxReleaseGnueabi=../../Dist/ArmLinuxReleaseGnueabi/bin/imagetiesr
+CND_PACKAGE_DIR_ArmLinuxReleaseGnueabi=dist/ArmLinuxReleaseGnueabi/arm-none-linux-gnueabi-Linux-x86/package
+CND_PACKAGE_NAME_ArmLinuxReleaseGnueabi=imagetiesr.tar
+CND_PACKAGE_PATH_ArmLinuxReleaseGnueabi=dist/ArmLinuxReleaseGnueabi/arm-none-linux-gnueabi-Linux-x86/package/imagetiesr.tar
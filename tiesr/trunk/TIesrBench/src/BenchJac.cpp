@@ -0,0 +1,44 @@
+/*=======================================================================
+
+ *
+ * BenchJac.cpp
+ *
+ * Access to the JAC functions benchmarked by the TIesr benchmark.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ The mean and variance compensation functions of JAC are internal to
+ the TIesrEngineSI library.  This source compiles the JAC source into
+ the benchmark so that the functions can be timed directly.  The
+ library itself only exports its open and close functions, so the
+ benchmark copy does not conflict with it.
+
+======================================================================*/
+
+#include "../../TIesrEngine/src/jac_one.cpp"
+
+#include "BenchJac.h"
+
+
+void BenchJac_jac_one_mean( gmhmm_type* gv, unsigned short aIndex )
+{
+   jac_one_mean( gv, aIndex );
+}
+
+
+void BenchJac_sva_compensate( gmhmm_type* gv )
+{
+#ifdef USE_SVA
+   sva_compensate( gv );
+#endif
+}
@@ -0,0 +1,35 @@
+/*=======================================================================
+
+ *
+ * BenchJac.h
+ *
+ * Header for access to the JAC functions benchmarked by the TIesr
+ * benchmark.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+======================================================================*/
+
+#ifndef _BENCHJAC_H
+#define _BENCHJAC_H
+
+#include "tiesr_config.h"
+#include "gmhmm_type.h"
+
+/* Compensate mean vector aIndex for the present channel and noise
+ estimates.  The original means must have been loaded. */
+void BenchJac_jac_one_mean( gmhmm_type* gv, unsigned short aIndex );
+
+/* Scale all inverse variances for the present noise estimate */
+void BenchJac_sva_compensate( gmhmm_type* gv );
+
+#endif /* _BENCHJAC_H */
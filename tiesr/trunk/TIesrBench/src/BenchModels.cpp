@@ -0,0 +1,1186 @@
+/*=======================================================================
+
+ *
+ * BenchModels.cpp
+ *
+ * Synthetic model and dictionary data of the TIesr benchmark.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This source writes the synthetic data used by the benchmark.  The
+ decision trees and dictionary are written first.  The pronunciations
+ of the grammar words are then looked up with TIesrDT, and modified by
+ the dictionary exceptions, so that the grammar network uses the same
+ pronunciations TIesrDict returns.
+
+ The acoustic model has one three state HMM per phone in each of two
+ gender sets.  Mean vectors are drawn around a random center for each
+ phone and state, so that the Gaussians are clustered the way trained
+ models are, and the VQ clusters used for Gaussian selection and rapid
+ JAC are found by a pass of k-means over the means.
+
+======================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tiesr_config.h"
+#include "gmhmm_type.h"
+#include "mfcc_f_user.h"
+#include "pack_user.h"
+#include "dist_user.h"
+
+#include "TIesrDT_User.h"
+
+#include "BenchModels.h"
+
+
+/*--------------------------------
+  Phones and letters
+  --------------------------------*/
+
+/* Phones of the dictionary, in phone.lis order.  The HMM of phone i is
+ HMM i+1, since HMM 0 is silence. */
+static const char* const PHONES[] =
+{
+   "aa", "ae", "ah", "ao", "aw", "ay", "b", "ch", "d", "dh", "eh", "er",
+   "ey", "f", "g", "hh", "ih", "iy", "jh", "k", "l", "m", "n", "ng", "ow",
+   "oy", "p", "r", "s", "sh", "t", "th", "uh", "uw", "v", "w", "y", "z", "zh"
+};
+static const int NUM_PHONES = sizeof(PHONES)/sizeof(PHONES[0]);
+
+static const char* const UNVOICED[] =
+{
+   "ch", "f", "hh", "k", "p", "s", "sh", "t", "th"
+};
+static const int NUM_UNVOICED = sizeof(UNVOICED)/sizeof(UNVOICED[0]);
+
+/* Decision tree pseudo-phones following the phones in onewphone.list */
+static const int DT_PAUSE = NUM_PHONES;
+static const int DT_KS = NUM_PHONES + 1;
+
+/* Default phone of each letter, and the alternative phones the decision
+ tree selects in some contexts.  "_" is the silent pseudo-phone. */
+static const char* const LETTER_PHONES[26][2] =
+{
+   { "ae", "ey aa ah" }, { "b", "_" },       { "k", "s ch" },
+   { "d", "t jh" },      { "eh", "iy _ ah" }, { "f", "v" },
+   { "g", "jh _" },      { "hh", "_" },       { "ih", "ay iy" },
+   { "jh", "y" },        { "k", "_" },        { "l", "_" },
+   { "m", "" },          { "n", "ng" },       { "aa", "ow ah uw" },
+   { "p", "f" },         { "k", "" },         { "r", "er" },
+   { "s", "z sh" },      { "t", "th dh sh" }, { "ah", "uw uh" },
+   { "v", "" },          { "w", "_" },        { "k_s", "z" },
+   { "y", "iy ay" },     { "z", "s zh" }
+};
+
+static const char* const VOWELS = "AEIOU";
+static const char* const CONSONANTS = "BCDFGHJKLMNPQRSTVWXYZ";
+
+/* Attribute values in cAttValue.txt order: letters, then classes */
+enum
+{
+   ATT_VOICED = 26,
+   ATT_UNVOICED,
+   ATT_SHORT_PAUSE,
+   ATT_NO_ATTRIBUTE,
+   NUM_ATT
+};
+
+/* Decision tree contexts used by the synthetic trees */
+static const int CXT_LEFT1 = 3;
+static const int CXT_RIGHT1 = 4;
+static const int CXT_LEFTCLASS1 = 11;
+static const int NUM_CXT = 12;
+
+
+/*--------------------------------
+  Model dimensions
+  --------------------------------*/
+
+static const int N_MFCC = 10;
+static const int NBR_DIM = 20;
+static const int N_STATES = 3;
+static const int N_SETS = 2;
+
+/* Spread of the phone centers and of the Gaussians about them, in Q11
+ features scaled by muScaleP2, for static and dynamic features */
+static const double CENTER_SPREAD[2] = { 3000.0, 800.0 };
+static const double STATE_SPREAD[2] = { 1200.0, 300.0 };
+static const double GAUSS_STDDEV[2] = { 1200.0, 500.0 };
+
+/* Typical static features of low level noise and of voiced speech at a
+ moderate level, about which the silence and phone models are placed */
+static const double SILENCE_MEAN[10] =
+{
+   11500.0, -7000.0, -300.0, -2000.0, -1500.0, -1000.0, 0.0, -1000.0, -1000.0, -700.0
+};
+static const double SPEECH_MEAN[10] =
+{
+   21000.0, -600.0, -3600.0, -700.0, -6000.0, -1000.0, -1700.0, -1000.0, -1300.0, -200.0
+};
+
+
+/*--------------------------------
+  Random numbers
+  --------------------------------*/
+
+/* A local generator, so data does not depend on the C library */
+static unsigned int bench_seed;
+
+static unsigned int bench_rand( void )
+{
+   bench_seed = bench_seed * 1103515245u + 12345u;
+   return ( bench_seed >> 8 ) & 0xffffff;
+}
+
+static double bench_uniform( void )
+{
+   return ( bench_rand() + 0.5 ) / 16777216.0;
+}
+
+static double bench_gauss( void )
+{
+   return sqrt( -2.0 * log( bench_uniform() ) ) * cos( 2.0 * M_PI * bench_uniform() );
+}
+
+static int bench_range( int aLow, int aHigh )
+{
+   return aLow + (int)( bench_rand() % (unsigned int)( aHigh - aLow + 1 ) );
+}
+
+
+/*--------------------------------
+  File output helpers
+  --------------------------------*/
+
+static int write_file( const char* aDir, const char* aName,
+        const void* aData, size_t aBytes )
+{
+   char fname[BENCH_MAX_PATH*2];
+   FILE* fp;
+   size_t nwrite;
+
+   sprintf( fname, "%s/%s", aDir, aName );
+   fp = fopen( fname, "wb" );
+   if( fp == NULL )
+      return 1;
+
+   nwrite = fwrite( aData, 1, aBytes, fp );
+   fclose( fp );
+   return nwrite != aBytes;
+}
+
+/* Write a model file as read by load_model_file, a length followed by
+ that number of shorts */
+static int write_model_file( const char* aDir, const char* aName,
+        const short* aData, int aLength )
+{
+   char fname[BENCH_MAX_PATH*2];
+   FILE* fp;
+   unsigned short len = (unsigned short)aLength;
+   int failed;
+
+   sprintf( fname, "%s/%s", aDir, aName );
+   fp = fopen( fname, "wb" );
+   if( fp == NULL )
+      return 1;
+
+   failed = fwrite( &len, sizeof(short), 1, fp ) != 1;
+   failed |= fwrite( aData, sizeof(short), aLength, fp ) != (size_t)aLength;
+   fclose( fp );
+   return failed;
+}
+
+/* Write packed mean or variance vectors, preceded by the number of
+ vectors rather than the number of shorts */
+static int write_vector_file( const char* aDir, const char* aName,
+        const unsigned short* aPacked, int aNumVecs )
+{
+   char fname[BENCH_MAX_PATH*2];
+   FILE* fp;
+   unsigned short num = (unsigned short)aNumVecs;
+   int failed;
+
+   sprintf( fname, "%s/%s", aDir, aName );
+   fp = fopen( fname, "wb" );
+   if( fp == NULL )
+      return 1;
+
+   failed = fwrite( &num, sizeof(short), 1, fp ) != 1;
+   failed |= fwrite( aPacked, sizeof(short), aNumVecs * N_MFCC, fp ) !=
+      (size_t)( aNumVecs * N_MFCC );
+   fclose( fp );
+   return failed;
+}
+
+/* Path of a name in a directory.  Lengths are checked when the top
+ directory is created. */
+static void join_path( char* aPath, const char* aDir, const char* aName )
+{
+   strcpy( aPath, aDir );
+   strcat( aPath, "/" );
+   strcat( aPath, aName );
+}
+
+static int phone_index( const char* aPhone )
+{
+   int p;
+   for( p = 0; p < NUM_PHONES; p++ )
+   {
+      if( ! strcmp( aPhone, PHONES[p] ) )
+         return p;
+   }
+   if( ! strcmp( aPhone, "_" ) )
+      return DT_PAUSE;
+   if( ! strcmp( aPhone, "k_s" ) )
+      return DT_KS;
+   return -1;
+}
+
+static int is_unvoiced( const char* aPhone )
+{
+   int p;
+   for( p = 0; p < NUM_UNVOICED; p++ )
+   {
+      if( ! strcmp( aPhone, UNVOICED[p] ) )
+         return 1;
+   }
+   return 0;
+}
+
+
+/*--------------------------------
+  Words
+  --------------------------------*/
+
+static int compare_words( const void* aWord1, const void* aWord2 )
+{
+   return strcmp( (const char*)aWord1, (const char*)aWord2 );
+}
+
+/* Make a pronounceable word of alternating consonant and vowel groups */
+static void make_word( char* aWord )
+{
+   int len = bench_range( 3, 9 );
+   int pos = 0;
+   int vowel = bench_range( 0, 1 );
+
+   while( pos < len )
+   {
+      if( vowel )
+         aWord[pos++] = VOWELS[ bench_range( 0, 4 ) ];
+      else
+      {
+         aWord[pos++] = CONSONANTS[ bench_range( 0, 20 ) ];
+         if( pos < len && bench_range( 0, 3 ) == 0 )
+            aWord[pos++] = CONSONANTS[ bench_range( 0, 20 ) ];
+      }
+      vowel = ! vowel;
+   }
+   aWord[pos] = '\0';
+}
+
+/* Create sorted unique dictionary words, followed by sorted unique words
+ that are not in the dictionary */
+static int make_words( BenchModels_t* aModels )
+{
+   int numDict = aModels->size.numDictWords;
+   int numWords = numDict + aModels->size.numOOVWords;
+   int w, k, n;
+
+   aModels->words = (char (*)[BENCH_MAX_WORD])calloc( numWords, BENCH_MAX_WORD );
+   if( aModels->words == NULL )
+      return 1;
+
+   n = 0;
+   while( n < numWords )
+   {
+      make_word( aModels->words[n] );
+      for( k = 0; k < n; k++ )
+      {
+         if( ! strcmp( aModels->words[k], aModels->words[n] ) )
+            break;
+      }
+      if( k == n )
+         n++;
+   }
+
+   qsort( aModels->words, numDict, BENCH_MAX_WORD, compare_words );
+   qsort( aModels->words + numDict, numWords - numDict, BENCH_MAX_WORD,
+          compare_words );
+
+   /* Grammar words are spread over the dictionary */
+   for( w = 0; w < aModels->size.numGrammarWords; w++ )
+   {
+      char tmp[BENCH_MAX_WORD];
+      k = w + bench_range( 0, numDict - 1 - w );
+      strcpy( tmp, aModels->words[w] );
+      strcpy( aModels->words[w], aModels->words[k] );
+      strcpy( aModels->words[k], tmp );
+   }
+
+   aModels->numWords = numWords;
+   return 0;
+}
+
+
+/*--------------------------------
+  Decision trees
+  --------------------------------*/
+
+/* Append a leaf set holding entries of a phone with one attribute list
+ each, and a final default phone */
+static int add_leaf_set( unsigned char* aTree, int aPos, int aNumEntries,
+        const int* aPhones, const int (*aAtts)[4], const int* aNumAtts,
+        int aDefault )
+{
+   int start = aPos++;
+   int e, a;
+
+   for( e = 0; e < aNumEntries; e++ )
+   {
+      aTree[aPos++] = (unsigned char)aPhones[e];
+      aTree[aPos++] = (unsigned char)aNumAtts[e];
+      for( a = 0; a < aNumAtts[e]; a++ )
+         aTree[aPos++] = (unsigned char)aAtts[e][a];
+   }
+   aTree[aPos++] = (unsigned char)aDefault;
+   aTree[start] = (unsigned char)( aPos - start );
+   return aPos;
+}
+
+/* Pick a letter attribute not yet used in a tree node */
+static int pick_letter( int* aUsed )
+{
+   int att;
+   do
+   {
+      att = bench_range( 0, 25 );
+   } while( aUsed[att] );
+   aUsed[att] = 1;
+   return att;
+}
+
+static int compare_ints( const void* aInt1, const void* aInt2 )
+{
+   return *(const int*)aInt1 - *(const int*)aInt2;
+}
+
+/* Write the tree of a letter.  The top question is the right letter.  Two
+ right letters branch to questions on the left letter and on the class of
+ the prior phone.  Other right letters select an alternative phone or
+ the default phone. */
+static int write_tree( const char* aDir, int aLetter )
+{
+   unsigned char tree[256];
+   unsigned char file[256 + 4 + 1 + NUM_CXT];
+   int phones[2], numAtts[2];
+   int atts[2][4];
+   int used[26];
+   int alt[3];
+   int numAlt = 0;
+   int base;
+   int branch[2];
+   int pos, size, e, a, c;
+   int child;
+   char names[32];
+   char* tok;
+   char fname[16];
+
+   base = phone_index( LETTER_PHONES[aLetter][0] );
+   strcpy( names, LETTER_PHONES[aLetter][1] );
+   for( tok = strtok( names, " " ); tok && numAlt < 3; tok = strtok( NULL, " " ) )
+      alt[numAlt++] = phone_index( tok );
+
+   /* Top question on the right letter, with no offset */
+   tree[0] = (unsigned char)( CXT_RIGHT1 << 4 );
+   tree[1] = 0;
+   pos = 2;
+
+   if( numAlt == 0 )
+   {
+      pos = add_leaf_set( tree, pos, 0, NULL, NULL, NULL, base );
+   }
+   else
+   {
+      memset( used, 0, sizeof(used) );
+      branch[0] = pick_letter( used );
+      branch[1] = pick_letter( used );
+      qsort( branch, 2, sizeof(int), compare_ints );
+
+      /* Branch set with the attribute of each branch */
+      tree[pos++] = 0xC0 | 3;
+      tree[pos++] = (unsigned char)branch[0];
+      tree[pos++] = (unsigned char)branch[1];
+      tree[pos++] = 2;
+
+      /* Branch offsets are filled in once the children are written */
+      child = pos;
+      pos += 4;
+
+      /* Leaf set of this level */
+      for( e = 0; e < 2; e++ )
+      {
+         phones[e] = alt[ e % numAlt ];
+         numAtts[e] = bench_range( 2, 4 );
+         for( a = 0; a < numAtts[e]; a++ )
+            atts[e][a] = pick_letter( used );
+      }
+      pos = add_leaf_set( tree, pos, numAlt > 1 ? 2 : 1, phones, atts,
+                          numAtts, base );
+
+      /* Child asking the left letter */
+      size = pos;
+      phones[0] = alt[ numAlt - 1 ];
+      numAtts[0] = 3;
+      memset( used, 0, sizeof(used) );
+      for( a = 0; a < 3; a++ )
+         atts[0][a] = pick_letter( used );
+      pos = add_leaf_set( tree, pos, 1, phones, atts, numAtts, alt[0] );
+      c = ( CXT_LEFT1 << 12 ) | ( pos - size );
+      tree[child] = (unsigned char)( c >> 8 );
+      tree[child+1] = (unsigned char)( c & 0xff );
+
+      /* Child asking the class of the prior phone */
+      size = pos;
+      phones[0] = alt[0];
+      numAtts[0] = 1;
+      atts[0][0] = ATT_UNVOICED;
+      pos = add_leaf_set( tree, pos, 1, phones, atts, numAtts, base );
+      c = ( CXT_LEFTCLASS1 << 12 ) | ( pos - size );
+      tree[child+2] = (unsigned char)( c >> 8 );
+      tree[child+3] = (unsigned char)( c & 0xff );
+   }
+
+   /* Tree file holds the tree size, number of contexts and number of
+    attribute values of each context, followed by the tree */
+   *(int*)file = pos;
+   file[4] = (unsigned char)NUM_CXT;
+   for( c = 0; c < NUM_CXT; c++ )
+      file[5 + c] = (unsigned char)( c < 8 ? 27 : 4 );
+   memcpy( file + 5 + NUM_CXT, tree, pos );
+
+   sprintf( fname, "%c.olmdtpm", 'A' + aLetter );
+   return write_file( aDir, fname, file, 5 + NUM_CXT + pos );
+}
+
+static int write_trees( const char* aDir )
+{
+   FILE* fp;
+   char fname[BENCH_MAX_PATH*2];
+   int p, letter;
+   int failed = 0;
+
+   /* Letter and class attributes */
+   sprintf( fname, "%s/cAttValue.txt", aDir );
+   fp = fopen( fname, "w" );
+   if( fp == NULL )
+      return 1;
+   for( letter = 0; letter < 26; letter++ )
+      fprintf( fp, "%c\n", 'A' + letter );
+   fprintf( fp, "VOICED\nUNVOICED\nSHORT_PAUSE\nNO_ATTRIBUTE\n" );
+   fclose( fp );
+
+   /* Phones output by the trees and their classes */
+   sprintf( fname, "%s/onewphone.list", aDir );
+   fp = fopen( fname, "w" );
+   if( fp == NULL )
+      return 1;
+   for( p = 0; p < NUM_PHONES; p++ )
+      fprintf( fp, "%s %s\n", PHONES[p], is_unvoiced( PHONES[p] ) ? "UNVOICED" : "VOICED" );
+   fprintf( fp, "_ SHORT_PAUSE\nk_s UNVOICED\n" );
+   fclose( fp );
+
+   for( letter = 0; letter < 26; letter++ )
+      failed |= write_tree( aDir, letter );
+
+   return failed;
+}
+
+
+/*--------------------------------
+  Dictionary
+  --------------------------------*/
+
+/* Look up the pronunciation of each dictionary word with TIesrDT, then
+ give some of the words an exception in the dictionary.  The resulting
+ pronunciation of each grammar word is saved in aProns as phone indices,
+ with the count in the first entry. */
+static int write_dictionary( BenchModels_t* aModels, char (*aProns)[32] )
+{
+   TIesrDT_t dt;
+   char pronString[256];
+   char phones[32];
+   unsigned char* dict;
+   char* tok;
+   char prev[BENCH_MAX_WORD];
+   int size, numPhones, w, k, prefix;
+   int failed = 0;
+   FILE* fp;
+   char fname[BENCH_MAX_PATH*2];
+
+   /* Phone list of the dictionary */
+   sprintf( fname, "%s/%s/%s/phone.lis", aModels->dictdir, aModels->language,
+            aModels->dictid );
+   fp = fopen( fname, "w" );
+   if( fp == NULL )
+      return 1;
+   for( k = 0; k < NUM_PHONES; k++ )
+      fprintf( fp, "%s\n", PHONES[k] );
+   fclose( fp );
+
+   if( TIesrDT_Create( &dt, aModels->treedir ) != TIesrDTErrorNone )
+      return 1;
+
+   dict = (unsigned char*)malloc( aModels->size.numDictWords * ( BENCH_MAX_WORD + 8 ) + 1 );
+   if( dict == NULL )
+   {
+      TIesrDT_Destroy( dt );
+      return 1;
+   }
+
+   size = 0;
+   prev[0] = '\0';
+   for( w = 0; w < aModels->size.numDictWords && ! failed; w++ )
+   {
+      const char* word = aModels->words[w];
+
+      failed = TIesrDT_Pron( dt, word, pronString, sizeof(pronString) ) != TIesrDTErrorNone;
+
+      numPhones = 0;
+      for( tok = strtok( pronString, " " ); tok; tok = strtok( NULL, " " ) )
+         phones[numPhones++] = (char)phone_index( tok );
+
+      /* Entries are separated by an alignment byte.  Words share a prefix
+       with the prior word, except every eighth word, which bounds the
+       lookup of the full word. */
+      dict[size++] = 0xff;
+      for( prefix = 0; prev[prefix] && prev[prefix] == word[prefix]; prefix++ );
+      if( prefix >= 2 && ( w & 7 ) )
+      {
+         dict[size++] = (unsigned char)( -prefix );
+         strcpy( (char*)dict + size, word + prefix );
+         size += strlen( word + prefix );
+      }
+      else
+      {
+         strcpy( (char*)dict + size, word );
+         size += strlen( word );
+      }
+      strcpy( prev, word );
+
+      /* A third of the words substitute a phone, a sixth delete one.  The
+       rest use the decision tree pronunciation. */
+      k = bench_range( 0, 5 );
+      if( numPhones > 1 && k < 2 )
+      {
+         int at = bench_range( 0, numPhones - 1 );
+         int phone = bench_range( 0, NUM_PHONES - 1 );
+         dict[size++] = 0x82;
+         dict[size++] = (unsigned char)( 0x40 | at );
+         dict[size++] = (unsigned char)phone;
+         phones[at] = (char)phone;
+      }
+      else if( numPhones > 1 && k == 2 )
+      {
+         int at = bench_range( 0, numPhones - 1 );
+         dict[size++] = 0x81;
+         dict[size++] = (unsigned char)( 0xC0 | at );
+         memmove( phones + at, phones + at + 1, numPhones - at - 1 );
+         numPhones--;
+      }
+      else
+      {
+         dict[size++] = 0x80;
+      }
+
+      if( w < aModels->size.numGrammarWords )
+      {
+         aProns[w][0] = (char)numPhones;
+         memcpy( aProns[w] + 1, phones, numPhones );
+      }
+   }
+
+   TIesrDT_Destroy( dt );
+
+   /* Binary dictionary is its size followed by the entries */
+   if( ! failed )
+   {
+      sprintf( fname, "%s/%s/%s/dict.bin", aModels->dictdir, aModels->language,
+               aModels->dictid );
+      fp = fopen( fname, "wb" );
+      failed = ( fp == NULL );
+      if( fp )
+      {
+         failed |= fwrite( &size, sizeof(int), 1, fp ) != 1;
+         failed |= fwrite( dict, 1, size, fp ) != (size_t)size;
+         fclose( fp );
+      }
+   }
+
+   free( dict );
+   return failed;
+}
+
+
+/*--------------------------------
+  Acoustic models
+  --------------------------------*/
+
+/* Shift of each dimension that packs the largest magnitude in a byte */
+static void find_scales( const short* aVecs, int aNumVecs, short* aScale )
+{
+   int d, v, s;
+   int maxAbs;
+
+   for( d = 0; d < NBR_DIM; d++ )
+   {
+      maxAbs = 1;
+      for( v = 0; v < aNumVecs; v++ )
+      {
+         int a = abs( aVecs[ v*NBR_DIM + d ] );
+         if( a > maxAbs )
+            maxAbs = a;
+      }
+      for( s = 0; s < 15 && ( maxAbs << ( s + 1 ) ) <= 32767 - 128; s++ );
+      aScale[d] = (short)s;
+   }
+}
+
+/* Pack vectors in the file format, and unpack them to obtain the values
+ the engine will use */
+static void pack_vectors( short* aVecs, int aNumVecs, const short* aScale,
+        unsigned short* aPacked )
+{
+   int v;
+   for( v = 0; v < aNumVecs; v++ )
+   {
+      vector_packing( aVecs + v*NBR_DIM, aPacked + v*N_MFCC, aScale, N_MFCC );
+      vector_unpacking( aPacked + v*N_MFCC, aVecs + v*NBR_DIM, aScale, N_MFCC );
+   }
+}
+
+static short to_short( double aValue )
+{
+   if( aValue > 32767.0 )
+      return 32767;
+   if( aValue < -32767.0 )
+      return -32767;
+   return (short)floor( aValue + 0.5 );
+}
+
+/* Natural log of a probability in Q6 */
+static short log_q6( double aProb )
+{
+   return aProb > 0.0 ? to_short( 64.0 * log( aProb ) ) : -32768;
+}
+
+static int write_acoustic_models( BenchModels_t* aModels )
+{
+   const char* dir = aModels->modeldir;
+   int numHmmSet = aModels->numPhones;
+   int numPdf = N_SETS * numHmmSet * N_STATES;
+   int numMix = aModels->size.numMixtures;
+   int numComp = numPdf * numMix;
+   int numMu = ( numComp * 3 ) / 4;
+   int numVar = numPdf;
+   int numCls = aModels->size.numClusters;
+   short* mu = (short*)calloc( numMu * NBR_DIM, sizeof(short) );
+   short* var = (short*)calloc( numVar * NBR_DIM, sizeof(short) );
+   unsigned short* packed = (unsigned short*)calloc( ( numMu > numVar ? numMu : numVar ) * N_MFCC + 1,
+                                                     sizeof(short) );
+   short* gconst = (short*)calloc( numVar, sizeof(short) );
+   short* mixture = (short*)calloc( numPdf * ( 1 + 3*numMix ), sizeof(short) );
+   short* pdf = (short*)calloc( numPdf, sizeof(short) );
+   short* hmm = (short*)calloc( N_SETS*numHmmSet*( 1 + 1 + N_STATES ), sizeof(short) );
+   short* tran = (short*)calloc( numHmmSet * 16, sizeof(short) );
+   short* centroid = (short*)calloc( numCls * NBR_DIM + 2, sizeof(short) );
+   unsigned char* cluster = (unsigned char*)calloc( numMu + 2, 1 );
+   int* count = (int*)calloc( numCls, sizeof(int) );
+   double* sum = (double*)calloc( numCls * NBR_DIM, sizeof(double) );
+   gmhmm_type* gv = (gmhmm_type*)calloc( 1, sizeof(gmhmm_type) );
+   short* compMu = (short*)calloc( numComp, sizeof(short) );
+   short scale[2*NBR_DIM];
+   double center[NBR_DIM];
+   double state[NBR_DIM];
+   short config[2] = { 1, 1 };
+   short dim = (short)N_MFCC;
+   int p, s, g, m, d, c, v, k;
+   int failed = 0;
+
+   if( ! mu || ! var || ! packed || ! gconst || ! mixture || ! pdf || ! hmm ||
+       ! tran || ! centroid || ! cluster || ! count || ! sum || ! gv || ! compMu )
+   {
+      failed = 1;
+      goto Done;
+   }
+
+   /* Scaling of each feature dimension used by the engine */
+   dim_p2_init( N_MFCC, gv );
+
+   /* Mean of component c of pdf i is c, for the first numMu components.
+    The remaining components share a mean of another component of the
+    same phone. */
+   for( c = 0; c < numComp; c++ )
+      compMu[c] = (short)( c < numMu ? c : bench_range( 0, numMu - 1 ) );
+
+   /* Means about a center for each phone and state.  The female set is
+    the male set with a shift. */
+   for( p = 0; p < numHmmSet; p++ )
+   {
+      for( d = 0; d < NBR_DIM; d++ )
+      {
+         center[d] = CENTER_SPREAD[ d >= N_MFCC ] * bench_gauss();
+         if( d < N_MFCC )
+            center[d] = p ? SPEECH_MEAN[d] + center[d] : SILENCE_MEAN[d] + 0.3 * center[d];
+      }
+
+      for( s = 0; s < N_STATES; s++ )
+      {
+         for( d = 0; d < NBR_DIM; d++ )
+            state[d] = center[d] + STATE_SPREAD[ d >= N_MFCC ] * bench_gauss();
+
+         for( g = 0; g < N_SETS; g++ )
+         {
+            int pdfIdx = ( g * numHmmSet + p ) * N_STATES + s;
+            for( m = 0; m < numMix; m++ )
+            {
+               c = pdfIdx * numMix + m;
+               if( c >= numMu )
+                  continue;
+               for( d = 0; d < NBR_DIM; d++ )
+               {
+                  double shift = ( g && d < N_MFCC ) ? 0.3 * STATE_SPREAD[0] : 0.0;
+                  mu[ c*NBR_DIM + d ] = to_short( state[d] + shift +
+                          0.5 * GAUSS_STDDEV[ d >= N_MFCC ] * bench_gauss() );
+               }
+            }
+         }
+      }
+   }
+
+   /* Inverse variances in Q9 */
+   for( v = 0; v < numVar; v++ )
+   {
+      for( d = 0; d < NBR_DIM; d++ )
+      {
+         double sd = GAUSS_STDDEV[ d >= N_MFCC ] * ( 0.7 + 0.7 * bench_uniform() );
+         var[ v*NBR_DIM + d ] = to_short( 512.0 * 2048.0 * 2048.0 / ( sd * sd ) );
+      }
+   }
+
+   /* Scales, and packed means and variances */
+   find_scales( mu, numMu, scale );
+   find_scales( var, numVar, scale + NBR_DIM );
+   failed |= write_file( dir, "scale.bin", scale, sizeof(scale) );
+   failed |= write_file( dir, "config.bin", config, sizeof(config) );
+   failed |= write_file( dir, "dim.bin", &dim, sizeof(dim) );
+
+   pack_vectors( mu, numMu, scale, packed );
+   failed |= write_vector_file( dir, "mu.bin", packed, numMu );
+
+   pack_vectors( var, numVar, scale + NBR_DIM, packed );
+   failed |= write_vector_file( dir, "var.bin", packed, numVar );
+
+   /* Gaussian constants from the unpacked inverse variances */
+   for( v = 0; v < numVar; v++ )
+      gconst[v] = gauss_det_const( var + v*NBR_DIM, 2, gv->muScaleP2, NBR_DIM );
+   failed |= write_model_file( dir, "gconst.bin", gconst, numVar );
+
+   /* Mixtures with random weights, and their offsets */
+   k = 0;
+   for( p = 0; p < numPdf; p++ )
+   {
+      double w[64];
+      double total = 0.0;
+
+      pdf[p] = (short)k;
+      mixture[k++] = (short)numMix;
+      for( m = 0; m < numMix; m++ )
+      {
+         w[m] = 0.2 + bench_uniform();
+         total += w[m];
+      }
+      for( m = 0; m < numMix; m++ )
+      {
+         mixture[k++] = log_q6( w[m] / total );
+         mixture[k++] = compMu[ p*numMix + m ];
+         mixture[k++] = (short)p;
+      }
+   }
+   failed |= write_model_file( dir, "pdf.bin", pdf, numPdf );
+   failed |= write_model_file( dir, "mixture.bin", mixture, k );
+
+   /* One left to right transition matrix per phone, shared by the sets.
+    Each holds the number of states including exit, the initial
+    probabilities, and the transitions of each emitting state. */
+   for( p = 0; p < numHmmSet; p++ )
+   {
+      short* t = tran + p*16;
+      double stay;
+
+      t[0] = N_STATES + 1;
+      t[1] = log_q6( 0.9 );
+      t[2] = log_q6( 0.1 );
+      t[3] = log_q6( 0.0 );
+      for( s = 0; s < N_STATES; s++ )
+      {
+         short* row = t + 4 + s*4;
+         stay = p == 0 ? 0.9 : 0.55 + 0.3 * bench_uniform();
+         for( k = 0; k < 4; k++ )
+            row[k] = log_q6( 0.0 );
+         row[s] = log_q6( stay );
+         row[s+1] = log_q6( s == 0 ? ( 1.0 - stay ) * 0.9 : 1.0 - stay );
+         if( s == 0 )
+            row[2] = log_q6( ( 1.0 - stay ) * 0.1 );
+      }
+   }
+   failed |= write_model_file( dir, "tran.bin", tran, numHmmSet * 16 );
+
+   /* HMM offsets, followed by the transition offset and pdfs of each */
+   k = N_SETS * numHmmSet;
+   for( g = 0; g < N_SETS; g++ )
+   {
+      for( p = 0; p < numHmmSet; p++ )
+      {
+         hmm[ g*numHmmSet + p ] = (short)k;
+         hmm[k++] = (short)( p * 16 );
+         for( s = 0; s < N_STATES; s++ )
+            hmm[k++] = (short)( ( g * numHmmSet + p ) * N_STATES + s );
+      }
+   }
+   failed |= write_model_file( dir, "hmm.bin", hmm, k );
+
+   /* Map of the HMMs of a set to their monophone, silence is not one */
+   for( p = 0; p < numHmmSet; p++ )
+      tran[p] = (short)( p - 1 );
+   failed |= write_file( dir, "hmm2phone.bin", tran, numHmmSet * sizeof(short) );
+
+   /* VQ clusters of the means found by a pass of k-means, starting from
+    randomly chosen means */
+   for( c = 0; c < numCls; c++ )
+   {
+      k = bench_range( 0, numMu - 1 );
+      for( d = 0; d < NBR_DIM; d++ )
+         sum[ c*NBR_DIM + d ] = mu[ k*NBR_DIM + d ];
+   }
+   for( v = 0; v < numMu; v++ )
+   {
+      double best = 0.0;
+      for( c = 0; c < numCls; c++ )
+      {
+         double dist = 0.0;
+         for( d = 0; d < NBR_DIM; d++ )
+         {
+            double diff = ( mu[ v*NBR_DIM + d ] - sum[ c*NBR_DIM + d ] ) /
+               GAUSS_STDDEV[ d >= N_MFCC ];
+            dist += diff * diff;
+         }
+         if( c == 0 || dist < best )
+         {
+            best = dist;
+            cluster[v] = (unsigned char)c;
+         }
+      }
+   }
+   memset( sum, 0, numCls * NBR_DIM * sizeof(double) );
+   for( v = 0; v < numMu; v++ )
+   {
+      count[ cluster[v] ]++;
+      for( d = 0; d < NBR_DIM; d++ )
+         sum[ cluster[v]*NBR_DIM + d ] += mu[ v*NBR_DIM + d ];
+   }
+   centroid[0] = (short)numCls;
+   centroid[1] = (short)NBR_DIM;
+   for( c = 0; c < numCls; c++ )
+   {
+      for( d = 0; d < NBR_DIM; d++ )
+         centroid[ 2 + c*NBR_DIM + d ] = count[c] ?
+            to_short( sum[ c*NBR_DIM + d ] / count[c] ) : 0;
+   }
+   failed |= write_file( dir, "vqcentr.bin", centroid,
+                         ( 2 + numCls * NBR_DIM ) * sizeof(short) );
+
+   memmove( cluster + 2, cluster, numMu );
+   *(short*)cluster = (short)numMu;
+   failed |= write_file( dir, "o2amidx.bin", cluster, numMu + 2 );
+
+   aModels->numMeans = numMu;
+   aModels->numVars = numVar;
+   aModels->numPdfs = numPdf;
+   aModels->numHmms = N_SETS * numHmmSet;
+
+ Done:
+   free( mu );
+   free( var );
+   free( packed );
+   free( gconst );
+   free( mixture );
+   free( pdf );
+   free( hmm );
+   free( tran );
+   free( centroid );
+   free( cluster );
+   free( count );
+   free( sum );
+   free( gv );
+   free( compMu );
+   return failed;
+}
+
+
+/*--------------------------------
+  Grammar
+  --------------------------------*/
+
+/* Write the grammar network of one grammar word between optional
+ silences, and the word list.  Symbol 0 is the trailing silence and
+ symbol 1 the leading silence.  The symbols of each word follow. */
+static int write_grammar( BenchModels_t* aModels, char (*aProns)[32] )
+{
+   const char* dir = aModels->modeldir;
+   int numGram = aModels->size.numGrammarWords;
+   int numSyms = 2;
+   int w, k, p, n, len;
+   int pos;
+   short* net;
+   short* first;
+   short* last;
+   int failed;
+   char fname[BENCH_MAX_PATH*2];
+   FILE* fp;
+
+   for( w = 0; w < numGram; w++ )
+      numSyms += aProns[w][0];
+
+   net = (short*)calloc( 7 + numSyms + 2*( 2 + numGram + 1 ) + numSyms*4 + numGram*2 + 4*numGram,
+                         sizeof(short) );
+   first = (short*)calloc( numGram, sizeof(short) );
+   last = (short*)calloc( numGram, sizeof(short) );
+   if( ! net || ! first || ! last )
+   {
+      free( net );
+      free( first );
+      free( last );
+      return 1;
+   }
+
+   k = 2;
+   for( w = 0; w < numGram; w++ )
+   {
+      first[w] = (short)k;
+      k += aProns[w][0];
+      last[w] = (short)( k - 1 );
+   }
+
+   net[0] = (short)aModels->numHmms;
+   net[1] = (short)numSyms;
+   net[2] = (short)( numGram + 1 );
+   net[3] = (short)N_SETS;
+   net[4] = (short)aModels->numPhones;
+   pos = 7 + numSyms;
+
+   /* Start node, which can enter the leading silence or any word */
+   net[5] = (short)pos;
+   net[pos++] = 0;
+   net[pos++] = (short)( numGram + 1 );
+   net[pos++] = 1;
+   for( w = 0; w < numGram; w++ )
+      net[pos++] = first[w];
+
+   /* Stop node, which can be reached from the trailing silence or from
+    the end of any word */
+   net[6] = (short)pos;
+   net[pos++] = 0;
+   net[pos++] = (short)( numGram + 1 );
+   net[pos++] = 0;
+   for( w = 0; w < numGram; w++ )
+      net[pos++] = last[w];
+
+   /* Trailing silence loops on itself, and ends the silence word */
+   net[7 + 0] = (short)pos;
+   net[pos++] = 0;
+   net[pos++] = (short)( 1 | 0x8000 );
+   net[pos++] = 0;
+   net[pos++] = 0;
+
+   /* Leading silence loops on itself or enters a word */
+   net[7 + 1] = (short)pos;
+   net[pos++] = 0;
+   net[pos++] = (short)( ( numGram + 1 ) | 0x8000 );
+   net[pos++] = 1;
+   for( w = 0; w < numGram; w++ )
+      net[pos++] = first[w];
+   net[pos++] = 0;
+
+   /* Phones of each word, the last enters the trailing silence and ends
+    the word */
+   for( w = 0; w < numGram; w++ )
+   {
+      len = aProns[w][0];
+      for( p = 0; p < len; p++ )
+      {
+         n = first[w] + p;
+         net[7 + n] = (short)pos;
+         net[pos++] = (short)( aProns[w][1 + p] + 1 );
+         if( p < len - 1 )
+         {
+            net[pos++] = 1;
+            net[pos++] = (short)( n + 1 );
+         }
+         else
+         {
+            net[pos++] = (short)( 1 | 0x8000 );
+            net[pos++] = 0;
+            net[pos++] = (short)( w + 1 );
+         }
+      }
+   }
+
+   failed = write_model_file( dir, "net.bin", net, pos );
+   aModels->numSyms = numSyms;
+
+   sprintf( fname, "%s/word.lis", dir );
+   fp = fopen( fname, "w" );
+   if( fp )
+   {
+      fprintf( fp, "_SIL\n" );
+      for( w = 0; w < numGram; w++ )
+         fprintf( fp, "%s\n", aModels->words[w] );
+      fclose( fp );
+   }
+   else
+      failed = 1;
+
+   free( net );
+   free( first );
+   free( last );
+   return failed;
+}
+
+
+/*--------------------------------
+  Public functions
+  --------------------------------*/
+
+int BenchModels_create( BenchModels_t* aModels, const char* aTmpDir,
+        const BenchModelSize_t* aSize, unsigned int aSeed )
+{
+   char (*prons)[32];
+   char path[BENCH_MAX_PATH];
+   int failed;
+
+   memset( aModels, 0, sizeof(BenchModels_t) );
+   aModels->size = *aSize;
+   aModels->numPhones = NUM_PHONES + 1;
+   aModels->language = "Synthetic";
+   aModels->dictid = "Dict";
+   bench_seed = aSeed;
+
+   if( aSize->numGrammarWords > aSize->numDictWords ||
+       aSize->numMixtures < 1 || aSize->numMixtures > 64 ||
+       aSize->numClusters < 1 || aSize->numClusters > 255 )
+      return 1;
+
+   /* Directories of the data, leaving room for the names below the top */
+   if( strlen( aTmpDir ) + 64 > BENCH_MAX_PATH )
+      return 1;
+
+   sprintf( aModels->topdir, "%s/tiesrbenchXXXXXX", aTmpDir );
+   if( mkdtemp( aModels->topdir ) == NULL )
+      return 1;
+
+   join_path( aModels->modeldir, aModels->topdir, "Models" );
+   join_path( aModels->dictdir, aModels->topdir, "Dict" );
+   join_path( aModels->treedir, aModels->dictdir, aModels->language );
+   join_path( path, aModels->treedir, aModels->dictid );
+   if( mkdir( aModels->modeldir, 0755 ) || mkdir( aModels->dictdir, 0755 ) ||
+       mkdir( aModels->treedir, 0755 ) || mkdir( path, 0755 ) )
+   {
+      BenchModels_remove( aModels );
+      return 1;
+   }
+
+   prons = (char (*)[32])calloc( aSize->numGrammarWords, 32 );
+   failed = ( prons == NULL );
+
+   failed = failed || make_words( aModels );
+   failed = failed || write_trees( aModels->treedir );
+   failed = failed || write_dictionary( aModels, prons );
+   failed = failed || write_acoustic_models( aModels );
+   failed = failed || write_grammar( aModels, prons );
+
+   free( prons );
+   if( failed )
+      BenchModels_remove( aModels );
+   return failed;
+}
+
+
+/* Remove a directory that holds only files and directories */
+static void remove_dir( const char* aDir, const char* const* aNames )
+{
+   char fname[BENCH_MAX_PATH*2];
+   int n;
+
+   for( n = 0; aNames[n]; n++ )
+   {
+      sprintf( fname, "%s/%s", aDir, aNames[n] );
+      remove( fname );
+   }
+   rmdir( aDir );
+}
+
+void BenchModels_remove( BenchModels_t* aModels )
+{
+   static const char* const MODELFILES[] =
+   {
+      "word.lis", "net.bin", "hmm.bin", "mu.bin", "var.bin", "tran.bin",
+      "pdf.bin", "mixture.bin", "gconst.bin", "dim.bin", "scale.bin",
+      "config.bin", "hmm2phone.bin", "o2amidx.bin", "vqcentr.bin", NULL
+   };
+   static const char* const DICTFILES[] = { "phone.lis", "dict.bin", NULL };
+   static const char* const NOFILES[] = { NULL };
+   const char* treefiles[26 + 3];
+   char names[26][12];
+   char path[BENCH_MAX_PATH];
+   int letter;
+
+   if( aModels->topdir[0] )
+   {
+      for( letter = 0; letter < 26; letter++ )
+      {
+         sprintf( names[letter], "%c.olmdtpm", 'A' + letter );
+         treefiles[letter] = names[letter];
+      }
+      treefiles[26] = "cAttValue.txt";
+      treefiles[27] = "onewphone.list";
+      treefiles[28] = NULL;
+
+      remove_dir( aModels->modeldir, MODELFILES );
+      join_path( path, aModels->treedir, aModels->dictid );
+      remove_dir( path, DICTFILES );
+      remove_dir( aModels->treedir, treefiles );
+      remove_dir( aModels->dictdir, NOFILES );
+      remove_dir( aModels->topdir, NOFILES );
+      aModels->topdir[0] = '\0';
+   }
+
+   free( aModels->words );
+   aModels->words = NULL;
+}
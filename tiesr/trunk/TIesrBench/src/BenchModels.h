@@ -0,0 +1,93 @@
+/*=======================================================================
+
+ *
+ * BenchModels.h
+ *
+ * Header for synthetic model and dictionary data of the TIesr benchmark.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ The benchmark does not use the TIesr data directory.  Instead it writes
+ a complete set of data files into a temporary directory: a gender
+ dependent monophone model set with its grammar network in the format
+ read by OpenASR, Gaussian VQ cluster data, decision trees in the format
+ read by TIesrDT, and a binary dictionary in the format read by
+ TIesrDict.  The data is generated from a seeded random number generator
+ so that every run benchmarks the same data.
+
+======================================================================*/
+
+#ifndef _BENCHMODELS_H
+#define _BENCHMODELS_H
+
+/* Maximum length of a path name in the synthetic data */
+#define BENCH_MAX_PATH 256
+
+/* Maximum length of a synthetic word */
+#define BENCH_MAX_WORD 16
+
+
+/* Sizes of the synthetic data.  Each HMM set holds one HMM per phone, and
+ the grammar is a single word from a list of words between silences. */
+typedef struct BenchModelSize
+{
+      int numMixtures;
+      int numClusters;
+      int numGrammarWords;
+      int numDictWords;
+      int numOOVWords;
+} BenchModelSize_t;
+
+
+/* Location of the synthetic data and the words used to create it */
+typedef struct BenchModels
+{
+      /* Top directory holding all data, removed by BenchModels_remove */
+      char topdir[BENCH_MAX_PATH];
+
+      /* Directory holding models and grammar for OpenASR */
+      char modeldir[BENCH_MAX_PATH];
+
+      /* Dictionary directory, language and identifier for LoadDictionary.
+       The decision trees for TIesrDT are in dictdir/language. */
+      char dictdir[BENCH_MAX_PATH];
+      char treedir[BENCH_MAX_PATH];
+      const char* language;
+      const char* dictid;
+
+      /* Words in the dictionary, followed by words not in the
+       dictionary.  The first numGrammarWords words are in the grammar. */
+      char (*words)[BENCH_MAX_WORD];
+      int numWords;
+
+      /* Sizes of the data actually created */
+      BenchModelSize_t size;
+      int numPhones;
+      int numMeans;
+      int numVars;
+      int numPdfs;
+      int numHmms;
+      int numSyms;
+
+} BenchModels_t;
+
+
+/* Create the synthetic data in a new temporary directory below aTmpDir.
+ Returns zero on success. */
+int BenchModels_create( BenchModels_t* aModels, const char* aTmpDir,
+        const BenchModelSize_t* aSize, unsigned int aSeed );
+
+/* Remove the synthetic data and free the word list */
+void BenchModels_remove( BenchModels_t* aModels );
+
+#endif /* _BENCHMODELS_H */
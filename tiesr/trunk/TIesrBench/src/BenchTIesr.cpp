@@ -0,0 +1,887 @@
+/*=======================================================================
+
+ *
+ * BenchTIesr.cpp
+ *
+ * Microbenchmarks of the TIesr engine, dictionary and decision tree
+ * processing.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This program times the functions that dominate TIesr processing time,
+ using synthetic models, grammar, dictionary and audio generated when
+ the program starts, so no data directory is needed.  The command line
+ is:
+
+ benchtiesr [-t minSeconds] [-r repetitions] [-f filter] [-s seed]
+            [-d tmpDir] [-o outFile]
+
+ minSeconds is the minimum time spent on each benchmark, default 0.5.
+
+ repetitions is the number of timed runs of each benchmark, default 5.
+ The time per operation of each run is measured, and the median and
+ minimum are reported.
+
+ filter limits the benchmarks run to those whose name contains it.
+
+ seed seeds the generation of the synthetic data, default 1.
+
+ tmpDir is the directory below which the synthetic data is written
+ while the program runs, default $TMPDIR or /tmp.
+
+ outFile is the file to which results are written, default stdout.
+
+ The results are written as a JSON object so that they can be tracked
+ by scripts.  Each result holds the benchmark name, the number of
+ operations timed, the median and minimum nanoseconds per operation,
+ and the unit of an operation.  Benchmarks that could not be run are
+ listed with the reason.
+
+ The path propagation and observation probability updates are internal
+ to the search, so they are timed over whole utterances using the
+ engine search statistics.  JAC mean and variance compensation are
+ timed using BenchJac.
+
+======================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "tiesr_config.h"
+#include "tiesr_engine_api_sireco.h"
+#include "gmhmm_type.h"
+#include "gmhmm_type_common_user.h"
+#include "mfcc_f_user.h"
+#include "noise_sub_user.h"
+#include "search_user.h"
+#include "rapidsearch_user.h"
+#include "load_user.h"
+
+#include "TIesrDT_User.h"
+#include "TIesrDict.h"
+
+#include "BenchModels.h"
+#include "BenchJac.h"
+
+
+/*--------------------------------
+  Constants
+  --------------------------------*/
+
+/* Maximum number of results and notes of a run */
+#define BENCH_MAX_RESULTS 32
+
+/* Shorts of memory given to the recognizer */
+static const int ENGINE_MEMORY = 500000;
+
+/* Sample rate and parts of the synthetic utterance, in samples */
+static const int SAMPLE_RATE = 8000;
+static const int LEAD_SAMPLES = 3200;
+static const int SPEECH_SAMPLES = 8000;
+static const int TRAIL_SAMPLES = 8000;
+
+/* Size of the synthetic data */
+static const BenchModelSize_t MODEL_SIZE =
+{
+   4,       /* mixtures per pdf */
+   64,      /* VQ clusters */
+   100,     /* grammar words */
+   2000,    /* dictionary words */
+   500      /* words not in the dictionary */
+};
+
+
+/*--------------------------------
+  Types
+  --------------------------------*/
+
+typedef struct BenchOptions
+{
+      double minTime;
+      int repetitions;
+      const char* filter;
+      unsigned int seed;
+      const char* tmpDir;
+      const char* outFile;
+} BenchOptions_t;
+
+typedef struct BenchResult
+{
+      const char* name;
+      const char* unit;
+      unsigned long iterations;
+      double nsPerOp;
+      double nsPerOpMin;
+} BenchResult_t;
+
+typedef struct BenchNote
+{
+      const char* name;
+      const char* reason;
+} BenchNote_t;
+
+
+/* All state used by the benchmarks */
+typedef struct BenchState
+{
+      BenchOptions_t options;
+      BenchModels_t models;
+
+      TIesrEngineSIRECOType engine;
+      gmhmm_type* gv;
+
+      TIesrDT_t dt;
+      CTIesrDict* dict;
+
+      /* Synthetic audio and a feature vector of a speech frame */
+      short* audio;
+      int numSamples;
+      short feature[ MAX_DIM ];
+
+      /* Position in the audio, mean index or word of the next operation */
+      int next;
+
+      BenchResult_t results[ BENCH_MAX_RESULTS ];
+      int numResults;
+      BenchNote_t notes[ BENCH_MAX_RESULTS ];
+      int numNotes;
+} BenchState_t;
+
+typedef void (*BenchFunc_t)( BenchState_t* aState, unsigned long aIters );
+
+
+/*--------------------------------
+  Harness
+  --------------------------------*/
+
+static int compare_doubles( const void* aD1, const void* aD2 )
+{
+   double d1 = *(const double*)aD1;
+   double d2 = *(const double*)aD2;
+   return d1 < d2 ? -1 : ( d1 > d2 );
+}
+
+static int bench_selected( const BenchState_t* aState, const char* aName )
+{
+   return aState->options.filter == NULL || strstr( aName, aState->options.filter );
+}
+
+static void bench_note( BenchState_t* aState, const char* aName, const char* aReason )
+{
+   if( aState->numNotes < BENCH_MAX_RESULTS )
+   {
+      aState->notes[ aState->numNotes ].name = aName;
+      aState->notes[ aState->numNotes ].reason = aReason;
+      aState->numNotes++;
+   }
+}
+
+/* Record the median and minimum of the per operation times of the runs */
+static void bench_result( BenchState_t* aState, const char* aName,
+        const char* aUnit, unsigned long aOps, double* aNsPerOp, int aRuns )
+{
+   BenchResult_t* result;
+
+   if( aState->numResults >= BENCH_MAX_RESULTS || aRuns == 0 )
+      return;
+
+   qsort( aNsPerOp, aRuns, sizeof(double), compare_doubles );
+
+   result = &aState->results[ aState->numResults++ ];
+   result->name = aName;
+   result->unit = aUnit;
+   result->iterations = aOps;
+   result->nsPerOp = ( aRuns & 1 ) ? aNsPerOp[ aRuns/2 ] :
+      ( aNsPerOp[ aRuns/2 - 1 ] + aNsPerOp[ aRuns/2 ] ) / 2.0;
+   result->nsPerOpMin = aNsPerOp[0];
+
+   fprintf( stderr, "%-24s %12.1f ns/%s\n", aName, result->nsPerOp, aUnit );
+}
+
+static double bench_time( BenchState_t* aState, BenchFunc_t aFunc,
+        unsigned long aIters )
+{
+   unsigned long long start = stats_clock();
+   aFunc( aState, aIters );
+   return (double)( stats_clock() - start );
+}
+
+/* Time a function that performs aOpsPerIter operations per iteration.
+ The number of iterations is calibrated so that each run takes its share
+ of the minimum time. */
+static void bench_run( BenchState_t* aState, const char* aName,
+        const char* aUnit, BenchFunc_t aFunc, unsigned long aOpsPerIter )
+{
+   double runNs = aState->options.minTime * 1e9 / aState->options.repetitions;
+   double nsPerOp[ 64 ];
+   unsigned long iters = 1;
+   double ns;
+   int run;
+
+   if( ! bench_selected( aState, aName ) )
+      return;
+
+   /* Calibrate with a tenth of the run time */
+   for( ;; )
+   {
+      ns = bench_time( aState, aFunc, iters );
+      if( ns >= runNs / 10.0 || iters >= ( 1UL << 30 ) )
+         break;
+      iters *= 2;
+   }
+   if( ns > 0.0 )
+      iters = (unsigned long)( iters * runNs / ns ) + 1;
+
+   for( run = 0; run < aState->options.repetitions; run++ )
+      nsPerOp[ run ] = bench_time( aState, aFunc, iters ) / ( iters * aOpsPerIter );
+
+   bench_result( aState, aName, aUnit, iters * aOpsPerIter, nsPerOp,
+                 aState->options.repetitions );
+}
+
+
+/*--------------------------------
+  Synthetic audio
+  --------------------------------*/
+
+/* Low level noise, then a voiced sound with formants moving every 80 ms,
+ then noise again, so that the utterance detector finds speech */
+static short* make_audio( int* aNumSamples )
+{
+   int numSamples = LEAD_SAMPLES + SPEECH_SAMPLES + TRAIL_SAMPLES;
+   short* audio = (short*)malloc( numSamples * sizeof(short) );
+   unsigned int seed = 12345;
+   double formant[2] = { 500.0, 1500.0 };
+   int n, h;
+
+   if( audio == NULL )
+      return NULL;
+
+   for( n = 0; n < numSamples; n++ )
+   {
+      double noise, sample = 0.0;
+
+      seed = seed * 1103515245u + 12345u;
+      noise = ( (int)( ( seed >> 16 ) & 0x7fff ) - 16384 ) / 16384.0;
+
+      if( n >= LEAD_SAMPLES && n < LEAD_SAMPLES + SPEECH_SAMPLES )
+      {
+         int t = n - LEAD_SAMPLES;
+         if( t % 640 == 0 )
+         {
+            formant[0] = 300.0 + ( ( t / 640 ) * 170 ) % 500;
+            formant[1] = 900.0 + ( ( t / 640 ) * 530 ) % 1500;
+         }
+
+         /* Harmonics of 120 Hz weighted by two formant resonances */
+         for( h = 1; h * 120.0 < SAMPLE_RATE / 2; h++ )
+         {
+            double f = h * 120.0;
+            double a = 1.0 / ( 1.0 + pow( ( f - formant[0] ) / 150.0, 2 ) ) +
+               0.5 / ( 1.0 + pow( ( f - formant[1] ) / 200.0, 2 ) );
+            sample += a * sin( 2.0 * M_PI * f * t / SAMPLE_RATE );
+         }
+         sample *= 3000.0 * sin( M_PI * t / SPEECH_SAMPLES );
+      }
+
+      audio[n] = (short)( sample + 30.0 * noise );
+   }
+
+   *aNumSamples = numSamples;
+   return audio;
+}
+
+
+/*--------------------------------
+  Benchmarks of feature extraction
+  --------------------------------*/
+
+/* Next window of the speech part of the audio */
+static short* next_window( BenchState_t* aState )
+{
+   short* window = aState->audio + LEAD_SAMPLES + aState->next;
+   aState->next += FRAME_LEN;
+   if( aState->next + WINDOW_LEN > SPEECH_SAMPLES )
+      aState->next = 0;
+   return window;
+}
+
+static void bench_mfcc_a_window( BenchState_t* aState, unsigned long aIters )
+{
+   gmhmm_type* gv = aState->gv;
+   short sig[ WINDOW_LEN ], mfcc[ MAX_DIM_MFCC16 ];
+   short log_mel_energy[ N_FILTER26 ], power_spectrum[ WINDOW_LEN ];
+   short last_sig = 0;
+   NormType var_norm;
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+   {
+      memcpy( sig, next_window( aState ), sizeof(sig) );
+      mfcc_a_window( sig, mfcc, log_mel_energy, gv->n_mfcc, gv->n_filter,
+                     gv->mel_filter, gv->cosxfm, power_spectrum, gv->muScaleP2,
+                     &var_norm, &last_sig, NULL );
+   }
+}
+
+#ifdef USE_SNR_SS
+static void bench_ss_mfcc_a_window( BenchState_t* aState, unsigned long aIters )
+{
+   gmhmm_type* gv = aState->gv;
+   short sig[ WINDOW_LEN ], mfcc[ MAX_DIM_MFCC16 ];
+   short log_mel_energy[ N_FILTER26 ], power_spectrum[ WINDOW_LEN ];
+   short last_sig = 0;
+   NormType var_norm;
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+   {
+      memcpy( sig, next_window( aState ), sizeof(sig) );
+      ss_mfcc_a_window( sig, mfcc, log_mel_energy, gv->n_mfcc, gv->n_filter,
+                        gv->mel_filter, gv->cosxfm, power_spectrum, gv->muScaleP2,
+                        &var_norm, &last_sig, (NssType*)gv->pNss );
+   }
+}
+#endif
+
+static void bench_fft( BenchState_t* aState, unsigned long aIters )
+{
+   short real[ WINDOW_LEN ], imag[ WINDOW_LEN ];
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+   {
+      memcpy( real, next_window( aState ), sizeof(real) );
+      memset( imag, 0, sizeof(imag) );
+      fft( real, imag );
+   }
+}
+
+
+/*--------------------------------
+  Benchmarks of Gaussian scoring
+  --------------------------------*/
+
+static void clear_gauss_scr( gmhmm_type* gv )
+{
+   int i;
+   for( i = 0; i < gv->n_mu; i++ )
+      gv->gauss_scr[i] = LZERO;
+}
+
+static void bench_gauss_obs_score_f( BenchState_t* aState, unsigned long aIters )
+{
+   gmhmm_type* gv = aState->gv;
+   unsigned long i;
+   int pdf;
+
+   for( i = 0; i < aIters; i++ )
+   {
+      clear_gauss_scr( gv );
+      for( pdf = 0; pdf < gv->n_pdf; pdf++ )
+         gauss_obs_score_f( aState->feature, pdf, gv );
+   }
+}
+
+static void bench_rj_gauss_obs_score_f( BenchState_t* aState, unsigned long aIters )
+{
+   gmhmm_type* gv = aState->gv;
+   unsigned long i;
+   long counter = 0;
+   short argmix;
+   int pdf;
+
+   for( i = 0; i < aIters; i++ )
+   {
+      clear_gauss_scr( gv );
+      for( pdf = 0; pdf < gv->n_pdf; pdf++ )
+         rj_gauss_obs_score_f( aState->feature, pdf, gv, &counter, &argmix );
+   }
+}
+
+static void bench_rj_clear_obs_scr( BenchState_t* aState, unsigned long aIters )
+{
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+      rj_clear_obs_scr( aState->gv, aState->feature );
+}
+
+
+/*--------------------------------
+  Benchmarks of the search
+  --------------------------------*/
+
+/* Recognize the synthetic utterance, and return the engine status */
+static TIesrEngineStatusType recognize( BenchState_t* aState )
+{
+   TIesrEngineSIRECOType* engine = &aState->engine;
+   TIesrEngineStatusType status;
+   int frame;
+   int numFrames = aState->numSamples / FRAME_LEN;
+
+   status = engine->OpenSearchEngine( aState->gv );
+   if( status != eTIesrEngineSuccess )
+      return status;
+
+   for( frame = 0; frame < numFrames && status == eTIesrEngineSuccess; frame++ )
+   {
+      status = engine->CallSearchEngine( aState->audio + frame * FRAME_LEN,
+                                         aState->gv, 0 );
+      if( engine->SpeechEnded( aState->gv ) )
+         break;
+   }
+
+   return engine->CloseSearchEngine( status, aState->gv );
+}
+
+/* Time path propagation and observation probability updates within the
+ search using the search statistics of whole utterances */
+static int bench_search( BenchState_t* aState )
+{
+   const char* PROPAGATE = "path_propagation";
+   const char* SCORE = "update_obs_prob";
+   TIesrEngineSIRECOType* engine = &aState->engine;
+   TIesrEngineStatsType utt, frm;
+   double propagate[ 64 ], score[ 64 ];
+   unsigned long frames = 0;
+   unsigned long long start;
+   int run, utts;
+
+   if( recognize( aState ) != eTIesrEngineSuccess ||
+       engine->GetAnswerCount( aState->gv, 0 ) == 0 )
+   {
+      bench_note( aState, PROPAGATE, "synthetic utterance was not recognized" );
+      bench_note( aState, SCORE, "synthetic utterance was not recognized" );
+      return 1;
+   }
+
+   if( ! bench_selected( aState, PROPAGATE ) && ! bench_selected( aState, SCORE ) )
+      return 0;
+
+   engine->SetTIesrStats( aState->gv, TRUE );
+   for( run = 0; run < aState->options.repetitions; run++ )
+   {
+      unsigned long long ns_propagate = 0, ns_score = 0;
+      unsigned long runFrames = 0;
+
+      start = stats_clock();
+      utts = 0;
+      do
+      {
+         recognize( aState );
+         engine->GetTIesrStats( aState->gv, &utt, &frm );
+         ns_propagate += utt.ns_propagate;
+         ns_score += utt.ns_score;
+         runFrames += utt.frames;
+         utts++;
+      } while( stats_clock() - start < aState->options.minTime * 1e9 / aState->options.repetitions );
+
+      propagate[ run ] = (double)ns_propagate / runFrames;
+      score[ run ] = (double)ns_score / runFrames;
+      frames += runFrames;
+   }
+   engine->SetTIesrStats( aState->gv, FALSE );
+
+   if( bench_selected( aState, PROPAGATE ) )
+      bench_result( aState, PROPAGATE, "frame", frames, propagate,
+                    aState->options.repetitions );
+   if( bench_selected( aState, SCORE ) )
+      bench_result( aState, SCORE, "frame", frames, score,
+                    aState->options.repetitions );
+
+   /* Leave the result of a recognition for the backtrace */
+   return recognize( aState ) != eTIesrEngineSuccess;
+}
+
+static void bench_back_trace_beam( BenchState_t* aState, unsigned long aIters )
+{
+   gmhmm_type* gv = aState->gv;
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+   {
+      gv->nbr_seg = 0;
+      if( gv->word_backtrace == WORDBT )
+         back_trace_beam( gv->best_word, gv->best_word_frm, gv->hmm_code,
+                          gv->stt, gv->stp, &gv->nbr_seg, &gv->hmm_dlt, gv );
+      else
+         back_trace_beam( gv->best_sym, gv->frm_cnt - 1, gv->hmm_code,
+                          gv->stt, gv->stp, &gv->nbr_seg, &gv->hmm_dlt, gv );
+   }
+}
+
+
+/*--------------------------------
+  Benchmarks of JAC
+  --------------------------------*/
+
+static void bench_jac_one_mean( BenchState_t* aState, unsigned long aIters )
+{
+   gmhmm_type* gv = aState->gv;
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+   {
+      BenchJac_jac_one_mean( gv, (unsigned short)aState->next );
+      if( ++aState->next >= gv->n_mu )
+         aState->next = 0;
+   }
+}
+
+static void bench_sva_compensate( BenchState_t* aState, unsigned long aIters )
+{
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+      BenchJac_sva_compensate( aState->gv );
+}
+
+static void bench_JAC_update( BenchState_t* aState, unsigned long aIters )
+{
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+      aState->engine.JAC_update( aState->gv );
+}
+
+
+/*--------------------------------
+  Benchmarks of pronunciation lookup
+  --------------------------------*/
+
+/* Next word, cycling through dictionary and out of dictionary words
+ interleaved, so that both the dictionary and decision tree paths are
+ measured */
+static const char* next_word( BenchState_t* aState )
+{
+   const BenchModels_t* models = &aState->models;
+   int numDict = models->size.numDictWords;
+   int n = aState->next;
+   int w;
+
+   if( n & 1 )
+      w = numDict + ( n/2 ) % models->size.numOOVWords;
+   else
+      w = ( n/2 ) % numDict;
+
+   aState->next = ( n + 1 ) % ( 2 * numDict );
+   return models->words[w];
+}
+
+static void bench_TIesrDT_Pron( BenchState_t* aState, unsigned long aIters )
+{
+   char pron[256];
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+      TIesrDT_Pron( aState->dt, next_word( aState ), pron, sizeof(pron) );
+}
+
+static void bench_GetPron( BenchState_t* aState, unsigned long aIters )
+{
+   char pron[256], pronString[1024];
+   unsigned long i;
+
+   for( i = 0; i < aIters; i++ )
+      aState->dict->GetPron( next_word( aState ), pron, pronString );
+}
+
+
+/*--------------------------------
+  Output
+  --------------------------------*/
+
+static int write_results( const BenchState_t* aState )
+{
+   const BenchModels_t* models = &aState->models;
+   FILE* fp = stdout;
+   int n;
+
+   if( aState->options.outFile )
+   {
+      fp = fopen( aState->options.outFile, "w" );
+      if( fp == NULL )
+      {
+         fprintf( stderr, "Failed to open %s\n", aState->options.outFile );
+         return 1;
+      }
+   }
+
+   fprintf( fp, "{\n" );
+   fprintf( fp, "  \"benchmark\": \"TIesr\",\n" );
+   fprintf( fp, "  \"seed\": %u,\n", aState->options.seed );
+   fprintf( fp, "  \"repetitions\": %d,\n", aState->options.repetitions );
+   fprintf( fp, "  \"config\": { \"hmms\": %d, \"pdfs\": %d, \"means\": %d, "
+            "\"variances\": %d, \"mixtures\": %d, \"clusters\": %d, "
+            "\"grammar_words\": %d, \"grammar_symbols\": %d, "
+            "\"dict_words\": %d, \"oov_words\": %d },\n",
+            models->numHmms, models->numPdfs, models->numMeans, models->numVars,
+            models->size.numMixtures, models->size.numClusters,
+            models->size.numGrammarWords, models->numSyms,
+            models->size.numDictWords, models->size.numOOVWords );
+
+   fprintf( fp, "  \"results\": [" );
+   for( n = 0; n < aState->numResults; n++ )
+   {
+      const BenchResult_t* r = &aState->results[n];
+      fprintf( fp, "%s\n    { \"name\": \"%s\", \"iterations\": %lu, "
+               "\"ns_per_op\": %.1f, \"ns_per_op_min\": %.1f, \"unit\": \"%s\" }",
+               n ? "," : "", r->name, r->iterations, r->nsPerOp, r->nsPerOpMin,
+               r->unit );
+   }
+   fprintf( fp, "%s],\n", aState->numResults ? "\n  " : "" );
+
+   fprintf( fp, "  \"skipped\": [" );
+   for( n = 0; n < aState->numNotes; n++ )
+   {
+      fprintf( fp, "%s\n    { \"name\": \"%s\", \"reason\": \"%s\" }",
+               n ? "," : "", aState->notes[n].name, aState->notes[n].reason );
+   }
+   fprintf( fp, "%s]\n}\n", aState->numNotes ? "\n  " : "" );
+
+   if( fp != stdout )
+      fclose( fp );
+   return 0;
+}
+
+
+/*--------------------------------
+  Main program
+  --------------------------------*/
+
+static int parse_options( int argc, char** argv, BenchOptions_t* aOptions )
+{
+   int opt;
+
+   aOptions->minTime = 0.5;
+   aOptions->repetitions = 5;
+   aOptions->filter = NULL;
+   aOptions->seed = 1;
+   aOptions->tmpDir = getenv( "TMPDIR" ) ? getenv( "TMPDIR" ) : "/tmp";
+   aOptions->outFile = NULL;
+
+   while( ( opt = getopt( argc, argv, "t:r:f:s:d:o:" ) ) != -1 )
+   {
+      switch( opt )
+      {
+         case 't':
+            aOptions->minTime = atof( optarg );
+            break;
+         case 'r':
+            aOptions->repetitions = atoi( optarg );
+            break;
+         case 'f':
+            aOptions->filter = optarg;
+            break;
+         case 's':
+            aOptions->seed = (unsigned int)strtoul( optarg, NULL, 0 );
+            break;
+         case 'd':
+            aOptions->tmpDir = optarg;
+            break;
+         case 'o':
+            aOptions->outFile = optarg;
+            break;
+         default:
+            return 1;
+      }
+   }
+
+   return optind != argc || aOptions->minTime <= 0.0 ||
+      aOptions->repetitions < 1 || aOptions->repetitions > 64;
+}
+
+/* Open the recognizer on the synthetic models.  Bias compensation is not
+ used since there is no SBC tree for the synthetic models. */
+static int open_engine( BenchState_t* aState )
+{
+   TIesrEngineSIRECOType* engine = &aState->engine;
+   char bias[ BENCH_MAX_PATH * 2 ];
+
+   TIesrEngineOpen( engine );
+
+   aState->gv = (gmhmm_type*)malloc( ENGINE_MEMORY * sizeof(short) );
+   if( aState->gv == NULL )
+      return 1;
+
+   if( engine->OpenASR( aState->models.modeldir, ENGINE_MEMORY, aState->gv ) !=
+       eTIesrEngineSuccess )
+   {
+      free( aState->gv );
+      aState->gv = NULL;
+      return 1;
+   }
+
+   aState->gv->comp_type &= ~SBC;
+   sprintf( bias, "%s/jac.bin", aState->models.topdir );
+   if( engine->JAC_load( bias, aState->gv, aState->models.modeldir, NULL ) !=
+       eTIesrEngineJACSuccess )
+   {
+      engine->CloseASR( aState->gv );
+      free( aState->gv );
+      aState->gv = NULL;
+      return 1;
+   }
+
+   return 0;
+}
+
+static void close_engine( BenchState_t* aState )
+{
+   if( aState->gv )
+   {
+      aState->engine.CloseASR( aState->gv );
+      free( aState->gv );
+      aState->gv = NULL;
+   }
+   TIesrEngineClose( &aState->engine );
+}
+
+static void run_engine_benchmarks( BenchState_t* aState )
+{
+   gmhmm_type* gv = aState->gv;
+   short* speech = aState->audio + LEAD_SAMPLES + SPEECH_SAMPLES/2;
+   short mfcc[ MAX_DIM_MFCC16 ];
+   short log_mel_energy[ N_FILTER26 ], power_spectrum[ WINDOW_LEN ];
+   short sig[ WINDOW_LEN ];
+   short last_sig = 0;
+   NormType var_norm;
+   int d;
+
+   aState->next = 0;
+   bench_run( aState, "mfcc_a_window", "frame", bench_mfcc_a_window, 1 );
+#ifdef USE_SNR_SS
+   aState->next = 0;
+   bench_run( aState, "ss_mfcc_a_window", "frame", bench_ss_mfcc_a_window, 1 );
+#endif
+   bench_run( aState, "fft", "call", bench_fft, 1 );
+
+   /* A feature vector of a speech frame, without the dynamic part */
+   memcpy( sig, speech, sizeof(sig) );
+   mfcc_a_window( sig, mfcc, log_mel_energy, gv->n_mfcc, gv->n_filter,
+                  gv->mel_filter, gv->cosxfm, power_spectrum, gv->muScaleP2,
+                  &var_norm, &last_sig, NULL );
+   for( d = 0; d < gv->n_mfcc; d++ )
+   {
+      aState->feature[d] = mfcc[d];
+      aState->feature[ d + gv->n_mfcc ] = 0;
+   }
+
+   bench_run( aState, "gauss_obs_score_f", "pdf", bench_gauss_obs_score_f, gv->n_pdf );
+   bench_run( aState, "rj_clear_obs_scr", "frame", bench_rj_clear_obs_scr, 1 );
+   rj_clear_obs_scr( gv, aState->feature );
+   bench_run( aState, "rj_gauss_obs_score_f", "pdf", bench_rj_gauss_obs_score_f,
+              gv->n_pdf );
+
+   if( bench_search( aState ) )
+   {
+      bench_note( aState, "back_trace_beam", "synthetic utterance was not recognized" );
+      bench_note( aState, "JAC_update", "synthetic utterance was not recognized" );
+   }
+   else
+   {
+      bench_run( aState, "back_trace_beam", "utterance", bench_back_trace_beam, 1 );
+      bench_run( aState, "JAC_update", "utterance", bench_JAC_update, 1 );
+   }
+
+#ifdef USE_SVA
+   bench_run( aState, "sva_compensate", "call", bench_sva_compensate, 1 );
+#endif
+
+   /* Compensation of the means requires the original means */
+#ifdef USE_16BITMEAN_DECOD
+   if( load_mean_vec( aState->models.modeldir, gv, FALSE ) != eTIesrEngineSuccess )
+   {
+      bench_note( aState, "jac_one_mean", "original means could not be loaded" );
+      return;
+   }
+#endif
+   aState->next = 0;
+   bench_run( aState, "jac_one_mean", "mean", bench_jac_one_mean, 1 );
+}
+
+static void run_pron_benchmarks( BenchState_t* aState )
+{
+   BenchModels_t* models = &aState->models;
+
+   if( TIesrDT_CreatePreload( &aState->dt, models->treedir ) != TIesrDTErrorNone )
+      bench_note( aState, "TIesrDT_Pron", "decision trees could not be loaded" );
+   else
+   {
+      aState->next = 0;
+      bench_run( aState, "TIesrDT_Pron", "word", bench_TIesrDT_Pron, 1 );
+      TIesrDT_Destroy( aState->dt );
+   }
+
+   aState->dict = new CTIesrDict;
+   if( aState->dict->LoadDictionary( models->dictdir, models->language,
+                                     models->dictid, 0 ) != CTIesrDict::ErrNone )
+      bench_note( aState, "GetPron", "dictionary could not be loaded" );
+   else
+   {
+      aState->next = 0;
+      bench_run( aState, "GetPron", "word", bench_GetPron, 1 );
+   }
+   delete aState->dict;
+}
+
+int main( int argc, char** argv )
+{
+   BenchState_t* state;
+   int failed;
+
+   state = (BenchState_t*)calloc( 1, sizeof(BenchState_t) );
+   if( state == NULL )
+      return 1;
+
+   if( parse_options( argc, argv, &state->options ) )
+   {
+      fprintf( stderr, "Usage: %s [-t minSeconds] [-r repetitions] [-f filter] "
+               "[-s seed] [-d tmpDir] [-o outFile]\n", argv[0] );
+      free( state );
+      return 1;
+   }
+
+   if( BenchModels_create( &state->models, state->options.tmpDir, &MODEL_SIZE,
+                           state->options.seed ) )
+   {
+      fprintf( stderr, "Failed to create synthetic data in %s\n", state->options.tmpDir );
+      free( state );
+      return 1;
+   }
+
+   state->audio = make_audio( &state->numSamples );
+   if( state->audio == NULL )
+      failed = 1;
+   else if( open_engine( state ) )
+   {
+      fprintf( stderr, "Failed to open the recognizer on the synthetic models\n" );
+      failed = 1;
+   }
+   else
+   {
+      run_engine_benchmarks( state );
+      close_engine( state );
+      run_pron_benchmarks( state );
+      failed = write_results( state );
+   }
+
+   BenchModels_remove( &state->models );
+   free( state->audio );
+   free( state );
+   return failed;
+}
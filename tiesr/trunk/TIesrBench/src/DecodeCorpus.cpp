@@ -0,0 +1,493 @@
+/*=======================================================================
+
+ *
+ * DecodeCorpus.cpp
+ *
+ * Parallel decoding of a corpus of audio files.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ Each recognizer loads its own copy of the models from the grammar
+ directory, and is opened anew for each run so that every run starts
+ from the same JAC state.
+
+======================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined (LINUX)
+#include <unistd.h>
+#endif
+
+#include "gmhmm_type.h"
+#include "gmhmm_type_common_user.h"
+
+#include "DecodeCorpus.h"
+
+
+/* Default shorts of memory given to each recognizer */
+static const int ENGINE_MEMORY = 500000;
+
+
+/*--------------------------------
+  Platform support
+  --------------------------------*/
+
+static int number_of_processors( void )
+{
+#if defined (LINUX)
+   long n = sysconf( _SC_NPROCESSORS_ONLN );
+   return n > 0 ? (int)n : 1;
+#elif defined (WIN32) || defined (WINCE)
+   SYSTEM_INFO info;
+   GetSystemInfo( &info );
+   return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+   return 1;
+#endif
+}
+
+/* CPU time of the calling thread in nanoseconds */
+static unsigned long long thread_cpu_clock( void )
+{
+#if defined (LINUX)
+   struct timespec ts;
+   if( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) == 0 )
+      return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+   return 0;
+#elif defined (WIN32) || defined (WINCE)
+   FILETIME created, exited, kernel, user;
+   ULARGE_INTEGER k, u;
+   if( ! GetThreadTimes( GetCurrentThread(), &created, &exited, &kernel, &user ) )
+      return 0;
+   k.LowPart = kernel.dwLowDateTime;
+   k.HighPart = kernel.dwHighDateTime;
+   u.LowPart = user.dwLowDateTime;
+   u.HighPart = user.dwHighDateTime;
+   return ( k.QuadPart + u.QuadPart ) * 100ULL;
+#else
+   return (unsigned long long)clock() * ( 1000000000ULL / CLOCKS_PER_SEC );
+#endif
+}
+
+static void lock_corpus( DecodeCorpus_t* aCorpus )
+{
+#if defined (LINUX)
+   pthread_mutex_lock( &aCorpus->mutex );
+#elif defined (WIN32) || defined (WINCE)
+   WaitForSingleObject( aCorpus->mutex, INFINITE );
+#endif
+}
+
+static void unlock_corpus( DecodeCorpus_t* aCorpus )
+{
+#if defined (LINUX)
+   pthread_mutex_unlock( &aCorpus->mutex );
+#elif defined (WIN32) || defined (WINCE)
+   ReleaseMutex( aCorpus->mutex );
+#endif
+}
+
+
+/*--------------------------------
+  Corpus
+  --------------------------------*/
+
+int DecodeCorpus_init( DecodeCorpus_t* aCorpus, const char* aGrammarDir )
+{
+   memset( aCorpus, 0, sizeof(DecodeCorpus_t) );
+
+   if( strlen( aGrammarDir ) + sizeof("/jac.bin") > DECODE_MAX_PATH )
+      return 1;
+
+   aCorpus->grammarDir = aGrammarDir;
+   aCorpus->memorySize = ENGINE_MEMORY;
+   strcpy( aCorpus->jacFile, aGrammarDir );
+   strcat( aCorpus->jacFile, "/jac.bin" );
+   aCorpus->treeFile = NULL;
+   aCorpus->adapt = 1;
+   aCorpus->jobs = number_of_processors();
+   return 0;
+}
+
+/* Copy a string into new memory */
+static char* copy_string( const char* aString )
+{
+   char* copy = (char*)malloc( strlen( aString ) + 1 );
+   if( copy != NULL )
+      strcpy( copy, aString );
+   return copy;
+}
+
+int DecodeCorpus_read_list( DecodeCorpus_t* aCorpus, const char* aListFile )
+{
+   char line[ DECODE_MAX_PATH ];
+   int maxFiles = aCorpus->numFiles;
+   FILE* fp;
+
+   fp = fopen( aListFile, "r" );
+   if( fp == NULL )
+      return 1;
+
+   while( fgets( line, DECODE_MAX_PATH, fp ) )
+   {
+      size_t length = strcspn( line, "\r\n" );
+      char* reference;
+      DecodeFile_t* file;
+
+      line[ length ] = '\0';
+      if( length == 0 || line[0] == '#' )
+         continue;
+
+      reference = strchr( line, '\t' );
+      if( reference != NULL )
+         *reference++ = '\0';
+
+      if( aCorpus->numFiles == maxFiles )
+      {
+         DecodeFile_t* files;
+
+         maxFiles = maxFiles ? 2 * maxFiles : 64;
+         files = (DecodeFile_t*)realloc( aCorpus->files, maxFiles * sizeof(DecodeFile_t) );
+         if( files == NULL )
+         {
+            fclose( fp );
+            return 1;
+         }
+         aCorpus->files = files;
+      }
+
+      file = &aCorpus->files[ aCorpus->numFiles ];
+      memset( file, 0, sizeof(DecodeFile_t) );
+      file->status = DECODE_NOT_DECODED;
+      file->worker = -1;
+      file->name = copy_string( line );
+      if( reference != NULL )
+         file->reference = copy_string( reference );
+      aCorpus->numFiles++;
+
+      if( file->name == NULL || ( reference != NULL && file->reference == NULL ) )
+      {
+         fclose( fp );
+         return 1;
+      }
+   }
+
+   fclose( fp );
+   return 0;
+}
+
+void DecodeCorpus_free( DecodeCorpus_t* aCorpus )
+{
+   int f;
+
+   for( f = 0; f < aCorpus->numFiles; f++ )
+   {
+      free( aCorpus->files[f].name );
+      free( aCorpus->files[f].reference );
+      free( aCorpus->files[f].words );
+   }
+   free( aCorpus->files );
+   free( aCorpus->workers );
+
+   aCorpus->files = NULL;
+   aCorpus->numFiles = 0;
+   aCorpus->workers = NULL;
+   aCorpus->numWorkers = 0;
+}
+
+double DecodeCorpus_seconds( const DecodeFile_t* aFile )
+{
+   return (double)aFile->samples / DECODE_SAMPLE_RATE;
+}
+
+
+/*--------------------------------
+  Recognizers
+  --------------------------------*/
+
+/* Read all samples of an audio file */
+static short* read_audio( const char* aFileName, long* aSamples )
+{
+   FILE* fp;
+   long size;
+   short* audio;
+
+   fp = fopen( aFileName, "rb" );
+   if( fp == NULL )
+      return NULL;
+
+   if( fseek( fp, 0, SEEK_END ) != 0 || ( size = ftell( fp ) ) < 0 ||
+       fseek( fp, 0, SEEK_SET ) != 0 )
+   {
+      fclose( fp );
+      return NULL;
+   }
+
+   *aSamples = size / (long)sizeof(short);
+   audio = (short*)malloc( ( *aSamples + 1 ) * sizeof(short) );
+   if( audio != NULL &&
+       fread( audio, sizeof(short), *aSamples, fp ) != (size_t)*aSamples )
+   {
+      free( audio );
+      audio = NULL;
+   }
+
+   fclose( fp );
+   return audio;
+}
+
+static int open_worker( DecodeWorker_t* aWorker )
+{
+   DecodeCorpus_t* corpus = aWorker->corpus;
+   TIesrEngineSIRECOType* engine = &aWorker->engine;
+
+   TIesrEngineOpen( engine );
+
+   aWorker->gv = (gmhmm_type*)malloc( corpus->memorySize * sizeof(short) );
+   if( aWorker->gv == NULL )
+      return 1;
+
+   if( engine->OpenASR( (char*)corpus->grammarDir, corpus->memorySize,
+                        aWorker->gv ) != eTIesrEngineSuccess )
+   {
+      free( aWorker->gv );
+      aWorker->gv = NULL;
+      return 1;
+   }
+
+   if( engine->JAC_load( corpus->jacFile, aWorker->gv, corpus->grammarDir,
+                         corpus->treeFile ) != eTIesrEngineJACSuccess )
+   {
+      engine->CloseASR( aWorker->gv );
+      free( aWorker->gv );
+      aWorker->gv = NULL;
+      return 1;
+   }
+
+   if( corpus->setup )
+      corpus->setup( engine, aWorker->gv, corpus->setupArg );
+
+   return 0;
+}
+
+static void close_worker( DecodeWorker_t* aWorker )
+{
+   if( aWorker->gv )
+   {
+      aWorker->engine.CloseASR( aWorker->gv );
+      free( aWorker->gv );
+      aWorker->gv = NULL;
+   }
+   TIesrEngineClose( &aWorker->engine );
+}
+
+/* Copy the recognized words of the last utterance */
+static char* answer_words( DecodeWorker_t* aWorker )
+{
+   TIesrEngineSIRECOType* engine = &aWorker->engine;
+   unsigned short numWords = engine->GetAnswerCount( aWorker->gv, 0 );
+   size_t length = 1;
+   unsigned short w;
+   char* words;
+
+   for( w = 0; w < numWords; w++ )
+      length += strlen( engine->GetAnswerWord( w, aWorker->gv, 0 ) ) + 1;
+
+   words = (char*)malloc( length );
+   if( words == NULL )
+      return NULL;
+
+   words[0] = '\0';
+   for( w = 0; w < numWords; w++ )
+   {
+      if( w > 0 )
+         strcat( words, " " );
+      strcat( words, engine->GetAnswerWord( w, aWorker->gv, 0 ) );
+   }
+   return words;
+}
+
+static void decode_file( DecodeWorker_t* aWorker, DecodeFile_t* aFile )
+{
+   TIesrEngineSIRECOType* engine = &aWorker->engine;
+   TIesrEngineStatusType status;
+   unsigned long long start, cpuStart, lastFrame, answer;
+   long frame, numFrames;
+   short* audio;
+
+   aFile->worker = aWorker->index;
+
+   audio = read_audio( aFile->name, &aFile->samples );
+   if( audio == NULL )
+   {
+      aFile->status = DECODE_READ_FAILED;
+      return;
+   }
+   numFrames = aFile->samples / FRAME_LEN;
+
+   cpuStart = thread_cpu_clock();
+   start = stats_clock();
+   lastFrame = start;
+
+   status = engine->OpenSearchEngine( aWorker->gv );
+   if( status == eTIesrEngineSuccess )
+   {
+      for( frame = 0; frame < numFrames && status == eTIesrEngineSuccess; frame++ )
+      {
+         status = engine->CallSearchEngine( audio + frame * FRAME_LEN, aWorker->gv, 0 );
+         if( engine->SpeechEnded( aWorker->gv ) )
+            break;
+      }
+      lastFrame = stats_clock();
+
+      status = engine->CloseSearchEngine( status, aWorker->gv );
+      if( status == eTIesrEngineSuccess )
+         aFile->words = answer_words( aWorker );
+   }
+   answer = stats_clock();
+
+   if( status == eTIesrEngineSuccess && aWorker->corpus->adapt )
+      engine->JAC_update( aWorker->gv );
+
+   aFile->decodeNs = stats_clock() - start;
+   aFile->cpuNs = thread_cpu_clock() - cpuStart;
+   aFile->latencyNs = answer - lastFrame;
+   aFile->status = status;
+   aFile->frames = engine->GetFrameCount( aWorker->gv );
+   aFile->searchMemory = engine->GetSearchMemorySize( aWorker->gv );
+
+   if( aFile->searchMemory > aWorker->searchMemory )
+      aWorker->searchMemory = aFile->searchMemory;
+   aWorker->numDecoded++;
+
+   free( audio );
+}
+
+/* Open a recognizer and decode files until none are left */
+static void* decode_worker( void* aArg )
+{
+   DecodeWorker_t* worker = (DecodeWorker_t*)aArg;
+   DecodeCorpus_t* corpus = worker->corpus;
+
+   if( open_worker( worker ) )
+   {
+      worker->failed = 1;
+      TIesrEngineClose( &worker->engine );
+      return NULL;
+   }
+
+   for( ;; )
+   {
+      int file;
+
+      lock_corpus( corpus );
+      file = corpus->nextFile < corpus->numFiles ? corpus->nextFile++ : -1;
+      unlock_corpus( corpus );
+
+      if( file < 0 )
+         break;
+
+      decode_file( worker, &corpus->files[ file ] );
+   }
+
+   close_worker( worker );
+   return NULL;
+}
+
+#if defined (WIN32) || defined (WINCE)
+static DWORD WINAPI decode_worker_thread( LPVOID aArg )
+{
+   decode_worker( aArg );
+   return 0;
+}
+#endif
+
+int DecodeCorpus_run( DecodeCorpus_t* aCorpus )
+{
+   unsigned long long start;
+   int f, w, started = 0;
+
+   for( f = 0; f < aCorpus->numFiles; f++ )
+   {
+      DecodeFile_t* file = &aCorpus->files[f];
+
+      free( file->words );
+      file->words = NULL;
+      file->status = DECODE_NOT_DECODED;
+      file->worker = -1;
+      file->samples = 0;
+      file->frames = 0;
+      file->searchMemory = 0;
+      file->decodeNs = file->latencyNs = file->cpuNs = 0;
+   }
+   aCorpus->nextFile = 0;
+
+   free( aCorpus->workers );
+   aCorpus->numWorkers = 0;
+   aCorpus->workers = (DecodeWorker_t*)calloc( aCorpus->jobs, sizeof(DecodeWorker_t) );
+   if( aCorpus->workers == NULL )
+      return 1;
+
+#if defined (LINUX)
+   pthread_mutex_init( &aCorpus->mutex, NULL );
+#elif defined (WIN32) || defined (WINCE)
+   aCorpus->mutex = CreateMutex( NULL, FALSE, NULL );
+#endif
+
+   start = stats_clock();
+
+   for( w = 0; w < aCorpus->jobs; w++ )
+   {
+      DecodeWorker_t* worker = &aCorpus->workers[w];
+
+      worker->corpus = aCorpus;
+      worker->index = w;
+
+#if defined (LINUX)
+      if( pthread_create( &worker->threadid, NULL, decode_worker, worker ) )
+         break;
+#elif defined (WIN32) || defined (WINCE)
+      worker->threadid = CreateThread( NULL, 0, decode_worker_thread, worker, 0, NULL );
+      if( worker->threadid == NULL )
+         break;
+#else
+      decode_worker( worker );
+#endif
+      started++;
+   }
+
+   for( w = 0; w < started; w++ )
+   {
+#if defined (LINUX)
+      pthread_join( aCorpus->workers[w].threadid, NULL );
+#elif defined (WIN32) || defined (WINCE)
+      WaitForSingleObject( aCorpus->workers[w].threadid, INFINITE );
+      CloseHandle( aCorpus->workers[w].threadid );
+#endif
+   }
+
+   aCorpus->wallNs = stats_clock() - start;
+
+#if defined (LINUX)
+   pthread_mutex_destroy( &aCorpus->mutex );
+#elif defined (WIN32) || defined (WINCE)
+   CloseHandle( aCorpus->mutex );
+#endif
+
+   aCorpus->numWorkers = started;
+   return started == 0;
+}
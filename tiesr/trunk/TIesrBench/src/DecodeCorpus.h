@@ -0,0 +1,168 @@
+/*=======================================================================
+
+ *
+ * DecodeCorpus.h
+ *
+ * Header for parallel decoding of a corpus of audio files.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ A corpus is a list of raw 16 bit 8 kHz audio files, each optionally
+ labeled with its reference words.  DecodeCorpus_run opens a number of
+ recognizers on a grammar directory, each in its own thread, and hands
+ the files to the recognizers one at a time as they become free.  Audio
+ is given to the search frame by frame without waiting, and decoding of
+ a file stops when the engine detects the end of speech or the file
+ ends.  The recognized words and processing cost of each file are kept
+ in the corpus.
+
+======================================================================*/
+
+#ifndef _DECODECORPUS_H
+#define _DECODECORPUS_H
+
+#if defined (LINUX)
+#include <pthread.h>
+#elif defined (WIN32) || defined (WINCE)
+#include <windows.h>
+#endif
+
+#include "tiesr_config.h"
+#include "tiesr_engine_api_sireco.h"
+
+
+/* Maximum length of a path name */
+#define DECODE_MAX_PATH 1024
+
+/* Sample rate of the audio files */
+#define DECODE_SAMPLE_RATE 8000
+
+/* Status of a file that no recognizer decoded */
+#define DECODE_NOT_DECODED -1
+
+/* Status of a file that could not be read */
+#define DECODE_READ_FAILED -2
+
+
+/* Result of decoding one file */
+typedef struct DecodeFile
+{
+      char* name;
+
+      /* Reference words separated by spaces, or NULL if not labeled */
+      char* reference;
+
+      /* Engine status, or DECODE_NOT_DECODED or DECODE_READ_FAILED */
+      int status;
+      int worker;
+
+      /* Recognized words separated by spaces, or NULL */
+      char* words;
+
+      long samples;
+      short frames;
+      unsigned short searchMemory;
+
+      /* Decode time, latency and thread CPU time in nanoseconds.  The
+       latency is the time from the return of the last frame given to the
+       search until the recognized words are available. */
+      unsigned long long decodeNs;
+      unsigned long long latencyNs;
+      unsigned long long cpuNs;
+} DecodeFile_t;
+
+
+/* Called after a recognizer opens to apply settings to it */
+typedef void (*DecodeSetup_t)( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr,
+        void* aArg );
+
+struct DecodeCorpus;
+
+/* One recognizer and the thread running it */
+typedef struct DecodeWorker
+{
+      struct DecodeCorpus* corpus;
+      int index;
+
+      TIesrEngineSIRECOType engine;
+      TIesr_t gv;
+
+      /* Set if the recognizer could not be opened */
+      int failed;
+
+      int numDecoded;
+      unsigned short searchMemory;
+
+#if defined (LINUX)
+      pthread_t threadid;
+#elif defined (WIN32) || defined (WINCE)
+      HANDLE threadid;
+#endif
+} DecodeWorker_t;
+
+
+typedef struct DecodeCorpus
+{
+      /* Settings of the recognizers, set before DecodeCorpus_run */
+      const char* grammarDir;
+      int memorySize;
+      char jacFile[ DECODE_MAX_PATH ];
+      const char* treeFile;
+      int adapt;
+      int jobs;
+      DecodeSetup_t setup;
+      void* setupArg;
+
+      DecodeFile_t* files;
+      int numFiles;
+
+      /* Index of the next file to decode, guarded by the mutex */
+      int nextFile;
+
+#if defined (LINUX)
+      pthread_mutex_t mutex;
+#elif defined (WIN32) || defined (WINCE)
+      HANDLE mutex;
+#endif
+
+      /* Recognizers of the last run */
+      DecodeWorker_t* workers;
+      int numWorkers;
+
+      /* Wall clock time of the last run */
+      unsigned long long wallNs;
+} DecodeCorpus_t;
+
+
+/* Initialize a corpus with default settings: one recognizer per
+ processor, 500000 shorts of memory each, the JAC file jac.bin in the
+ grammar directory, no SBC tree and JAC adaptation after each file.
+ Returns zero on success. */
+int DecodeCorpus_init( DecodeCorpus_t* aCorpus, const char* aGrammarDir );
+
+/* Read the list of audio files.  Each line holds a file name,
+ optionally followed by a tab and the reference words.  Empty lines and
+ lines starting with '#' are ignored.  Returns zero on success. */
+int DecodeCorpus_read_list( DecodeCorpus_t* aCorpus, const char* aListFile );
+
+/* Decode all files, discarding the results of any prior run.  Returns
+ zero if at least one recognizer ran. */
+int DecodeCorpus_run( DecodeCorpus_t* aCorpus );
+
+/* Free the files and recognizer results */
+void DecodeCorpus_free( DecodeCorpus_t* aCorpus );
+
+/* Duration of a file in seconds */
+double DecodeCorpus_seconds( const DecodeFile_t* aFile );
+
+#endif /* _DECODECORPUS_H */
@@ -0,0 +1,507 @@
+/*=======================================================================
+
+ *
+ * DecodeTIesr.cpp
+ *
+ * Offline decoding of a corpus of audio files with parallel recognizers.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This program decodes a list of audio files with a grammar and model
+ directory as fast as possible, using several recognizer instances in
+ parallel, and reports the recognition result and processing cost of
+ each file.  The command line is:
+
+ decodetiesr [-j jobs] [-m memorySize] [-p prune] [-b jacFile]
+             [-t treeFile] [-n] [-o hypFile] [-r reportFile]
+             listFile grammarDir
+
+ jobs is the number of recognizers decoding in parallel, each in its
+ own thread, default the number of processors.
+
+ memorySize is the number of shorts of memory given to each
+ recognizer, default 500000.
+
+ prune sets the search prune parameter of each recognizer, default
+ the engine default.
+
+ jacFile is the JAC channel and noise file loaded by each recognizer
+ when it opens, default grammarDir/jac.bin.  If the file does not exist
+ each recognizer starts from the initial JAC estimate.
+
+ treeFile is the SBC tree file used by JAC, default none.
+
+ -n turns off JAC adaptation after each file, so that the result of a
+ file does not depend on the files decoded before it by the same
+ recognizer.
+
+ hypFile receives the recognized words of each file in list order, one
+ line per file with the file name and the words separated by a tab,
+ default stdout.
+
+ reportFile receives a JSON object with the processing cost of each
+ file and of the whole corpus, default none.  A summary is always
+ written to stderr.
+
+ listFile holds the names of the audio files, one per line, as read
+ by DecodeCorpus_read_list.  Each audio file holds raw 16 bit 8 kHz
+ samples in machine byte order, as read by the TIesrFA file mode.
+
+ grammarDir is the directory holding the grammar network and models
+ written by TIesrFlex, as given to OpenASR.
+
+ The files are decoded by DecodeCorpus.
+
+ The real time factor (RTF) of a file is its decode time divided by its
+ duration.  The latency of a file is the time from the return of the
+ last frame given to the search until the recognized words are
+ available.  The search memory high water mark is the peak search space
+ reported by GetSearchMemorySize.
+
+======================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined (LINUX)
+#include <sys/resource.h>
+#endif
+
+#include "tiesr_config.h"
+#include "tiesr_engine_api_sireco.h"
+
+#include "DecodeCorpus.h"
+
+
+/*--------------------------------
+  Types
+  --------------------------------*/
+
+typedef struct DecodeOptions
+{
+      int jobs;
+      int memorySize;
+      int setPrune;
+      short prune;
+      const char* jacFile;
+      const char* treeFile;
+      int adapt;
+      const char* hypFile;
+      const char* reportFile;
+      const char* listFile;
+      const char* grammarDir;
+} DecodeOptions_t;
+
+typedef struct DecodeState
+{
+      DecodeOptions_t options;
+      DecodeCorpus_t corpus;
+} DecodeState_t;
+
+
+/*--------------------------------
+  Options
+  --------------------------------*/
+
+static int parse_options( int argc, char** argv, DecodeOptions_t* aOptions )
+{
+   int arg;
+
+   aOptions->jobs = 0;
+   aOptions->memorySize = 0;
+   aOptions->setPrune = 0;
+   aOptions->prune = 0;
+   aOptions->jacFile = NULL;
+   aOptions->treeFile = NULL;
+   aOptions->adapt = 1;
+   aOptions->hypFile = NULL;
+   aOptions->reportFile = NULL;
+
+   for( arg = 1; arg < argc && argv[arg][0] == '-'; arg++ )
+   {
+      const char* value = argv[arg][1] != '\0' && argv[arg][2] == '\0' &&
+         arg + 1 < argc ? argv[arg + 1] : NULL;
+
+      switch( argv[arg][1] )
+      {
+         case 'n':
+            if( argv[arg][2] != '\0' )
+               return 1;
+            aOptions->adapt = 0;
+            continue;
+         case 'j':
+            if( value == NULL || ( aOptions->jobs = atoi( value ) ) < 1 )
+               return 1;
+            break;
+         case 'm':
+            if( value == NULL || ( aOptions->memorySize = atoi( value ) ) < 1 )
+               return 1;
+            break;
+         case 'p':
+            if( value == NULL )
+               return 1;
+            aOptions->setPrune = 1;
+            aOptions->prune = (short)atoi( value );
+            break;
+         case 'b':
+            aOptions->jacFile = value;
+            break;
+         case 't':
+            aOptions->treeFile = value;
+            break;
+         case 'o':
+            aOptions->hypFile = value;
+            break;
+         case 'r':
+            aOptions->reportFile = value;
+            break;
+         default:
+            return 1;
+      }
+
+      if( value == NULL )
+         return 1;
+      arg++;
+   }
+
+   if( arg + 2 != argc )
+      return 1;
+
+   aOptions->listFile = argv[arg];
+   aOptions->grammarDir = argv[arg + 1];
+   return 0;
+}
+
+static void setup_prune( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr, void* aArg )
+{
+   const DecodeOptions_t* options = (const DecodeOptions_t*)aArg;
+   aEngine->SetTIesrPrune( aTIesr, options->prune );
+}
+
+
+/*--------------------------------
+  Reports
+  --------------------------------*/
+
+static int compare_ull( const void* aV1, const void* aV2 )
+{
+   unsigned long long v1 = *(const unsigned long long*)aV1;
+   unsigned long long v2 = *(const unsigned long long*)aV2;
+   return v1 < v2 ? -1 : ( v1 > v2 );
+}
+
+/* Nearest rank percentile of sorted values */
+static double percentile_ms( const unsigned long long* aSorted, int aCount, int aPercent )
+{
+   int rank;
+
+   if( aCount == 0 )
+      return 0.0;
+
+   rank = ( aPercent * aCount + 99 ) / 100;
+   if( rank < 1 )
+      rank = 1;
+   return aSorted[ rank - 1 ] / 1e6;
+}
+
+/* Peak resident memory of the process in kilobytes, or zero if unknown */
+static long peak_memory_kb( void )
+{
+#if defined (LINUX)
+   struct rusage usage;
+   if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+      return usage.ru_maxrss;
+#endif
+   return 0;
+}
+
+static void write_json_string( FILE* aFp, const char* aString )
+{
+   const unsigned char* c;
+
+   fputc( '"', aFp );
+   for( c = (const unsigned char*)aString; *c; c++ )
+   {
+      if( *c == '"' || *c == '\\' )
+         fprintf( aFp, "\\%c", *c );
+      else if( *c < 0x20 )
+         fprintf( aFp, "\\u%04x", *c );
+      else
+         fputc( *c, aFp );
+   }
+   fputc( '"', aFp );
+}
+
+static int write_hypotheses( const DecodeState_t* aState )
+{
+   FILE* fp = stdout;
+   int f;
+
+   if( aState->options.hypFile )
+   {
+      fp = fopen( aState->options.hypFile, "w" );
+      if( fp == NULL )
+         return 1;
+   }
+
+   for( f = 0; f < aState->corpus.numFiles; f++ )
+   {
+      const DecodeFile_t* file = &aState->corpus.files[f];
+      fprintf( fp, "%s\t%s\n", file->name, file->words ? file->words : "" );
+   }
+
+   if( fp != stdout )
+      fclose( fp );
+   return 0;
+}
+
+/* Corpus totals and percentiles */
+typedef struct DecodeSummary
+{
+      int decoded;
+      int failed;
+      double audioSeconds;
+      double decodeSeconds;
+      double wallSeconds;
+      unsigned short searchMemory;
+      long peakKb;
+      double latencyMs[4];
+      double decodeMs[4];
+} DecodeSummary_t;
+
+static const int PERCENTS[4] = { 50, 90, 99, 100 };
+
+static int summarize( const DecodeState_t* aState, DecodeSummary_t* aSummary )
+{
+   unsigned long long* latency;
+   unsigned long long* decode;
+   int f, p;
+
+   memset( aSummary, 0, sizeof(DecodeSummary_t) );
+
+   latency = (unsigned long long*)malloc( ( aState->corpus.numFiles + 1 ) * sizeof(unsigned long long) );
+   decode = (unsigned long long*)malloc( ( aState->corpus.numFiles + 1 ) * sizeof(unsigned long long) );
+   if( latency == NULL || decode == NULL )
+   {
+      free( latency );
+      free( decode );
+      return 1;
+   }
+
+   for( f = 0; f < aState->corpus.numFiles; f++ )
+   {
+      const DecodeFile_t* file = &aState->corpus.files[f];
+
+      if( file->status < 0 )
+      {
+         aSummary->failed++;
+         continue;
+      }
+
+      latency[ aSummary->decoded ] = file->latencyNs;
+      decode[ aSummary->decoded ] = file->decodeNs;
+      aSummary->decoded++;
+
+      aSummary->audioSeconds += DecodeCorpus_seconds( file );
+      aSummary->decodeSeconds += file->decodeNs / 1e9;
+      if( file->status != eTIesrEngineSuccess )
+         aSummary->failed++;
+      if( file->searchMemory > aSummary->searchMemory )
+         aSummary->searchMemory = file->searchMemory;
+   }
+
+   qsort( latency, aSummary->decoded, sizeof(unsigned long long), compare_ull );
+   qsort( decode, aSummary->decoded, sizeof(unsigned long long), compare_ull );
+   for( p = 0; p < 4; p++ )
+   {
+      aSummary->latencyMs[p] = percentile_ms( latency, aSummary->decoded, PERCENTS[p] );
+      aSummary->decodeMs[p] = percentile_ms( decode, aSummary->decoded, PERCENTS[p] );
+   }
+
+   aSummary->wallSeconds = aState->corpus.wallNs / 1e9;
+   aSummary->peakKb = peak_memory_kb();
+
+   free( latency );
+   free( decode );
+   return 0;
+}
+
+static void write_summary( const DecodeState_t* aState, const DecodeSummary_t* aSummary )
+{
+   fprintf( stderr, "files %d, decoded %d, failed %d, recognizers %d\n",
+            aState->corpus.numFiles, aSummary->decoded, aSummary->failed, aState->corpus.numWorkers );
+   fprintf( stderr, "audio %.2f s, decode %.2f s, wall %.2f s\n",
+            aSummary->audioSeconds, aSummary->decodeSeconds, aSummary->wallSeconds );
+   fprintf( stderr, "RTF %.4f per recognizer, %.4f aggregate\n",
+            aSummary->audioSeconds > 0.0 ? aSummary->decodeSeconds / aSummary->audioSeconds : 0.0,
+            aSummary->audioSeconds > 0.0 ? aSummary->wallSeconds / aSummary->audioSeconds : 0.0 );
+   fprintf( stderr, "latency ms p50 %.2f p90 %.2f p99 %.2f max %.2f\n",
+            aSummary->latencyMs[0], aSummary->latencyMs[1],
+            aSummary->latencyMs[2], aSummary->latencyMs[3] );
+   fprintf( stderr, "decode ms p50 %.2f p90 %.2f p99 %.2f max %.2f\n",
+            aSummary->decodeMs[0], aSummary->decodeMs[1],
+            aSummary->decodeMs[2], aSummary->decodeMs[3] );
+   fprintf( stderr, "memory: recognizer %d shorts, search peak %u shorts, process peak %ld kB\n",
+            aState->corpus.memorySize, aSummary->searchMemory, aSummary->peakKb );
+}
+
+static int write_report( const DecodeState_t* aState, const DecodeSummary_t* aSummary )
+{
+   FILE* fp;
+   int f, w, p;
+
+   fp = fopen( aState->options.reportFile, "w" );
+   if( fp == NULL )
+      return 1;
+
+   fprintf( fp, "{\n  \"grammar\": " );
+   write_json_string( fp, aState->options.grammarDir );
+   fprintf( fp, ",\n  \"recognizers\": %d,\n  \"memory_shorts\": %d,\n  \"adapt\": %s,\n",
+            aState->corpus.numWorkers, aState->corpus.memorySize,
+            aState->corpus.adapt ? "true" : "false" );
+
+   fprintf( fp, "  \"summary\": {\n" );
+   fprintf( fp, "    \"files\": %d, \"decoded\": %d, \"failed\": %d,\n",
+            aState->corpus.numFiles, aSummary->decoded, aSummary->failed );
+   fprintf( fp, "    \"audio_s\": %.3f, \"decode_s\": %.3f, \"wall_s\": %.3f,\n",
+            aSummary->audioSeconds, aSummary->decodeSeconds, aSummary->wallSeconds );
+   fprintf( fp, "    \"rtf\": %.5f, \"aggregate_rtf\": %.5f,\n",
+            aSummary->audioSeconds > 0.0 ? aSummary->decodeSeconds / aSummary->audioSeconds : 0.0,
+            aSummary->audioSeconds > 0.0 ? aSummary->wallSeconds / aSummary->audioSeconds : 0.0 );
+   for( p = 0; p < 4; p++ )
+      fprintf( fp, "    \"latency_ms_p%d\": %.3f, \"decode_ms_p%d\": %.3f,\n",
+               PERCENTS[p], aSummary->latencyMs[p], PERCENTS[p], aSummary->decodeMs[p] );
+   fprintf( fp, "    \"search_memory_peak_shorts\": %u, \"process_peak_kb\": %ld\n  },\n",
+            aSummary->searchMemory, aSummary->peakKb );
+
+   fprintf( fp, "  \"recognizer_results\": [" );
+   for( w = 0; w < aState->corpus.numWorkers; w++ )
+   {
+      const DecodeWorker_t* worker = &aState->corpus.workers[w];
+      fprintf( fp, "%s\n    { \"recognizer\": %d, \"opened\": %s, \"files\": %d, "
+               "\"search_memory_peak_shorts\": %u }", w ? "," : "", w,
+               worker->failed ? "false" : "true", worker->numDecoded, worker->searchMemory );
+   }
+
+   fprintf( fp, "\n  ],\n  \"files\": [" );
+   for( f = 0; f < aState->corpus.numFiles; f++ )
+   {
+      const DecodeFile_t* file = &aState->corpus.files[f];
+      double seconds = DecodeCorpus_seconds( file );
+
+      fprintf( fp, "%s\n    { \"file\": ", f ? "," : "" );
+      write_json_string( fp, file->name );
+      fprintf( fp, ", \"status\": %d, \"recognizer\": %d, \"words\": ",
+               file->status, file->worker );
+      write_json_string( fp, file->words ? file->words : "" );
+      fprintf( fp, ",\n      \"audio_s\": %.3f, \"frames\": %d, \"decode_ms\": %.3f, "
+               "\"rtf\": %.5f, \"latency_ms\": %.3f, \"search_memory_shorts\": %u }",
+               seconds, file->frames, file->decodeNs / 1e6,
+               seconds > 0.0 ? file->decodeNs / 1e9 / seconds : 0.0,
+               file->latencyNs / 1e6, file->searchMemory );
+   }
+   fprintf( fp, "\n  ]\n}\n" );
+
+   fclose( fp );
+   return 0;
+}
+
+
+int main( int argc, char** argv )
+{
+   DecodeState_t* state;
+   DecodeCorpus_t* corpus;
+   DecodeSummary_t summary;
+   int failed = 0;
+   int w;
+
+   state = (DecodeState_t*)calloc( 1, sizeof(DecodeState_t) );
+   if( state == NULL )
+      return 1;
+
+   if( parse_options( argc, argv, &state->options ) )
+   {
+      fprintf( stderr, "Usage: %s [-j jobs] [-m memorySize] [-p prune] [-b jacFile] "
+               "[-t treeFile] [-n] [-o hypFile] [-r reportFile] listFile grammarDir\n",
+               argv[0] );
+      free( state );
+      return 1;
+   }
+
+   if( DecodeCorpus_init( &state->corpus, state->options.grammarDir ) )
+   {
+      fprintf( stderr, "Grammar directory name is too long\n" );
+      free( state );
+      return 1;
+   }
+
+   corpus = &state->corpus;
+   if( state->options.jobs )
+      corpus->jobs = state->options.jobs;
+   if( state->options.memorySize )
+      corpus->memorySize = state->options.memorySize;
+   if( state->options.jacFile )
+      strncpy( corpus->jacFile, state->options.jacFile, DECODE_MAX_PATH - 1 );
+   corpus->treeFile = state->options.treeFile;
+   corpus->adapt = state->options.adapt;
+   if( state->options.setPrune )
+   {
+      corpus->setup = setup_prune;
+      corpus->setupArg = &state->options;
+   }
+
+   if( DecodeCorpus_read_list( corpus, state->options.listFile ) )
+   {
+      fprintf( stderr, "Failed to read file list %s\n", state->options.listFile );
+      failed = 1;
+   }
+   else if( DecodeCorpus_run( corpus ) )
+   {
+      fprintf( stderr, "Failed to start the recognizers\n" );
+      failed = 1;
+   }
+   else
+   {
+      for( w = 0; w < corpus->numWorkers; w++ )
+      {
+         if( corpus->workers[w].failed )
+            fprintf( stderr, "Recognizer %d failed to open %s\n", w,
+                     state->options.grammarDir );
+      }
+
+      if( summarize( state, &summary ) )
+         failed = 1;
+      else
+      {
+         write_summary( state, &summary );
+         if( state->options.reportFile && write_report( state, &summary ) )
+         {
+            fprintf( stderr, "Failed to write report %s\n", state->options.reportFile );
+            failed = 1;
+         }
+         if( summary.decoded == 0 )
+            failed = 1;
+      }
+
+      if( write_hypotheses( state ) )
+      {
+         fprintf( stderr, "Failed to write hypotheses %s\n", state->options.hypFile );
+         failed = 1;
+      }
+   }
+
+   DecodeCorpus_free( corpus );
+   free( state );
+   return failed;
+}
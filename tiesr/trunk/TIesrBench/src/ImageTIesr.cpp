@@ -0,0 +1,221 @@
+/*=======================================================================
+
+ *
+ * ImageTIesr.cpp
+ *
+ * Writing of TIesr engine images and timing of recognizer startup.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This program writes the engine image of a grammar directory, and
+ compares the time to open a recognizer from the directory with
+ OpenASR and from the image with OpenASRImage.  The command line is:
+
+ imagetiesr [-r repetitions] [-m memorySize] grammarDir imageFile
+
+ repetitions is the number of times each recognizer is opened and
+ closed, default 20.  The median time of each is reported.
+
+ memorySize is the number of shorts given to each recognizer, default
+ 500000.
+
+ The image is written with the configuration of the engine the program
+ is linked with, and can only be used by an engine with the same
+ configuration.
+
+======================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined (LINUX)
+#include <unistd.h>
+#elif defined (WIN32) || defined (WINCE)
+#include <windows.h>
+#endif
+
+#include "tiesr_config.h"
+#include "tiesr_engine_api_sireco.h"
+#include "gmhmm_type.h"
+#include "image_user.h"
+
+
+/* Default number of times each recognizer is opened */
+static const int DEFAULT_REPETITIONS = 20;
+
+/* Default shorts of memory given to a recognizer */
+static const int DEFAULT_MEMORY = 500000;
+
+
+typedef struct ImageOptions
+{
+      int repetitions;
+      int memorySize;
+      const char* grammarDir;
+      const char* imageFile;
+} ImageOptions_t;
+
+
+/* Wall clock time in nanoseconds, since startup includes file reading */
+static unsigned long long wall_clock( void )
+{
+#if defined (LINUX)
+   struct timespec ts;
+   if( clock_gettime( CLOCK_MONOTONIC, &ts ) == 0 )
+      return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+   return 0;
+#elif defined (WIN32) || defined (WINCE)
+   return (unsigned long long)GetTickCount() * 1000000ULL;
+#else
+   return (unsigned long long)clock() * ( 1000000000ULL / CLOCKS_PER_SEC );
+#endif
+}
+
+static int compare_times( const void* aT1, const void* aT2 )
+{
+   unsigned long long t1 = *(const unsigned long long*)aT1;
+   unsigned long long t2 = *(const unsigned long long*)aT2;
+   return t1 < t2 ? -1 : ( t1 > t2 );
+}
+
+static int parse_options( int argc, char** argv, ImageOptions_t* aOptions )
+{
+   int opt;
+
+   aOptions->repetitions = DEFAULT_REPETITIONS;
+   aOptions->memorySize = DEFAULT_MEMORY;
+
+   while( ( opt = getopt( argc, argv, "r:m:" ) ) != -1 )
+   {
+      switch( opt )
+      {
+         case 'r':
+            aOptions->repetitions = atoi( optarg );
+            break;
+         case 'm':
+            aOptions->memorySize = atoi( optarg );
+            break;
+         default:
+            return 1;
+      }
+   }
+
+   if( argc - optind != 2 || aOptions->repetitions <= 0 || aOptions->memorySize <= 0 )
+      return 1;
+
+   aOptions->grammarDir = argv[ optind ];
+   aOptions->imageFile = argv[ optind + 1 ];
+   return 0;
+}
+
+/* Open and close a recognizer repeatedly, from the grammar directory or
+ the image, and return the median time to open it in nanoseconds.  The
+ number of words of each recognizer is checked against aWords. */
+static int time_open( const ImageOptions_t* aOptions, TIesrEngineSIRECOType* aEngine,
+        gmhmm_type* aGv, int aFromImage, unsigned long long* aMedian,
+        unsigned short* aWords )
+{
+   unsigned long long* times;
+   unsigned long long start;
+   TIesrEngineStatusType status;
+   int r;
+
+   times = (unsigned long long*)malloc( aOptions->repetitions * sizeof(unsigned long long) );
+   if( times == NULL )
+      return 1;
+
+   for( r = 0; r < aOptions->repetitions; r++ )
+   {
+      start = wall_clock();
+      if( aFromImage )
+         status = aEngine->OpenASRImage( aOptions->imageFile, aOptions->memorySize, aGv );
+      else
+         status = aEngine->OpenASR( (char*)aOptions->grammarDir, aOptions->memorySize, aGv );
+      times[r] = wall_clock() - start;
+
+      if( status != eTIesrEngineSuccess )
+      {
+         fprintf( stderr, "Failed to open recognizer from %s: %d\n",
+                  aFromImage ? aOptions->imageFile : aOptions->grammarDir, status );
+         free( times );
+         return 1;
+      }
+
+      if( *aWords == 0 )
+         *aWords = aGv->trans->n_word;
+      else if( aGv->trans->n_word != *aWords )
+      {
+         fprintf( stderr, "Recognizers from %s and %s differ\n",
+                  aOptions->grammarDir, aOptions->imageFile );
+         aEngine->CloseASR( aGv );
+         free( times );
+         return 1;
+      }
+
+      aEngine->CloseASR( aGv );
+   }
+
+   qsort( times, aOptions->repetitions, sizeof(unsigned long long), compare_times );
+   *aMedian = times[ aOptions->repetitions / 2 ];
+
+   free( times );
+   return 0;
+}
+
+
+int main( int argc, char** argv )
+{
+   ImageOptions_t options;
+   TIesrEngineSIRECOType engine;
+   gmhmm_type* gv;
+   unsigned long long dirTime = 0, imageTime = 0;
+   unsigned short words = 0;
+   TIesrEngineStatusType status;
+   int failed;
+
+   if( parse_options( argc, argv, &options ) )
+   {
+      fprintf( stderr, "Usage: %s [-r repetitions] [-m memorySize] grammarDir imageFile\n",
+               argv[0] );
+      return 1;
+   }
+
+   status = WriteTIesrImage( (char*)options.grammarDir, options.imageFile );
+   if( status != eTIesrEngineSuccess )
+   {
+      fprintf( stderr, "Failed to write image %s: %d\n", options.imageFile, status );
+      return 1;
+   }
+
+   gv = (gmhmm_type*)malloc( options.memorySize * sizeof(short) );
+   if( gv == NULL )
+      return 1;
+
+   TIesrEngineOpen( &engine );
+
+   failed = time_open( &options, &engine, gv, 0, &dirTime, &words ) ||
+      time_open( &options, &engine, gv, 1, &imageTime, &words );
+
+   TIesrEngineClose( &engine );
+   free( gv );
+
+   if( failed )
+      return 1;
+
+   printf( "words        %u\n", words );
+   printf( "OpenASR      %10.3f ms\n", dirTime / 1e6 );
+   printf( "OpenASRImage %10.3f ms\n", imageTime / 1e6 );
+   return 0;
+}
@@ -0,0 +1,758 @@
+/*=======================================================================
+
+ *
+ * SweepTIesr.cpp
+ *
+ * Sweep of recognizer tuning parameters over a labeled corpus.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This program decodes a labeled corpus at every point of a grid of
+ recognizer parameter settings, and reports the word accuracy and CPU
+ cost of each point, the points on the Pareto frontier of accuracy
+ against cost, and the most accurate point within a cost budget.  The
+ command line is:
+
+ sweeptiesr [-j jobs] [-m memorySize] [-b jacFile] [-t treeFile] [-n]
+            [-B budget] [-o outFile] -g knob=values [-g knob=values ...]
+            listFile grammarDir
+
+ Each -g option adds a parameter to the grid.  values is a comma
+ separated list of values, or a range first:last:step.  The knobs are:
+
+ prune         SetTIesrPrune
+ tranwgt       SetTIesrTransiWeight
+ gauss_core    core percentage of SetTIesrGaussSelection
+ gauss_inter   intermediate percentage of SetTIesrGaussSelection
+ jacrate       SetTIesrJacRate
+ orm_frames, orm_noise, orm_llr_low, orm_llr_high, orm_count,
+ orm_percent, orm_start, orm_after_peak
+               the parameters of SetTIesrOnlineReferenceModel, in order
+
+ Knobs not in the grid keep the engine defaults.  The dynamic pruning
+ constants are compile time settings of tiesr_config.h and
+ search_user.h, so they can only be swept by rebuilding the engine.
+ The real time guard is not swept, since audio is never queued when
+ decoding files.
+
+ budget is the maximum CPU seconds per audio second of the recommended
+ setting.  If not given no setting is recommended.
+
+ outFile receives the results as a JSON object, default stdout.
+
+ The options -j -m -b -t -n and the arguments listFile and grammarDir
+ are as for decodetiesr, except that every line of listFile must hold
+ the reference words of the file after a tab.  The files of each point
+ are decoded in parallel by DecodeCorpus, with new recognizers for each
+ point.
+
+ The word accuracy is (N - S - D - I) / N, where N is the number of
+ reference words and S, D and I are the substitutions, deletions and
+ insertions of the best alignment of the recognized words with the
+ reference words.  Words starting with '_', such as _SIL, are not
+ scored.  The cost of a point is the thread CPU time of decoding all
+ files divided by their duration.
+
+======================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tiesr_config.h"
+#include "tiesr_engine_api_sireco.h"
+
+#include "DecodeCorpus.h"
+
+
+/*--------------------------------
+  Constants
+  --------------------------------*/
+
+/* Maximum number of knobs in the grid, and values of each knob */
+#define SWEEP_MAX_KNOBS 8
+#define SWEEP_MAX_VALUES 64
+
+/* Maximum number of points in the grid */
+static const int SWEEP_MAX_POINTS = 4096;
+
+/* Maximum number of words in a reference or recognized word string */
+#define SWEEP_MAX_WORDS 256
+
+
+/*--------------------------------
+  Knobs
+  --------------------------------*/
+
+typedef void (*SweepApply_t)( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr,
+        int aIndex, short aValue );
+
+typedef struct SweepKnob
+{
+      const char* name;
+      SweepApply_t apply;
+
+      /* Index of the parameter for knobs that set one of several */
+      int index;
+} SweepKnob_t;
+
+static void apply_prune( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr,
+        int aIndex, short aValue )
+{
+   aEngine->SetTIesrPrune( aTIesr, aValue );
+}
+
+static void apply_tranwgt( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr,
+        int aIndex, short aValue )
+{
+   aEngine->SetTIesrTransiWeight( aTIesr, aValue );
+}
+
+static void apply_jacrate( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr,
+        int aIndex, short aValue )
+{
+   aEngine->SetTIesrJacRate( aTIesr, aValue );
+}
+
+static void apply_gauss( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr,
+        int aIndex, short aValue )
+{
+   unsigned short param[2] = { 0, 0 };
+
+   aEngine->GetTIesrGaussSelection( aTIesr, &param[0], &param[1] );
+   param[ aIndex ] = (unsigned short)aValue;
+   aEngine->SetTIesrGaussSelection( aTIesr, param[0], param[1] );
+}
+
+static void apply_orm( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr,
+        int aIndex, short aValue )
+{
+   short param[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+   unsigned short percent = 0;
+
+   aEngine->GetTIesrOnlineReferenceModel( &param[0], &param[1], &param[2],
+                                          &param[3], &param[4], &percent,
+                                          &param[6], &param[7], aTIesr );
+   if( aIndex == 5 )
+      percent = (unsigned short)aValue;
+   else
+      param[ aIndex ] = aValue;
+   aEngine->SetTIesrOnlineReferenceModel( param[0], param[1], param[2], param[3],
+                                          param[4], percent, param[6], param[7],
+                                          aTIesr );
+}
+
+static const SweepKnob_t KNOBS[] =
+{
+   { "prune", apply_prune, 0 },
+   { "tranwgt", apply_tranwgt, 0 },
+   { "gauss_core", apply_gauss, 0 },
+   { "gauss_inter", apply_gauss, 1 },
+   { "jacrate", apply_jacrate, 0 },
+   { "orm_frames", apply_orm, 0 },
+   { "orm_noise", apply_orm, 1 },
+   { "orm_llr_low", apply_orm, 2 },
+   { "orm_llr_high", apply_orm, 3 },
+   { "orm_count", apply_orm, 4 },
+   { "orm_percent", apply_orm, 5 },
+   { "orm_start", apply_orm, 6 },
+   { "orm_after_peak", apply_orm, 7 },
+   { NULL, NULL, 0 }
+};
+
+
+/*--------------------------------
+  Types
+  --------------------------------*/
+
+/* A knob in the grid and its values */
+typedef struct SweepAxis
+{
+      const SweepKnob_t* knob;
+      short values[ SWEEP_MAX_VALUES ];
+      int numValues;
+} SweepAxis_t;
+
+/* Settings and results of one point of the grid */
+typedef struct SweepPoint
+{
+      short values[ SWEEP_MAX_KNOBS ];
+
+      int files;
+      int failed;
+      long refWords;
+      long errors;
+      double accuracy;
+      double audioSeconds;
+      double cpuSeconds;
+      double wallSeconds;
+      double cost;
+
+      int pareto;
+} SweepPoint_t;
+
+typedef struct SweepOptions
+{
+      int jobs;
+      int memorySize;
+      const char* jacFile;
+      const char* treeFile;
+      int adapt;
+      double budget;
+      const char* outFile;
+      const char* listFile;
+      const char* grammarDir;
+} SweepOptions_t;
+
+typedef struct SweepState
+{
+      SweepOptions_t options;
+      DecodeCorpus_t corpus;
+
+      SweepAxis_t axes[ SWEEP_MAX_KNOBS ];
+      int numAxes;
+
+      SweepPoint_t* points;
+      int numPoints;
+
+      /* Point being decoded */
+      const SweepPoint_t* current;
+} SweepState_t;
+
+
+/*--------------------------------
+  Options
+  --------------------------------*/
+
+/* Parse knob=values into a new axis of the grid */
+static int parse_axis( SweepState_t* aState, const char* aSpec )
+{
+   const char* equals = strchr( aSpec, '=' );
+   const SweepKnob_t* knob;
+   SweepAxis_t* axis;
+   int first, last, step;
+
+   if( equals == NULL || aState->numAxes == SWEEP_MAX_KNOBS )
+      return 1;
+
+   for( knob = KNOBS; knob->name; knob++ )
+   {
+      if( strlen( knob->name ) == (size_t)( equals - aSpec ) &&
+          strncmp( knob->name, aSpec, equals - aSpec ) == 0 )
+         break;
+   }
+   if( knob->name == NULL )
+      return 1;
+
+   axis = &aState->axes[ aState->numAxes ];
+   axis->knob = knob;
+   axis->numValues = 0;
+
+   if( sscanf( equals + 1, "%d:%d:%d", &first, &last, &step ) == 3 )
+   {
+      if( step == 0 || ( last - first ) / step < 0 ||
+          ( last - first ) / step >= SWEEP_MAX_VALUES )
+         return 1;
+
+      for( ; step > 0 ? first <= last : first >= last; first += step )
+         axis->values[ axis->numValues++ ] = (short)first;
+   }
+   else
+   {
+      const char* value = equals + 1;
+
+      for( ;; )
+      {
+         char* end;
+         long v = strtol( value, &end, 10 );
+
+         if( end == value || axis->numValues == SWEEP_MAX_VALUES )
+            return 1;
+         axis->values[ axis->numValues++ ] = (short)v;
+
+         if( *end == '\0' )
+            break;
+         if( *end != ',' )
+            return 1;
+         value = end + 1;
+      }
+   }
+
+   aState->numAxes++;
+   return 0;
+}
+
+static int parse_options( int argc, char** argv, SweepState_t* aState )
+{
+   SweepOptions_t* options = &aState->options;
+   int arg;
+
+   options->jobs = 0;
+   options->memorySize = 0;
+   options->jacFile = NULL;
+   options->treeFile = NULL;
+   options->adapt = 1;
+   options->budget = -1.0;
+   options->outFile = NULL;
+
+   for( arg = 1; arg < argc && argv[arg][0] == '-'; arg++ )
+   {
+      const char* value = argv[arg][1] != '\0' && argv[arg][2] == '\0' &&
+         arg + 1 < argc ? argv[arg + 1] : NULL;
+
+      switch( argv[arg][1] )
+      {
+         case 'n':
+            if( argv[arg][2] != '\0' )
+               return 1;
+            options->adapt = 0;
+            continue;
+         case 'j':
+            if( value == NULL || ( options->jobs = atoi( value ) ) < 1 )
+               return 1;
+            break;
+         case 'm':
+            if( value == NULL || ( options->memorySize = atoi( value ) ) < 1 )
+               return 1;
+            break;
+         case 'b':
+            options->jacFile = value;
+            break;
+         case 't':
+            options->treeFile = value;
+            break;
+         case 'B':
+            if( value == NULL || ( options->budget = atof( value ) ) <= 0.0 )
+               return 1;
+            break;
+         case 'o':
+            options->outFile = value;
+            break;
+         case 'g':
+            if( value == NULL || parse_axis( aState, value ) )
+               return 1;
+            break;
+         default:
+            return 1;
+      }
+
+      if( value == NULL )
+         return 1;
+      arg++;
+   }
+
+   if( arg + 2 != argc || aState->numAxes == 0 )
+      return 1;
+
+   options->listFile = argv[arg];
+   options->grammarDir = argv[arg + 1];
+   return 0;
+}
+
+/* Create the points of the grid, with the last axis varying fastest */
+static int make_points( SweepState_t* aState )
+{
+   int numPoints = 1;
+   int a, p;
+
+   for( a = 0; a < aState->numAxes; a++ )
+   {
+      numPoints *= aState->axes[a].numValues;
+      if( numPoints > SWEEP_MAX_POINTS )
+         return 1;
+   }
+
+   aState->points = (SweepPoint_t*)calloc( numPoints, sizeof(SweepPoint_t) );
+   if( aState->points == NULL )
+      return 1;
+   aState->numPoints = numPoints;
+
+   for( p = 0; p < numPoints; p++ )
+   {
+      int rest = p;
+
+      for( a = aState->numAxes - 1; a >= 0; a-- )
+      {
+         const SweepAxis_t* axis = &aState->axes[a];
+         aState->points[p].values[a] = axis->values[ rest % axis->numValues ];
+         rest /= axis->numValues;
+      }
+   }
+   return 0;
+}
+
+
+/*--------------------------------
+  Scoring
+  --------------------------------*/
+
+/* Split a word string into the words that are scored */
+static int split_words( const char* aString, char* aCopy, char** aWords )
+{
+   int numWords = 0;
+   char* word;
+
+   if( aString == NULL )
+      return 0;
+
+   strcpy( aCopy, aString );
+   for( word = strtok( aCopy, " \t" ); word; word = strtok( NULL, " \t" ) )
+   {
+      if( word[0] != '_' && numWords < SWEEP_MAX_WORDS )
+         aWords[ numWords++ ] = word;
+   }
+   return numWords;
+}
+
+/* Number of substitutions, deletions and insertions of the best
+ alignment of the recognized words with the reference words */
+static int word_errors( char** aRef, int aNumRef, char** aHyp, int aNumHyp )
+{
+   int row[ SWEEP_MAX_WORDS + 1 ];
+   int r, h;
+
+   for( h = 0; h <= aNumHyp; h++ )
+      row[h] = h;
+
+   for( r = 1; r <= aNumRef; r++ )
+   {
+      int diagonal = row[0];
+
+      row[0] = r;
+      for( h = 1; h <= aNumHyp; h++ )
+      {
+         int best = diagonal + ( strcmp( aRef[r - 1], aHyp[h - 1] ) != 0 );
+
+         if( row[h] + 1 < best )
+            best = row[h] + 1;
+         if( row[h - 1] + 1 < best )
+            best = row[h - 1] + 1;
+
+         diagonal = row[h];
+         row[h] = best;
+      }
+   }
+   return row[ aNumHyp ];
+}
+
+/* Score the decoded corpus into the point */
+static int score_point( const DecodeCorpus_t* aCorpus, SweepPoint_t* aPoint )
+{
+   char* refWords[ SWEEP_MAX_WORDS ];
+   char* hypWords[ SWEEP_MAX_WORDS ];
+   int f;
+
+   for( f = 0; f < aCorpus->numFiles; f++ )
+   {
+      const DecodeFile_t* file = &aCorpus->files[f];
+      char* refCopy;
+      char* hypCopy;
+      int numRef, numHyp;
+
+      refCopy = (char*)malloc( strlen( file->reference ) + 1 );
+      hypCopy = (char*)malloc( file->words ? strlen( file->words ) + 1 : 1 );
+      if( refCopy == NULL || hypCopy == NULL )
+      {
+         free( refCopy );
+         free( hypCopy );
+         return 1;
+      }
+
+      numRef = split_words( file->reference, refCopy, refWords );
+      numHyp = split_words( file->words, hypCopy, hypWords );
+
+      aPoint->files++;
+      if( file->status != eTIesrEngineSuccess )
+         aPoint->failed++;
+      aPoint->refWords += numRef;
+      aPoint->errors += word_errors( refWords, numRef, hypWords, numHyp );
+      aPoint->audioSeconds += DecodeCorpus_seconds( file );
+      aPoint->cpuSeconds += file->cpuNs / 1e9;
+
+      free( refCopy );
+      free( hypCopy );
+   }
+
+   aPoint->accuracy = aPoint->refWords > 0 ?
+      (double)( aPoint->refWords - aPoint->errors ) / aPoint->refWords : 0.0;
+   aPoint->cost = aPoint->audioSeconds > 0.0 ?
+      aPoint->cpuSeconds / aPoint->audioSeconds : 0.0;
+   aPoint->wallSeconds = aCorpus->wallNs / 1e9;
+   return 0;
+}
+
+/* Mark the points that no other point beats in both accuracy and cost */
+static void mark_pareto( SweepState_t* aState )
+{
+   int p, q;
+
+   for( p = 0; p < aState->numPoints; p++ )
+   {
+      const SweepPoint_t* point = &aState->points[p];
+
+      aState->points[p].pareto = 1;
+      for( q = 0; q < aState->numPoints; q++ )
+      {
+         const SweepPoint_t* other = &aState->points[q];
+
+         if( other->accuracy >= point->accuracy && other->cost <= point->cost &&
+             ( other->accuracy > point->accuracy || other->cost < point->cost ) )
+         {
+            aState->points[p].pareto = 0;
+            break;
+         }
+      }
+   }
+}
+
+/* Most accurate point, then cheapest, within the budget, or -1 */
+static int recommend( const SweepState_t* aState )
+{
+   int best = -1;
+   int p;
+
+   if( aState->options.budget <= 0.0 )
+      return -1;
+
+   for( p = 0; p < aState->numPoints; p++ )
+   {
+      const SweepPoint_t* point = &aState->points[p];
+
+      if( point->cost > aState->options.budget )
+         continue;
+
+      if( best < 0 || point->accuracy > aState->points[best].accuracy ||
+          ( point->accuracy == aState->points[best].accuracy &&
+            point->cost < aState->points[best].cost ) )
+         best = p;
+   }
+   return best;
+}
+
+
+/*--------------------------------
+  Sweep
+  --------------------------------*/
+
+static void setup_point( TIesrEngineSIRECOType* aEngine, TIesr_t aTIesr, void* aArg )
+{
+   const SweepState_t* state = (const SweepState_t*)aArg;
+   int a;
+
+   for( a = 0; a < state->numAxes; a++ )
+   {
+      const SweepKnob_t* knob = state->axes[a].knob;
+      knob->apply( aEngine, aTIesr, knob->index, state->current->values[a] );
+   }
+}
+
+static void print_settings( FILE* aFp, const SweepState_t* aState,
+        const SweepPoint_t* aPoint, const char* aFormat )
+{
+   int a;
+
+   for( a = 0; a < aState->numAxes; a++ )
+      fprintf( aFp, aFormat, a ? ", " : "", aState->axes[a].knob->name,
+               aPoint->values[a] );
+}
+
+static int run_sweep( SweepState_t* aState )
+{
+   int p;
+
+   aState->corpus.setup = setup_point;
+   aState->corpus.setupArg = aState;
+
+   for( p = 0; p < aState->numPoints; p++ )
+   {
+      SweepPoint_t* point = &aState->points[p];
+      int w, opened = 0;
+
+      aState->current = point;
+      if( DecodeCorpus_run( &aState->corpus ) )
+         return 1;
+
+      for( w = 0; w < aState->corpus.numWorkers; w++ )
+         opened += ! aState->corpus.workers[w].failed;
+      if( opened == 0 || score_point( &aState->corpus, point ) )
+         return 1;
+
+      fprintf( stderr, "point %d/%d: ", p + 1, aState->numPoints );
+      print_settings( stderr, aState, point, "%s%s=%d" );
+      fprintf( stderr, "  accuracy %.4f cost %.4f failed %d\n",
+               point->accuracy, point->cost, point->failed );
+   }
+
+   mark_pareto( aState );
+   return 0;
+}
+
+static int write_results( const SweepState_t* aState )
+{
+   FILE* fp = stdout;
+   int p, best;
+
+   if( aState->options.outFile )
+   {
+      fp = fopen( aState->options.outFile, "w" );
+      if( fp == NULL )
+         return 1;
+   }
+
+   fprintf( fp, "{\n  \"files\": %d,\n  \"recognizers\": %d,\n  \"adapt\": %s,\n",
+            aState->corpus.numFiles, aState->corpus.jobs,
+            aState->corpus.adapt ? "true" : "false" );
+
+   fprintf( fp, "  \"points\": [" );
+   for( p = 0; p < aState->numPoints; p++ )
+   {
+      const SweepPoint_t* point = &aState->points[p];
+
+      fprintf( fp, "%s\n    { \"settings\": { ", p ? "," : "" );
+      print_settings( fp, aState, point, "%s\"%s\": %d" );
+      fprintf( fp, " },\n      \"accuracy\": %.5f, \"ref_words\": %ld, \"errors\": %ld, "
+               "\"failed\": %d,\n      \"cpu_per_audio_s\": %.5f, \"audio_s\": %.3f, "
+               "\"cpu_s\": %.3f, \"wall_s\": %.3f, \"pareto\": %s }",
+               point->accuracy, point->refWords, point->errors, point->failed,
+               point->cost, point->audioSeconds, point->cpuSeconds, point->wallSeconds,
+               point->pareto ? "true" : "false" );
+   }
+   fprintf( fp, "\n  ],\n" );
+
+   /* Frontier in order of increasing cost */
+   fprintf( fp, "  \"pareto\": [" );
+   {
+      int* order = (int*)malloc( aState->numPoints * sizeof(int) );
+      int numOrder = 0, i, j;
+
+      if( order != NULL )
+      {
+         for( p = 0; p < aState->numPoints; p++ )
+         {
+            if( ! aState->points[p].pareto )
+               continue;
+            for( i = numOrder; i > 0 &&
+                    aState->points[ order[i - 1] ].cost > aState->points[p].cost; i-- )
+               order[i] = order[i - 1];
+            order[i] = p;
+            numOrder++;
+         }
+         for( j = 0; j < numOrder; j++ )
+            fprintf( fp, "%s%d", j ? ", " : " ", order[j] );
+         free( order );
+      }
+   }
+   fprintf( fp, " ],\n" );
+
+   best = recommend( aState );
+   if( aState->options.budget > 0.0 )
+      fprintf( fp, "  \"budget\": %.5f,\n", aState->options.budget );
+   else
+      fprintf( fp, "  \"budget\": null,\n" );
+
+   if( best < 0 )
+      fprintf( fp, "  \"recommended\": null\n}\n" );
+   else
+   {
+      fprintf( fp, "  \"recommended\": { \"point\": %d, \"settings\": { ", best );
+      print_settings( fp, aState, &aState->points[best], "%s\"%s\": %d" );
+      fprintf( fp, " } }\n}\n" );
+
+      fprintf( stderr, "recommended: " );
+      print_settings( stderr, aState, &aState->points[best], "%s%s=%d" );
+      fprintf( stderr, "\n" );
+   }
+
+   if( fp != stdout )
+      fclose( fp );
+   return 0;
+}
+
+
+int main( int argc, char** argv )
+{
+   SweepState_t* state;
+   DecodeCorpus_t* corpus;
+   int failed = 0;
+   int f;
+
+   state = (SweepState_t*)calloc( 1, sizeof(SweepState_t) );
+   if( state == NULL )
+      return 1;
+
+   if( parse_options( argc, argv, state ) )
+   {
+      fprintf( stderr, "Usage: %s [-j jobs] [-m memorySize] [-b jacFile] [-t treeFile] "
+               "[-n] [-B budget] [-o outFile] -g knob=values [-g knob=values ...] "
+               "listFile grammarDir\n", argv[0] );
+      free( state );
+      return 1;
+   }
+
+   if( DecodeCorpus_init( &state->corpus, state->options.grammarDir ) )
+   {
+      fprintf( stderr, "Grammar directory name is too long\n" );
+      free( state );
+      return 1;
+   }
+
+   corpus = &state->corpus;
+   if( state->options.jobs )
+      corpus->jobs = state->options.jobs;
+   if( state->options.memorySize )
+      corpus->memorySize = state->options.memorySize;
+   if( state->options.jacFile )
+      strncpy( corpus->jacFile, state->options.jacFile, DECODE_MAX_PATH - 1 );
+   corpus->treeFile = state->options.treeFile;
+   corpus->adapt = state->options.adapt;
+
+   if( DecodeCorpus_read_list( corpus, state->options.listFile ) )
+   {
+      fprintf( stderr, "Failed to read file list %s\n", state->options.listFile );
+      failed = 1;
+   }
+   else
+   {
+      for( f = 0; f < corpus->numFiles; f++ )
+      {
+         if( corpus->files[f].reference == NULL )
+         {
+            fprintf( stderr, "File %s has no reference words\n", corpus->files[f].name );
+            failed = 1;
+         }
+      }
+   }
+
+   if( ! failed && make_points( state ) )
+   {
+      fprintf( stderr, "Grid has more than %d points\n", SWEEP_MAX_POINTS );
+      failed = 1;
+   }
+
+   if( ! failed && run_sweep( state ) )
+   {
+      fprintf( stderr, "Failed to decode the corpus\n" );
+      failed = 1;
+   }
+
+   if( ! failed && write_results( state ) )
+   {
+      fprintf( stderr, "Failed to write results %s\n", state->options.outFile );
+      failed = 1;
+   }
+
+   DecodeCorpus_free( corpus );
+   free( state->points );
+   free( state );
+   return failed;
+}
@@ -1298,6 +1298,31 @@ void CTIesrDict::map_phone( char *iphone, char *ophone )
 }
 
 
+//--------------------------
+// next_token
+//
+// Split the next token delimited by DELIMIT from the string at *aPos,
+// as strtok does, but without its static state, so that dictionaries
+// may be used by several threads.  Returns NULL when no token is left.
+//
+
+static char *next_token( char **aPos )
+{
+   char *token = *aPos + strspn( *aPos, DELIMIT );
+   char *end;
+
+   if( *token == '\0' )
+      return NULL;
+
+   end = token + strcspn( token, DELIMIT );
+   if( *end )
+      *end++ = '\0';
+
+   *aPos = end;
+   return token;
+}
+
+
 //--------------------------
 // map_pron
 //
@@ -1308,20 +1333,17 @@ void CTIesrDict::map_pron( char *ipron, char *opron )
 {
    char *ptr;
    char buf[ MAX_STR ], ophone[ MAX_STR ];
+   char *pos = buf;
 
    *opron = '\0';
    strcpy( buf, ipron );
 
-   ptr = strtok( buf, DELIMIT );
-
-   while( ptr )
+   while( ( ptr = next_token( &pos ) ) != NULL )
    {
 
       map_phone( ptr, ophone );
       strcat( opron, ophone );
       strcat( opron, " " );
-
-      ptr = strtok( NULL, DELIMIT );
    }
 
 }
@@ -1490,11 +1512,9 @@ void CTIesrDict::pron2bin( char *str, char *pron )
    int i = 1;
    char *ptr;
 
-   ptr = strtok( str, DELIMIT );
-   while( ptr )
+   while( ( ptr = next_token( &str ) ) != NULL )
    {
       pron[ i++ ] = get_phone_idx( ptr );
-      ptr = strtok( NULL, DELIMIT );
    }
 
    pron[ 0 ] = i - 1;
@@ -43,6 +43,11 @@ OBJECTFILES= \
 	${OBJECTDIR}/_ext/_DOTDOT/src/dist.o \
 	${OBJECTDIR}/_ext/_DOTDOT/src/sbc.o \
 	${OBJECTDIR}/_ext/_DOTDOT/src/search.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/trace.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/profile.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/image.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/slot.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/bundle.o \
 	${OBJECTDIR}/_ext/_DOTDOT/src/volume.o
 
 # C Compiler Flags
@@ -129,6 +134,31 @@ ${OBJECTDIR}/_ext/_DOTDOT/src/search.o: nbproject/Makefile-${CND_CONF}.mk ../src
 	${RM} $@.d
 	$(COMPILE.cc) -O2 -Wall -DTIESRENGINECOREAPI_EXPORTS -DWIN32 -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/search.o ../src/search.cpp
 
+${OBJECTDIR}/_ext/_DOTDOT/src/trace.o: nbproject/Makefile-${CND_CONF}.mk ../src/trace.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -Wall -DTIESRENGINECOREAPI_EXPORTS -DWIN32 -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/trace.o ../src/trace.cpp
+
+${OBJECTDIR}/_ext/_DOTDOT/src/profile.o: nbproject/Makefile-${CND_CONF}.mk ../src/profile.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -Wall -DTIESRENGINECOREAPI_EXPORTS -DWIN32 -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/profile.o ../src/profile.cpp
+
+${OBJECTDIR}/_ext/_DOTDOT/src/image.o: nbproject/Makefile-${CND_CONF}.mk ../src/image.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -Wall -DTIESRENGINECOREAPI_EXPORTS -DWIN32 -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/image.o ../src/image.cpp
+
+${OBJECTDIR}/_ext/_DOTDOT/src/slot.o: nbproject/Makefile-${CND_CONF}.mk ../src/slot.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -Wall -DTIESRENGINECOREAPI_EXPORTS -DWIN32 -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/slot.o ../src/slot.cpp
+
+${OBJECTDIR}/_ext/_DOTDOT/src/bundle.o: nbproject/Makefile-${CND_CONF}.mk ../src/bundle.cpp 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.cc) -O2 -Wall -DTIESRENGINECOREAPI_EXPORTS -DWIN32 -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/bundle.o ../src/bundle.cpp
+
 ${OBJECTDIR}/_ext/_DOTDOT/src/volume.o: nbproject/Makefile-${CND_CONF}.mk ../src/volume.cpp 
 	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
 	${RM} $@.d
@@ -0,0 +1,590 @@
+/*=======================================================================
+
+ *
+ * TestTIesrEngine.cpp
+ *
+ * Program to test the TIesrEngine fixed point math functions.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This program sweeps the fixed point math functions of TIesrEngineCore
+ over their input ranges and compares each result with a reference
+ copy of the original polynomial implementation held in this file.
+ The lookup tables of dist.h and the faster normalization in
+ log_polyfit must reproduce the reference results exactly.  The
+ program prints each mismatch found, and returns nonzero if any
+ function does not match.
+
+ The tables of dist.h are generated from the reference implementations
+ by the -t option, which prints them in the layout used in dist.h.
+
+ The command line is:
+
+ testtiesrengine [-t]
+
+=====================================================================*/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "tiesr_config.h"
+#include "tiesrcommonmacros.h"
+#include "dist_user.h"
+
+/* Maximum number of mismatches printed for each function */
+#define MAX_PRINT  10
+
+/* Table sizes, which must agree with dist.h */
+#define LOGSUM_TABLE_SIZE 449
+#define EXPN_Q6_TABLE_SIZE 688
+#define POWPOLY_TABLE_SIZE 512
+
+/* Number of values passed to log_polyfit_vector at a time */
+#define VECTOR_SIZE  256
+
+
+/*----------------------------------------------------------------
+  Reference implementations.  These are the polynomial versions of
+  dist.cpp that the dist.h tables were generated from, and the
+  original one bit at a time normalization of log_polyfit.
+  ----------------------------------------------------------------*/
+
+static unsigned short ref_expn( short x, short qpt )
+{
+   /* log2(e) in Q14 */
+   short ln2e = 23637;
+
+   /* order 4 polynomial for 2^x,  in Q14 */
+   short coef_pow2[5] = { 158, 909, 3936, 11357, 16384 };
+
+   long temp;
+   long itemp;
+   unsigned long ftemp;
+   unsigned short result;
+   short frac, s_temp;
+   short coef;
+
+   temp = ln2e*x;
+   temp = -temp;
+
+   itemp =  temp >> (qpt+14);
+   if( itemp >= 16 )
+      return 0;
+   else
+   {
+      s_temp = (short) itemp;
+      result = ( 32768 >> s_temp );
+   }
+
+   ftemp = itemp << (qpt+14);
+   ftemp = temp & ~ftemp;
+   if( qpt + 14 <= 15 )
+   {
+      ftemp <<= 15 - qpt - 14;
+   }
+   else
+   {
+      ftemp += ( 1 << ( qpt + 14 - 16 ) );
+      ftemp >>= ( qpt + 14 - 15 );
+   }
+
+   frac = (short)ftemp;
+   if( frac >= 16384 )
+   {
+      result >>= 1;
+      frac += -32768;;
+   }
+   frac = -frac;
+
+   s_temp = coef_pow2[0];
+   for( coef = 1; coef < 5; coef++ )
+   {
+      temp = s_temp*frac;
+      temp += (long)( coef_pow2[coef] << 15 );
+      temp += (long)1<<14;
+      s_temp = (short)( temp >>= 15 );
+   }
+
+   temp = result * (unsigned short)s_temp;
+   temp += 1<<13;
+   return (unsigned short)( temp >> 14 );
+}
+
+
+static short ref_log_one( unsigned short x )
+{
+   short coef_lnopx[5] = { -1801, 7104, -15220, 32623, 4 };
+
+   long temp;
+   short s_temp;
+   short data;
+   short coef;
+
+   if( x == 32768 )
+      return( 22713 );
+
+   data = (short)x;
+   s_temp = coef_lnopx[0];
+   for( coef = 1; coef < 5; coef++ )
+   {
+      temp = s_temp * data;
+      temp += (long)( coef_lnopx[coef] << 15 );
+      temp += 1<<14;
+      s_temp = (short)( temp >> 15 );
+   }
+
+   return  s_temp;
+}
+
+
+/* Q6 term added to lna by hlr_logsum for a difference -d */
+static short ref_logsum_term( short d )
+{
+   long temp;
+
+   temp = (long)ref_log_one( ref_expn( -d, 6 ) );
+   temp += 1<<8;
+   temp >>= 9;
+   return (short)temp;
+}
+
+
+static short ref_logsum( short lna, short lnb )
+{
+   short s_temp;
+   long temp;
+   long diff;
+
+   if( lna < lnb )
+   {
+      s_temp = lnb;
+      lnb = lna;
+      lna = s_temp;
+   }
+
+   diff = (long)lnb;
+   diff -= (long)lna;
+   if( diff < -448 )
+      return( lna );
+
+   temp = (long)ref_log_one( ref_expn( (short)diff, 6 ) );
+   temp += lna << 9;
+   temp += 1<<8;
+   temp >>= 9;
+
+   if( temp > 32767 )
+      temp = 32767;
+
+   return (short)temp;
+}
+
+
+static const short ref_coef_logpoly[ LOGPOLYORD + 1 ] = {
+  -781, 5338, -16182, 28637, -32768, 25419, -13767, 5640, -1536};
+
+static short ref_log_polyfit( long value, short compensate )
+{
+  short result = 0;
+  short data;
+  short norm;
+  short i;
+  long  tmp;
+
+  if ( value <= 0 )
+    value = 1;
+
+  for (norm = 0; value < 0x40000000; norm++)
+    value <<= 1;
+
+  data = (short) ( value >> 16 );
+
+  result = ref_coef_logpoly[ 0 ];
+
+  for (i = LOGPOLYORD - 1; i >= 0; i--) {
+
+    tmp = result * data;
+    tmp <<= 1;
+    tmp += ( (long) ref_coef_logpoly[ LOGPOLYORD - i ] << 16 );
+    result = (short)  LONG_RIGHT_SHIFT_N( tmp, 16 );
+  }
+
+  tmp = result * MAX_COEF_LOGPOLY;
+  tmp <<= 8;
+
+  tmp >>= 6;
+  tmp -= (long) norm << 25;
+  tmp -= (long) compensate << 25;
+
+  tmp += 1040187392;
+
+  result =  LONG_RIGHT_SHIFT_N( tmp , 16 );
+
+  return result;
+}
+
+
+/* POWPOLYORD polynomial at the Q9 fraction data, in Q14 */
+static short ref_powpoly( short data )
+{
+  short result;
+  short i;
+  long  tmp;
+
+  result = coef_powpoly[ 0 ];
+
+  for (i = POWPOLYORD - 1; i >= 0; i--) {
+
+    tmp = result * data;
+    tmp += ( (long) coef_powpoly[ POWPOLYORD - i ] << 9 );
+    result = (short)  LONG_RIGHT_SHIFT_N( tmp, 9 );
+  }
+
+  return result;
+}
+
+
+static long ref_pow_polyfit( short value )
+{
+  short result;
+  short norm;
+  short i;
+  long  tmp;
+
+  if ( value < -512 ) return (long) 0;
+  else if ( value <= 0) return (long) 1;
+  if ( value > 15870 ) return (long) 2147483647;
+
+  norm = (value &  0xfe00) >> 9;
+  result = ref_powpoly( value & ~0xfe00 );
+
+  tmp = result;
+  if ( norm > 14 ) {
+    tmp = (long) tmp << ( norm - 14 );
+  }
+  else{
+    i = 14-norm-1;
+    if (i>=0)
+      tmp += (1 << i);
+    tmp =  tmp >> ( 14 - norm );
+  }
+
+  return tmp;
+}
+
+
+static long ref_sqrt( long x )
+{
+  long y0, y1, z;
+
+  if (x <= 0) {
+    y1 = 0;
+  } else {
+    y1 = x >> 1;
+    if (y1 == 0) return x;
+    else {
+      do {
+	y0 = y1;
+	z = x / y0;
+	y1 = (y0 + z) >> 1;
+      } while (labs(y0 - y1) > 1);
+    }
+  }
+  return y1;
+}
+
+
+/*----------------------------------------------------------------
+  print_tables
+
+  Print the dist.h tables generated from the reference implementations.
+  ----------------------------------------------------------------*/
+static void print_tables( void )
+{
+  int d;
+
+  printf( "static const short logsum_table[ LOGSUM_TABLE_SIZE ] = {\n" );
+  for( d = 0; d < LOGSUM_TABLE_SIZE; d++ )
+  {
+    printf( "%s%2d%s", ( d % 16 ) ? " " : "  ", ref_logsum_term( (short)d ),
+            ( d == LOGSUM_TABLE_SIZE - 1 ) ? "\n" : ( ( d % 16 == 15 ) ? ",\n" : "," ) );
+  }
+  printf( "};\n\n" );
+
+  printf( "static const unsigned short expn_q6_table[ EXPN_Q6_TABLE_SIZE ] = {\n" );
+  for( d = 0; d < EXPN_Q6_TABLE_SIZE; d++ )
+  {
+    printf( "%s%5u%s", ( d % 10 ) ? " " : "  ", ref_expn( (short)-d, 6 ),
+            ( d == EXPN_Q6_TABLE_SIZE - 1 ) ? "\n" : ( ( d % 10 == 9 ) ? ",\n" : "," ) );
+  }
+  printf( "};\n\n" );
+
+  printf( "static const short powpoly_table[ POWPOLY_TABLE_SIZE ] = {\n" );
+  for( d = 0; d < POWPOLY_TABLE_SIZE; d++ )
+  {
+    printf( "%s%5d%s", ( d % 10 ) ? " " : "  ", ref_powpoly( (short)d ),
+            ( d == POWPOLY_TABLE_SIZE - 1 ) ? "\n" : ( ( d % 10 == 9 ) ? ",\n" : "," ) );
+  }
+  printf( "};\n" );
+}
+
+
+/*----------------------------------------------------------------
+  Sweep tests.  Each returns the number of mismatches found.
+  ----------------------------------------------------------------*/
+
+static long test_expn( void )
+{
+  long errors = 0;
+  long x;
+  short qpt;
+  unsigned short r, ref;
+
+  for( qpt = 0; qpt < 16; qpt++ )
+  {
+    for( x = -32768; x <= 0; x++ )
+    {
+      r = hlr_expn( (short)x, qpt );
+      ref = ref_expn( (short)x, qpt );
+      if( r != ref && errors++ < MAX_PRINT )
+        printf( "hlr_expn( %ld, %d ) = %u, expected %u\n", x, qpt, r, ref );
+    }
+  }
+  return errors;
+}
+
+
+static long test_log_one( void )
+{
+  long errors = 0;
+  long x;
+  short r, ref;
+
+  for( x = 0; x <= 32768; x++ )
+  {
+    r = hlr_log_one( (unsigned short)x );
+    ref = ref_log_one( (unsigned short)x );
+    if( r != ref && errors++ < MAX_PRINT )
+      printf( "hlr_log_one( %ld ) = %d, expected %d\n", x, r, ref );
+  }
+  return errors;
+}
+
+
+/* Every lna, with differences spanning the cutoff, in both orders */
+static long test_logsum( void )
+{
+  long errors = 0;
+  long lna, lnb, d;
+  short r, ref;
+
+  for( lna = -32768; lna <= 32767; lna++ )
+  {
+    for( d = 0; d <= LOGSUM_TABLE_SIZE + 16; d++ )
+    {
+      lnb = lna - d;
+      if( lnb < -32768 )
+        break;
+
+      ref = ref_logsum( (short)lna, (short)lnb );
+
+      r = hlr_logsum( (short)lna, (short)lnb );
+      if( r != ref && errors++ < MAX_PRINT )
+        printf( "hlr_logsum( %ld, %ld ) = %d, expected %d\n", lna, lnb, r, ref );
+
+      r = hlr_logsum( (short)lnb, (short)lna );
+      if( r != ref && errors++ < MAX_PRINT )
+        printf( "hlr_logsum( %ld, %ld ) = %d, expected %d\n", lnb, lna, r, ref );
+    }
+  }
+  return errors;
+}
+
+
+static long check_log_polyfit( long value, short compensate, long errors )
+{
+  short r, ref;
+
+  r = log_polyfit( value, compensate );
+  ref = ref_log_polyfit( value, compensate );
+  if( r != ref && errors++ < MAX_PRINT )
+    printf( "log_polyfit( %ld, %d ) = %d, expected %d\n", value, compensate, r, ref );
+  return errors;
+}
+
+
+/* All values below 2^24, and every leading 16 bit pattern shifted to
+   each position above that, since only the top 16 bits of the
+   normalized value are used. */
+static long test_log_polyfit( void )
+{
+  static const short compensate[] = { 0, 9, 14, 20, -3 };
+  long errors = 0;
+  long value;
+  long top;
+  short shift;
+  unsigned short c;
+
+  for( c = 0; c < sizeof(compensate)/sizeof(compensate[0]); c++ )
+  {
+    errors = check_log_polyfit( 0, compensate[c], errors );
+    errors = check_log_polyfit( -1, compensate[c], errors );
+
+    for( value = 1; value < (1L << 24); value++ )
+      errors = check_log_polyfit( value, compensate[c], errors );
+
+    for( shift = 9; shift <= 15; shift++ )
+    {
+      for( top = 0x8000; top <= 0xFFFF; top++ )
+      {
+        value = top << shift;
+        errors = check_log_polyfit( value, compensate[c], errors );
+        errors = check_log_polyfit( value + (1L << shift) - 1, compensate[c], errors );
+      }
+    }
+  }
+  return errors;
+}
+
+
+/* log_polyfit_vector must give the same result as log_polyfit */
+static long test_log_polyfit_vector( void )
+{
+  long errors = 0;
+  long value[ VECTOR_SIZE ];
+  short result[ VECTOR_SIZE ];
+  long start;
+  short i;
+
+  for( start = 0; start < (1L << 20); start += VECTOR_SIZE )
+  {
+    for( i = 0; i < VECTOR_SIZE; i++ )
+      value[i] = ( start + i ) * 1031 - 4096;
+
+    log_polyfit_vector( value, result, VECTOR_SIZE, 9 );
+
+    for( i = 0; i < VECTOR_SIZE; i++ )
+    {
+      if( result[i] != log_polyfit( value[i], 9 ) && errors++ < MAX_PRINT )
+        printf( "log_polyfit_vector( %ld, 9 ) = %d, expected %d\n",
+                value[i], result[i], log_polyfit( value[i], 9 ) );
+    }
+  }
+  return errors;
+}
+
+
+static long test_pow_polyfit( void )
+{
+  long errors = 0;
+  long x;
+  long r, ref;
+
+  for( x = -32768; x <= 32767; x++ )
+  {
+    r = pow_polyfit( (short)x );
+    ref = ref_pow_polyfit( (short)x );
+    if( r != ref && errors++ < MAX_PRINT )
+      printf( "pow_polyfit( %ld ) = %ld, expected %ld\n", x, r, ref );
+  }
+  return errors;
+}
+
+
+static long check_sqrt( long x, long errors )
+{
+  long r, ref;
+  double root;
+
+  r = fx_sqrt( x );
+  ref = ref_sqrt( x );
+
+  /* Newton iteration stops within one of the integer root */
+  root = ( x > 0 ) ? (double)(long)sqrt( (double)x ) : 0.0;
+  if( ( r != ref || r < root - 1.0 || r > root + 1.0 ) && errors++ < MAX_PRINT )
+    printf( "fx_sqrt( %ld ) = %ld, expected %ld\n", x, r, ref );
+  return errors;
+}
+
+
+static long test_sqrt( void )
+{
+  long errors = 0;
+  long x;
+  long top;
+  short shift;
+
+  for( x = -16; x < (1L << 24); x++ )
+    errors = check_sqrt( x, errors );
+
+  for( shift = 8; shift <= 15; shift++ )
+  {
+    for( top = 0x8000; top <= 0xFFFF; top += 7 )
+      errors = check_sqrt( top << shift, errors );
+  }
+
+  errors = check_sqrt( 2147483647L, errors );
+  return errors;
+}
+
+
+typedef struct {
+  const char *name;
+  long (*test)( void );
+} TestType;
+
+static const TestType tests[] = {
+  { "hlr_expn", test_expn },
+  { "hlr_log_one", test_log_one },
+  { "hlr_logsum", test_logsum },
+  { "log_polyfit", test_log_polyfit },
+  { "log_polyfit_vector", test_log_polyfit_vector },
+  { "pow_polyfit", test_pow_polyfit },
+  { "fx_sqrt", test_sqrt }
+};
+
+
+int main( int argc, char** argv )
+{
+  unsigned short t;
+  long errors;
+  int failed = 0;
+
+  if( argc > 1 )
+  {
+    if( strcmp( argv[1], "-t" ) != 0 )
+    {
+      printf( "testtiesrengine [-t]\n" );
+      exit(1);
+    }
+
+    print_tables();
+    return 0;
+  }
+
+  for( t = 0; t < sizeof(tests)/sizeof(tests[0]); t++ )
+  {
+    errors = tests[t].test();
+    printf( "%-20s %s", tests[t].name, errors ? "FAIL" : "ok" );
+    if( errors )
+    {
+      printf( " (%ld mismatches)", errors );
+      failed = 1;
+    }
+    printf( "\n" );
+  }
+
+  return failed;
+}
@@ -0,0 +1,89 @@
+/*=======================================================================
+
+ *
+ * bundle.cpp
+ *
+ * Access to the files of TIesr model bundles.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ The format of a bundle is described in bundle_user.h.  Models are
+ loaded from a bundle by load_models_bundle in load.cpp.
+
+======================================================================*/
+
+/* Headers required by Windows OS */
+#if defined (WIN32) || defined (WINCE)
+#include <windows.h>
+#endif
+
+#include <string.h>
+
+#include "tiesr_config.h"
+#include "bundle_user.h"
+
+
+/* Identifier of bundles */
+static const char BUNDLE_MAGIC[4] = { 'T', 'I', 'M', 'B' };
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API Boolean bundle_check( const void *aBundle )
+{
+   const BundleHeaderType *header = (const BundleHeaderType*) aBundle;
+   const BundleFileType *file = (const BundleFileType*) ( header + 1 );
+   unsigned int tableEnd;
+   unsigned short f;
+
+   if( !aBundle ||
+       memcmp( header->magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC) ) != 0 ||
+       header->version != BUNDLE_VERSION )
+      return FALSE;
+
+   tableEnd = sizeof(BundleHeaderType) + header->n_files * sizeof(BundleFileType);
+   if( tableEnd > header->size )
+      return FALSE;
+
+   for( f = 0; f < header->n_files; f++, file++ )
+   {
+      if( memchr( file->name, '\0', BUNDLE_NAME_SIZE ) == NULL ||
+	  file->offset < tableEnd ||
+	  file->offset > header->size ||
+	  file->size > header->size - file->offset )
+	 return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API const unsigned char* bundle_file( const void *aBundle,
+							 const char *aName,
+							 unsigned int *aSize )
+{
+   const BundleHeaderType *header = (const BundleHeaderType*) aBundle;
+   const BundleFileType *file = (const BundleFileType*) ( header + 1 );
+   unsigned short f;
+
+   for( f = 0; f < header->n_files; f++, file++ )
+   {
+      if( strcmp( file->name, aName ) == 0 )
+      {
+	 *aSize = file->size;
+	 return (const unsigned char*) aBundle + file->offset;
+      }
+   }
+
+   return NULL;
+}
@@ -0,0 +1,143 @@
+/*=======================================================================
+
+ *
+ * bundle_user.h
+ *
+ * Header for interface of TIesr model bundles.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ A model bundle holds the files of a grammar directory in one block of
+ memory, so that a grammar built by TIesrFlex can be given to the
+ engine without writing and reading files.  The files are the same as
+ those of the directory, and load_models_bundle reads them from the
+ bundle as load_models reads them from the directory.
+
+ A bundle is a header, followed by a table locating each file in the
+ bundle, followed by the file contents, each aligned to BUNDLE_ALIGN
+ bytes.  The header and table are in the byte order of the machine
+ that made the bundle:
+
+   char magic[4]              "TIMB"
+   unsigned short version     BUNDLE_VERSION
+   unsigned short n_files     number of files
+   unsigned int size          bytes in the bundle
+
+ followed by n_files entries of:
+
+   char name[BUNDLE_NAME_SIZE]  file name, ending with '\0'
+   unsigned int offset          bytes from the start of the bundle
+   unsigned int size            bytes of the file
+
+======================================================================*/
+
+#ifndef BUNDLE_USER_H
+#define BUNDLE_USER_H
+
+
+/*--------------------------------------------------------------
+The Windows method of exporting functions from a DLL.
+---------------------------------------------------------------*/
+#if defined (WIN32) || defined (WINCE)
+
+/* If it is not defined already, define a macro that does
+Windows format export of DLL functions */
+#ifndef TIESRENGINECOREAPI_API
+
+// The following ifdef block is the standard way of creating macros which
+// make exporting from a DLL simpler. All files within this DLL are compiled
+// with the TIESRENGINECOREAPI_EXPORTS symbol defined on the command line.
+// This symbol should not be defined on any project that uses this DLL.
+// This way any other project whose source files include this file see
+// TIESRENGINECOREAPI_API functions as being imported from a DLL,
+// whereas this DLL sees symbols defined with this macro as being exported.
+#ifdef TIESRENGINECOREAPI_EXPORTS
+#define TIESRENGINECOREAPI_API __declspec(dllexport)
+#else
+#define TIESRENGINECOREAPI_API __declspec(dllimport)
+#endif
+#endif
+
+#else
+
+#ifndef TIESRENGINECOREAPI_API
+#define TIESRENGINECOREAPI_API
+#endif
+
+#endif
+/*--------------------------------------------------------------------*/
+
+
+#include "tiesr_config.h"
+#include "status.h"
+#include "gmhmm_type.h"
+
+
+/* Version of the bundle format */
+#define BUNDLE_VERSION 1
+
+/* Alignment of files in a bundle, in bytes */
+#define BUNDLE_ALIGN 8
+
+/* Size of a file name in the table of a bundle */
+#define BUNDLE_NAME_SIZE 16
+
+
+typedef struct
+{
+      char magic[4];
+      unsigned short version;
+      unsigned short n_files;
+      unsigned int size;
+} BundleHeaderType;
+
+
+typedef struct
+{
+      char name[ BUNDLE_NAME_SIZE ];
+      unsigned int offset;
+      unsigned int size;
+} BundleFileType;
+
+
+/*----------------------------------------------------------------
+ bundle_check
+
+ Check that a bundle is well formed: the header is of this format and
+ version, and each file lies within the bundle.
+ --------------------------------*/
+TIESRENGINECOREAPI_API Boolean bundle_check( const void *aBundle );
+
+
+/*----------------------------------------------------------------
+ bundle_file
+
+ Find a file of a bundle by name.  Returns the file contents and sets
+ their size in bytes, or returns NULL if the bundle has no such file.
+ --------------------------------*/
+TIESRENGINECOREAPI_API const unsigned char* bundle_file( const void *aBundle,
+							 const char *aName,
+							 unsigned int *aSize );
+
+
+/*----------------------------------------------------------------
+ load_models_bundle
+
+ Set the models and grammar of the ASR structure from a bundle, in
+ place of load_models.  The bundle is not copied, and must be kept
+ by the caller until free_models.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType load_models_bundle( const void *aBundle,
+								 gmhmm_type *gv );
+
+#endif
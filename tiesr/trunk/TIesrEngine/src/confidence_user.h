@@ -58,6 +58,7 @@ Windows format export of DLL functions */
 #include "tiesrcommonmacros.h"
 #include "status.h"
 #include "gmhmm_type.h"
+#include "profile_user.h"
 #include "tiesr_config.h"
 #include "search_user.h"
 
@@ -176,6 +177,13 @@ TIESRENGINECOREAPI_API void cm_load(FILE*fp, gmhmm_type *gv);
 TIESRENGINECOREAPI_API void cm_save(FILE *fp,
 	     gmhmm_type* gv);
 
+/* save and load the confidence measure parameters of an adaptation
+   profile snapshot */
+TIESRENGINECOREAPI_API void cm_save_profile(TIesrProfileBufType* aBuf,
+					    gmhmm_type* gv);
+TIESRENGINECOREAPI_API void cm_load_profile(TIesrProfileBufType* aBuf,
+					    gmhmm_type* gv);
+
 /* return confidence score */
 short cm_score(gmhmm_type *gv);
 
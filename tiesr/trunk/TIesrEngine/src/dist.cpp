@@ -38,6 +38,10 @@
 
 #include "tiesr_config.h"
 #include "dist_user.h"
+#include "dist.h"
+#ifdef RAPID_JAC
+#include "rapidsearch_user.h"
+#endif
 
 /* prototypes */
 
@@ -49,6 +53,12 @@
   supports Viterbi mixtures, full mixture log likelihood, and mixture
   component likelihood calculation.
 
+  Although gv is const, with RAPID_JAC a mean that has not been
+  compensated since the JAC estimates changed is compensated here by
+  rj_lazy_mean, which writes the mean, its epoch and the search
+  statistics.  Callers running in several threads must compensate the
+  means they use beforehand, as JAC_update does.
+
   ----------------------------------------------------------------*/
 
 TIESRENGINECOREAPI_API short /*Q6 */ hlr_gauss_obs_score_f(const short *feature, int pdf_idx,
@@ -91,7 +101,12 @@ TIESRENGINECOREAPI_API short /*Q6 */ hlr_gauss_obs_score_f(const short *feature,
 
   for (i = imin; i < imax; i++) {      /* n mixtures */
 #ifndef BIT8MEAN
+#ifdef RAPID_JAC
+    /* a lazily compensated mean is written on first use */
+    mu     = RJ_MEAN((gmhmm_type*) gv, mixture[ i * 3 + 2 ]);
+#else
     mu     = get_mean(gv->base_mu, mixture, n_dim, i);
+#endif
     invvar = get_var(gv->base_var, mixture, n_dim, i);
     gconst = gv->base_gconst[ mixture[ i * 3 + 3 ] ];
     feat = feature;
@@ -135,8 +150,10 @@ TIESRENGINECOREAPI_API short hlr_logsum( short lna, short lnb )
    short s_temp;
    long temp;
    long diff;
+#ifndef USE_FIXED_POINT_TABLES
    short result;
    unsigned short adb;
+#endif
 
    /* lna holds larger value, lnb smaller */
    if( lna < lnb )
@@ -151,7 +168,11 @@ TIESRENGINECOREAPI_API short hlr_logsum( short lna, short lnb )
    diff -= (long)lna;
    if( diff < -448 )
       return( lna );
-      
+
+#ifdef USE_FIXED_POINT_TABLES
+   /* table holds the rounded Q6 value of ln( 1 + exp(diff) ) */
+   temp = (long)lna + logsum_table[ -diff ];
+#else
    /* find exponential of diff in unsigned short Q15 */
    s_temp = (short)diff;
    adb = hlr_expn( s_temp, 6 );
@@ -164,6 +185,8 @@ TIESRENGINECOREAPI_API short hlr_logsum( short lna, short lnb )
    temp += lna << 9;
    temp += 1<<8;
    temp >>= 9;
+#endif
+
    if( temp > 32767 )
       temp = 32767;
 
@@ -192,6 +215,14 @@ TIESRENGINECOREAPI_API unsigned short hlr_expn( short x, short qpt )
    short frac, s_temp;
    short coef;
 
+#ifdef USE_FIXED_POINT_TABLES
+   /* Q6 is the common case, from log likelihood differences */
+   if( qpt == 6 && x <= 0 )
+   {
+      return ( x > -EXPN_Q6_TABLE_SIZE ) ? expn_q6_table[ -x ] : 0;
+   }
+#endif
+
    /* base two exponent Q qpt+14 */
    temp = ln2e*x;
    
@@ -463,10 +494,11 @@ const short coef_logpoly[ LOGPOLYORD + 1 ] = {
   -781, 5338, -16182, 28637, -32768, 25419, -13767, 5640, -1536};
 
 /* ---------------------------------------------------------------------------
-   polynomial fit to compute log2()
+   polynomial fit to compute log2(). Defined static inline so that
+   log_polyfit_vector evaluates it in-line over a whole vector.
    ---------------------------------------------------------------------- */
-short
-log_polyfit(long value, short compensate)
+static inline short
+log2_polyfit(long value, short compensate)
 {
   //  static short result = 0;
   short result = 0;
@@ -481,10 +513,15 @@ log_polyfit(long value, short compensate)
     value = 1; /* need a better solution  */
   }
 
-  /* normalize to most precision */
+  /* normalize to most precision, value < 0x40000000 shifted up by
+     binary steps rather than one bit at a time */
 
-  for (norm = 0; value < 0x40000000; norm++)
-    value <<= 1;
+  norm = 0;
+  if ( value < 0x00008000 ) { value <<= 16; norm += 16; }
+  if ( value < 0x00800000 ) { value <<= 8;  norm += 8; }
+  if ( value < 0x08000000 ) { value <<= 4;  norm += 4; }
+  if ( value < 0x20000000 ) { value <<= 2;  norm += 2; }
+  if ( value < 0x40000000 ) { value <<= 1;  norm += 1; }
 
   /* positive, between 0.5 and 1, Q 15 */
 
@@ -520,6 +557,28 @@ log_polyfit(long value, short compensate)
   return result;                                      /* log2(value) in Q 9 */
 }
 
+/* ---------------------------------------------------------------------------
+   polynomial fit to compute log2()
+   ---------------------------------------------------------------------- */
+TIESRENGINECOREAPI_API short
+log_polyfit(long value, short compensate)
+{
+  return log2_polyfit( value, compensate );
+}
+
+/* ---------------------------------------------------------------------------
+   log2() of a vector of values, such as a frame of mel energies.  Each
+   result is identical to log_polyfit( value[i], compensate ).
+   ---------------------------------------------------------------------- */
+TIESRENGINECOREAPI_API void log_polyfit_vector( const long *value, short *result,
+                                                const short n_value, short compensate )
+{
+  short i;
+
+  for ( i = 0; i < n_value; i++ )
+    result[ i ] = log2_polyfit( value[ i ], compensate );
+}
+
 /* ---------------------------------------------------------------------------
    polynomial fit to compute pow2()
    ---------------------------------------------------------------------- */
@@ -543,7 +602,10 @@ TIESRENGINECOREAPI_API long pow_polyfit( short value )
   data =  value & ~0xfe00;
 
   /* compute the pow2(data) polynomial */
-  
+
+#ifdef USE_FIXED_POINT_TABLES
+  result = powpoly_table[ data ];
+#else
   result = coef_powpoly[ 0 ];
 
   for (i = POWPOLYORD - 1; i >= 0; i--) {
@@ -552,6 +614,7 @@ TIESRENGINECOREAPI_API long pow_polyfit( short value )
     tmp += ( (long) coef_powpoly[ POWPOLYORD - i ] << 9 );    /* Q 9 */
     result = (short)  LONG_RIGHT_SHIFT_N( tmp, 9 );                            /* Q 0 */
   }
+#endif
 
   /* 2.0 == 32725 >= result >= 16384 == 1.0 */
   tmp = result; 
@@ -0,0 +1,228 @@
+/*=======================================================================
+
+ *
+ * dist.h
+ *
+ * Local lookup tables for fixed point math in distance computation.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This header holds constant tables used by dist.cpp when
+ USE_FIXED_POINT_TABLES is defined.  Each table was generated offline by
+ sweeping the polynomial implementation in dist.cpp over its entire valid
+ input range, so table lookups are bit-exact with the polynomial code.
+ The tables must be regenerated if any polynomial coefficient changes.
+
+ The TestTIesrEngine program holds reference copies of the polynomial
+ code.  Running "testtiesrengine -t" prints the three tables in the
+ layout below, and running it without arguments checks that the
+ functions using these tables match the polynomial code for all inputs.
+ A coefficient change must be made in both dist.cpp and
+ TestTIesrEngine.cpp.
+
+======================================================================*/
+
+#ifndef DIST_H
+#define DIST_H
+
+#ifdef USE_FIXED_POINT_TABLES
+
+/*----------------------------------------------------------------
+  Log-add correction table for hlr_logsum.
+
+  Entry d holds round( hlr_log_one( hlr_expn( -d, 6 ) ) / 2^9 ), which is
+  the Q6 term added to the larger of the two Q6 log values when their
+  difference is -d.  Differences below -448 add nothing.
+  ----------------------------------------------------------------*/
+#define LOGSUM_TABLE_SIZE 449
+
+static const short logsum_table[ LOGSUM_TABLE_SIZE ] = {
+  44, 44, 43, 43, 42, 42, 41, 41, 40, 40, 40, 39, 39, 38, 38, 37,
+  37, 36, 36, 36, 35, 35, 34, 34, 33, 33, 33, 32, 32, 31, 31, 31,
+  30, 30, 30, 29, 29, 28, 28, 28, 27, 27, 27, 26, 26, 26, 25, 25,
+  25, 24, 24, 24, 24, 23, 23, 23, 22, 22, 22, 21, 21, 21, 21, 20,
+  20, 20, 20, 19, 19, 19, 18, 18, 18, 18, 18, 17, 17, 17, 17, 16,
+  16, 16, 16, 15, 15, 15, 15, 15, 14, 14, 14, 14, 14, 13, 13, 13,
+  13, 13, 13, 12, 12, 12, 12, 12, 12, 11, 11, 11, 11, 11, 11, 10,
+  10, 10, 10, 10, 10, 10,  9,  9,  9,  9,  9,  9,  9,  8,  8,  8,
+   8,  8,  8,  8,  8,  8,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+   6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  5,  5,  5,  5,  5,
+   5,  5,  5,  5,  5,  5,  5,  5,  4,  4,  4,  4,  4,  4,  4,  4,
+   4,  4,  4,  4,  4,  4,  4,  4,  4,  3,  3,  3,  3,  3,  3,  3,
+   3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  2,
+   2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+   2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+   1,  1,  1,  1,  1,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0
+};
+
+
+/*----------------------------------------------------------------
+  Exponential table for hlr_expn with Q6 input.
+
+  Entry d holds hlr_expn( -d, 6 ) in unsigned Q15.  All inputs less than
+  -(EXPN_Q6_TABLE_SIZE-1) produce zero.
+  ----------------------------------------------------------------*/
+#define EXPN_Q6_TABLE_SIZE 688
+
+static const unsigned short expn_q6_table[ EXPN_Q6_TABLE_SIZE ] = {
+  32768, 32260, 31760, 31268, 30782, 30306, 29836, 29372, 28918, 28468,
+  28028, 27594, 27166, 26744, 26330, 25922, 25520, 25124, 24734, 24352,
+  23974, 23602, 23238, 22876, 22521, 22172, 21828, 21490, 21157, 20829,
+  20506, 20188, 19875, 19567, 19264, 18965, 18671, 18381, 18096, 17816,
+  17540, 17268, 17000, 16736, 16477, 16221, 15970, 15722, 15478, 15239,
+  15002, 14770, 14541, 14315, 14093, 13875, 13660, 13448, 13240, 13034,
+  12832, 12633, 12437, 12245, 12055, 11868, 11684, 11503, 11324, 11149,
+  10976, 10806, 10638, 10474, 10311, 10151,  9994,  9839,  9687,  9536,
+   9388,  9243,  9100,  8959,  8820,  8683,  8548,  8416,  8285,  8157,
+   8030,  7906,  7783,  7663,  7544,  7427,  7312,  7198,  7087,  6977,
+   6869,  6762,  6658,  6554,  6453,  6353,  6254,  6157,  6062,  5968,
+   5875,  5784,  5694,  5606,  5519,  5434,  5349,  5266,  5185,  5104,
+   5025,  4947,  4871,  4795,  4721,  4648,  4576,  4505,  4435,  4366,
+   4298,  4232,  4166,  4102,  4038,  3975,  3914,  3853,  3793,  3735,
+   3677,  3620,  3564,  3508,  3454,  3400,  3348,  3296,  3245,  3194,
+   3145,  3096,  3048,  3001,  2954,  2909,  2863,  2819,  2775,  2732,
+   2690,  2648,  2607,  2567,  2527,  2488,  2449,  2411,  2374,  2337,
+   2301,  2265,  2230,  2195,  2161,  2128,  2095,  2062,  2030,  1999,
+   1968,  1937,  1907,  1878,  1849,  1820,  1792,  1764,  1737,  1710,
+   1683,  1657,  1632,  1606,  1581,  1557,  1533,  1509,  1486,  1463,
+   1440,  1417,  1395,  1374,  1353,  1332,  1311,  1291,  1271,  1251,
+   1232,  1212,  1194,  1175,  1157,  1139,  1121,  1104,  1087,  1070,
+   1053,  1037,  1021,  1005,   990,   974,   959,   944,   930,   915,
+    901,   887,   873,   860,   846,   833,   820,   808,   795,   783,
+    771,   759,   747,   735,   724,   713,   702,   691,   680,   670,
+    659,   649,   639,   629,   619,   610,   600,   591,   582,   573,
+    564,   555,   546,   538,   530,   521,   513,   505,   498,   490,
+    482,   475,   467,   460,   453,   446,   439,   432,   426,   419,
+    413,   406,   400,   394,   388,   382,   376,   370,   364,   358,
+    353,   347,   342,   337,   331,   326,   321,   316,   311,   307,
+    302,   297,   293,   288,   284,   279,   275,   271,   266,   262,
+    258,   254,   250,   246,   243,   239,   235,   231,   228,   224,
+    221,   217,   214,   211,   207,   204,   201,   198,   195,   192,
+    189,   186,   183,   180,   177,   175,   172,   169,   167,   164,
+    162,   159,   157,   154,   152,   149,   147,   145,   143,   140,
+    138,   136,   134,   132,   130,   128,   126,   124,   122,   120,
+    118,   116,   115,   113,   111,   109,   108,   106,   104,   103,
+    101,   100,    98,    96,    95,    93,    92,    91,    89,    88,
+     86,    85,    84,    83,    81,    80,    79,    78,    76,    75,
+     74,    73,    72,    71,    69,    68,    67,    66,    65,    64,
+     63,    62,    61,    60,    59,    59,    58,    57,    56,    55,
+     54,    53,    52,    52,    51,    50,    49,    49,    48,    47,
+     46,    46,    45,    44,    43,    43,    42,    41,    41,    40,
+     40,    39,    38,    38,    37,    37,    36,    35,    35,    34,
+     34,    33,    33,    32,    32,    31,    31,    30,    30,    29,
+     29,    29,    28,    28,    27,    27,    26,    26,    26,    25,
+     25,    24,    24,    24,    23,    23,    23,    22,    22,    22,
+     21,    21,    21,    20,    20,    20,    19,    19,    19,    18,
+     18,    18,    18,    17,    17,    17,    17,    16,    16,    16,
+     16,    15,    15,    15,    15,    14,    14,    14,    14,    13,
+     13,    13,    13,    13,    12,    12,    12,    12,    12,    12,
+     11,    11,    11,    11,    11,    10,    10,    10,    10,    10,
+     10,    10,     9,     9,     9,     9,     9,     9,     9,     8,
+      8,     8,     8,     8,     8,     8,     8,     7,     7,     7,
+      7,     7,     7,     7,     7,     7,     6,     6,     6,     6,
+      6,     6,     6,     6,     6,     6,     6,     5,     5,     5,
+      5,     5,     5,     5,     5,     5,     5,     5,     5,     5,
+      4,     4,     4,     4,     4,     4,     4,     4,     4,     4,
+      4,     4,     4,     4,     4,     4,     3,     3,     3,     3,
+      3,     3,     3,     3,     3,     3,     3,     3,     3,     3,
+      3,     3,     3,     3,     3,     3,     3,     2,     2,     2,
+      2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+      1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+      1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+      1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+      1,     1,     1,     1,     1,     1,     1,     1
+};
+
+
+/*----------------------------------------------------------------
+  Fractional power of two table for pow_polyfit.
+
+  Entry d holds the POWPOLYORD polynomial evaluated at the Q9 fraction d,
+  which is 2^(d/512) in Q14.
+  ----------------------------------------------------------------*/
+#define POWPOLY_TABLE_SIZE 512
+
+static const short powpoly_table[ POWPOLY_TABLE_SIZE ] = {
+  16384, 16406, 16428, 16451, 16473, 16495, 16518, 16540, 16562, 16585,
+  16607, 16630, 16652, 16675, 16697, 16720, 16743, 16765, 16788, 16811,
+  16834, 16857, 16879, 16902, 16925, 16948, 16971, 16994, 17017, 17040,
+  17063, 17086, 17109, 17133, 17156, 17179, 17202, 17226, 17249, 17272,
+  17296, 17319, 17343, 17366, 17390, 17413, 17437, 17460, 17484, 17508,
+  17531, 17555, 17579, 17603, 17627, 17651, 17675, 17698, 17722, 17746,
+  17770, 17795, 17819, 17843, 17867, 17891, 17915, 17940, 17964, 17988,
+  18013, 18037, 18062, 18086, 18110, 18135, 18160, 18184, 18209, 18234,
+  18258, 18283, 18308, 18333, 18357, 18382, 18407, 18432, 18457, 18482,
+  18507, 18532, 18557, 18582, 18608, 18633, 18658, 18683, 18709, 18734,
+  18759, 18785, 18810, 18836, 18861, 18887, 18912, 18938, 18964, 18989,
+  19015, 19041, 19067, 19092, 19118, 19144, 19170, 19196, 19222, 19248,
+  19274, 19300, 19327, 19353, 19379, 19405, 19431, 19458, 19484, 19510,
+  19537, 19563, 19590, 19617, 19643, 19670, 19696, 19723, 19750, 19776,
+  19803, 19830, 19857, 19884, 19911, 19938, 19965, 19992, 20019, 20046,
+  20073, 20100, 20128, 20155, 20182, 20209, 20237, 20264, 20292, 20319,
+  20347, 20374, 20402, 20429, 20457, 20485, 20513, 20540, 20568, 20596,
+  20624, 20652, 20680, 20708, 20736, 20764, 20792, 20820, 20849, 20877,
+  20905, 20933, 20962, 20990, 21019, 21047, 21076, 21104, 21133, 21161,
+  21190, 21219, 21248, 21276, 21305, 21334, 21363, 21392, 21421, 21450,
+  21479, 21508, 21537, 21566, 21596, 21625, 21654, 21684, 21713, 21742,
+  21772, 21801, 21831, 21860, 21890, 21920, 21949, 21979, 22009, 22039,
+  22069, 22098, 22128, 22158, 22188, 22219, 22249, 22278, 22309, 22339,
+  22369, 22399, 22430, 22461, 22491, 22521, 22552, 22582, 22613, 22644,
+  22674, 22705, 22736, 22767, 22798, 22828, 22859, 22890, 22921, 22952,
+  22983, 23014, 23046, 23077, 23108, 23140, 23171, 23202, 23234, 23265,
+  23296, 23328, 23360, 23392, 23423, 23455, 23487, 23518, 23550, 23582,
+  23614, 23646, 23678, 23710, 23742, 23775, 23807, 23839, 23872, 23903,
+  23936, 23968, 24001, 24033, 24066, 24098, 24131, 24164, 24197, 24229,
+  24262, 24295, 24328, 24361, 24394, 24427, 24460, 24493, 24527, 24560,
+  24593, 24626, 24660, 24693, 24726, 24760, 24794, 24827, 24861, 24894,
+  24928, 24961, 24996, 25029, 25063, 25097, 25131, 25165, 25200, 25234,
+  25268, 25302, 25336, 25371, 25405, 25440, 25474, 25509, 25543, 25578,
+  25612, 25647, 25682, 25716, 25752, 25786, 25821, 25856, 25892, 25926,
+  25962, 25997, 26032, 26067, 26102, 26138, 26173, 26209, 26244, 26280,
+  26315, 26351, 26386, 26422, 26458, 26494, 26530, 26566, 26602, 26638,
+  26674, 26710, 26746, 26783, 26818, 26855, 26891, 26927, 26965, 27001,
+  27038, 27074, 27111, 27147, 27185, 27221, 27258, 27295, 27332, 27369,
+  27406, 27443, 27481, 27518, 27555, 27592, 27630, 27667, 27704, 27742,
+  27780, 27817, 27855, 27893, 27931, 27969, 28006, 28044, 28082, 28120,
+  28158, 28197, 28235, 28273, 28311, 28350, 28388, 28427, 28465, 28503,
+  28542, 28581, 28620, 28659, 28697, 28737, 28775, 28813, 28852, 28892,
+  28931, 28970, 29009, 29048, 29088, 29127, 29166, 29207, 29246, 29285,
+  29325, 29365, 29405, 29444, 29485, 29525, 29565, 29605, 29645, 29685,
+  29726, 29766, 29806, 29846, 29887, 29928, 29968, 30008, 30050, 30091,
+  30131, 30172, 30212, 30254, 30295, 30335, 30376, 30418, 30459, 30500,
+  30542, 30583, 30624, 30666, 30707, 30749, 30792, 30833, 30874, 30917,
+  30958, 31001, 31042, 31083, 31126, 31167, 31210, 31252, 31294, 31337,
+  31381, 31423, 31465, 31508, 31551, 31592, 31636, 31679, 31721, 31765,
+  31807, 31851, 31894, 31937, 31981, 32023, 32066, 32110, 32154, 32196,
+  32241, 32285, 32328, 32373, 32417, 32460, 32504, 32548, 32592, 32637,
+  32680, 32725
+};
+
+#endif /* USE_FIXED_POINT_TABLES */
+
+#endif /* DIST_H */
@@ -210,7 +210,10 @@ static const short coef_powpoly[ POWPOLYORD + 1 ] = {
 /*--------------------------------*/
 /* Functional interface */
 
-/* returns Q6 */
+/* returns Q6. With rapid JAC and lazily compensated means, the first
+   use of a mean after the JAC estimates change writes the compensated
+   mean into gv->base_mu and updates the offline VQ epochs. Concurrent
+   calls are only safe if those means have already been compensated. */
 TIESRENGINECOREAPI_API short  hlr_gauss_obs_score_f(const short *feature, int pdf_idx,
 			     ObsType type, short *comp, 
 			     const short n_dim, const gmhmm_type *gv );
@@ -260,6 +263,12 @@ TIESRENGINECOREAPI_API long fx_sqrt(long x);
    ---------------------------------------------------------------------- */
 TIESRENGINECOREAPI_API short log_polyfit(long value, short compensate);
 
+/* ---------------------------------------------------------------------------
+   log_polyfit applied to each of n_value elements of a vector
+   ---------------------------------------------------------------------- */
+TIESRENGINECOREAPI_API void log_polyfit_vector( const long *value, short *result,
+                                                const short n_value, short compensate );
+
 /* ---------------------------------------------------------------------------
    polynomial fit to compute pow2()
    ---------------------------------------------------------------------- */
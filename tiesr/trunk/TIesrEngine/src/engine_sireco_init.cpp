@@ -41,6 +41,7 @@
 #include "tiesr_engine_api_sireco.h"
 #include "gmhmm_si_api.h"
 #include "gmhmm_type_common_user.h"
+#include "trace_user.h"
 #include "volume_user.h"
 #include "uttdet_user.h"
 #include "jac-estm_user.h"
@@ -89,6 +90,8 @@ TIESRENGINESIAPI_API
 void TIesrEngineOpen (TIesrEngineSIRECOType *tiesr)
 {
   tiesr->OpenASR           = OpenASR; 
+  tiesr->OpenASRImage      = OpenASRImage; 
+  tiesr->OpenASRBundle     = OpenASRBundle; 
   tiesr->CloseASR          = CloseASR; 
   tiesr->OpenSearchEngine  = OpenSearchEngine; 
   tiesr->CallSearchEngine  = CallSearchEngine; 
@@ -96,12 +99,25 @@ void TIesrEngineOpen (TIesrEngineSIRECOType *tiesr)
   tiesr->SpeechDetected    = SpeechDetected; 
   tiesr->SpeechEnded       = SpeechEnded; 
 
+  tiesr->AddGrammar       = AddGrammar;
+  tiesr->SelectGrammar    = SelectGrammar;
+  tiesr->RemoveGrammar    = RemoveGrammar;
+  tiesr->GetActiveGrammar = GetActiveGrammar;
+
 
   tiesr->JAC_load   = JAC_load;
   tiesr->JAC_save  = JAC_save;
   tiesr->JAC_clear  = JAC_clear;
   tiesr->JAC_update = JAC_update;
 
+  tiesr->OpenTIesrProfiles  = OpenTIesrProfiles;
+  tiesr->CloseTIesrProfiles = CloseTIesrProfiles;
+  tiesr->JAC_save_profile   = JAC_save_profile;
+  tiesr->JAC_load_profile   = JAC_load_profile;
+  tiesr->RemoveTIesrProfile = RemoveTIesrProfile;
+  tiesr->WriteTIesrProfiles = WriteTIesrProfiles;
+  tiesr->ReadTIesrProfiles  = ReadTIesrProfiles;
+
   tiesr->GetFrameCount   = GetFrameCount; 
   tiesr->GetTotalScore = GetTotalScore;
 
@@ -169,6 +185,14 @@ void TIesrEngineOpen (TIesrEngineSIRECOType *tiesr)
   tiesr->GetBestWordStartAt = GetBestWordStartAt;
 #endif
 
+  tiesr->SetTIesrStats = SetTIesrStats;
+  tiesr->GetTIesrStats = GetTIesrStats;
+
+  tiesr->SetTIesrTrace = SetTIesrTrace;
+  tiesr->TraceTIesrEvent = TraceTIesrEvent;
+  tiesr->DumpTIesrTrace = DumpTIesrTrace;
+  tiesr->GetTIesrClock = stats_clock;
+
   tiesr->GetNumNbests = GetNumNbests;
   tiesr->SetTIesrNBest = SetTIesrNBest;
   tiesr->GetTIesrNBest = GetTIesrNBest;
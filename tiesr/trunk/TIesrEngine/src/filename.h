@@ -42,4 +42,10 @@ static const char * const file_names[] =  {
    "hmm2phone.bin"
 };
 
+/* file of a grammar directory naming the model pool directory that
+   holds the model files the grammar directory does not, and the size
+   of the name with its newline and '\0' */
+#define MODEL_POOL_FILE "modelpool.txt"
+#define MAX_POOL_NAME 256
+
 #endif
@@ -43,6 +43,39 @@
 TIesrEngineStatusType OpenASR(char *path, int total_words, gmhmm_type *memoryPool);
 
 
+/*---------------------------------------------------------------------
+ OpenASRImage
+ 
+ Initialize the ASR as OpenASR does, mapping the speech HMM and
+ sentence network from an engine image written by WriteTIesrImage.
+ Grammars can not be added to an ASR opened from an image.
+
+ Arguments:
+ aImageFile: Engine image file
+ total_words: Number of shorts in memoryPool
+ memoryPool: Pointer to memory, the beginning of which is the gmhmm_type struct.
+-----------------------------*/
+TIesrEngineStatusType OpenASRImage(const char *aImageFile, int total_words,
+				   gmhmm_type *memoryPool);
+
+
+/*---------------------------------------------------------------------
+ OpenASRBundle
+ 
+ Initialize the ASR as OpenASR does, reading the speech HMM and
+ sentence network from a model bundle in memory, such as one made by
+ TIesrFlex OutputGrammarBundle.  The bundle must be kept until
+ CloseASR.  Grammars can not be added to an ASR opened from a bundle.
+
+ Arguments:
+ aBundle: Model bundle
+ total_words: Number of shorts in memoryPool
+ memoryPool: Pointer to memory, the beginning of which is the gmhmm_type struct.
+-----------------------------*/
+TIesrEngineStatusType OpenASRBundle(const void *aBundle, int total_words,
+				    gmhmm_type *memoryPool);
+
+
 /*-------------------------------------------------------------------
  CloseASR
 
@@ -52,6 +85,42 @@ TIesrEngineStatusType OpenASR(char *path, int total_words, gmhmm_type *memoryPoo
  memoryPool: Pointer to memory pool starting with the gmhmm_type struct.
  ------------------------------*/
 void CloseASR(gmhmm_type * memoryPool );
+
+
+/*---------------------------------------------------------------------
+ AddGrammar, SelectGrammar, RemoveGrammar, GetActiveGrammar
+
+ Keep several grammar networks resident with the models loaded by
+ OpenASR, and select the network searched by the next utterance.  The
+ grammar loaded by OpenASR has index 0.  A grammar directory added must
+ hold a net.bin and word.lis.  If it holds a hmm.bin, the network indexes
+ that list of HMMs, and its hmm2phone.bin maps them to phones for SBC;
+ otherwise the network indexes the HMMs of the OpenASR grammar.  The
+ HMMs of all grammars index the same models, so any mu.bin, var.bin,
+ tran.bin, pdf.bin, mixture.bin, gconst.bin, VQ files or other model
+ files the directory holds must match those loaded by OpenASR byte for
+ byte, or eTIesrEngineGrammarMismatch is returned.
+
+ TIesrFlex OutputGrammar writes only the models a grammar uses, so two
+ grammars compiled independently by it normally have different mu.bin
+ and var.bin files and can not be added to each other.  Grammars
+ written by TIesrFlex OutputGrammarPool hold no hmm.bin; their networks
+ index the HMMs of their pool directly, so all grammars of a pool can
+ be added to each other and share one HMM list.
+
+ Arguments:
+ aGrammarDir: Directory holding the grammar network and word list
+ aIndex: Index of a resident grammar
+ gv: Pointer to the ASR structure
+ ------------------------------*/
+TIesrEngineStatusType AddGrammar( const char *aGrammarDir, gmhmm_type *gv,
+				  unsigned short *aIndex );
+
+TIesrEngineStatusType SelectGrammar( unsigned short aIndex, gmhmm_type *gv );
+
+TIesrEngineStatusType RemoveGrammar( unsigned short aIndex, gmhmm_type *gv );
+
+unsigned short GetActiveGrammar( gmhmm_type const *gv );
  
 
 /*---------------------------------------------------------------------------
@@ -33,6 +33,7 @@
 #include "mfcc_f_def_struct_user.h"
 #include "gmhmm.h"
 #include "sbc_struct_user.h"
+#include "search_stats.h"
 
 /*--------------------------------*/
 typedef enum CompensationType {
@@ -587,6 +588,10 @@ typedef struct gmhmm_type
   */
   short * pNss; /* pointer to noise subtraction data structure */ 
 
+  /* --------------  background model compensation ----------------*/
+  short * pJacBg; /* pointer to the background compensation state, NULL if compensating inline */
+  short * pJacEm; /* pointer to the shared JAC EM pool, NULL if computing inline */
+
   short cm_score; /* confidence score of the current recognition result, in Q6 */
   short * pConf; /* pointer to the confidence measure data structure */
 
@@ -611,6 +616,26 @@ typedef struct gmhmm_type
   short realt_guard;
 #endif
 
+  /* search statistics of the utterance and of the current frame */
+  Boolean bStats; /* TRUE if timing and utterance statistics are collected */
+  TIesrEngineStatsType stats_utt;
+  TIesrEngineStatsType stats_frm;
+
+  /* ring buffer of timed processing events, NULL if not tracing */
+  short* pTrace;
+
+  /* table of resident grammar networks, NULL if only the network
+     loaded by OpenASR is used */
+  short* pGrammars;
+
+  /* engine image the models are mapped from, NULL if the models were
+     loaded from a model directory */
+  short* pImage;
+
+  /* model bundle the models were loaded from, NULL if they were loaded
+     from a model directory.  The bundle belongs to the caller. */
+  const unsigned char* pBundle;
+
 } gmhmm_type;
 
 
@@ -47,6 +47,9 @@ BOOL APIENTRY DllMain( HANDLE hModule,
 
 
 #include "tiesr_config.h"
+#if !defined( WIN32 ) && !defined( WINCE )
+#include <time.h>
+#endif
 #include "gmhmm_type_common_user.h"
 #include "uttdet_user.h"
 #include "jac-estm_user.h"
@@ -414,6 +417,88 @@ TIESRENGINECOREAPI_API void SetTIesrSBC( gmhmm_type *gvv, short sbc_fgt )
 }
 
 
+/*--------------------------------*/
+TIESRENGINECOREAPI_API void SetTIesrStats( gmhmm_type *gvv, short enable )
+{
+  gvv->bStats = enable ? TRUE : FALSE;
+  memset( &gvv->stats_utt, 0, sizeof(TIesrEngineStatsType) );
+  memset( &gvv->stats_frm, 0, sizeof(TIesrEngineStatsType) );
+}
+
+
+/*--------------------------------*/
+TIESRENGINECOREAPI_API void GetTIesrStats( const gmhmm_type *gvv,
+					   TIesrEngineStatsType *utt_stats,
+					   TIesrEngineStatsType *frm_stats )
+{
+  if( utt_stats )
+    *utt_stats = gvv->stats_utt;
+  if( frm_stats )
+    *frm_stats = gvv->stats_frm;
+}
+
+
+/*----------------------------------------------------------------
+  stats_clock
+
+  Return a monotonic time in nanoseconds for timing the stages of
+  processing, or zero if no such clock is available.
+  --------------------------------*/
+TIESRENGINECOREAPI_API unsigned long long stats_clock( void )
+{
+#if defined( WIN32 ) || defined( WINCE )
+  LARGE_INTEGER count, freq;
+
+  QueryPerformanceCounter( &count );
+  QueryPerformanceFrequency( &freq );
+  return (unsigned long long) ( (double) count.QuadPart * 1.0e9 / (double) freq.QuadPart );
+#elif defined( CLOCK_MONOTONIC )
+  struct timespec now;
+
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+#else
+  return 0;
+#endif
+}
+
+
+/*----------------------------------------------------------------
+  stats_end_frame
+
+  Complete the statistics of a frame processed starting at time
+  start_ns, and add them to the utterance statistics. The front end
+  time is the frame time not spent in the search.
+  --------------------------------*/
+TIESRENGINECOREAPI_API void stats_end_frame( gmhmm_type *gvv, unsigned long long start_ns )
+{
+  TIesrEngineStatsType *frm = &gvv->stats_frm;
+  TIesrEngineStatsType *utt = &gvv->stats_utt;
+  unsigned long long search_ns = frm->ns_score + frm->ns_propagate;
+  unsigned long long frame_ns = stats_clock() - start_ns;
+  short i;
+
+  frm->ns_frontend = frame_ns > search_ns ? frame_ns - search_ns : 0;
+
+  utt->frames += frm->frames;
+  utt->gauss_evaluated += frm->gauss_evaluated;
+  utt->gauss_cache_hits += frm->gauss_cache_hits;
+  utt->gauss_cluster_scored += frm->gauss_cluster_scored;
+  for( i = 0; i < 3; i++ )
+    utt->clusters[i] += frm->clusters[i];
+  utt->active_syms += frm->active_syms;
+  utt->active_states += frm->active_states;
+  if( frm->beam_cells > utt->beam_cells )
+    utt->beam_cells = frm->beam_cells;
+  utt->compactions += frm->compactions;
+  utt->prune_width += frm->prune_width;
+  utt->jac_vectors += frm->jac_vectors;
+  utt->ns_frontend += frm->ns_frontend;
+  utt->ns_score += frm->ns_score;
+  utt->ns_propagate += frm->ns_propagate;
+}
+
+
 TIESRENGINECOREAPI_API void GetRealTimeGuardTh( short* th, gmhmm_type * gv )
 {
 #ifdef REALTIMEGUARD
@@ -469,6 +554,9 @@ TIesrEngineStatusType  OpenSearchEngine(gmhmm_type *gvv)
   gvv->nbr_cpy = 0; 
   gvv->pred_first_frame = TRUE;
 
+  memset( &gvv->stats_utt, 0, sizeof(TIesrEngineStatsType) );
+  memset( &gvv->stats_frm, 0, sizeof(TIesrEngineStatsType) );
+
 #ifdef USE_SNR_SS
   ss_reset((NssType * )gvv->pNss);
 
@@ -200,6 +200,18 @@ TIESRENGINECOREAPI_API void GetTIesrSBC(const gmhmm_type *gvv, short *sbc_fgt );
 
 TIESRENGINECOREAPI_API void SetTIesrSBC( gmhmm_type *gvv, short sbc_fgt );
 
+TIESRENGINECOREAPI_API void SetTIesrStats( gmhmm_type *gvv, short enable );
+
+TIESRENGINECOREAPI_API void GetTIesrStats( const gmhmm_type *gvv,
+					   TIesrEngineStatsType *utt_stats,
+					   TIesrEngineStatsType *frm_stats );
+
+/* Monotonic time in nanoseconds used to time processing stages */
+TIESRENGINECOREAPI_API unsigned long long stats_clock( void );
+
+/* Complete the current frame statistics and add them to the utterance */
+TIESRENGINECOREAPI_API void stats_end_frame( gmhmm_type *gvv, unsigned long long start_ns );
+
 
 /* GMHMM_SI_API */ 
 TIESRENGINECOREAPI_API TIesrEngineStatusType  OpenSearchEngine(gmhmm_type *gvv);
@@ -0,0 +1,539 @@
+/*=======================================================================
+
+ *
+ * image.cpp
+ *
+ * Writing and mapping of TIesr engine model images.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ An image is a header holding the model dimensions and the offset and
+ size of each section, followed by the sections, each aligned to
+ IMAGE_ALIGN bytes.  On Windows the image is read into memory, since
+ there is no mapping of files to memory in this engine for Windows.
+
+======================================================================*/
+
+/* Headers required by Windows OS */
+#if defined (WIN32) || defined (WINCE)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tiesr_config.h"
+#include "gmhmm.h"
+#include "load_user.h"
+#include "image_user.h"
+
+
+/* Identifier of image files */
+static const char IMAGE_MAGIC[4] = { 'T', 'I', 'M', 'I' };
+
+/* Marker of the byte order of the image */
+#define IMAGE_BYTE_ORDER 0x0102
+
+/* Alignment of sections in the image, in bytes */
+#define IMAGE_ALIGN 8
+
+
+typedef struct
+{
+      unsigned int offset;
+      unsigned int size;
+} ImageSectionType;
+
+
+typedef struct
+{
+      char magic[4];
+      unsigned short version;
+      unsigned short byte_order;
+      unsigned short config;
+
+      unsigned short n_mfcc;
+      unsigned short n_mu;
+      unsigned short n_var;
+      unsigned short n_pdf;
+
+      ImageSectionType section[ IMAGE_SECTIONS ];
+} ImageHeaderType;
+
+
+/* An image in use by an ASR structure */
+typedef struct
+{
+      unsigned char *base;
+      unsigned int size;
+      Boolean mapped;
+} ImageType;
+
+
+/*----------------------------------------------------------------
+ image_config
+
+ Flags of the configuration that determines the form of the models in
+ memory.
+ --------------------------------*/
+static unsigned short image_config( void )
+{
+   unsigned short config = 0;
+
+#ifdef BIT8MEAN
+   config |= 0x01;
+#endif
+#ifdef BIT8VAR
+   config |= 0x02;
+#endif
+#ifdef USE_16BITMEAN_DECOD
+   config |= 0x04;
+#endif
+#ifdef USE_SVA
+   config |= 0x08;
+#endif
+#ifdef OFFLINE_CLS
+   config |= 0x10;
+#endif
+
+   return config;
+}
+
+
+/*----------------------------------------------------------------
+ image_file_length
+
+ Number of shorts of a file loaded by load_model_file, read from the
+ start of the file.  Files are opened as load_models opens them, so a
+ model file may be in the model pool of the directory.
+ --------------------------------*/
+static unsigned int image_file_length( const char *aModelDir, const char *aName )
+{
+   unsigned short len = 0;
+   ModelFileType fp;
+
+   if( !model_file_open( &fp, aModelDir, NULL, aName, "rb" ) )
+      return 0;
+
+   if( model_file_read( &len, sizeof(unsigned short), 1, &fp ) != 1 )
+      len = 0;
+   model_file_close( &fp );
+
+   return len;
+}
+
+
+/*----------------------------------------------------------------
+ image_read_file
+
+ Read a whole file into memory.  Returns NULL, with a size of zero, if
+ the file does not exist.
+ --------------------------------*/
+static unsigned char* image_read_file( const char *aModelDir, const char *aName,
+				       unsigned int *aSize )
+{
+   unsigned char *data;
+   long size;
+   ModelFileType fp;
+
+   *aSize = 0;
+
+   if( !model_file_open( &fp, aModelDir, NULL, aName, "rb" ) )
+      return NULL;
+
+   size = model_file_length( &fp );
+
+   data = size > 0 ? (unsigned char*) malloc( size ) : NULL;
+   if( data && model_file_read( data, 1, size, &fp ) != (size_t) size )
+   {
+      free( data );
+      data = NULL;
+   }
+   model_file_close( &fp );
+
+   if( data )
+      *aSize = (unsigned int) size;
+   return data;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType WriteTIesrImage( char *aModelDir,
+							      const char *aImageFile )
+{
+   static const char zeros[ IMAGE_ALIGN ] = { 0 };
+   ImageHeaderType header;
+   const void *data[ IMAGE_SECTIONS ];
+   unsigned char *vqData[2];
+   unsigned int words, vecSize, varSize, offset, pad;
+   unsigned short s;
+   gmhmm_type *gv;
+   TIesrEngineStatusType status;
+   FILE *fp;
+
+   gv = (gmhmm_type*) calloc( 1, sizeof(gmhmm_type) );
+   if( !gv )
+      return eTIesrEngineMemorySizeFail;
+
+   status = load_models( aModelDir, gv, FALSE, NULL, NULL );
+   if( status != eTIesrEngineSuccess )
+   {
+      free_models( gv );
+      free( gv );
+      return status;
+   }
+
+   memset( &header, 0, sizeof(header) );
+   memcpy( header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC) );
+   header.version = IMAGE_VERSION;
+   header.byte_order = IMAGE_BYTE_ORDER;
+   header.config = image_config( );
+   header.n_mfcc = gv->n_mfcc;
+   header.n_mu = gv->n_mu;
+   header.n_var = gv->n_var;
+   header.n_pdf = gv->n_pdf;
+
+#ifdef BIT8MEAN
+   vecSize = gv->n_mfcc;
+#else
+   vecSize = 2 * gv->n_mfcc;
+#endif
+#ifdef BIT8VAR
+   varSize = gv->n_mfcc;
+#else
+   varSize = 2 * gv->n_mfcc;
+#endif
+
+   /* The words of the word list are stored one after the other */
+   words = 0;
+   for( s = 0; gv->vocabulary && s < gv->trans->n_word; s++ )
+      words += strlen( gv->vocabulary[s] ) + 1;
+
+   data[ IMAGE_SCALE_MU ] = gv->scale_mu;
+   header.section[ IMAGE_SCALE_MU ].size = gv->scale_mu ? gv->n_mfcc * 2 * sizeof(short) : 0;
+   data[ IMAGE_SCALE_VAR ] = gv->scale_var;
+   header.section[ IMAGE_SCALE_VAR ].size = gv->scale_var ? gv->n_mfcc * 2 * sizeof(short) : 0;
+   data[ IMAGE_NET ] = gv->base_net;
+   header.section[ IMAGE_NET ].size =
+      image_file_length( aModelDir, file_names[1] ) * sizeof(short);
+   data[ IMAGE_WORDS ] = words ? gv->vocabulary[0] : NULL;
+   header.section[ IMAGE_WORDS ].size = words;
+   data[ IMAGE_HMMS ] = gv->base_hmms;
+   header.section[ IMAGE_HMMS ].size =
+      image_file_length( aModelDir, file_names[2] ) * sizeof(short);
+   data[ IMAGE_MU ] = gv->base_mu;
+   header.section[ IMAGE_MU ].size = gv->n_mu * vecSize * sizeof(short);
+   data[ IMAGE_VAR ] = gv->base_var;
+   header.section[ IMAGE_VAR ].size = gv->n_var * varSize * sizeof(short);
+   data[ IMAGE_TRAN ] = gv->base_tran;
+   header.section[ IMAGE_TRAN ].size =
+      image_file_length( aModelDir, file_names[5] ) * sizeof(short);
+   data[ IMAGE_PDF ] = gv->base_pdf;
+   header.section[ IMAGE_PDF ].size = gv->n_pdf * sizeof(short);
+   data[ IMAGE_MIXTURE ] = gv->base_mixture;
+   header.section[ IMAGE_MIXTURE ].size =
+      image_file_length( aModelDir, file_names[7] ) * sizeof(short);
+   data[ IMAGE_GCONST ] = gv->base_gconst;
+   header.section[ IMAGE_GCONST ].size =
+      image_file_length( aModelDir, file_names[8] ) * sizeof(short);
+
+   vqData[0] = image_read_file( aModelDir, "o2amidx.bin",
+				&header.section[ IMAGE_RAM2CLS ].size );
+   data[ IMAGE_RAM2CLS ] = vqData[0];
+   vqData[1] = image_read_file( aModelDir, "vqcentr.bin",
+				&header.section[ IMAGE_VQCENTR ].size );
+   data[ IMAGE_VQCENTR ] = vqData[1];
+
+   /* Lay out the sections after the header */
+   offset = sizeof(ImageHeaderType);
+   for( s = 0; s < IMAGE_SECTIONS; s++ )
+   {
+      offset = ( offset + IMAGE_ALIGN - 1 ) & ~( IMAGE_ALIGN - 1 );
+      header.section[s].offset = offset;
+      offset += header.section[s].size;
+   }
+
+   status = eTIesrEngineSaveFail;
+   fp = fopen( aImageFile, "wb" );
+   if( fp )
+   {
+      Boolean failed = fwrite( &header, sizeof(header), 1, fp ) != 1;
+
+      offset = sizeof(ImageHeaderType);
+      for( s = 0; s < IMAGE_SECTIONS && !failed; s++ )
+      {
+	 pad = header.section[s].offset - offset;
+	 failed |= pad && fwrite( zeros, 1, pad, fp ) != pad;
+	 failed |= header.section[s].size &&
+	    fwrite( data[s], 1, header.section[s].size, fp ) != header.section[s].size;
+	 offset = header.section[s].offset + header.section[s].size;
+      }
+
+      failed |= fclose( fp ) != 0;
+      if( !failed )
+	 status = eTIesrEngineSuccess;
+   }
+
+   free( vqData[0] );
+   free( vqData[1] );
+   free_models( gv );
+   free( gv );
+
+   return status;
+}
+
+
+/*----------------------------------------------------------------
+ image_open
+
+ Map or read an image file into memory.
+ --------------------------------*/
+static ImageType* image_open( const char *aImageFile )
+{
+   ImageType *image = (ImageType*) malloc( sizeof(ImageType) );
+
+   if( !image )
+      return NULL;
+
+#if defined (WIN32) || defined (WINCE)
+   {
+      FILE *fp = fopen( aImageFile, "rb" );
+      long size;
+
+      image->base = NULL;
+      if( fp )
+      {
+	 fseek( fp, 0, SEEK_END );
+	 size = ftell( fp );
+	 fseek( fp, 0, SEEK_SET );
+
+	 image->base = size > 0 ? (unsigned char*) malloc( size ) : NULL;
+	 if( image->base && fread( image->base, 1, size, fp ) != (size_t) size )
+	 {
+	    free( image->base );
+	    image->base = NULL;
+	 }
+	 image->size = (unsigned int) size;
+	 fclose( fp );
+      }
+      image->mapped = FALSE;
+   }
+#else
+   {
+      struct stat st;
+      void *base = MAP_FAILED;
+      int fd = open( aImageFile, O_RDONLY );
+
+      if( fd >= 0 )
+      {
+	 /* A private writable mapping, so a stray write to a model
+	    array only copies its page */
+	 if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+	    base = mmap( NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+	 close( fd );
+      }
+
+      image->base = base != MAP_FAILED ? (unsigned char*) base : NULL;
+      image->size = base != MAP_FAILED ? (unsigned int) st.st_size : 0;
+      image->mapped = TRUE;
+   }
+#endif
+
+   if( !image->base )
+   {
+      free( image );
+      return NULL;
+   }
+
+   return image;
+}
+
+
+/*----------------------------------------------------------------*/
+static void image_close( ImageType *aImage )
+{
+#if defined (WIN32) || defined (WINCE)
+   free( aImage->base );
+#else
+   munmap( aImage->base, aImage->size );
+#endif
+   free( aImage );
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API const void* image_section( const gmhmm_type *gv, unsigned short aSection,
+						  unsigned int *aSize )
+{
+   const ImageType *image = (const ImageType*) gv->pImage;
+   const ImageHeaderType *header = (const ImageHeaderType*) image->base;
+
+   *aSize = header->section[ aSection ].size;
+   if( *aSize == 0 )
+      return NULL;
+
+   return image->base + header->section[ aSection ].offset;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API short* image_copy( const gmhmm_type *gv, unsigned short aSection )
+{
+   unsigned int size;
+   const void *data = image_section( gv, aSection, &size );
+   short *copy;
+
+   if( !data )
+      return NULL;
+
+   copy = (short*) malloc( size );
+   if( copy )
+      memcpy( copy, data, size );
+
+   return copy;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType load_models_image( const char *aImageFile,
+								gmhmm_type *gv )
+{
+   ImageType *image;
+   const ImageHeaderType *header;
+   unsigned int size;
+   unsigned short s;
+   char *word;
+
+   gv->pImage = NULL;
+   gv->pBundle = NULL;
+   gv->vocabulary = NULL;
+
+   image = image_open( aImageFile );
+   if( !image )
+      return eTIesrEngineModelLoadFail;
+
+   /* Check the image was written for this engine, and is complete */
+   header = (const ImageHeaderType*) image->base;
+   if( image->size < sizeof(ImageHeaderType) ||
+       memcmp( header->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC) ) != 0 ||
+       header->version != IMAGE_VERSION ||
+       header->byte_order != IMAGE_BYTE_ORDER ||
+       header->config != image_config( ) )
+   {
+      image_close( image );
+      return eTIesrEngineModelLoadFail;
+   }
+
+   for( s = 0; s < IMAGE_SECTIONS; s++ )
+   {
+      if( header->section[s].offset % IMAGE_ALIGN != 0 ||
+	  header->section[s].offset > image->size ||
+	  header->section[s].size > image->size - header->section[s].offset )
+      {
+	 image_close( image );
+	 return eTIesrEngineModelLoadFail;
+      }
+   }
+
+   gv->pImage = (short*) image;
+
+   gv->n_mfcc = header->n_mfcc;
+   gv->n_mu = header->n_mu;
+   gv->n_var = header->n_var;
+   gv->n_pdf = header->n_pdf;
+
+   /* Model data the engine only reads is used in the image */
+   gv->scale_mu = (short*) image_section( gv, IMAGE_SCALE_MU, &size );
+   gv->scale_var = (short*) image_section( gv, IMAGE_SCALE_VAR, &size );
+   gv->base_net = (short*) image_section( gv, IMAGE_NET, &size );
+   gv->trans = (TransType*) gv->base_net;
+   gv->base_hmms = (unsigned short*) image_section( gv, IMAGE_HMMS, &size );
+   gv->base_tran = (short*) image_section( gv, IMAGE_TRAN, &size );
+   gv->base_pdf = (unsigned short*) image_section( gv, IMAGE_PDF, &size );
+   gv->base_mixture = (short*) image_section( gv, IMAGE_MIXTURE, &size );
+#ifdef USE_SVA
+   gv->base_var_orig = (short*) image_section( gv, IMAGE_VAR, &size );
+#endif
+
+   /* Model data adapted by the engine is copied */
+   gv->base_mu = image_copy( gv, IMAGE_MU );
+   gv->base_var = image_copy( gv, IMAGE_VAR );
+   gv->base_gconst = image_copy( gv, IMAGE_GCONST );
+   gv->gauss_scr = (short*) calloc( gv->n_mu, sizeof(short) );
+
+#ifdef USE_16BITMEAN_DECOD
+   gv->base_mu_orig = NULL;
+#else
+   gv->base_mu_orig = image_copy( gv, IMAGE_MU );
+#endif
+
+   if( !gv->base_net || !gv->base_hmms || !gv->base_tran || !gv->base_pdf ||
+       !gv->base_mixture || !gv->base_mu || !gv->base_var ||
+       !gv->base_gconst || !gv->gauss_scr
+#ifndef USE_16BITMEAN_DECOD
+       || !gv->base_mu_orig
+#endif
+       )
+      return eTIesrEngineModelLoadFail;
+
+   /* Point to each word of the word list */
+   word = (char*) image_section( gv, IMAGE_WORDS, &size );
+   if( gv->trans->n_word > 0 )
+   {
+      gv->vocabulary = (char**) malloc( gv->trans->n_word * sizeof(char*) );
+      if( !gv->vocabulary || !word )
+	 return eTIesrEngineModelLoadFail;
+
+      for( s = 0; s < gv->trans->n_word; s++ )
+      {
+	 gv->vocabulary[s] = word;
+	 word += strlen( word ) + 1;
+      }
+   }
+
+   return eTIesrEngineSuccess;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API void free_models_image( gmhmm_type *gv )
+{
+   if( !gv->pImage )
+      return;
+
+   gv->scale_mu = NULL;
+   gv->scale_var = NULL;
+   gv->base_net = NULL;
+   gv->trans = NULL;
+   gv->base_hmms = NULL;
+   gv->base_tran = NULL;
+   gv->base_pdf = NULL;
+   gv->base_mixture = NULL;
+#ifdef USE_SVA
+   gv->base_var_orig = NULL;
+#endif
+
+   /* The words are in the image, only the list of them is allocated */
+   if( gv->vocabulary )
+      free( gv->vocabulary );
+   gv->vocabulary = NULL;
+
+   image_close( (ImageType*) gv->pImage );
+   gv->pImage = NULL;
+}
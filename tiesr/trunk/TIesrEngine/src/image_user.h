@@ -0,0 +1,145 @@
+/*=======================================================================
+
+ *
+ * image_user.h
+ *
+ * Header for interface of TIesr engine model images.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ An engine image holds the models and grammar of a model directory in
+ the form the engine uses after load_models and the reading of the VQ
+ cluster data: unpacked means and variances, the network, the word
+ list split into strings, and so on.  Each part is a section located
+ by its offset in the file, so the image can be mapped at any address
+ and used in place.
+
+ Sections the engine only reads are used where they are mapped.  The
+ means, variances and Gaussian constants are adapted, and are copied
+ out of the image.
+
+ The image is in the byte order and model format (byte or short means
+ and variances) of the engine that wrote it, which are checked when it
+ is loaded.
+
+======================================================================*/
+
+#ifndef IMAGE_USER_H
+#define IMAGE_USER_H
+
+
+/*--------------------------------------------------------------
+The Windows method of exporting functions from a DLL.
+---------------------------------------------------------------*/
+#if defined (WIN32) || defined (WINCE)
+
+/* If it is not defined already, define a macro that does
+Windows format export of DLL functions */
+#ifndef TIESRENGINECOREAPI_API
+
+// The following ifdef block is the standard way of creating macros which
+// make exporting from a DLL simpler. All files within this DLL are compiled
+// with the TIESRENGINECOREAPI_EXPORTS symbol defined on the command line.
+// This symbol should not be defined on any project that uses this DLL.
+// This way any other project whose source files include this file see
+// TIESRENGINECOREAPI_API functions as being imported from a DLL,
+// whereas this DLL sees symbols defined with this macro as being exported.
+#ifdef TIESRENGINECOREAPI_EXPORTS
+#define TIESRENGINECOREAPI_API __declspec(dllexport)
+#else
+#define TIESRENGINECOREAPI_API __declspec(dllimport)
+#endif
+#endif
+
+#else
+
+#ifndef TIESRENGINECOREAPI_API
+#define TIESRENGINECOREAPI_API
+#endif
+
+#endif
+/*--------------------------------------------------------------------*/
+
+
+#include "tiesr_config.h"
+#include "status.h"
+#include "gmhmm_type.h"
+
+
+/* Version of the image format */
+#define IMAGE_VERSION 1
+
+
+/* Sections of an image */
+enum
+{
+   IMAGE_SCALE_MU,
+   IMAGE_SCALE_VAR,
+   IMAGE_NET,
+   IMAGE_WORDS,   /* words of the word list, each ended by '\0' */
+   IMAGE_HMMS,
+   IMAGE_MU,
+   IMAGE_VAR,
+   IMAGE_TRAN,
+   IMAGE_PDF,
+   IMAGE_MIXTURE,
+   IMAGE_GCONST,
+   IMAGE_RAM2CLS, /* contents of o2amidx.bin */
+   IMAGE_VQCENTR, /* contents of vqcentr.bin */
+   IMAGE_SECTIONS
+};
+
+
+/*----------------------------------------------------------------
+ WriteTIesrImage
+
+ Load the models and grammar of a model directory and write them to an
+ image file.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType WriteTIesrImage( char *aModelDir,
+							      const char *aImageFile );
+
+
+/*----------------------------------------------------------------
+ load_models_image
+
+ Map an image file and set the models and grammar of the ASR
+ structure from it, in place of load_models.  The image stays mapped
+ until free_models.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType load_models_image( const char *aImageFile,
+								gmhmm_type *gv );
+
+
+/*----------------------------------------------------------------
+ free_models_image
+
+ Release the image of the ASR structure, leaving the models copied
+ out of it to be freed by free_models.
+ --------------------------------*/
+TIESRENGINECOREAPI_API void free_models_image( gmhmm_type *gv );
+
+
+/*----------------------------------------------------------------
+ image_section, image_copy
+
+ Get a section of the image of the ASR structure and its size in
+ bytes, or a copy of it allocated with malloc.  Both return NULL if
+ the section is empty.
+ --------------------------------*/
+TIESRENGINECOREAPI_API const void* image_section( const gmhmm_type *gv, unsigned short aSection,
+						  unsigned int *aSize );
+
+TIESRENGINECOREAPI_API short* image_copy( const gmhmm_type *gv, unsigned short aSection );
+
+#endif
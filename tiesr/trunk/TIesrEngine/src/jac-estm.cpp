@@ -30,6 +30,14 @@
 
 
 #include "tiesr_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( JAC_PARALLEL_EM ) && defined( LINUX )
+#include <pthread.h>
+#endif
+
 #include "tiesrcommonmacros.h"
 #include "dist_user.h"
 #include "search_user.h"
@@ -48,6 +56,7 @@
 #include "rapidsearch_user.h"
 #endif
 #include "load_user.h"
+#include "jac_one_user.h"
 
 //#define DBG_CONF
 
@@ -111,6 +120,8 @@ static void ijac_update_t(HmmType *jac_hmm, short *pdfa, const short ap[], const
     FOR_EACH_MIXING(k,pmix,pdf) { 
 #ifdef BIT8MEAN 
       mu = GET_MU(gv->base_mu, pmix, n_mfcc);
+#elif defined(RAPID_JAC)
+      mu = RJ_MEAN(gv, INDEX_FOR_MEAN(pmix));
 #else
       mu = GET_MU(gv->base_mu, pmix, gv->nbr_dim);
 #endif
@@ -227,6 +238,8 @@ static void update_t(HmmType *jac_hmm, short *pdfa, const short ap[], const shor
     FOR_EACH_MIXING(k,pmix,pdf) { 
 #ifdef BIT8MEAN 
       mu = GET_MU(gv->base_mu,pmix, n_mfcc);
+#elif defined(RAPID_JAC)
+      mu = RJ_MEAN(gv, INDEX_FOR_MEAN(pmix));
 #else
       mu = GET_MU(gv->base_mu, pmix, gv->nbr_dim);
 #endif
@@ -426,7 +439,7 @@ TIesrEngineJACStatusType JAC_clear( gmhmm_type *gv,
    /* Try to initialize SBC phonetic regression tree structure, and statistics
     accumulators */
    if (gv->comp_type & SBC) 
-     hStatus = sbc_init_tree( gv->sbcState, aModelDir,
+     hStatus = sbc_init_tree( gv->sbcState, aModelDir, gv->pBundle,
 			      aTreeFile, FALSE,
 			      gv->nbr_dim,
 			      gv->trans->n_hmm_set , TRUE);
@@ -440,7 +453,7 @@ TIesrEngineJACStatusType JAC_clear( gmhmm_type *gv,
       }
 
       /* Load set-indpendent HMM to phone mapping */
-      hStatus = sbc_load_hmm2phone(aModelDir, gv->trans->n_hmm_set, 
+      hStatus = sbc_load_hmm2phone(aModelDir, gv->pBundle, gv->trans->n_hmm_set, 
 				   gv->sbcState, TRUE); 
 
    }
@@ -579,7 +592,7 @@ TIesrEngineJACStatusType MP_JAC_load( const char *bias_file, gmhmm_type *gv,
       {
          /* Initialize the hierarchical regression tree structure and
           hmm-to-phone map from data files. */
-         hStatus = sbc_init_tree( gv->sbcState, pNetDir, p_tree_file, FALSE,
+         hStatus = sbc_init_tree( gv->sbcState, pNetDir, gv->pBundle, p_tree_file, FALSE,
                  gv->nbr_dim,
                  gv->trans->n_hmm_set, bTriphone );
 
@@ -602,7 +615,7 @@ TIesrEngineJACStatusType MP_JAC_load( const char *bias_file, gmhmm_type *gv,
 	 }
 
          /* Load 'gender' independent hmm to monophone mapping from data file.*/
-	 hStatus = sbc_load_hmm2phone(pNetDir, gv->trans->n_hmm_set, 
+	 hStatus = sbc_load_hmm2phone(pNetDir, gv->pBundle, gv->trans->n_hmm_set, 
 				     gv->sbcState, bTriphone); 
       }
 
@@ -775,6 +788,243 @@ TIesrEngineJACStatusType JAC_save(const char *bias_file, gmhmm_type *gv)
    return eTIesrEngineJACSaveFail;
 }
 
+
+/* ------------------------------ adaptation profiles ------------------------------------ */
+
+/* Identifier of a profile snapshot */
+static const char PROFILE_MAGIC[4] = { 'T', 'I', 'A', 'P' };
+
+/* Sections of adaptation state in a snapshot */
+#define PROFILE_JAC   0x01
+#define PROFILE_SVA   0x02
+#define PROFILE_WSVA  0x04
+#define PROFILE_SBC   0x08
+#define PROFILE_ORM   0x10
+#define PROFILE_CM    0x20
+
+/* Header of a snapshot. A snapshot can only be loaded into a
+   recognizer with the same header. */
+typedef struct
+{
+   ushort version;
+   ushort sections;
+   ushort n_filter;
+   ushort nbr_dim;
+
+   /* size of the SBC section, which depends on the regression tree */
+   unsigned int sbc_size;
+} JACProfileHeaderType;
+
+
+/*----------------------------------------------------------------
+  JAC_profile_header
+
+  Describe the adaptation state of a recognizer.
+  ----------------------------------------------------------------*/
+static void JAC_profile_header( gmhmm_type *gv, JACProfileHeaderType *aHeader )
+{
+   aHeader->version = PROFILE_VERSION;
+   aHeader->sections = PROFILE_JAC;
+   aHeader->n_filter = gv->n_filter;
+   aHeader->nbr_dim = gv->nbr_dim;
+   aHeader->sbc_size = 0;
+
+#ifdef USE_SVA
+   aHeader->sections |= PROFILE_SVA;
+#endif
+
+#ifdef USE_WSVA
+   if( gv->pNss )
+      aHeader->sections |= PROFILE_WSVA;
+#endif
+
+#ifdef USE_SBC
+   if( ( gv->comp_type & SBC ) && gv->sbcState->hlrTreeBase )
+   {
+      TIesrProfileBufType count = { NULL, 0, 0, FALSE };
+
+      sbc_save_profile( gv->sbcState, &count );
+      aHeader->sections |= PROFILE_SBC;
+      aHeader->sbc_size = count.pos;
+   }
+#endif
+
+#ifdef USE_ORM_PU
+   aHeader->sections |= PROFILE_ORM;
+#endif
+
+#ifdef USE_CONFIDENCE
+   aHeader->sections |= PROFILE_CM;
+#endif
+}
+
+
+/*----------------------------------------------------------------
+  JAC_profile_snapshot
+
+  Put the header and the state written by JAC_save into a buffer.
+  ----------------------------------------------------------------*/
+static void JAC_profile_snapshot( gmhmm_type *gv, const JACProfileHeaderType *aHeader,
+				  TIesrProfileBufType *aBuf )
+{
+   profile_put( aBuf, PROFILE_MAGIC, sizeof(PROFILE_MAGIC) );
+   profile_put( aBuf, &aHeader->version, sizeof(ushort) );
+   profile_put( aBuf, &aHeader->sections, sizeof(ushort) );
+   profile_put( aBuf, &aHeader->n_filter, sizeof(ushort) );
+   profile_put( aBuf, &aHeader->nbr_dim, sizeof(ushort) );
+   profile_put( aBuf, &aHeader->sbc_size, sizeof(unsigned int) );
+
+   profile_put( aBuf, gv->log_H, sizeof(short) * gv->n_filter );
+   profile_put( aBuf, gv->accum, sizeof(long) * 2 * gv->n_filter );
+
+#ifdef USE_SVA
+   profile_put( aBuf, gv->log_var_rho, sizeof(short) * gv->nbr_dim );
+   profile_put( aBuf, gv->var_fisher_IM, sizeof(long) * gv->nbr_dim );
+#endif
+
+#ifdef USE_WSVA
+   /* The noise level of the current utterance is that of the previous
+      utterance when the profile is loaded */
+   if( aHeader->sections & PROFILE_WSVA )
+      profile_put( aBuf, &( (NssType*) gv->pNss )->noiselvl, sizeof(short) );
+#endif
+
+#ifdef USE_SBC
+   if( aHeader->sections & PROFILE_SBC )
+      sbc_save_profile( gv->sbcState, aBuf );
+#endif
+
+#ifdef USE_ORM_PU
+   rj_save_profile( gv, aBuf );
+#endif
+
+#ifdef USE_CONFIDENCE
+   cm_save_profile( aBuf, gv );
+#endif
+}
+
+
+/*----------------------------------------------------------------
+  JAC_save_profile
+  ----------------------------------------------------------------*/
+TIesrEngineJACStatusType JAC_save_profile( TIesrProfileStoreType *aStore,
+					   const char *aId, gmhmm_type *gv )
+{
+   JACProfileHeaderType header;
+   TIesrProfileBufType buf = { NULL, 0, 0, FALSE };
+
+   JAC_profile_header( gv, &header );
+
+   /* Size the snapshot, then fill it */
+   JAC_profile_snapshot( gv, &header, &buf );
+
+   buf.size = buf.pos;
+   buf.pos = 0;
+   buf.data = (unsigned char*) malloc( buf.size );
+   if( !buf.data )
+      return eTIesrEngineJACMemoryFail;
+
+   JAC_profile_snapshot( gv, &header, &buf );
+   if( buf.failed )
+   {
+      free( buf.data );
+      return eTIesrEngineJACSaveFail;
+   }
+
+   return profile_store_insert( aStore, aId, buf.data, buf.size );
+}
+
+
+/*----------------------------------------------------------------
+  JAC_load_profile
+  ----------------------------------------------------------------*/
+TIesrEngineJACStatusType JAC_load_profile( TIesrProfileStoreType *aStore,
+					   const char *aId, gmhmm_type *gv )
+{
+   JACProfileHeaderType header, expected;
+   TIesrProfileBufType buf;
+   char magic[ sizeof(PROFILE_MAGIC) ];
+   TIesrEngineJACStatusType eStatus = eTIesrEngineJACSuccess;
+#ifdef USE_SVA
+   ushort d;
+#endif
+
+   if( !profile_store_find( aStore, aId, &buf ) )
+      return eTIesrEngineJACLoadFail;
+
+   /* Check the snapshot fits this recognizer before changing anything */
+   profile_get( &buf, magic, sizeof(magic) );
+   profile_get( &buf, &header.version, sizeof(ushort) );
+   profile_get( &buf, &header.sections, sizeof(ushort) );
+   profile_get( &buf, &header.n_filter, sizeof(ushort) );
+   profile_get( &buf, &header.nbr_dim, sizeof(ushort) );
+   profile_get( &buf, &header.sbc_size, sizeof(unsigned int) );
+
+   JAC_profile_header( gv, &expected );
+   if( buf.failed || memcmp( magic, PROFILE_MAGIC, sizeof(magic) ) != 0 ||
+       header.version != expected.version ||
+       header.sections != expected.sections ||
+       header.n_filter != expected.n_filter ||
+       header.nbr_dim != expected.nbr_dim ||
+       header.sbc_size != expected.sbc_size )
+      return eTIesrEngineJACLoadFail;
+
+   profile_get( &buf, gv->log_H, sizeof(short) * gv->n_filter );
+   profile_get( &buf, gv->accum, sizeof(long) * 2 * gv->n_filter );
+
+   /* A running global estimate exists, so continue to 
+      update according to the accumulated estimates */
+   gv->smooth_coef = gv->jac_smooth_coef; 
+
+#ifdef USE_SVA
+   profile_get( &buf, gv->log_var_rho, sizeof(short) * gv->nbr_dim );
+   profile_get( &buf, gv->var_fisher_IM, sizeof(long) * gv->nbr_dim );
+
+   /* Clear the temporary accumulators */
+   for( d = 0; d < gv->nbr_dim; d++ )
+      gv->var_fisher_IM_per_utter[ d ] = 0;
+#endif
+
+#ifdef USE_WSVA
+   if( header.sections & PROFILE_WSVA )
+      profile_get( &buf, &( (NssType*) gv->pNss )->prevMeanEn, sizeof(short) );
+#endif
+
+#ifdef USE_SBC
+   if( ( header.sections & PROFILE_SBC ) &&
+       sbc_load_profile( gv->sbcState, &buf ) != eTIesrEngineHLRSuccess )
+      eStatus = eTIesrEngineJACSBCLoadFail;
+#endif
+
+#ifdef USE_ORM_PU
+   if( rj_load_profile( gv, &buf ) != eTIesrEngineSuccess )
+      eStatus = eTIesrEngineJACLoadFail;
+#endif
+
+#ifdef USE_CONFIDENCE
+   cm_load_profile( &buf, gv );
+#endif
+
+   if( buf.failed )
+      eStatus = eTIesrEngineJACLoadFail;
+
+#ifdef RAPID_JAC
+   /* Compensate means as the search uses them in the next utterance,
+      once any background compensation of all means is swapped in. If
+      the clean means can not be kept, the means may already be
+      compensated and can not be compensated again, so they keep their
+      present compensation and the failure is returned. */
+   jac_bg_sync( gv );
+   {
+      TIesrEngineJACStatusType lazyStatus = rj_lazy_open( gv );
+      if( lazyStatus != eTIesrEngineJACSuccess )
+	 eStatus = lazyStatus;
+   }
+#endif
+
+   return eStatus;
+}
+
 /* ------------------------------ for force alignment --------------------------------------  */
 
 /*--------------------------------*/
@@ -971,19 +1221,248 @@ static TIesrEngineStatusType jac_force_alignment(gmhmm_type * gv)
 
 
 
+/*--------------------------------*/
+/* Compute observation likelihood and backward variables of segment s */
+static void jac_segment_likelihood(JACSegType *seg, ushort s, gmhmm_type *gv)
+{
+#ifdef USE_SBC
+  sbc_observation_likelihood(gv->stt[s], seg->seg_len, gv->hmm_code[s], 
+			     seg->hmm, seg->state_lld, gv->n_mfcc, gv); 
+#else
+  observation_likelihood(gv->stt[s], seg->seg_len, seg->hmm, seg->state_lld, gv->n_mfcc, gv); 
+#endif
+  seg->lld_forward = EM_beta(seg->state_lld, seg->bp, seg->seg_len, seg->hmm, seg->c_t_beta, gv);
+}
+
+
+static void jac_segment_worker(JACWorkerType *work)
+{
+  ushort s;
+
+  for (s = work->first; s < work->n_segs; s += work->step)
+    jac_segment_likelihood(work->segs + s, s, work->gv);
+}
+
+
+#if defined( JAC_PARALLEL_EM ) && defined( LINUX )
+/*--------------------------------*/
+/* The EM pool shared by all recognizers. jac_em_users_mutex serializes
+   starting and stopping the pool threads. */
+static JACEmType jac_em_pool = { {}, 0, 0, PTHREAD_MUTEX_INITIALIZER,
+                                 PTHREAD_COND_INITIALIZER, NULL, FALSE };
+static pthread_mutex_t jac_em_users_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*--------------------------------*/
+/* Claim and run workers of a job until none are left. The job is taken
+   off the queue when its last worker is claimed. Called with the pool
+   mutex locked. */
+static void jac_em_run(JACEmType *em, JACEmJobType *job)
+{
+  JACWorkerType *work;
+  JACEmJobType **pjob;
+
+  while (job->next < job->n_workers) {
+    work = job->work + job->next++;
+
+    if (job->next == job->n_workers) {
+      for (pjob = &em->head; *pjob != job; pjob = &(*pjob)->link) ;
+      *pjob = job->link;
+    }
+
+    pthread_mutex_unlock(&em->mutex);
+
+    jac_segment_worker(work);
+
+    pthread_mutex_lock(&em->mutex);
+    if (++job->done == job->n_workers)
+      pthread_cond_broadcast(&em->cond);
+  }
+}
+
+
+/*--------------------------------*/
+/* Pool thread main loop */
+static void *jac_em_thread(void *arg)
+{
+  JACEmType *em = (JACEmType *) arg;
+
+  pthread_mutex_lock(&em->mutex);
+  while (!em->bExit) {
+    if (em->head)
+      jac_em_run(em, em->head);
+    else
+      pthread_cond_wait(&em->cond, &em->mutex);
+  }
+  pthread_mutex_unlock(&em->mutex);
+
+  return NULL;
+}
+
+
+#ifdef RAPID_JAC
+/*--------------------------------*/
+/* Compensate the lazily compensated means used by the segments, so that
+   the workers only read the models. */
+static void jac_segment_means(JACSegType *segs, ushort n_segs, gmhmm_type *gv)
+{
+  ushort s;
+  short j, k, pdf_i, *pdf, *pmix;
+
+  if (((OFFLINE_VQ_HMM_type*) gv->offline_vq)->mu_clean == NULL)
+    return;
+
+  for (s = 0; s < n_segs; s++) {
+    FOR_EMS_STATES(j, segs[s].hmm, gv->base_tran) {
+      pdf_i = GET_BJ_IDX(segs[s].hmm, j);
+      pdf = GET_MIX(gv, pdf_i);
+      FOR_EACH_MIXING(k, pmix, pdf)
+	(void) RJ_MEAN(gv, INDEX_FOR_MEAN(pmix));
+    }
+  }
+}
+#endif
+#endif
+
+
+/*--------------------------------*/
+/* Compute the likelihoods of all segments. Each worker writes only its own
+   segments, so the result is the same as computing them serially. */
+static void jac_segment_likelihoods(JACSegType *segs, ushort n_segs, gmhmm_type *gv)
+{
+  JACWorkerType work[JAC_EM_THREADS];
+  ushort i, n_workers = MIN(JAC_EM_THREADS, n_segs);
+#if defined( JAC_PARALLEL_EM ) && defined( LINUX )
+  JACEmType *em = (JACEmType *) gv->pJacEm;
+#endif
+
+  for (i = 0; i < n_workers; i++) {
+    work[i].gv = gv;
+    work[i].segs = segs;
+    work[i].first = i;
+    work[i].step = n_workers;
+    work[i].n_segs = n_segs;
+  }
+
+#if defined( JAC_PARALLEL_EM ) && defined( LINUX )
+  if (em && n_workers > 1) {
+#ifdef RAPID_JAC
+    /* hlr_gauss_obs_score_f writes a mean the first time it is used
+       after the JAC estimates change */
+    jac_segment_means(segs, n_segs, gv);
+#endif
+
+    JACEmJobType job, **pjob;
+
+    job.work = work;
+    job.n_workers = n_workers;
+    job.next = 0;
+    job.done = 0;
+    job.link = NULL;
+
+    /* the calling thread also runs workers of its job, and waits for the
+       workers claimed by the pool threads */
+    pthread_mutex_lock(&em->mutex);
+    for (pjob = &em->head; *pjob; pjob = &(*pjob)->link) ;
+    *pjob = &job;
+    pthread_cond_broadcast(&em->cond);
+
+    jac_em_run(em, &job);
+    while (job.done < n_workers)
+      pthread_cond_wait(&em->cond, &em->mutex);
+    pthread_mutex_unlock(&em->mutex);
+    return;
+  }
+#endif
+
+  for (i = 0; i < n_workers; i++) jac_segment_worker(&work[i]);
+}
+
+
+/*----------------------------------------------------------------
+  jac_em_open
+
+  Use the EM pool, starting its threads if this is the first
+  recognizer using it. If no thread can be started the segment
+  likelihoods are computed in the thread calling JAC_update.
+  ----------------------------------------------------------------*/
+void jac_em_open(gmhmm_type *gv)
+{
+  gv->pJacEm = NULL;
+
+#if defined( JAC_PARALLEL_EM ) && defined( LINUX )
+  {
+    JACEmType *em = &jac_em_pool;
+    ushort i;
+
+    pthread_mutex_lock(&jac_em_users_mutex);
+    if (em->n_users++ == 0) {
+      em->bExit = FALSE;
+
+      /* the calling thread is one of the JAC_EM_THREADS workers */
+      em->n_threads = 0;
+      for (i = 1; i < JAC_EM_THREADS; i++) {
+	if (pthread_create(&em->thread[em->n_threads], NULL, jac_em_thread, em) != 0)
+	  break;
+	em->n_threads++;
+      }
+    }
+    pthread_mutex_unlock(&jac_em_users_mutex);
+
+    gv->pJacEm = (short *) em;
+  }
+#endif
+}
+
+
+/*----------------------------------------------------------------
+  jac_em_close
+
+  Stop using the EM pool, stopping its threads if this is the last
+  recognizer using it.
+  ----------------------------------------------------------------*/
+void jac_em_close(gmhmm_type *gv)
+{
+#if defined( JAC_PARALLEL_EM ) && defined( LINUX )
+  JACEmType *em = (JACEmType *) gv->pJacEm;
+  ushort i;
+
+  if (!em)
+    return;
+
+  pthread_mutex_lock(&jac_em_users_mutex);
+  if (--em->n_users == 0) {
+    pthread_mutex_lock(&em->mutex);
+    em->bExit = TRUE;
+    pthread_cond_broadcast(&em->cond);
+    pthread_mutex_unlock(&em->mutex);
+
+    for (i = 0; i < em->n_threads; i++)
+      pthread_join(em->thread[i], NULL);
+    em->n_threads = 0;
+  }
+  pthread_mutex_unlock(&jac_em_users_mutex);
+
+  gv->pJacEm = NULL;
+#endif
+}
+
+
 /* GMHMM_SI_API */ 
 /* HMM-level JAC_update w/wo force alignment */
 TIesrEngineJACStatusType JAC_update(gmhmm_type *gvv)
 {
   gmhmm_type *gv = (gmhmm_type *) gvv;
-  short jac_memory_base[ MAX_EM_MEMORY ];
+  short *jac_memory_base, *alpha;
+  JACSegType segs[MAX_NBR_SEGS], *seg;
+  ushort n_segs;
+  long em_mem, alpha_mem; /* total EM memory */
   short last_lhd = BAD_SCR, curt_lhd;
   ushort em_iter, iter, d, coeff_1,  max_seg_len = 0; 
   long total_like, lld_forward;    /* total likelihood in Q6 */
   long *glb_accum = gv->accum;
   long *glb_accum_d = GET_D_OBJ(glb_accum, gv->n_filter);
   long *loc_accum = glb_accum + 2 * gv->n_filter;
-  HmmType *hmm;
   ushort  frame_cnt[NBR_TRANSFO] /* total number of frames */;
   long temp[3*N_FILTER26];
 
@@ -1031,13 +1510,57 @@ TIesrEngineJACStatusType JAC_update(gmhmm_type *gvv)
    
 
 
+  /* segments used, with the EM memory each needs */
+  em_mem = 0;
+  alpha_mem = 0;
+  for (n_segs = 0; n_segs < gv->nbr_seg; n_segs++) {
+
+    /* is useful for N-best, since there are multiple
+       alignments, which are saved in the vector gv->stp and gv->stt */ 
+    if (n_segs && (gv->stp[n_segs] > gv->stp[n_segs-1])) break; /* only use the top */
+
+    seg = segs + n_segs;
+    seg->seg_len = gv->stp[n_segs] - gv->stt[n_segs];
+    //	printf("stt = %d, stp = %d\n", gv->stt[n_segs], gv->stp[n_segs]);
+    if (seg->seg_len > gv->jac_max_segment_size) {
+      // fprintf(stderr,"segment %d size limited to %d\n", seg_len,MAX_SEG_SIZE);
+      seg->seg_len  = gv->jac_max_segment_size;
+    }
+    max_seg_len = MAX(max_seg_len, seg->seg_len);
+    seg->hmm = GET_HMM(gv->base_hmms, gv->hmm_code[n_segs], gv->hmm_dlt);
+
+    /* state lld, bwd prob, and c_t_beta */
+    em_mem += (2 * NBR_STATES(seg->hmm, gv->base_tran) - 1) * seg->seg_len + seg->seg_len + 1;
+    /* fwd prob, two colums t, t-1, shared by all segments */
+    alpha_mem = MAX(alpha_mem, NBR_STATES(seg->hmm, gv->base_tran) * 2);
+  }
+
+  jac_memory_base = (short *) malloc((alpha_mem + em_mem + 1) * sizeof(short));
+  if (jac_memory_base == NULL) {
+    PRT_ERR(fprintf(stderr,"maximum size capacity exceeded in JAC\n"));
+    return eTIesrEngineJACMemoryFail;  /* lack of memory */
+  }
+
+  alpha = jac_memory_base;
+  em_mem = alpha_mem;
+  for (seg = segs; seg < segs + n_segs; seg++) {
+    seg->state_lld = jac_memory_base + em_mem;     
+    em_mem += (NBR_STATES(seg->hmm, gv->base_tran)-1) * seg->seg_len;
+    seg->bp = jac_memory_base + em_mem;                
+    em_mem += NBR_STATES(seg->hmm, gv->base_tran) * seg->seg_len; /* bwd prob */
+    seg->c_t_beta = jac_memory_base + em_mem;       
+    em_mem += seg->seg_len + 1;
+  }
+
 #ifdef USE_SBC
   sbc_rst_SBC_stat( gv->sbcState );
 #endif
 
 #ifdef USE_16BITMEAN_DECOD
-  if (load_mean_vec(gv->chpr_Model_Dir, gv, FALSE) != eTIesrEngineSuccess)
+  if (load_mean_vec(gv->chpr_Model_Dir, gv, FALSE) != eTIesrEngineSuccess) {
+    free(jac_memory_base);
     return eTIesrEngineJACMemoryFail;
+  }
 #endif
 
 #if defined(USE_CONFIDENCE) && defined(USE_CONF_DRV_ADP)
@@ -1060,64 +1583,36 @@ TIesrEngineJACStatusType JAC_update(gmhmm_type *gvv)
 #endif
 
     for (iter = 0; iter<MAX_NEWTON_ITR; iter++) {
-      ushort s, seg_len, em_mem; /* active memory size */
-      short *state_lld, *bp, *alpha, *c_t_beta;
+      ushort s;
 
       FOREACH(d, gv->n_filter*2) loc_accum[d] = 0;
-      for (s = 0; s < gv->nbr_seg; s++) {  /* for each segment */
 
-	/* is useful for N-best, since there are multiple
-	   alignments, which are saved in the vector gv->stp and gv->stt */ 
-	if (s && (gv->stp[s] > gv->stp[s-1])) break; /* only use the top */
+      jac_segment_likelihoods(segs, n_segs, gv);
 
-	seg_len = gv->stp[s] - gv->stt[s];
-	//	printf("stt = %d, stp = %d\n", gv->stt[s], gv->stp[s]);
-	
-        if (seg_len > gv->jac_max_segment_size) {
-	  // fprintf(stderr,"segment %d size limited to %d\n", seg_len,MAX_SEG_SIZE);
-	  seg_len  = gv->jac_max_segment_size;
-	}
-	max_seg_len = MAX(max_seg_len, seg_len);
-	hmm = GET_HMM(gv->base_hmms, gv->hmm_code[s], gv->hmm_dlt);
-	em_mem = 0; /* active memory size */
-	state_lld = jac_memory_base + em_mem;     
-	em_mem += (NBR_STATES(hmm, gv->base_tran)-1) * seg_len;
-	bp = jac_memory_base + em_mem;                
-	em_mem += NBR_STATES(hmm,gv->base_tran) * seg_len; /* bwd prob */
-	alpha = jac_memory_base + em_mem ;       
-	em_mem += NBR_STATES(hmm, gv->base_tran) * 2; /* fwd prob, two colums t, t-1 */
-	c_t_beta = jac_memory_base + em_mem;       
-	em_mem += seg_len+1;
-	/* total EM memory == em_mem */
-	
-	if (em_mem> MAX_EM_MEMORY) {
-	  PRT_ERR(fprintf(stderr,"maximum size capacity exceeded in JAC\n"));
-	  return eTIesrEngineJACMemoryFail;  /* lack of memory */
-	}
+      for (s = 0; s < n_segs; s++) {  /* for each segment */
+	seg = segs + s;
+	lld_forward = seg->lld_forward;
 #ifdef USE_SBC
 	sbc_rst_seg_stat( gv->sbcState );
-	sbc_observation_likelihood(gv->stt[s],seg_len,gv->hmm_code[s], 
-				   hmm,state_lld, gv->n_mfcc,gv ); 
-#else
-	observation_likelihood(gv->stt[s],seg_len,hmm,state_lld, gv->n_mfcc,gv); /* maybe calc twice if shared */
 #endif
-	lld_forward = EM_beta(state_lld,bp,seg_len,hmm, c_t_beta,gv);
 
 	if (lld_forward > -512000000) /* -1e6 in Q9 */ 
 	  {
-	    if( update_statistics(gv->hmm_code[s], hmm,state_lld, bp, gv->stt[s],
-				  seg_len,alpha, c_t_beta,loc_accum, gv->log_H, 
+	    if( update_statistics(gv->hmm_code[s], seg->hmm, seg->state_lld, seg->bp, gv->stt[s],
+				  seg->seg_len, alpha, seg->c_t_beta, loc_accum, gv->log_H, 
 				  gv->log_N, gv->n_mfcc, gv))
 	      { 
 		total_like += lld_forward; 
 		/* info for frame average likelihood */
-		frame_cnt[0] += seg_len;
+		frame_cnt[0] += seg->seg_len;
 		
 #ifdef USE_SBC
 		if (gv->comp_type & SBC) 
-		  if (sbc_acc_SBC(gv->hmm_code[s], gv->nbr_dim, seg_len,
-				  gv->sbcState , gv->sbc_fgt) == FALSE) 
+		  if (sbc_acc_SBC(gv->hmm_code[s], gv->nbr_dim, seg->seg_len,
+				  gv->sbcState , gv->sbc_fgt) == FALSE) {
+		    free(jac_memory_base);
 		    return eTIesrEngineJACSVAFail;
+		  }
 #endif
 	      }
 	    
@@ -1222,6 +1717,7 @@ TIesrEngineJACStatusType JAC_update(gmhmm_type *gvv)
 	  /* Sanity check, should not have divisor go to zero */
 	  if ( gv->var_fisher_IM[d] == 0 ) {  
 	    PRT_ERR(printf("dividing by zero error occurs during sequential variance adaptation!\n"));
+	    free(jac_memory_base);
 	    return eTIesrEngineJACSVAFail;
 	  }
 	  
@@ -1293,6 +1789,8 @@ TIesrEngineJACStatusType JAC_update(gmhmm_type *gvv)
 
   }// for outer-iter
 
+  free(jac_memory_base);
+
 #ifdef USE_16BITMEAN_DECOD
   free(gv->base_mu_orig);
   gv->base_mu_orig = NULL;
@@ -79,8 +79,59 @@
 /*
 ** part A: Collect (EM) statistics for a training segment
 **         Total memory requirement: 2 x N (T+1) + 1. e.g. N = 5, T = 30 -> 311 words
+**         This is allocated on the heap for all segments of an utterance,
+**         so that the likelihoods of the segments can be computed in parallel.
 */
-#define MAX_EM_MEMORY 1000  
+
+/* Per-segment EM workspace. The observation likelihood and backward
+   variables of a segment do not depend on other segments. */
+typedef struct {
+  HmmType *hmm;         /* segment hmm */
+  ushort seg_len;       /* number of frames used */
+  short *state_lld;     /* observation likelihood, (N-1) x T */
+  short *bp;            /* backward variable, N x T */
+  short *c_t_beta;      /* normalization factor, T+1 */
+  long lld_forward;     /* total segment log likelihood */
+} JACSegType;
+
+/* Arguments for a worker computing every step-th segment likelihood */
+typedef struct {
+  gmhmm_type *gv;
+  JACSegType *segs;
+  ushort first;
+  ushort step;
+  ushort n_segs;
+} JACWorkerType;
+
+#if defined( JAC_PARALLEL_EM ) && defined( LINUX )
+#include <pthread.h>
+
+/* The workers of one Newton iteration of a JAC_update. The job is
+   queued on the EM pool until all of its workers have been claimed. */
+typedef struct JACEmJob {
+  JACWorkerType *work;
+  ushort n_workers;
+  ushort next;          /* next worker to claim */
+  ushort done;          /* workers completed */
+  struct JACEmJob *link;   /* next queued job */
+} JACEmJobType;
+
+/* EM worker threads, one pool shared by all recognizers of the process.
+   The pool is started by the first OpenASR and stopped by the last
+   CloseASR. Each thread running JAC_update queues its job and claims
+   workers of its own job, so jobs are completed even if no pool thread
+   could be started, and recognizers running JAC_update at the same time
+   share the pool threads. */
+typedef struct {
+  pthread_t thread[JAC_EM_THREADS];
+  ushort n_threads;     /* pool threads started */
+  ushort n_users;       /* recognizers using the pool */
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;  /* job posted, completed, or exit */
+  JACEmJobType *head;   /* queued jobs with unclaimed workers, oldest first */
+  Boolean bExit;
+} JACEmType;
+#endif
 
 /*
 ** part B: accumulators:
@@ -26,6 +26,7 @@
 #define _JAC_ESTM_USER_H
 
 #include "gmhmm_type.h"
+#include "profile_user.h"
 
 /* for debug of JAC */
 //#define _JAC_DEBUG 1
@@ -54,7 +55,8 @@ TIesrEngineJACStatusType JAC_set_default_params( gmhmm_type *gv );
  Arguments:
  bias_file: JAC state information file
  gv: Pointer to the ASR structure holding recognition state information
- pNetDir: Directory holding grammar hmm and grammar network info
+ pNetDir: Directory holding grammar hmm and grammar network info, not used
+ if the models were loaded from a model bundle
  pPhoneticTreeFile: Full name of file containing hierarchical regression tree
   --------------------------------*/
 TIesrEngineJACStatusType JAC_load (const char *bias_file, gmhmm_type *gv,
@@ -75,6 +77,46 @@ TIesrEngineJACStatusType JAC_load (const char *bias_file, gmhmm_type *gv,
 TIesrEngineJACStatusType JAC_save(const char *bias_file, gmhmm_type *gv );
 
 
+/*-----------------------------------------------------------------------------
+  JAC_save_profile
+
+  Save the state that JAC_save writes to a file as the adaptation
+  profile of aId in a profile store, replacing any prior profile of aId.
+
+  Arguments:
+  aStore: Profile store
+  aId: ID of the speaker or channel
+  gv: Pointer to the ASR structure holding recognition state information
+  --------------------------------*/
+TIesrEngineJACStatusType JAC_save_profile( TIesrProfileStoreType *aStore,
+					   const char *aId, gmhmm_type *gv );
+
+
+/*-----------------------------------------------------------------------------
+  JAC_load_profile
+
+  Load the adaptation profile of aId from a profile store between
+  utterances, as JAC_load does from a file.  Returns
+  eTIesrEngineJACLoadFail and leaves the state unchanged if the store
+  holds no profile of aId, or the profile was saved by a recognizer
+  with other models or configuration.  Only the adaptation state is
+  copied, so the cost does not depend on the size of the models.  The
+  means are compensated for the new state in the next utterance, and
+  with rapid JAC each mean is compensated when the search first uses
+  it.  With rapid JAC, if the clean means needed for that can not be
+  allocated or reloaded, the adaptation state is loaded but the means
+  keep their present compensation, and the rj_lazy_open error is
+  returned.
+
+  Arguments:
+  aStore: Profile store
+  aId: ID of the speaker or channel
+  gv: Pointer to the ASR structure holding recognition state information
+  --------------------------------*/
+TIesrEngineJACStatusType JAC_load_profile( TIesrProfileStoreType *aStore,
+					   const char *aId, gmhmm_type *gv );
+
+
 /*-----------------------------------------------------------------------------
   JAC_clear
 
@@ -106,4 +148,24 @@ TIesrEngineJACStatusType JAC_clear(gmhmm_type *gv,
 /* GMHMM_SI_API */ 
 TIesrEngineJACStatusType JAC_update(gmhmm_type *gv);
 
+
+/*--------------------------------
+  jac_em_open
+
+  Use the process-wide pool of threads that compute the segment
+  likelihoods of JAC_update. The pool threads are started by the first
+  recognizer opened, and shared by all recognizers. If no thread can be
+  started the likelihoods are computed in the thread calling JAC_update.
+  --------------------------------*/
+void jac_em_open(gmhmm_type *gv);
+
+
+/*--------------------------------
+  jac_em_close
+
+  Stop using the EM pool. The pool threads are stopped when the last
+  recognizer using them is closed.
+  --------------------------------*/
+void jac_em_close(gmhmm_type *gv);
+
 #endif
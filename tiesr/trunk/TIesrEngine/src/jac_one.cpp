@@ -37,6 +37,13 @@
 
 #include "tiesr_config.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+#include <pthread.h>
+#endif
+
 #include "tiesrcommonmacros.h"
 #include "mfcc_f_user.h"
 #include "pmc_f_user.h"
@@ -157,7 +164,15 @@ TIesrEngineJACStatusType per_frame_jac_compensate(short mfcc_buf[], gmhmm_type *
    */
    if (gv->signal_cnt==10 || gv->speech_detected == 1)//   if (gv->speech_detected == 1)
    {
-      if(gv->comp_type & SVA) sva_compensate( gv );
+      if(gv->comp_type & SVA)
+      {
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+	 if( gv->pJacBg )
+	    jac_bg_request( JACBG_SVA, gv );
+	 else
+#endif
+	    sva_compensate( gv );
+      }
    }
 #endif
 
@@ -230,6 +245,21 @@ TIesrEngineJACStatusType per_frame_jac_compensate(short mfcc_buf[], gmhmm_type *
    if (gv->speech_detected ==1 || gv->signal_cnt >=NOISEWAIT) 
    {
       TIesrEngineJACStatusType jacStatus;
+
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+      /* Lazy compensation only updates the cluster biases here */
+      if( gv->pJacBg && !((OFFLINE_VQ_HMM_type*) gv->offline_vq)->mu_clean )
+      {
+	 jac_bg_request( JACBG_JAC, gv );
+
+	 /* Search can not start until compensated means exist */
+	 if( gv->speech_detected == 1 )
+	    jac_bg_wait_means( gv );
+
+	 return eTIesrEngineJACSuccess;
+      }
+#endif
+
       jacStatus = rj_proc(gv);
       if( jacStatus != eTIesrEngineJACSuccess )
 	 return jacStatus;
@@ -305,6 +335,7 @@ void jac_one_mean(gmhmm_type *gv, ushort index_mean)
        gv->log_H, 1, gv->n_mfcc, gv->n_filter, gv->muScaleP2, gv->scale_mu, gv->cosxfm, 
        NULL, b8bit);
 
+  SEARCH_STAT( gv->stats_frm.jac_vectors++ );
 }
 
 #ifdef USE_SVA
@@ -422,25 +453,50 @@ static void sva_weightedSVA(short * log_var_rho, short * linear_rho, short num_d
   ----------------------------------------------------------------*/
 static void sva_compensate( gmhmm_type* gv )
 {
-   short org_precis[ MAX_DIM ];
-   short new_precis[ MAX_DIM ];
    short linear_rho[ MAX_DIM ];
-   short vecindex;
-   short dim;
-   long prod;
-   short *invvarorig;
-   short *invvar;
-         
+
+   sva_multipliers( linear_rho, gv );
+   sva_apply( linear_rho, gv->base_var, gv->base_gconst, gv );
+}
+
+
+/*----------------------------------------------------------------
+  sva_multipliers
+
+  This function calculates the linear multiplying factors of the
+  inverse variances for the present utterance.
+  ----------------------------------------------------------------*/
+static void sva_multipliers( short* linear_rho, gmhmm_type* gv )
+{
    /* Calculate the linear multiplying factors in linear_rho */
    sva_init_multipliers( gv->log_var_rho, linear_rho, gv->nbr_dim );
 
 #ifdef USE_WSVA
    sva_weightedSVA(gv->log_var_rho, linear_rho, gv->nbr_dim, gv); 
 #endif
-   
+}
+
+
+/*----------------------------------------------------------------
+  sva_apply
+
+  This function compensates all original mfcc inverse variance vectors
+  by the linear multiplying factors. Only the original variances and
+  model sizes are read from gv, so the output may be a spare buffer
+  filled by the background worker.
+  ----------------------------------------------------------------*/
+static void sva_apply( const short* linear_rho, short* invvar, short* gconst,
+		       gmhmm_type* gv )
+{
+   short org_precis[ MAX_DIM ];
+   short new_precis[ MAX_DIM ];
+   short vecindex;
+   short dim;
+   long prod;
+   short *invvarorig;
+         
    /* Locations of original and compensated inverse variances */
    invvarorig = gv->base_var_orig;
-   invvar = gv->base_var;
 
    /* Loop over all inverse variance vectors */
    for( vecindex = 0; vecindex < gv->n_var; vecindex++ )
@@ -498,7 +554,7 @@ static void sva_compensate( gmhmm_type* gv )
       /* Recalculate the Gaussian constant based on the
 	 compensated variance */
       //    printf(" %f ", gv->base_gconst[i] / (float)(1<<6));
-      gv->base_gconst[vecindex] = 
+      gconst[vecindex] = 
 	 gauss_det_const( new_precis, 2, gv->muScaleP2, gv->nbr_dim);
       //    printf(" %f\n", gv->base_gconst[i] / (float)(1<<6));
   }
@@ -571,3 +627,451 @@ static unsigned short expn_plus_q9(const short xQ9)
 
 
 #endif //#ifdef USE_SVA
+
+
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+
+/* The worker pool shared by all recognizers. jac_bg_users_mutex
+   serializes starting and stopping the pool threads. */
+static JACBgPoolType jac_bg_pool = { {}, 0, 0, PTHREAD_MUTEX_INITIALIZER,
+				     PTHREAD_COND_INITIALIZER, NULL, FALSE };
+static pthread_mutex_t jac_bg_users_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*----------------------------------------------------------------
+  jac_bg_free
+
+  Free the spare buffers and the worker structure.
+  ----------------------------------------------------------------*/
+static void jac_bg_free( JACBgType* bg )
+{
+   if( bg->var )
+      free( bg->var );
+   if( bg->gconst )
+      free( bg->gconst );
+#ifdef RAPID_JAC
+   if( bg->mu )
+      free( bg->mu );
+   if( bg->vq_bias )
+      free( bg->vq_bias );
+#endif
+   free( bg );
+}
+
+
+/*----------------------------------------------------------------
+  jac_bg_start
+
+  Queue the waiting job on the worker pool if no job is in progress and
+  the spare buffers are free. Called with the recognizer mutex locked.
+  ----------------------------------------------------------------*/
+static void jac_bg_start( JACBgType* bg )
+{
+   JACBgPoolType* pool = &jac_bg_pool;
+   JACBgType** pbg;
+
+   if( bg->bBusy || bg->ready || bg->next.mask == 0 )
+      return;
+
+   bg->job = bg->next;
+   bg->next.mask = 0;
+   bg->bBusy = TRUE;
+
+   pthread_mutex_lock( &pool->mutex );
+   bg->link = NULL;
+   for( pbg = &pool->head; *pbg; pbg = &(*pbg)->link ) ;
+   *pbg = bg;
+   pthread_cond_signal( &pool->cond );
+   pthread_mutex_unlock( &pool->mutex );
+}
+
+
+#ifdef RAPID_JAC
+/*----------------------------------------------------------------
+  jac_bg_means
+
+  Rapid JAC compensation of all means into the spare buffers. This is
+  rj_noise_compensation followed by rj_compensate, using the job noise
+  and channel estimates. The model means are still the clean means
+  loaded with the models, since they are only swapped once.
+  ----------------------------------------------------------------*/
+static void jac_bg_means( JACBgType* bg, gmhmm_type* gv )
+{
+   OFFLINE_VQ_HMM_type* vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+   short mu16[ MAX_DIM ];
+   short *mu, *sp_bias, *mumu;
+   short i, k;
+   ushort n;
+
+   for( i = 0; i < vqhmm->n_cs; i++ )
+   {
+      pmc( vqhmm->vq_centroid + i * gv->nbr_dim, bg->job.log_N, mu16,
+	   bg->job.log_H, 1, gv->n_mfcc, gv->n_filter, gv->muScaleP2, gv->scale_mu,
+	   gv->cosxfm, bg->vq_bias + i * gv->nbr_dim, FALSE );
+   }
+
+   for( n = 0; n < gv->n_mu; n++ )
+   {
+      mu = gv->base_mu + n * gv->nbr_dim;
+      mumu = bg->mu + n * gv->nbr_dim;
+      sp_bias = bg->vq_bias + vqhmm->pRAM2Cls[n] * gv->nbr_dim;
+
+      for( k = gv->nbr_dim - 1; k >= 0; k-- )
+	 mumu[k] = mu[k] + sp_bias[k];
+   }
+}
+#endif
+
+
+/*----------------------------------------------------------------
+  jac_bg_thread
+
+  The worker takes the oldest queued recognizer, computes its job into
+  the spare buffers, and marks it ready to be swapped in. The
+  recognizer may be closed as soon as its mutex is released.
+  ----------------------------------------------------------------*/
+static void* jac_bg_thread( void* arg )
+{
+   JACBgPoolType* pool = (JACBgPoolType*) arg;
+   JACBgType* bg;
+   gmhmm_type* gv;
+
+   pthread_mutex_lock( &pool->mutex );
+   while( TRUE )
+   {
+      while( !pool->head && !pool->bExit )
+	 pthread_cond_wait( &pool->cond, &pool->mutex );
+
+      if( pool->bExit )
+	 break;
+
+      bg = pool->head;
+      pool->head = bg->link;
+      pthread_mutex_unlock( &pool->mutex );
+
+      gv = bg->gv;
+
+#ifdef USE_SVA
+      if( bg->job.mask & JACBG_SVA )
+	 sva_apply( bg->job.linear_rho, bg->var, bg->gconst, gv );
+#endif
+
+#ifdef RAPID_JAC
+      if( bg->job.mask & JACBG_JAC )
+	 jac_bg_means( bg, gv );
+#endif
+
+      pthread_mutex_lock( &bg->mutex );
+      bg->bBusy = FALSE;
+      bg->ready = bg->job.mask;
+      pthread_cond_broadcast( &bg->cond );
+      pthread_mutex_unlock( &bg->mutex );
+
+      pthread_mutex_lock( &pool->mutex );
+   }
+   pthread_mutex_unlock( &pool->mutex );
+
+   return NULL;
+}
+
+
+/*----------------------------------------------------------------
+  jac_bg_request
+
+  Record the inputs of a compensation job and start it if possible.
+  The SVA multipliers are calculated here, so gv->log_var_rho is
+  updated at the same point as for inline compensation. Mean
+  compensation is only done once, as in rj_compensate.
+  ----------------------------------------------------------------*/
+static void jac_bg_request( short mask, gmhmm_type* gv )
+{
+   JACBgType* bg = (JACBgType*) gv->pJacBg;
+   ushort i;
+
+#ifdef RAPID_JAC
+   if( mask & JACBG_JAC )
+   {
+      OFFLINE_VQ_HMM_type* vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+
+      if( bg->bMeanRequested || vqhmm->bCompensated )
+	 mask &= ~JACBG_JAC;
+      else
+	 bg->bMeanRequested = TRUE;
+   }
+#else
+   mask &= ~JACBG_JAC;
+#endif
+
+   if( mask == 0 )
+      return;
+
+   pthread_mutex_lock( &bg->mutex );
+
+#ifdef USE_SVA
+   if( mask & JACBG_SVA )
+      sva_multipliers( bg->next.linear_rho, gv );
+#endif
+
+   if( mask & JACBG_JAC )
+   {
+      for( i = 0; i < gv->n_filter; i++ )
+      {
+	 bg->next.log_N[i] = gv->log_N[i];
+	 bg->next.log_H[i] = gv->log_H[i];
+      }
+   }
+
+   bg->next.mask |= mask;
+   jac_bg_start( bg );
+
+   pthread_mutex_unlock( &bg->mutex );
+}
+
+
+/*----------------------------------------------------------------
+  jac_bg_wait_means
+
+  Block until the requested mean compensation is swapped in. This only
+  waits if speech is detected before the first mean compensation
+  completes.
+  ----------------------------------------------------------------*/
+static void jac_bg_wait_means( gmhmm_type* gv )
+{
+#ifdef RAPID_JAC
+   JACBgType* bg = (JACBgType*) gv->pJacBg;
+   OFFLINE_VQ_HMM_type* vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+
+   while( bg->bMeanRequested && !vqhmm->bCompensated )
+   {
+      pthread_mutex_lock( &bg->mutex );
+      while( bg->bBusy )
+	 pthread_cond_wait( &bg->cond, &bg->mutex );
+      pthread_mutex_unlock( &bg->mutex );
+
+      jac_bg_publish( gv );
+   }
+#endif
+}
+
+#endif /* JAC_BACKGROUND_COMPENSATION */
+
+
+/*----------------------------------------------------------------
+  jac_bg_open
+
+  Allocate the spare buffers and use the background compensation
+  worker pool, starting its threads if this is the first recognizer
+  using it. On any failure the worker pool is not used.
+  ----------------------------------------------------------------*/
+void jac_bg_open( gmhmm_type* gv )
+{
+   gv->pJacBg = NULL;
+
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+   {
+      JACBgPoolType* pool = &jac_bg_pool;
+      JACBgType* bg;
+      Boolean failed;
+      ushort i;
+#ifdef BIT8VAR
+      int var_size = gv->n_mfcc;
+#else
+      int var_size = gv->nbr_dim;
+#endif
+
+      bg = (JACBgType*) malloc( sizeof(JACBgType) );
+      if( !bg )
+	 return;
+
+      bg->var = (short*) malloc( gv->n_var * var_size * sizeof(short) );
+      bg->gconst = (short*) malloc( gv->n_var * sizeof(short) );
+      failed = ( !bg->var || !bg->gconst );
+
+#ifdef RAPID_JAC
+      {
+	 OFFLINE_VQ_HMM_type* vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+	 bg->mu = (short*) malloc( gv->n_mu * gv->nbr_dim * sizeof(short) );
+	 bg->vq_bias = (short*) malloc( vqhmm->n_cs * gv->nbr_dim * sizeof(short) );
+	 failed |= ( !bg->mu || !bg->vq_bias );
+      }
+#endif
+
+      if( failed )
+      {
+	 jac_bg_free( bg );
+	 return;
+      }
+
+      bg->gv = gv;
+      bg->link = NULL;
+      bg->next.mask = 0;
+      bg->bBusy = FALSE;
+      bg->ready = 0;
+      bg->bMeanRequested = FALSE;
+
+      pthread_mutex_lock( &jac_bg_users_mutex );
+      if( pool->n_users == 0 )
+      {
+	 pool->bExit = FALSE;
+	 pool->n_threads = 0;
+	 for( i = 0; i < JAC_BG_THREADS; i++ )
+	 {
+	    if( pthread_create( &pool->thread[ pool->n_threads ], NULL,
+				jac_bg_thread, pool ) != 0 )
+	       break;
+	    pool->n_threads++;
+	 }
+      }
+
+      /* Without a pool thread, compensation is done inline */
+      if( pool->n_threads == 0 )
+      {
+	 pthread_mutex_unlock( &jac_bg_users_mutex );
+	 jac_bg_free( bg );
+	 return;
+      }
+
+      pool->n_users++;
+      pthread_mutex_unlock( &jac_bg_users_mutex );
+
+      pthread_mutex_init( &bg->mutex, NULL );
+      pthread_cond_init( &bg->cond, NULL );
+
+      gv->pJacBg = (short*) bg;
+   }
+#endif
+}
+
+
+/*----------------------------------------------------------------
+  jac_bg_close
+
+  Discard any job of the recognizer that has not been swapped in, and
+  free its buffers. The pool threads are stopped if this is the last
+  recognizer using them.
+  ----------------------------------------------------------------*/
+void jac_bg_close( gmhmm_type* gv )
+{
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+   JACBgPoolType* pool = &jac_bg_pool;
+   JACBgType* bg = (JACBgType*) gv->pJacBg;
+   JACBgType** pbg;
+   ushort i;
+
+   if( !bg )
+      return;
+
+   /* Remove a job not yet taken by a worker, and wait for a job that
+      has been taken */
+   pthread_mutex_lock( &bg->mutex );
+   if( bg->bBusy )
+   {
+      pthread_mutex_lock( &pool->mutex );
+      for( pbg = &pool->head; *pbg; pbg = &(*pbg)->link )
+      {
+	 if( *pbg == bg )
+	 {
+	    *pbg = bg->link;
+	    bg->bBusy = FALSE;
+	    break;
+	 }
+      }
+      pthread_mutex_unlock( &pool->mutex );
+   }
+
+   while( bg->bBusy )
+      pthread_cond_wait( &bg->cond, &bg->mutex );
+   pthread_mutex_unlock( &bg->mutex );
+
+   pthread_mutex_lock( &jac_bg_users_mutex );
+   if( --pool->n_users == 0 )
+   {
+      pthread_mutex_lock( &pool->mutex );
+      pool->bExit = TRUE;
+      pthread_cond_broadcast( &pool->cond );
+      pthread_mutex_unlock( &pool->mutex );
+
+      for( i = 0; i < pool->n_threads; i++ )
+	 pthread_join( pool->thread[i], NULL );
+      pool->n_threads = 0;
+   }
+   pthread_mutex_unlock( &jac_bg_users_mutex );
+
+   pthread_cond_destroy( &bg->cond );
+   pthread_mutex_destroy( &bg->mutex );
+   jac_bg_free( bg );
+   gv->pJacBg = NULL;
+#endif
+}
+
+
+/*----------------------------------------------------------------
+  jac_bg_publish
+
+  Swap completed spare buffers with the model buffers, and start any
+  waiting job. If the worker holds its mutex the swap is left to the
+  next frame, so frame processing never blocks here.
+  ----------------------------------------------------------------*/
+void jac_bg_publish( gmhmm_type* gv )
+{
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+   JACBgType* bg = (JACBgType*) gv->pJacBg;
+   short* swap;
+
+   if( !bg || pthread_mutex_trylock( &bg->mutex ) != 0 )
+      return;
+
+   if( bg->ready & JACBG_SVA )
+   {
+      swap = gv->base_var;
+      gv->base_var = bg->var;
+      bg->var = swap;
+
+      swap = gv->base_gconst;
+      gv->base_gconst = bg->gconst;
+      bg->gconst = swap;
+   }
+
+#ifdef RAPID_JAC
+   if( bg->ready & JACBG_JAC )
+   {
+      OFFLINE_VQ_HMM_type* vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+
+      memcpy( vqhmm->vq_bias, bg->vq_bias, vqhmm->n_cs * gv->nbr_dim * sizeof(short) );
+
+      /* Means are compensated only once, so the clean means and the
+	 spare biases are no longer needed */
+      free( gv->base_mu );
+      gv->base_mu = bg->mu;
+      bg->mu = NULL;
+
+      free( bg->vq_bias );
+      bg->vq_bias = NULL;
+
+      vqhmm->bCompensated = TRUE;
+      SEARCH_STAT( gv->stats_frm.jac_vectors += gv->n_mu );
+   }
+#endif
+
+   bg->ready = 0;
+   jac_bg_start( bg );
+
+   pthread_mutex_unlock( &bg->mutex );
+#endif
+}
+
+
+/*----------------------------------------------------------------
+  jac_bg_sync
+
+  Complete a mean compensation requested of the worker. This is done
+  before the means are compensated lazily, since the worker would
+  otherwise replace them when it finishes.
+  ----------------------------------------------------------------*/
+void jac_bg_sync( gmhmm_type* gv )
+{
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+   if( gv->pJacBg )
+      jac_bg_wait_means( gv );
+#endif
+}
@@ -81,6 +81,133 @@ static unsigned short expn_plus_q9( const short x);
 static void sva_compensate( gmhmm_type* gv );
 
 
+/*----------------------------------------------------------------
+  sva_multipliers
+
+  Calculates the linear SVA multipliers for the present utterance,
+  including the weighted SVA update of gv->log_var_rho.
+  ----------------------------------------------------------------*/
+static void sva_multipliers( short* linear_rho, gmhmm_type* gv );
+
+
+/*----------------------------------------------------------------
+  sva_apply
+
+  Compensates all original inverse variance vectors by the linear
+  multipliers, writing the compensated inverse variances and their
+  Gaussian constants to invvar and gconst.
+  ----------------------------------------------------------------*/
+static void sva_apply( const short* linear_rho, short* invvar, short* gconst,
+		       gmhmm_type* gv );
+
+
+#if defined( JAC_BACKGROUND_COMPENSATION ) && defined( LINUX )
+
+/* Background compensation jobs */
+#define JACBG_SVA 1
+#define JACBG_JAC 2
+
+/* Inputs of one background compensation job */
+typedef struct JACBgJob
+{
+  /* Compensations to do, of JACBG_SVA and JACBG_JAC */
+  short mask;
+
+  /* SVA linear inverse variance multipliers, Q12 */
+  short linear_rho[ MAX_DIM ];
+
+  /* Noise and channel log mel spectra for JAC */
+  short log_N[ N_FILTER26 ];
+  short log_H[ N_FILTER26 ];
+} JACBgJobType;
+
+
+/* Background compensation state of a recognizer. The worker writes
+   only to its spare buffers. The frame processing thread swaps the
+   spare buffers with the model buffers in gmhmm_type after a job
+   completes. */
+typedef struct JACBg
+{
+  gmhmm_type *gv;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+
+  /* Next recognizer queued on the worker pool */
+  struct JACBg *link;
+
+  /* Job being computed, and latest job requested while busy */
+  JACBgJobType job;
+  JACBgJobType next;
+
+  /* Job is queued or being computed */
+  Boolean bBusy;
+
+  /* Compensations completed and waiting to be swapped in */
+  short ready;
+
+  /* Mean compensation has been requested */
+  Boolean bMeanRequested;
+
+  /* Spare inverse variances and Gaussian constants */
+  short *var;
+  short *gconst;
+
+#ifdef RAPID_JAC
+  /* Spare means and cluster biases, freed once the means are swapped in */
+  short *mu;
+  short *vq_bias;
+#endif
+} JACBgType;
+
+
+/* Background compensation worker threads, one pool shared by all
+   recognizers of the process. The pool is started by the first OpenASR
+   and stopped by the last CloseASR. Recognizers with a job waiting are
+   queued and served in order. */
+typedef struct JACBgPool
+{
+  pthread_t thread[ JAC_BG_THREADS ];
+  ushort n_threads;
+  ushort n_users;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+
+  /* Recognizers with a job not yet taken by a worker, oldest first */
+  JACBgType *head;
+
+  /* Pool threads should exit */
+  Boolean bExit;
+} JACBgPoolType;
+
+
+/*----------------------------------------------------------------
+  jac_bg_request
+
+  Requests background compensation given the present utterance
+  estimates. A request made while the worker is busy replaces any
+  previous waiting request, and is started after the next swap.
+  ----------------------------------------------------------------*/
+static void jac_bg_request( short mask, gmhmm_type* gv );
+
+
+/*----------------------------------------------------------------
+  jac_bg_wait_means
+
+  Waits until requested mean compensation has been swapped in.
+  ----------------------------------------------------------------*/
+static void jac_bg_wait_means( gmhmm_type* gv );
+
+
+/*----------------------------------------------------------------
+  jac_bg_thread
+
+  Pool worker thread main loop.
+  ----------------------------------------------------------------*/
+static void* jac_bg_thread( void* arg );
+
+#endif
+
+
 #ifdef USE_WSVA
 
 /*
@@ -39,4 +39,21 @@ TIesrEngineJACStatusType per_frame_jac_compensate(short mfcc_buf[], gmhmm_type *
 
 void jac_one_mean(gmhmm_type *gv, ushort index_mean);
 
+/* Use the background compensation worker pool shared by all
+   recognizers, starting it if needed. If no worker can be started,
+   gv->pJacBg is NULL and compensation is done inline. */
+void jac_bg_open(gmhmm_type *gv);
+
+/* Free the background compensation buffers, and stop the worker pool
+   if no other recognizer uses it */
+void jac_bg_close(gmhmm_type *gv);
+
+/* Swap in any completed background compensation. Must be called
+   between frames by the thread processing frames. */
+void jac_bg_publish(gmhmm_type *gv);
+
+/* Wait for any requested mean compensation and swap it in, so the
+   worker no longer changes the model means. */
+void jac_bg_sync(gmhmm_type *gv);
+
 #endif
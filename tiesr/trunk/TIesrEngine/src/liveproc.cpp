@@ -43,6 +43,8 @@
 #include "search_user.h"
 #include "jac_one_user.h"
 #include "gmhmm_si_api.h"
+#include "gmhmm_type_common_user.h"
+#include "trace_user.h"
 #if defined(USE_GAUSS_SELECT) || defined(USE_ORM_VAD) 
 #include "rapidsearch_user.h"
 #endif
@@ -104,6 +106,8 @@ MP_CallEachPass(short sig_frm[], gmhmm_type * gvv, Boolean bDoSearch)
   /* put into circular buffer, for regression computation */
   idx = circ_idx( gv->signal_cnt );
 
+  TRACE_BEGIN( gv, trace_start );
+
 #ifdef USE_SNR_SS
     ss_mfcc_a_window(gv->sample_signal, gv->mfcc_buf[ idx ], log_mel_energy, gv->n_mfcc, 
 		     gv->n_filter, gv->mel_filter, gv->cosxfm,power_spectrum, 
@@ -114,8 +118,12 @@ MP_CallEachPass(short sig_frm[], gmhmm_type * gvv, Boolean bDoSearch)
 		  gv->muScaleP2, &var_norm, &(gv->last_sig), gv->pNss);
 #endif
 
+  TRACE_END( gv, "mfcc", trace_start );
+
   /* utterance detection */
+  TRACE_BEGIN( gv, uttdet_start );
   compute_uttdet( power_spectrum, gv->signal_cnt, gv->signal_cnt+1, gv->mfcc_buf[ idx ], gv, &var_norm);
+  TRACE_END( gv, "uttdet", uttdet_start );
 
   if (gv->comp_type & CMN) 
     for ( i = 0; i <  gv->n_mfcc; i++ )  gv->mfcc_buf[ idx ][ i ] -= gv->mfcc_mean[ i ];     /* CMN */
@@ -192,6 +200,9 @@ MP_CallEachPass(short sig_frm[], gmhmm_type * gvv, Boolean bDoSearch)
   }
 #endif
 
+  /* Use any models compensated in the background from this frame on */
+  jac_bg_publish( gv );
+
   if ( gv->speech_detected  ) {
     
     /* several frames has already passed detection, go back */
@@ -208,9 +219,11 @@ MP_CallEachPass(short sig_frm[], gmhmm_type * gvv, Boolean bDoSearch)
 #if defined(USE_GAUSS_SELECT) || defined(USE_ORM_VAD)
     
     /* compute Gaussian cluster scores */
+    TRACE_BEGIN( gv, select_start );
     i = rj_clear_obs_scr(gv, mfcc_feature);
     /* update scores from an on-line reference model */
     rj_update_noise(gv, mfcc_feature, i); 
+    TRACE_END( gv, "gauss_select", select_start );
 
 #if defined(USE_ORM_VAD)
     /* GMM-based VAD */
@@ -240,10 +253,13 @@ MP_CallEachPass(short sig_frm[], gmhmm_type * gvv, Boolean bDoSearch)
 #endif  
 
 
-      /* search needs frm_cnt to start with 0 */
+      /* search needs frm_cnt to start with 0.  Several searches in one
+	 frame are the catch-up of frames buffered by the VAD. */
       
+      TRACE_BEGIN( gv, search_start );
       if (bDoSearch) 
 	a_status = (TIesrEngineStatusType) search_a_frame(p_fea, 1, gv->frm_cnt, gv);
+      TRACE_END( gv, "search", search_start );
       gv->frm_cnt++;
       gv->mfcc_cnt += gv->n_mfcc;
       if ( gv->frm_cnt == gv->max_frame_nbr) 
@@ -285,8 +301,18 @@ TIesrEngineStatusType CallSearchEngine(short sig_frm[], gmhmm_type *gvv,
 				       unsigned int aFramesQueued ) 
 {
   TIesrEngineStatusType a_status = eTIesrEngineSuccess;
+  SEARCH_STAT( unsigned long long start_ns = 0 );
+  TRACE_BEGIN( gvv, trace_start );
   gvv->FramesQueued= aFramesQueued;
 
+#ifdef USE_SEARCH_STATS
+  if( gvv->bStats )
+  {
+    memset( &gvv->stats_frm, 0, sizeof(TIesrEngineStatsType) );
+    start_ns = stats_clock();
+  }
+#endif
+
 #ifdef _MONOPHONE_NET
   a_status = MP_CallEachPass(sig_frm, (gmhmm_type*) gvv->pAux, TRUE); 
     /* use triphone to do second-pass */
@@ -296,6 +322,9 @@ TIesrEngineStatusType CallSearchEngine(short sig_frm[], gmhmm_type *gvv,
   a_status = MP_CallEachPass(sig_frm, gvv, TRUE); 
 #endif 
 
+  SEARCH_STAT( if( gvv->bStats ) stats_end_frame( gvv, start_ns ) );
+  TRACE_END( gvv, "frame", trace_start );
+
   return a_status;
 }
 
@@ -32,6 +32,9 @@
 #include "mfcc_f_user.h"
 #include "pack_user.h"
 #include "load_user.h"
+#include "image_user.h"
+#include "bundle_user.h"
+#include "slot_user.h"
 
 //char *malloc( int );
 
@@ -47,14 +50,135 @@ static void myrewind( FILE *fp )
 }
 
 
+/*----------------------------------------------------------------
+ model_pool_dir
+
+ Get the model pool directory named by a grammar directory.  Returns
+ FALSE if the grammar directory does not name a pool.
+ --------------------------------*/
+static Boolean model_pool_dir( const char *aModelDir, char aPoolDir[ MAX_POOL_NAME ] )
+{
+   char fname[ MAX_STR ];
+   FILE *fp;
+   size_t len;
+   
+   if( strlen( aModelDir ) + strlen( MODEL_POOL_FILE ) + 2 > MAX_STR )
+      return FALSE;
+   
+   sprintf( fname, "%s/%s", aModelDir, MODEL_POOL_FILE );
+   fp = fopen( fname, "r" );
+   if( !fp )
+      return FALSE;
+   
+   if( !fgets( aPoolDir, MAX_POOL_NAME, fp ) )
+      aPoolDir[0] = '\0';
+   fclose( fp );
+   
+   len = strlen( aPoolDir );
+   while( len > 0 && ( aPoolDir[ len - 1 ] == '\n' || aPoolDir[ len - 1 ] == '\r' ) )
+      aPoolDir[ --len ] = '\0';
+   
+   return len > 0;
+}
+
+
+/*----------------------------------------------------------------
+ model_file_open, model_file_read, model_file_length, model_file_close
+
+ A model file is read from disk, or from its contents in a model
+ bundle, so the loading functions need not know where the models are.
+ A file a grammar directory does not hold is read from the model pool
+ the directory names, if any.
+ --------------------------------*/
+Boolean model_file_open( ModelFileType *aFile, const char *aModelDir,
+			 const void *aBundle, const char *aName, const char *aMode )
+{
+   char fname[ MAX_STR ];
+   char poolDir[ MAX_POOL_NAME ];
+   
+   aFile->fp = NULL;
+   aFile->data = NULL;
+   aFile->size = 0;
+   aFile->pos = 0;
+   
+   if( aBundle )
+   {
+      aFile->data = bundle_file( aBundle, aName, &aFile->size );
+      return aFile->data != NULL;
+   }
+   
+   if( aModelDir )
+   {
+      sprintf( fname, "%s/%s", aModelDir, aName );
+      aFile->fp = fopen( fname, aMode );
+      
+      if( !aFile->fp && model_pool_dir( aModelDir, poolDir ) )
+      {
+	 sprintf( fname, "%s/%s", poolDir, aName );
+	 aFile->fp = fopen( fname, aMode );
+      }
+   }
+   else
+      aFile->fp = fopen( aName, aMode );
+   
+   return aFile->fp != NULL;
+}
+
+
 /*--------------------------------*/
-TIESRENGINECOREAPI_API TIesrEngineStatusType load_scales( char *fname, gmhmm_type *gv )
+size_t model_file_read( void *aDst, size_t aSize, size_t aCount, ModelFileType *aFile )
+{
+   if( aFile->fp )
+      return fread( aDst, aSize, aCount, aFile->fp );
+   
+   if( aSize == 0 || !aFile->data )
+      return 0;
+   
+   if( aCount > ( aFile->size - aFile->pos ) / aSize )
+      aCount = ( aFile->size - aFile->pos ) / aSize;
+   memcpy( aDst, aFile->data + aFile->pos, aSize * aCount );
+   aFile->pos += aSize * aCount;
+   return aCount;
+}
+
+
+/*--------------------------------*/
+/* The file is read again from its start */
+long model_file_length( ModelFileType *aFile )
+{
+   long size;
+   
+   if( !aFile->fp )
+   {
+      aFile->pos = 0;
+      return aFile->size;
+   }
+   
+   fseek(aFile->fp, 0, 2);
+   size = ftell(aFile->fp);
+   myrewind(aFile->fp);
+   return size;
+}
+
+
+/*--------------------------------*/
+void model_file_close( ModelFileType *aFile )
+{
+   if( aFile->fp )
+      fclose( aFile->fp );
+   aFile->fp = NULL;
+   aFile->data = NULL;
+}
+
+
+/*--------------------------------*/
+static TIesrEngineStatusType read_scales( const char *mod_dir, const void *aBundle,
+					  const char *fname, gmhmm_type *gv )
 {
-   FILE  *fp;
+   ModelFileType file, *fp = &file;
    size_t nread;
    
-   fp = fopen(fname, "rb");
-   if (!fp)
+   if( !model_file_open( fp, mod_dir, aBundle, fname, "rb" ) )
    {
       PRT_ERR(fprintf(stderr, "can't open %s\n", fname));
       PRT_ERR(exit(0));
@@ -65,17 +189,17 @@ TIESRENGINECOREAPI_API TIesrEngineStatusType load_scales( char *fname, gmhmm_typ
    gv->scale_mu = (short *) malloc( sizeof(short) * gv->n_mfcc * 2 );
    if( gv->scale_mu == NULL )
    {
-      fclose(fp);
+      model_file_close(fp);
       return eTIesrEngineModelFileFail;
    }
    
    
-   nread = fread(gv->scale_mu, sizeof(short), gv->n_mfcc*2, fp);
+   nread = model_file_read(gv->scale_mu, sizeof(short), gv->n_mfcc*2, fp);
    if( nread != (size_t)gv->n_mfcc*2 )
    {
       free(gv->scale_mu);
       gv->scale_mu = NULL;
-      fclose(fp);
+      model_file_close(fp);
       return eTIesrEngineModelFileFail;
    }
    
@@ -83,48 +207,62 @@ TIESRENGINECOREAPI_API TIesrEngineStatusType load_scales( char *fname, gmhmm_typ
    gv->scale_var =(short *) malloc( sizeof(short) * gv->n_mfcc * 2 );
    if( gv->scale_var == NULL )
    {
-      fclose(fp);
+      model_file_close(fp);
       return eTIesrEngineModelFileFail;
    }
    
    
-   nread = fread( gv->scale_var, sizeof(short), gv->n_mfcc*2, fp);
+   nread = model_file_read( gv->scale_var, sizeof(short), gv->n_mfcc*2, fp);
    if( nread != (size_t)gv->n_mfcc*2 )
    {
       free(gv->scale_var);
       gv->scale_var = NULL;
-      fclose(fp);
+      model_file_close(fp);
       return eTIesrEngineModelFileFail;
    }
    
    
-   fclose( fp );
+   model_file_close( fp );
    return eTIesrEngineSuccess;
 }
 
 
+/*--------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType load_scales( char *fname, gmhmm_type *gv )
+{
+   return read_scales( NULL, NULL, fname, gv );
+}
+
+
 /*--------------------------------*/
 /*
  ** return 0 if file open fail
  */
-TIESRENGINECOREAPI_API unsigned short load_n_mfcc( char *fname )
+static unsigned short read_n_mfcc( const char *mod_dir, const void *aBundle,
+				   const char *fname )
 {
-   FILE  *fp;
+   ModelFileType file, *fp = &file;
    unsigned short n_mfcc = 0;
    
-   fp = fopen(fname, "rb");
-   if (!fp)
+   if( !model_file_open( fp, mod_dir, aBundle, fname, "rb" ) )
    {
       PRT_ERR(fprintf(stderr, "can't open %s\n", fname));
       return n_mfcc;
    }
    
-   fread(&n_mfcc, sizeof(unsigned short), 1, fp);
-   fclose( fp );
+   model_file_read(&n_mfcc, sizeof(unsigned short), 1, fp);
+   model_file_close( fp );
    return n_mfcc;
 }
 
 
+/*--------------------------------*/
+TIESRENGINECOREAPI_API unsigned short load_n_mfcc( char *fname )
+{
+   return read_n_mfcc( NULL, NULL, fname );
+}
+
+
 
 /*----------------------------------------------------------------*/
 /*
@@ -132,7 +270,7 @@ TIESRENGINECOREAPI_API unsigned short load_n_mfcc( char *fname )
  */
 
 TIesrEngineStatusType unpacking(short *base, ushort nbr, short n_mfcc,
-FILE *fp, short scale[])
+ModelFileType *fp, short scale[])
 {
    int i;
    unsigned short tmp_sh[ MAX_DIM_MFCC16 ];
@@ -140,7 +278,7 @@ FILE *fp, short scale[])
    size_t nread;
    for (vec = base, i=0; i< nbr; i++, vec += n_mfcc * 2)
    {
-      nread = fread(tmp_sh, sizeof(short), n_mfcc, fp);
+      nread = model_file_read(tmp_sh, sizeof(short), n_mfcc, fp);
       if( nread != (size_t)n_mfcc )
          return eTIesrEngineModelLoadFail;
       vector_unpacking(tmp_sh, vec, scale, n_mfcc);
@@ -153,9 +291,10 @@ FILE *fp, short scale[])
 /* ---------------------------------------------------------------------------
  load mu
  ---------------------------------------------------------------------- */
-short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
+static short *load_mu( const char *mod_dir, const void *aBundle, const char *fname,
+		       gmhmm_type *gv, fileConfiguration_t*  fileConfig )
 {
-   FILE *fp;
+   ModelFileType file, *fp = &file;
    unsigned int vec_size = gv->n_mfcc;
    short *mu; /* array of mean vectors  */
    size_t nread;
@@ -171,16 +310,15 @@ short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
    #endif
    
    
-   fp = fopen(fname, "rb");
-   if( !fp )
+   if( !model_file_open( fp, mod_dir, aBundle, fname, "rb" ) )
       return NULL;
    
    
    /* Read number of mean vectors */
-   nread = fread(&(gv->n_mu), sizeof(unsigned short), 1, fp);
+   nread = model_file_read(&(gv->n_mu), sizeof(unsigned short), 1, fp);
    if( nread != 1 )
    {
-      fclose( fp );
+      model_file_close( fp );
       return NULL;
    }
    
@@ -191,7 +329,7 @@ short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
    mu = (short *) malloc( gv->n_mu * vec_size * sizeof(short) );
    if( !mu )
    {
-      fclose(fp);
+      model_file_close(fp);
       return NULL;
    }
    
@@ -203,8 +341,8 @@ short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
    if( fileConfig->byteMu )
    {
       /* file mu is already in proper format, read in directly */
-      nread = fread(mu, sizeof(short), gv->n_mu * vec_size, fp);
-      fclose( fp );
+      nread = model_file_read(mu, sizeof(short), gv->n_mu * vec_size, fp);
+      model_file_close( fp );
       if( nread != gv->n_mu*vec_size )
       {
          free( mu );
@@ -218,7 +356,7 @@ short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
        interleaved byte format.  It could be put in TIesr Engine.
        See TIesrFlex for the conversion code.  If that is done,
        then a call will be put here to convert. */
-      fclose( fp );
+      model_file_close( fp );
       free( mu );
       return NULL;
    }
@@ -235,7 +373,7 @@ short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
        into non-interleaved short vectors */
       TIesrEngineStatusType status;
       status = unpacking(mu, gv->n_mu, gv->n_mfcc, fp, gv->scale_mu);
-      fclose( fp );
+      model_file_close( fp );
       if( status != eTIesrEngineSuccess )
       {
          free( mu );
@@ -248,8 +386,8 @@ short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
    {
       /* Input data is already in non-interleaved short features,
        read directly */
-      nread = fread(mu, sizeof(short), gv->n_mu * vec_size, fp);
-      fclose( fp );
+      nread = model_file_read(mu, sizeof(short), gv->n_mu * vec_size, fp);
+      model_file_close( fp );
       if( nread != gv->n_mu*vec_size )
       {
          free(mu);
@@ -267,25 +405,25 @@ short *load_mu( char *fname,  gmhmm_type *gv, fileConfiguration_t*  fileConfig )
 /* ---------------------------------------------------------------------------
  load var
  ---------------------------------------------------------------------- */
-static short *load_var( char *fname, gmhmm_type *gv, fileConfiguration_t *fileConfig )
+static short *load_var( const char *mod_dir, const void *aBundle, const char *fname,
+			gmhmm_type *gv, fileConfiguration_t *fileConfig )
 {
-   FILE               *fp;
+   ModelFileType file, *fp = &file;
    short *base_var; /* inverse of variance */
    size_t nread;
    
    /* Open binary inverse variances file or failure */
-   fp = fopen(fname, "rb");
-   if( !fp )
+   if( !model_file_open( fp, mod_dir, aBundle, fname, "rb" ) )
    {
       return NULL;
    }
    
    
    /* Load number of inverse variance vectors */
-   nread = fread(&(gv->n_var), sizeof(unsigned short), 1, fp);
+   nread = model_file_read(&(gv->n_var), sizeof(unsigned short), 1, fp);
    if( nread != 1 )
    {
-      fclose( fp );
+      model_file_close( fp );
       return NULL;
    }
    
@@ -301,7 +439,7 @@ static short *load_var( char *fname, gmhmm_type *gv, fileConfiguration_t *fileCo
    #endif
    if( ! base_var )
    {
-      fclose(fp);
+      model_file_close(fp);
       return NULL;
    }
    
@@ -312,8 +450,8 @@ static short *load_var( char *fname, gmhmm_type *gv, fileConfiguration_t *fileCo
    if( fileConfig->byteVar )
    {
       /* Input file inv variance is already in byte format, read directly. */
-      nread = fread(base_var, sizeof(short), gv->n_var * gv->n_mfcc, fp);
-      fclose(fp);
+      nread = model_file_read(base_var, sizeof(short), gv->n_var * gv->n_mfcc, fp);
+      model_file_close(fp);
       if( nread != (unsigned int)(gv->n_var*gv->n_mfcc) )
       {
          free(base_var);
@@ -327,7 +465,7 @@ static short *load_var( char *fname, gmhmm_type *gv, fileConfiguration_t *fileCo
        to interleaved byte format.  It could be put in TIesr Engine.
        See TIesrFlex for the conversion code.  If that is done, then
        a call will be put here to convert. */
-      fclose( fp );
+      model_file_close( fp );
       free( base_var );
       return NULL;
    }
@@ -344,7 +482,7 @@ static short *load_var( char *fname, gmhmm_type *gv, fileConfiguration_t *fileCo
        into non-interleaved short vectors */
       TIesrEngineStatusType status;
       status = unpacking(base_var, gv->n_var, gv->n_mfcc, fp, gv->scale_var);
-      fclose( fp );
+      model_file_close( fp );
       if( status != eTIesrEngineSuccess )
       {
          free( base_var );
@@ -356,8 +494,8 @@ static short *load_var( char *fname, gmhmm_type *gv, fileConfiguration_t *fileCo
    {
       /* Input data is already in non-interleaved short features,
        read directly */
-      nread = fread(base_var, sizeof(short), gv->n_var * 2 * gv->n_mfcc, fp);
-      fclose( fp );
+      nread = model_file_read(base_var, sizeof(short), gv->n_var * 2 * gv->n_mfcc, fp);
+      model_file_close( fp );
       if( nread != (size_t)gv->n_var * 2 * gv->n_mfcc )
       {
          free(base_var);
@@ -460,28 +598,28 @@ void trans_weight(short *trans_pool, unsigned short len)
 /*
  ** generic load
  */
-TIESRENGINECOREAPI_API short *load_model_file(char fname[], unsigned short *len)
+short *read_model_file( const char *mod_dir, const void *aBundle,
+			const char *fname, unsigned short *len )
 {
-   FILE *fp;
+   ModelFileType file, *fp = &file;
    short *ptr;
    size_t nread;
    
    
-   fp = fopen(fname, "rb");
-   if( !fp )
+   if( !model_file_open( fp, mod_dir, aBundle, fname, "rb" ) )
       return NULL;
    
-   fread(len, sizeof(unsigned short), 1, fp);
+   model_file_read(len, sizeof(unsigned short), 1, fp);
    
    ptr = (short *) malloc((*len) * sizeof(short) );
    if( !ptr )
    {
-      fclose(fp);
+      model_file_close(fp);
       return NULL;
    }
    
-   nread = fread(ptr, sizeof(short), *len, fp);
-   fclose(fp);
+   nread = model_file_read(ptr, sizeof(short), *len, fp);
+   model_file_close(fp);
    if( nread != *len )
    {
       free(ptr);
@@ -492,52 +630,56 @@ TIESRENGINECOREAPI_API short *load_model_file(char fname[], unsigned short *len)
 }
 
 
+/*--------------------------------*/
+TIESRENGINECOREAPI_API short *load_model_file(char fname[], unsigned short *len)
+{
+   return read_model_file( NULL, NULL, fname, len );
+}
+
+
 /* ---------------------------------------------------------------------------
  load word list
  ---------------------------------------------------------------------- */
-static TIesrEngineStatusType
-load_word_list( char *fname, gmhmm_type *gv )
+TIesrEngineStatusType
+read_word_list( const char *mod_dir, const void *aBundle, const char *fname,
+		unsigned short n_word, char ***aVocabulary )
 {
-   FILE      *fp;
+   ModelFileType file, *fp = &file;
    short     i;
    int size;
    char *p_char;
    
-   if ( gv->trans->n_word == 0)
+   if ( n_word == 0)
       return eTIesrEngineSuccess;
    
-   fp = fopen(fname, "r");
-   if( !fp )
+   if( !model_file_open( fp, mod_dir, aBundle, fname, "r" ) )
       return eTIesrEngineModelLoadFail;
    
-   fseek(fp, 0, 2);
-   
-   size = ftell(fp); /* count */
+   size = model_file_length(fp); /* count */
    
-   gv->vocabulary = (char **) malloc( gv->trans->n_word * sizeof(char *) );
-   if( ! gv->vocabulary )
+   *aVocabulary = (char **) malloc( n_word * sizeof(char *) );
+   if( ! *aVocabulary )
    {
-      fclose(fp);
+      model_file_close(fp);
       return eTIesrEngineModelLoadFail;
    }
    
    p_char = (char *) malloc( size * sizeof(char));
    if( ! p_char )
    {
-      free( gv->vocabulary );
-      gv->vocabulary = NULL;
-      fclose(fp);
+      free( *aVocabulary );
+      *aVocabulary = NULL;
+      model_file_close(fp);
       return eTIesrEngineModelLoadFail;
    }
    
    
-   myrewind(fp);
-   fread(p_char, sizeof(char), size, fp);
-   fclose( fp );
+   model_file_read(p_char, sizeof(char), size, fp);
+   model_file_close( fp );
    
-   for (i = 0; i < gv->trans->n_word; i++)
+   for (i = 0; i < n_word; i++)
    {
-      gv->vocabulary[ i ] = p_char;
+      (*aVocabulary)[ i ] = p_char;
       while (*p_char != '\n') p_char++;
       *p_char = '\0'; /* replace line-feed by string end */
       p_char++;
@@ -548,6 +690,14 @@ load_word_list( char *fname, gmhmm_type *gv )
 }
 
 
+static TIesrEngineStatusType
+load_word_list( const char *mod_dir, const void *aBundle, const char *fname,
+		gmhmm_type *gv )
+{
+   return read_word_list( mod_dir, aBundle, fname, gv->trans->n_word, &gv->vocabulary );
+}
+
+
 /*--------------------------------*/
 TIESRENGINECOREAPI_API void free_scales(gmhmm_type *gv)
 {
@@ -561,6 +711,10 @@ TIESRENGINECOREAPI_API void free_scales(gmhmm_type *gv)
 /*--------------------------------*/
 TIESRENGINECOREAPI_API void free_models(gmhmm_type *gv)
 {
+   /* Release the models used in place in an image */
+   if( gv->pImage )
+      free_models_image( gv );
+   
    if( gv->base_net )
       free( gv->base_net );
    if( gv->base_hmms )
@@ -600,6 +754,90 @@ TIESRENGINECOREAPI_API void free_models(gmhmm_type *gv)
 }
 
 
+/*----------------------------------------------------------------
+ load_network
+
+ Load the grammar network and word list of a grammar directory, without
+ its models.  The network and word list are freed by free_network.
+ ----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API
+TIesrEngineStatusType load_network( char *mod_dir, short **aNet, char ***aVocabulary )
+{
+   unsigned short len;
+   TIesrEngineStatusType status;
+   
+   *aVocabulary = NULL;
+   
+   *aNet = read_model_file( mod_dir, NULL, file_names[1], &len );
+   if( ! *aNet )
+      return eTIesrEngineModelLoadFail;
+   
+   status = read_word_list( mod_dir, NULL, file_names[0],
+			    ((TransType *) *aNet)->n_word, aVocabulary );
+   if( status != eTIesrEngineSuccess )
+   {
+      free( *aNet );
+      *aNet = NULL;
+      return eTIesrEngineModelLoadFail;
+   }
+   
+   status = link_slots( mod_dir, NULL, aNet, aVocabulary );
+   if( status != eTIesrEngineSuccess )
+   {
+      free_network( *aNet, *aVocabulary );
+      *aNet = NULL;
+      *aVocabulary = NULL;
+      return eTIesrEngineModelLoadFail;
+   }
+   
+   return eTIesrEngineSuccess;
+}
+
+
+/*----------------------------------------------------------------
+ load_hmms
+
+ Load the list of HMMs a grammar directory holds itself.  The list is
+ NULL if the directory holds none, in which case its network indexes
+ the HMMs of the model pool it names, or of the models it was compiled
+ against.  The list is freed by free.
+ ----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API
+TIesrEngineStatusType load_hmms( const char *mod_dir, unsigned short **aHmms )
+{
+   char fname[ MAX_STR ];
+   ModelFileType file;
+   unsigned short len;
+   
+   *aHmms = NULL;
+   if( strlen( mod_dir ) + strlen( file_names[2] ) + 2 > MAX_STR )
+      return eTIesrEngineModelLoadFail;
+   
+   sprintf( fname, "%s/%s", mod_dir, file_names[2] );
+   if( !model_file_open( &file, NULL, NULL, fname, "rb" ) )
+      return eTIesrEngineSuccess;
+   model_file_close( &file );
+   
+   *aHmms = (unsigned short *) read_model_file( NULL, NULL, fname, &len );
+   return *aHmms ? eTIesrEngineSuccess : eTIesrEngineModelLoadFail;
+}
+
+
+/*--------------------------------*/
+TIESRENGINECOREAPI_API void free_network( short *aNet, char **aVocabulary )
+{
+   if( aNet )
+      free( aNet );
+   
+   if( aVocabulary )
+   {
+      if( aVocabulary[0] )
+         free( aVocabulary[0] );
+      free( aVocabulary );
+   }
+}
+
+
 /*----------------------------------------------------------------
  load_model_config
 
@@ -609,19 +847,17 @@ TIESRENGINECOREAPI_API void free_models(gmhmm_type *gv)
  short or byte.
 
  ----------------------------------------------------------------*/
-TIesrEngineStatusType load_model_config(char fname[],
-fileConfiguration_t *fileConfig )
+TIesrEngineStatusType load_model_config( const char *mod_dir, const void *aBundle,
+					 const char *fname,
+					 fileConfiguration_t *fileConfig )
 {
-   FILE *fp;
+   ModelFileType file, *fp = &file;
    size_t nread;
    
    
-   fp = fopen(fname, "rb");
-   
-   
    /* If configuration file is not available, assume the last assumption for
     creating models, that is, the models have byte mean and variance. */
-   if( !fp )
+   if( !model_file_open( fp, mod_dir, aBundle, fname, "rb" ) )
    {
       fileConfig->byteMu = 1;
       fileConfig->byteVar = 1;
@@ -630,9 +866,9 @@ fileConfiguration_t *fileConfig )
    }
    
    /* Read configuration parameters into configuration structure */
-   nread = fread( &fileConfig->byteMu, sizeof(short), 1, fp);
-   nread = fread( &fileConfig->byteVar, sizeof(short), 1, fp);
-   fclose(fp);
+   nread = model_file_read( &fileConfig->byteMu, sizeof(short), 1, fp);
+   nread = model_file_read( &fileConfig->byteVar, sizeof(short), 1, fp);
+   model_file_close(fp);
    
    
    /* Check for enough data to read last parameter */
@@ -650,23 +886,40 @@ TIESRENGINECOREAPI_API
 TIesrEngineStatusType load_mean_vec(char * mod_dir, gmhmm_type * gv ,
 Boolean bLoadBaseMu )
 {
-   char fname[ MAX_STR ];
    TIesrEngineStatusType status;
    fileConfiguration_t fileConfig;
    
+   /* Means of models mapped from an image are copied from the image */
+   if( gv->pImage )
+   {
+      if( gv->base_mu == NULL && bLoadBaseMu )
+      {
+         gv->base_mu = image_copy( gv, IMAGE_MU );
+         if( ! gv->base_mu )
+            return eTIesrEngineModelLoadFail;
+      }
+      
+      if( gv->base_mu_orig == NULL && bLoadBaseMu == FALSE )
+      {
+         gv->base_mu_orig = image_copy( gv, IMAGE_MU );
+         if( ! gv->base_mu_orig )
+            return eTIesrEngineModelLoadFail;
+      }
+      return eTIesrEngineSuccess;
+   }
+   
    /* Read the configuration of input file model data.  For now, if no
     configuration file is available, byte means and variances are
     assumed, since this was the last way we were assuming data was
-    written to binary model files. */
-   sprintf(fname, "%s/%s", mod_dir, file_names[11]);
-   status = load_model_config( fname, &fileConfig );
+    written to binary model files.  Models loaded from a bundle are
+    read from it again. */
+   status = load_model_config( mod_dir, gv->pBundle, file_names[11], &fileConfig );
    if( status != eTIesrEngineSuccess )
       return eTIesrEngineModelLoadFail;
    
-   sprintf( fname, "%s/%s", mod_dir, file_names[3] );
    if (gv->base_mu == NULL && bLoadBaseMu)
    {
-      gv->base_mu = load_mu( fname, gv, &fileConfig );
+      gv->base_mu = load_mu( mod_dir, gv->pBundle, file_names[3], gv, &fileConfig );
       if( ! gv->base_mu )
          return eTIesrEngineModelLoadFail;
    }
@@ -674,7 +927,7 @@ Boolean bLoadBaseMu )
    /* load mu again for PMC */
    if (gv->base_mu_orig == NULL && bLoadBaseMu == FALSE)
    {
-      gv->base_mu_orig = load_mu( fname, gv, &fileConfig );
+      gv->base_mu_orig = load_mu( mod_dir, gv->pBundle, file_names[3], gv, &fileConfig );
       if( ! gv->base_mu_orig )
          return eTIesrEngineModelLoadFail;
    }
@@ -686,23 +939,25 @@ Boolean bLoadBaseMu )
 /*
  ** return the mfcc dimension of the feature, 0 if mfcc dimension file does not exist
  */
-TIESRENGINECOREAPI_API
-TIesrEngineStatusType load_models(char *mod_dir, gmhmm_type *gv, char bMonoNet,
-char * network_file , char* word_list_file)
+static TIesrEngineStatusType load_models_from( const char *mod_dir, const void *aBundle,
+					       gmhmm_type *gv, char bMonoNet,
+					       char * network_file , char* word_list_file )
 {
-   char fname[ MAX_STR ];
    unsigned short len;
    TIesrEngineStatusType status;
    fileConfiguration_t fileConfig;
    
    
+   /* Models are read from files or a bundle, not mapped from an image */
+   gv->pImage = NULL;
+   gv->pBundle = (const unsigned char*) aBundle;
+   
    /* Initialization of byte to short scale vectors */
    gv->scale_mu = NULL;
    gv->scale_var = NULL;
    
    /* read the dimension of mfcc */
-   sprintf(fname, "%s/%s", mod_dir, file_names[9]);
-   gv->n_mfcc = load_n_mfcc( fname );
+   gv->n_mfcc = read_n_mfcc( mod_dir, aBundle, file_names[9] );
    if (gv->n_mfcc == 0)
       return  eTIesrEngineModelLoadFail;
    
@@ -711,16 +966,14 @@ char * network_file , char* word_list_file)
     configuration file is available, byte means and variances are
     assumed, since this was the last way we were assuming data was
     written to binary model files. */
-   sprintf(fname, "%s/%s", mod_dir, file_names[11]);
-   status = load_model_config( fname, &fileConfig );
+   status = load_model_config( mod_dir, aBundle, file_names[11], &fileConfig );
    if( status != eTIesrEngineSuccess )
       return eTIesrEngineModelLoadFail;
    
    /* Read the scaling of mean and variance if mu.bin or var.bin in byte. */
    if( fileConfig.byteMu || fileConfig.byteVar )
    {
-      sprintf(fname, "%s/%s", mod_dir, file_names[10]);
-      status = load_scales( fname, gv );
+      status = read_scales( mod_dir, aBundle, file_names[10], gv );
       if( status != eTIesrEngineSuccess )
          return eTIesrEngineModelLoadFail;
    }
@@ -743,8 +996,7 @@ char * network_file , char* word_list_file)
    {
       if (!bMonoNet)
       {
-         sprintf(fname, "%s/%s", mod_dir, file_names[1]);
-         gv->base_net =  load_model_file(fname, &len);
+         gv->base_net =  read_model_file( mod_dir, aBundle, file_names[1], &len);
          if( ! gv->base_net )
             return eTIesrEngineModelLoadFail;
          gv->trans = (TransType *) gv->base_net;
@@ -763,13 +1015,12 @@ char * network_file , char* word_list_file)
     */
    if (word_list_file)
    {
-      status = load_word_list( word_list_file, gv );
+      status = load_word_list( NULL, NULL, word_list_file, gv );
       if( status != eTIesrEngineSuccess )
          return eTIesrEngineModelLoadFail;
    }else if (!bMonoNet)
    {
-      sprintf(fname, "%s/%s", mod_dir, file_names[0]);
-      status = load_word_list( fname, gv );
+      status = load_word_list( mod_dir, aBundle, file_names[0], gv );
       if( status != eTIesrEngineSuccess )
          return eTIesrEngineModelLoadFail;
    }else
@@ -777,19 +1028,26 @@ char * network_file , char* word_list_file)
       gv->vocabulary = NULL;
    }
    
+   /* Link the slot networks of the grammar of the model directory */
+   if( !network_file && !word_list_file && !bMonoNet )
+   {
+      status = link_slots( mod_dir, aBundle, &gv->base_net, &gv->vocabulary );
+      if( status != eTIesrEngineSuccess )
+         return eTIesrEngineModelLoadFail;
+      gv->trans = (TransType *) gv->base_net;
+   }
+   
    /*
     ** read all HMM's used in the top level grammar
     */
    
-   sprintf(fname, "%s/%s", mod_dir, file_names[2]);
-   gv->base_hmms =  (unsigned short *)load_model_file(fname, &len);
+   gv->base_hmms =  (unsigned short *)read_model_file( mod_dir, aBundle, file_names[2], &len);
    if( ! gv->base_hmms )
       return eTIesrEngineModelLoadFail;
    
    
    /* load mu, performing conversions as necessary */
-   sprintf( fname, "%s/%s", mod_dir, file_names[3] );
-   gv->base_mu = load_mu( fname, gv, &fileConfig );
+   gv->base_mu = load_mu( mod_dir, aBundle, file_names[3], gv, &fileConfig );
    if( ! gv->base_mu )
       return eTIesrEngineModelLoadFail;
    
@@ -809,21 +1067,20 @@ char * network_file , char* word_list_file)
     been a process in cluster-dependent JAC, inside function of
     rj_compensate(gmhmm_type * gv) */
    #else
-   gv->base_mu_orig = load_mu( fname, gv, &fileConfig );
+   gv->base_mu_orig = load_mu( mod_dir, aBundle, file_names[3], gv, &fileConfig );
    if( ! gv->base_mu_orig )
       return eTIesrEngineModelLoadFail;
    #endif
    
    /* load inverse variance vectors  */
-   sprintf( fname, "%s/%s", mod_dir, file_names[4] );
-   gv->base_var = load_var( fname, gv, &fileConfig );
+   gv->base_var = load_var( mod_dir, aBundle, file_names[4], gv, &fileConfig );
    if( ! gv->base_var )
       return eTIesrEngineModelLoadFail;
    
    #ifdef USE_SVA
    
    /* load var again for SVA */
-   gv->base_var_orig = load_var( fname, gv, &fileConfig );
+   gv->base_var_orig = load_var( mod_dir, aBundle, file_names[4], gv, &fileConfig );
    if( ! gv->base_var_orig )
       return eTIesrEngineModelLoadFail;
    
@@ -833,8 +1090,7 @@ char * network_file , char* word_list_file)
    /*
     ** transition matrix
     */
-   sprintf(fname, "%s/%s", mod_dir, file_names[5]);
-   gv->base_tran = load_model_file(fname, &len);
+   gv->base_tran = read_model_file( mod_dir, aBundle, file_names[5], &len);
    if( ! gv->base_tran )
       return eTIesrEngineModelLoadFail;
    
@@ -845,8 +1101,7 @@ char * network_file , char* word_list_file)
    /*
     ** PDF
     */
-   sprintf(fname, "%s/%s", mod_dir, file_names[6]);
-   gv->base_pdf = (unsigned short *)load_model_file(fname, &(gv->n_pdf));
+   gv->base_pdf = (unsigned short *)read_model_file( mod_dir, aBundle, file_names[6], &(gv->n_pdf));
    if( ! gv->base_pdf )
       return eTIesrEngineModelLoadFail;
    
@@ -862,22 +1117,45 @@ char * network_file , char* word_list_file)
    /*
     ** mixture
     */
-   sprintf(fname, "%s/%s", mod_dir, file_names[7]);
-   gv->base_mixture = load_model_file(fname, &len);
+   gv->base_mixture = read_model_file( mod_dir, aBundle, file_names[7], &len);
    if( ! gv->base_mixture )
       return eTIesrEngineModelLoadFail;
    
    /*
     ** gconst
     */
-   sprintf(fname, "%s/%s", mod_dir, file_names[8]);
-   gv->base_gconst = load_model_file(fname, &len);
+   gv->base_gconst = read_model_file( mod_dir, aBundle, file_names[8], &len);
    if( ! gv->base_gconst )
       return eTIesrEngineModelLoadFail;
    
    return eTIesrEngineSuccess;
 }
 
+
+/*--------------------------------*/
+TIESRENGINECOREAPI_API
+TIesrEngineStatusType load_models(char *mod_dir, gmhmm_type *gv, char bMonoNet,
+char * network_file , char* word_list_file)
+{
+   return load_models_from( mod_dir, NULL, gv, bMonoNet, network_file, word_list_file );
+}
+
+
+/*----------------------------------------------------------------
+ load_models_bundle
+
+ The files of the bundle are read as load_models reads the files of a
+ grammar directory.
+ --------------------------------*/
+TIESRENGINECOREAPI_API
+TIesrEngineStatusType load_models_bundle( const void *aBundle, gmhmm_type *gv )
+{
+   if( !bundle_check( aBundle ) )
+      return eTIesrEngineModelLoadFail;
+   
+   return load_models_from( NULL, aBundle, gv, FALSE, NULL, NULL );
+}
+
 /*-----------------------------------------------------------
  mem_alloc
 
@@ -72,6 +72,15 @@ typedef struct fileConfiguration
       short byteVar;
 } fileConfiguration_t;
 
+/* A model file, read from a model directory or from a model bundle */
+typedef struct
+{
+      FILE *fp;
+      const unsigned char *data;
+      unsigned int size;
+      unsigned int pos;
+} ModelFileType;
+
 /*--------------------------------*/
 /* The user interface to the loading functions */
 
@@ -92,6 +101,34 @@ TIESRENGINECOREAPI_API TIesrEngineStatusType load_models(char *mod_dir, gmhmm_ty
 				  char * network_file, 
 				  char * word_list_file );
 
+/* load the network and word list of a grammar directory, and free them
+   @param mod_dir pointer to grammar directory
+   @param aNet pointer to the loaded network
+   @param aVocabulary pointer to the loaded word list, NULL if no words */
+TIESRENGINECOREAPI_API TIesrEngineStatusType load_network( char *mod_dir, short **aNet,
+							   char ***aVocabulary );
+
+TIESRENGINECOREAPI_API void free_network( short *aNet, char **aVocabulary );
+
+/* load the list of HMMs a grammar directory holds itself, not that of
+   its model pool, NULL if it holds none
+   @param mod_dir pointer to grammar directory
+   @param aHmms pointer to the loaded list */
+TIESRENGINECOREAPI_API TIesrEngineStatusType load_hmms( const char *mod_dir,
+							unsigned short **aHmms );
+
+/* read a model file of shorts from a model directory or bundle
+   @param mod_dir pointer to model directory, or NULL if in aBundle
+   @param fname name of the file
+   @param len pointer to the number of shorts read */
+short *read_model_file( const char *mod_dir, const void *aBundle,
+			const char *fname, unsigned short *len );
+
+/* read a word list of n_word words from a model directory or bundle */
+TIesrEngineStatusType read_word_list( const char *mod_dir, const void *aBundle,
+				      const char *fname, unsigned short n_word,
+				      char ***aVocabulary );
+
 #ifdef USE_16BITMEAN_DECOD
 /* load mean vectors to either base mean for decoding or original mean for adaptation 
    @param mod_dir pointer to model directory
@@ -105,11 +142,29 @@ TIESRENGINECOREAPI_API TIesrEngineStatusType load_mean_vec(char * mod_dir, gmhmm
       @param len pointer to the length of the read data */
 TIESRENGINECOREAPI_API short *load_model_file(char fname[], unsigned short *len);
 
-TIesrEngineStatusType load_model_config(char fname[], 
-					fileConfiguration_t *fileConfig );
+TIesrEngineStatusType load_model_config( const char *mod_dir, const void *aBundle,
+					 const char *fname,
+					 fileConfiguration_t *fileConfig );
 
 TIesrEngineStatusType unpacking(short *base, ushort nbr, short n_mfcc,
-				FILE *fp, short scale[]);
+				ModelFileType *fp, short scale[]);
+
+/* open a model file of a model directory or bundle, and read it as fread does
+   @param aFile pointer to the model file opened
+   @param aModelDir model directory, or NULL if aName is the full file name
+   @param aBundle model bundle holding the file, NULL if the file is on disk
+   @param aName name of the file
+   @param aMode fopen mode of a file on disk
+   returns FALSE if the file can not be opened */
+Boolean model_file_open( ModelFileType *aFile, const char *aModelDir,
+			 const void *aBundle, const char *aName, const char *aMode );
+
+size_t model_file_read( void *aDst, size_t aSize, size_t aCount, ModelFileType *aFile );
+
+/* number of bytes of an open model file */
+long model_file_length( ModelFileType *aFile );
+
+void model_file_close( ModelFileType *aFile );
 
 /* allocate a pointer to a space from a block of memory 
    @param base_mem pointer to the block of memory
@@ -590,8 +590,7 @@ ss_power_spectrum_to_mfcc(const short *power_spectrum,
   compensate = 2*(var_norm->norm0 + var_norm->norm1 - WINDOW_PWR ) +
           var_norm->norm2 - 3;
 
-  for (i = 0; i < n_filter; i++) 
-    log_mel_energy[i] = log_polyfit( mel_energy[i], compensate);
+  log_polyfit_vector( mel_energy, log_mel_energy, n_filter, compensate );
   
   /* log2() to log10() */
   for (i = 0; i < n_filter; i++) {
@@ -664,8 +663,7 @@ power_spectrum_to_mfcc(const short *power_spectrum,
 
   compensate = 2 * var_norm->norm0 + 2 * var_norm->norm1 + var_norm->norm2 - 19;
 
-  for (i = 0; i < n_filter; i++) 
-    log_mel_energy[i] = log_polyfit( mel_energy[i], compensate);
+  log_polyfit_vector( mel_energy, log_mel_energy, n_filter, compensate );
   
   /* log2() to log10() */
   for (i = 0; i < n_filter; i++) {
@@ -717,8 +715,7 @@ fft_spectrum_to_mfcc(const short *real_sig,const short *imag_sig,
   /* norm2 unused, norm2 - 2 + 1 -> -2  */
   compensate = 2 * var_norm->norm0 + 2 * var_norm->norm1 -1 - 19;
 
-  for (i = 0; i < n_filter; i++) 
-    log_mel_energy[i] = log_polyfit( mel_energy[i], compensate);
+  log_polyfit_vector( mel_energy, log_mel_energy, n_filter, compensate );
   
   /* log2() to log10() */
   for (i = 0; i < n_filter; i++) {
@@ -0,0 +1,428 @@
+/*=======================================================================
+
+ *
+ * profile.cpp
+ *
+ * Store of TIesr adaptation profiles.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ Profiles are kept in a hash table for lookup by ID, and in a list
+ ordered by use so the least recently used profile can be discarded.
+ The store does not interpret the snapshots, which are built and
+ checked by JAC_save_profile and JAC_load_profile.
+
+======================================================================*/
+
+/* Headers required by Windows OS */
+#if defined (WIN32) || defined (WINCE)
+#include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tiesr_config.h"
+#include "gmhmm.h"
+#include "profile_user.h"
+
+
+/* Identifier of profile files */
+static const char PROFILE_FILE_MAGIC[4] = { 'T', 'I', 'P', 'S' };
+
+
+/* A profile in the store */
+typedef struct TIesrProfile
+{
+      char *id;
+      unsigned int hash;
+
+      unsigned char *data;
+      unsigned int size;
+
+      /* next profile in the same hash bucket */
+      struct TIesrProfile *hnext;
+
+      /* neighbors in order of use, most recent first */
+      struct TIesrProfile *prev;
+      struct TIesrProfile *next;
+
+} ProfileType;
+
+
+struct TIesrProfileStore
+{
+      unsigned int capacity;
+      unsigned int count;
+
+      /* hash buckets, a power of two in number */
+      ProfileType **buckets;
+      unsigned int n_buckets;
+
+      ProfileType *mru;
+      ProfileType *lru;
+};
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API void profile_put( TIesrProfileBufType *aBuf, const void *aValues, unsigned int aSize )
+{
+   if( aBuf->data )
+   {
+      if( aBuf->pos + aSize > aBuf->size )
+      {
+	 aBuf->failed = TRUE;
+	 return;
+      }
+      memcpy( aBuf->data + aBuf->pos, aValues, aSize );
+   }
+   aBuf->pos += aSize;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API void profile_get( TIesrProfileBufType *aBuf, void *aValues, unsigned int aSize )
+{
+   if( aBuf->pos + aSize > aBuf->size )
+   {
+      aBuf->failed = TRUE;
+      return;
+   }
+   memcpy( aValues, aBuf->data + aBuf->pos, aSize );
+   aBuf->pos += aSize;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API void profile_skip( TIesrProfileBufType *aBuf, unsigned int aSize )
+{
+   if( aBuf->pos + aSize > aBuf->size )
+      aBuf->failed = TRUE;
+   else
+      aBuf->pos += aSize;
+}
+
+
+/*----------------------------------------------------------------*/
+static unsigned int profile_hash( const char *aId )
+{
+   unsigned int hash = 2166136261u;
+
+   while( *aId )
+   {
+      hash ^= (unsigned char) *aId++;
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+
+/*----------------------------------------------------------------*/
+static ProfileType* profile_find( const TIesrProfileStoreType *aStore, const char *aId )
+{
+   unsigned int hash = profile_hash( aId );
+   ProfileType *profile = aStore->buckets[ hash & ( aStore->n_buckets - 1 ) ];
+
+   while( profile && ( profile->hash != hash || strcmp( profile->id, aId ) != 0 ) )
+      profile = profile->hnext;
+
+   return profile;
+}
+
+
+/*----------------------------------------------------------------*/
+static void profile_unlink( TIesrProfileStoreType *aStore, ProfileType *aProfile )
+{
+   if( aProfile->prev )
+      aProfile->prev->next = aProfile->next;
+   else
+      aStore->mru = aProfile->next;
+
+   if( aProfile->next )
+      aProfile->next->prev = aProfile->prev;
+   else
+      aStore->lru = aProfile->prev;
+}
+
+
+/*----------------------------------------------------------------*/
+static void profile_touch( TIesrProfileStoreType *aStore, ProfileType *aProfile )
+{
+   if( aStore->mru == aProfile )
+      return;
+
+   profile_unlink( aStore, aProfile );
+
+   aProfile->prev = NULL;
+   aProfile->next = aStore->mru;
+   if( aStore->mru )
+      aStore->mru->prev = aProfile;
+   aStore->mru = aProfile;
+   if( !aStore->lru )
+      aStore->lru = aProfile;
+}
+
+
+/*----------------------------------------------------------------*/
+static void profile_remove( TIesrProfileStoreType *aStore, ProfileType *aProfile )
+{
+   ProfileType **link = aStore->buckets + ( aProfile->hash & ( aStore->n_buckets - 1 ) );
+
+   while( *link != aProfile )
+      link = &( *link )->hnext;
+   *link = aProfile->hnext;
+
+   profile_unlink( aStore, aProfile );
+   aStore->count--;
+
+   free( aProfile->id );
+   free( aProfile->data );
+   free( aProfile );
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineJACStatusType profile_store_insert( TIesrProfileStoreType *aStore,
+								      const char *aId,
+								      unsigned char *aData,
+								      unsigned int aSize )
+{
+   ProfileType *profile = profile_find( aStore, aId );
+   ProfileType **bucket;
+
+   if( profile )
+   {
+      free( profile->data );
+      profile->data = aData;
+      profile->size = aSize;
+      profile_touch( aStore, profile );
+      return eTIesrEngineJACSuccess;
+   }
+
+   profile = (ProfileType*) malloc( sizeof(ProfileType) );
+   if( profile )
+   {
+      profile->id = (char*) malloc( strlen( aId ) + 1 );
+      if( !profile->id )
+      {
+	 free( profile );
+	 profile = NULL;
+      }
+   }
+   if( !profile )
+   {
+      free( aData );
+      return eTIesrEngineJACMemoryFail;
+   }
+
+   if( aStore->count == aStore->capacity )
+      profile_remove( aStore, aStore->lru );
+
+   strcpy( profile->id, aId );
+   profile->hash = profile_hash( aId );
+   profile->data = aData;
+   profile->size = aSize;
+
+   bucket = aStore->buckets + ( profile->hash & ( aStore->n_buckets - 1 ) );
+   profile->hnext = *bucket;
+   *bucket = profile;
+
+   profile->prev = NULL;
+   profile->next = aStore->mru;
+   if( aStore->mru )
+      aStore->mru->prev = profile;
+   aStore->mru = profile;
+   if( !aStore->lru )
+      aStore->lru = profile;
+
+   aStore->count++;
+   return eTIesrEngineJACSuccess;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API TIesrProfileStoreType* OpenTIesrProfiles( unsigned int aCapacity )
+{
+   TIesrProfileStoreType *store;
+
+   if( aCapacity == 0 )
+      return NULL;
+
+   store = (TIesrProfileStoreType*) malloc( sizeof(TIesrProfileStoreType) );
+   if( !store )
+      return NULL;
+
+   /* At least two buckets per profile */
+   store->n_buckets = 1;
+   while( store->n_buckets < 2 * aCapacity )
+      store->n_buckets <<= 1;
+
+   store->buckets = (ProfileType**) calloc( store->n_buckets, sizeof(ProfileType*) );
+   if( !store->buckets )
+   {
+      free( store );
+      return NULL;
+   }
+
+   store->capacity = aCapacity;
+   store->count = 0;
+   store->mru = NULL;
+   store->lru = NULL;
+
+   return store;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API void CloseTIesrProfiles( TIesrProfileStoreType *aStore )
+{
+   if( !aStore )
+      return;
+
+   while( aStore->lru )
+      profile_remove( aStore, aStore->lru );
+
+   free( aStore->buckets );
+   free( aStore );
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API Boolean profile_store_find( TIesrProfileStoreType *aStore,
+						   const char *aId,
+						   TIesrProfileBufType *aBuf )
+{
+   ProfileType *profile = profile_find( aStore, aId );
+
+   if( !profile )
+      return FALSE;
+
+   profile_touch( aStore, profile );
+
+   aBuf->data = profile->data;
+   aBuf->size = profile->size;
+   aBuf->pos = 0;
+   aBuf->failed = FALSE;
+
+   return TRUE;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API void RemoveTIesrProfile( TIesrProfileStoreType *aStore,
+						const char *aId )
+{
+   ProfileType *profile = profile_find( aStore, aId );
+
+   if( profile )
+      profile_remove( aStore, profile );
+}
+
+
+/*----------------------------------------------------------------
+ WriteTIesrProfiles
+
+ The file holds the number of profiles, followed by the ID length, ID,
+ snapshot size and snapshot of each profile, least recently used first.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineJACStatusType WriteTIesrProfiles( const TIesrProfileStoreType *aStore,
+								    const char *aFileName )
+{
+   const ProfileType *profile;
+   ushort version = PROFILE_VERSION;
+   ushort idLength;
+   Boolean failed;
+   FILE *fp;
+
+   fp = fopen( aFileName, "wb" );
+   if( !fp )
+      return eTIesrEngineJACSaveFail;
+
+   failed = fwrite( PROFILE_FILE_MAGIC, sizeof(PROFILE_FILE_MAGIC), 1, fp ) != 1;
+   failed |= fwrite( &version, sizeof(ushort), 1, fp ) != 1;
+   failed |= fwrite( &aStore->count, sizeof(unsigned int), 1, fp ) != 1;
+
+   for( profile = aStore->lru; profile && !failed; profile = profile->prev )
+   {
+      idLength = (ushort) strlen( profile->id );
+      failed |= fwrite( &idLength, sizeof(ushort), 1, fp ) != 1;
+      failed |= fwrite( profile->id, 1, idLength, fp ) != idLength;
+      failed |= fwrite( &profile->size, sizeof(unsigned int), 1, fp ) != 1;
+      failed |= fwrite( profile->data, 1, profile->size, fp ) != profile->size;
+   }
+
+   failed |= fclose( fp ) != 0;
+
+   return failed ? eTIesrEngineJACSaveFail : eTIesrEngineJACSuccess;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineJACStatusType ReadTIesrProfiles( TIesrProfileStoreType *aStore,
+								   const char *aFileName )
+{
+   char magic[ sizeof(PROFILE_FILE_MAGIC) ];
+   char id[ MAX_STR ];
+   ushort version, idLength;
+   unsigned int count, size, n;
+   unsigned char *data;
+   TIesrEngineJACStatusType status = eTIesrEngineJACSuccess;
+   FILE *fp;
+
+   fp = fopen( aFileName, "rb" );
+   if( !fp )
+      return eTIesrEngineJACLoadFail;
+
+   if( fread( magic, sizeof(magic), 1, fp ) != 1 ||
+       memcmp( magic, PROFILE_FILE_MAGIC, sizeof(magic) ) != 0 ||
+       fread( &version, sizeof(ushort), 1, fp ) != 1 ||
+       version != PROFILE_VERSION ||
+       fread( &count, sizeof(unsigned int), 1, fp ) != 1 )
+   {
+      fclose( fp );
+      return eTIesrEngineJACLoadFail;
+   }
+
+   for( n = 0; n < count && status == eTIesrEngineJACSuccess; n++ )
+   {
+      if( fread( &idLength, sizeof(ushort), 1, fp ) != 1 ||
+	  idLength >= MAX_STR ||
+	  fread( id, 1, idLength, fp ) != idLength ||
+	  fread( &size, sizeof(unsigned int), 1, fp ) != 1 )
+      {
+	 status = eTIesrEngineJACLoadFail;
+	 break;
+      }
+      id[ idLength ] = '\0';
+
+      data = (unsigned char*) malloc( size );
+      if( !data )
+      {
+	 status = eTIesrEngineJACMemoryFail;
+	 break;
+      }
+
+      if( fread( data, 1, size, fp ) != size )
+      {
+	 free( data );
+	 status = eTIesrEngineJACLoadFail;
+	 break;
+      }
+
+      status = profile_store_insert( aStore, id, data, size );
+   }
+
+   fclose( fp );
+   return status;
+}
@@ -0,0 +1,168 @@
+/*=======================================================================
+
+ *
+ * profile_user.h
+ *
+ * Header for interface of the TIesr adaptation profile store.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ An adaptation profile is a snapshot of the adaptation state that
+ JAC_save would write to a JAC state file: the JAC channel estimate and
+ accumulators, and depending on configuration the SVA, WSVA, SBC, ORM
+ and confidence measure parameters.  A profile store keeps the profiles
+ of many speakers or channels in memory, keyed by an ID string, and
+ discards the least recently used profile when it is full.
+
+ JAC_save_profile captures the state of a recognizer into a store, and
+ JAC_load_profile copies it back in.  The snapshots are built by each
+ module with the buffer functions below.
+
+======================================================================*/
+
+#ifndef PROFILE_USER_H
+#define PROFILE_USER_H
+
+
+/*--------------------------------------------------------------
+The Windows method of exporting functions from a DLL.
+---------------------------------------------------------------*/
+#if defined (WIN32) || defined (WINCE)
+
+/* If it is not defined already, define a macro that does
+Windows format export of DLL functions */
+#ifndef TIESRENGINECOREAPI_API
+
+// The following ifdef block is the standard way of creating macros which
+// make exporting from a DLL simpler. All files within this DLL are compiled
+// with the TIESRENGINECOREAPI_EXPORTS symbol defined on the command line.
+// This symbol should not be defined on any project that uses this DLL.
+// This way any other project whose source files include this file see
+// TIESRENGINECOREAPI_API functions as being imported from a DLL,
+// whereas this DLL sees symbols defined with this macro as being exported.
+#ifdef TIESRENGINECOREAPI_EXPORTS
+#define TIESRENGINECOREAPI_API __declspec(dllexport)
+#else
+#define TIESRENGINECOREAPI_API __declspec(dllimport)
+#endif
+#endif
+
+#else
+
+#ifndef TIESRENGINECOREAPI_API
+#define TIESRENGINECOREAPI_API
+#endif
+
+#endif
+/*--------------------------------------------------------------------*/
+
+
+#include "tiesr_config.h"
+#include "status.h"
+#include "gmhmm_type.h"
+
+
+/* Version of the profile snapshot format */
+#define PROFILE_VERSION 1
+
+
+/* A profile store, opaque to the application */
+typedef struct TIesrProfileStore TIesrProfileStoreType;
+
+
+/* A snapshot buffer.  Each module of the engine puts its adaptation
+ state into the buffer in the same order as it writes the JAC state
+ file.  With a NULL data pointer the values are only counted, which
+ gives the size of a snapshot.  An access past the end of the buffer
+ sets the failed flag and is ignored. */
+typedef struct TIesrProfileBuf
+{
+      unsigned char *data;
+      unsigned int size;
+      unsigned int pos;
+      Boolean failed;
+} TIesrProfileBufType;
+
+
+/* Append, read or skip aSize bytes at the current position */
+TIESRENGINECOREAPI_API void profile_put( TIesrProfileBufType *aBuf, const void *aValues,
+					 unsigned int aSize );
+TIESRENGINECOREAPI_API void profile_get( TIesrProfileBufType *aBuf, void *aValues,
+					 unsigned int aSize );
+TIESRENGINECOREAPI_API void profile_skip( TIesrProfileBufType *aBuf, unsigned int aSize );
+
+
+/*----------------------------------------------------------------
+ OpenTIesrProfiles
+
+ Create a store that holds at most aCapacity profiles.  Returns NULL
+ on failure.  A store may be used by one thread at a time.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrProfileStoreType* OpenTIesrProfiles( unsigned int aCapacity );
+
+
+/*----------------------------------------------------------------
+ CloseTIesrProfiles
+
+ Free the store and all of its profiles.
+ --------------------------------*/
+TIESRENGINECOREAPI_API void CloseTIesrProfiles( TIesrProfileStoreType *aStore );
+
+
+/*----------------------------------------------------------------
+ profile_store_insert
+
+ Make the snapshot aData of aSize bytes the most recently used profile
+ of aId, replacing any prior profile of aId.  The store takes ownership
+ of aData, which must be allocated with malloc.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineJACStatusType profile_store_insert( TIesrProfileStoreType *aStore,
+								      const char *aId,
+								      unsigned char *aData,
+								      unsigned int aSize );
+
+
+/*----------------------------------------------------------------
+ profile_store_find
+
+ Set aBuf to read the snapshot of aId, which becomes the most recently
+ used profile.  Returns FALSE if the store holds no profile of aId.
+ --------------------------------*/
+TIESRENGINECOREAPI_API Boolean profile_store_find( TIesrProfileStoreType *aStore,
+						   const char *aId,
+						   TIesrProfileBufType *aBuf );
+
+
+/*----------------------------------------------------------------
+ RemoveTIesrProfile
+
+ Discard the profile of aId, if any.
+ --------------------------------*/
+TIESRENGINECOREAPI_API void RemoveTIesrProfile( TIesrProfileStoreType *aStore,
+						const char *aId );
+
+
+/*----------------------------------------------------------------
+ WriteTIesrProfiles, ReadTIesrProfiles
+
+ Write all profiles of the store to a file, and add the profiles in a
+ file to the store.  The least recently used profiles of the file are
+ discarded if they do not all fit.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineJACStatusType WriteTIesrProfiles( const TIesrProfileStoreType *aStore,
+								    const char *aFileName );
+
+TIESRENGINECOREAPI_API TIesrEngineJACStatusType ReadTIesrProfiles( TIesrProfileStoreType *aStore,
+								   const char *aFileName );
+
+#endif
@@ -26,6 +26,9 @@
 #include <windows.h>
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "tiesr_config.h"
 #include "search_user.h"
 #include "dist_user.h"
@@ -33,6 +36,7 @@
 #include "gmhmm_type.h"
 #include "sbc_user.h"
 #include "load_user.h"
+#include "image_user.h"
 #include "pmc_f_user.h"
 #ifdef USE_NBEST
 #include "nbest_user.h"
@@ -93,6 +97,18 @@ TIesrEngineJACStatusType rj_compensate(gmhmm_type * gv)
   if (vqhmm->bCompensated)
      return eTIesrEngineJACSuccess; 
 
+  /* With lazy compensation the new biases only invalidate the means,
+     which rj_lazy_mean compensates as they are used */
+  if (vqhmm->mu_clean){
+     vqhmm->epoch++;
+     if (vqhmm->epoch == 0){
+        memset(vqhmm->mu_epoch, 0, gv->n_mu * sizeof(ushort));
+        vqhmm->epoch = 1;
+     }
+     vqhmm->bCompensated = TRUE;
+     return eTIesrEngineJACSuccess;
+  }
+
 #ifdef USE_16BITMEAN_DECOD
   {
      TIesrEngineStatusType loadStatus;
@@ -134,6 +150,7 @@ TIesrEngineJACStatusType rj_compensate(gmhmm_type * gv)
 #endif
   }
   vqhmm->bCompensated = TRUE; 
+  SEARCH_STAT( gv->stats_frm.jac_vectors += gv->n_mu );
 
 #ifdef USE_16BITMEAN_DECOD
   if( gv->base_mu_orig )
@@ -146,6 +163,74 @@ TIesrEngineJACStatusType rj_compensate(gmhmm_type * gv)
   return eTIesrEngineJACSuccess;
 }
 
+
+/*----------------------------------------------------------------
+  rj_lazy_open
+
+  Keep the clean means resident so that the means can be compensated
+  lazily, one at a time as they are used, after the JAC estimates
+  change.  All means are marked for compensation in the next utterance.
+  Any background compensation of the means must be complete.
+ ----------------------------------------------------------------*/
+TIesrEngineJACStatusType rj_lazy_open(gmhmm_type * gv)
+{
+  OFFLINE_VQ_HMM_type *vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+
+  if (vqhmm->mu_clean == NULL){
+    vqhmm->mu_epoch = (ushort*) calloc(gv->n_mu, sizeof(ushort));
+    if (vqhmm->mu_epoch == NULL)
+      return eTIesrEngineJACMemoryFail;
+
+    if (gv->base_mu_orig){
+      vqhmm->mu_clean = (short*) malloc(gv->n_mu * gv->nbr_dim * sizeof(short));
+      if (vqhmm->mu_clean)
+	memcpy(vqhmm->mu_clean, gv->base_mu_orig, gv->n_mu * gv->nbr_dim * sizeof(short));
+    }
+#ifdef USE_16BITMEAN_DECOD
+    else if (load_mean_vec(gv->chpr_Model_Dir, gv, FALSE) == eTIesrEngineSuccess){
+      vqhmm->mu_clean = gv->base_mu_orig;
+      gv->base_mu_orig = NULL;
+    }
+#endif
+
+    if (vqhmm->mu_clean == NULL){
+      free(vqhmm->mu_epoch);
+      vqhmm->mu_epoch = NULL;
+      return eTIesrEngineJACRJLoadFail;
+    }
+
+    /* The means are all marked as compensated in epoch zero */
+    vqhmm->epoch = 0;
+  }
+
+  vqhmm->bCompensated = FALSE;
+  return eTIesrEngineJACSuccess;
+}
+
+
+/*----------------------------------------------------------------
+  rj_lazy_mean
+
+  Compensate mean k with the bias of its cluster if it has not been
+  compensated since the biases last changed, and return it.
+ ----------------------------------------------------------------*/
+short* rj_lazy_mean(gmhmm_type * gv, ushort k)
+{
+  OFFLINE_VQ_HMM_type *vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+  short *mu = gv->base_mu + k * gv->nbr_dim;
+  short *mu_clean = vqhmm->mu_clean + k * gv->nbr_dim;
+  short *sp_bias = vqhmm->vq_bias + vqhmm->pRAM2Cls[k] * gv->nbr_dim;
+  short d;
+
+  for (d = gv->nbr_dim - 1; d >= 0; d--)
+    mu[d] = mu_clean[d] + sp_bias[d];
+
+  vqhmm->mu_epoch[k] = vqhmm->epoch;
+  SEARCH_STAT( gv->stats_frm.jac_vectors++ );
+
+  return mu;
+}
+
 #endif /* #ifdef RAPID_JAC */
 
 
@@ -203,6 +288,29 @@ static void rj_offline_inv_of_average_var(gmhmm_type * gv, OFFLINE_VQ_HMM_type *
 }
 
 
+#ifdef OFFLINE_CLS
+/*----------------------------------------------------------------
+ rj_source_open
+
+ Open a file of vq clustering data, from the model directory or bundle
+ of the models, or from a section of the engine image.
+ --------------------------------*/
+static Boolean rj_source_open( gmhmm_type *gv, const char *aName,
+			       unsigned short aSection, ModelFileType *aSrc )
+{
+  if( gv->pImage )
+  {
+    aSrc->fp = NULL;
+    aSrc->pos = 0;
+    aSrc->data = (const unsigned char*) image_section( gv, aSection, &aSrc->size );
+    return aSrc->data != NULL;
+  }
+
+  return model_file_open( aSrc, gv->chpr_Model_Dir, gv->pBundle, aName, "rb" );
+}
+#endif
+
+
 /*---------------------------------------------------------------------------
  rj_open_ROM
 
@@ -226,41 +334,34 @@ static TIesrEngineStatusType rj_open_ROM( gmhmm_type *gv )
   Boolean failed = FALSE; 
 
 #ifdef OFFLINE_CLS
-  char buf[MAX_STR], *dirname = gv->chpr_Model_Dir;
   unsigned char *pChr; 
-  FILE *fp;
+  ModelFileType src;
   OFFLINE_VQ_HMM_type * pOffline = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
   short nread, *p_short; 
 
   /* read table mapping RAM mean to cluster */
-  strcpy( buf, dirname);
-  strcat( buf, "/o2amidx.bin" );
-  fp = fopen( buf, "rb" );
-  failed |= ( fp == NULL );
-  fread(&pOffline->sz_RamMean, sizeof(short), 1, fp);
+  failed |= !rj_source_open( gv, "o2amidx.bin", IMAGE_RAM2CLS, &src );
+  model_file_read(&pOffline->sz_RamMean, sizeof(short), 1, &src);
   nread = ((pOffline->sz_RamMean + 1) >> 1) + 1;
   p_short = mem_alloc( pOffline->base_mem, &pOffline->mem_count, 
 		       nread, VQHMM_SIZE, SHORTALIGN, "RAM2Cls");
   pOffline->pRAM2Cls = (unsigned char*) p_short; 
   pChr = (unsigned char*) pOffline->pRAM2Cls; 
-  nread = fread(pChr, sizeof(unsigned char), pOffline->sz_RamMean, fp);
+  nread = model_file_read(pChr, sizeof(unsigned char), pOffline->sz_RamMean, &src);
   failed |= (nread != pOffline->sz_RamMean); 
-  fclose( fp );
+  model_file_close( &src );
 
 
   /* read cluster to ROM mean mapping */
-  strcpy( buf, dirname);
-  strcat( buf, "/vqcentr.bin"); 
-  fp = fopen( buf, "rb" );
-  failed |= ( fp == NULL );
-  fread(&pOffline->n_cs, sizeof(short), 1, fp);
-  fread(&pOffline->nbr_dim, sizeof(short), 1, fp); 
+  failed |= !rj_source_open( gv, "vqcentr.bin", IMAGE_VQCENTR, &src );
+  model_file_read(&pOffline->n_cs, sizeof(short), 1, &src);
+  model_file_read(&pOffline->nbr_dim, sizeof(short), 1, &src); 
   nread = pOffline->n_cs * pOffline->nbr_dim;
   pOffline->vq_centroid = mem_alloc( pOffline->base_mem, &pOffline->mem_count, 
 				     nread, VQHMM_SIZE, SHORTALIGN, "VQ Centroid");
-  nread = fread(pOffline->vq_centroid, sizeof(short), pOffline->n_cs * pOffline->nbr_dim, fp);
+  nread = model_file_read(pOffline->vq_centroid, sizeof(short), pOffline->n_cs * pOffline->nbr_dim, &src);
   failed |= (nread != pOffline->n_cs * pOffline->nbr_dim);
-  fclose( fp );
+  model_file_close( &src );
  
   pOffline->vq_bias = mem_alloc( pOffline->base_mem, &pOffline->mem_count, 
 				 pOffline->n_cs * pOffline->nbr_dim, VQHMM_SIZE, 
@@ -409,7 +510,7 @@ short rj_gauss_obs_score_f(short *feature, int pdf_idx, gmhmm_type*gv, long * l_
       if (vqhmm->category[l] == 0){
 #endif
 #ifndef BIT8MEAN
-	mu = get_mean(gv->base_mu, mixture, nbr_dim, i);   
+	mu = RJ_MEAN(gv, k);
 	invvar = get_var(gv->base_var, mixture, nbr_dim, i);
 	gconst = gv->base_gconst[ mixture[ i * 3 + 3 ] ];
 	feat = feature;
@@ -420,12 +521,16 @@ short rj_gauss_obs_score_f(short *feature, int pdf_idx, gmhmm_type*gv, long * l_
 #endif
 
 	if (l_cnter) (*l_cnter)++;
+	SEARCH_STAT( gv->stats_frm.gauss_evaluated++ );
 #if defined(USE_GAUSS_SELECT) || defined(USE_ONLINE_REF)
 	vqhmm->low_score = MIN(vqhmm->low_score, scr);
 #if defined(USE_GAUSS_SELECT)
       }
       else
+      {
 	scr = (long) vqhmm->dist[l];
+	SEARCH_STAT( gv->stats_frm.gauss_cluster_scored++ );
+      }
 #endif
 #endif
 
@@ -456,6 +561,10 @@ short rj_gauss_obs_score_f(short *feature, int pdf_idx, gmhmm_type*gv, long * l_
 
       gv->gauss_scr[k] = LONG2SHORT(scr); 
     }
+#ifdef USE_SEARCH_STATS
+    else
+      gv->stats_frm.gauss_cache_hits++;
+#endif
     
     if (iargmix && scr > min_scr){
       min_scr = scr; *iargmix = i; 
@@ -640,6 +749,46 @@ TIesrEngineStatusType rj_save(gmhmm_type * gv, FILE * pf)
   return eTIesrEngineSuccess;
 }
 
+
+/*----------------------------------------------------------------------------
+ rj_save_profile, rj_load_profile
+
+ Put or get the ORM model adaptation data of an adaptation profile
+ snapshot, in the format of rj_save and rj_load.
+ -------------------------------------*/
+TIesrEngineStatusType rj_save_profile(gmhmm_type * gv, TIesrProfileBufType* aBuf)
+{
+#ifdef USE_ORM_PU
+  OFFLINE_VQ_HMM_type* vqhmm = ( OFFLINE_VQ_HMM_type* ) gv->offline_vq;
+
+  profile_put(aBuf, &(vqhmm->inum_prior), sizeof(short));
+  if (vqhmm->inum_prior > 0){
+    profile_put(aBuf, vqhmm->iprior, sizeof(short) * vqhmm->inum_prior);
+    profile_put(aBuf, vqhmm->pprior, sizeof(short) * vqhmm->inum_prior);
+  }
+#endif
+  return aBuf->failed ? eTIesrEngineVQHMMSave : eTIesrEngineSuccess;
+}
+
+TIesrEngineStatusType rj_load_profile(gmhmm_type * gv, TIesrProfileBufType* aBuf)
+{
+#ifdef USE_ORM_PU
+  short inum;
+  OFFLINE_VQ_HMM_type* vqhmm = ( OFFLINE_VQ_HMM_type* ) gv->offline_vq;
+
+  profile_get(aBuf, &inum, sizeof(short));
+  if (aBuf->failed || inum < 0 || inum > 3 * GBG_NUM_IDS)
+    return eTIesrEngineVQHMMLoad;
+
+  vqhmm->inum_prior = inum;
+  if (inum > 0){
+    profile_get(aBuf, vqhmm->iprior, sizeof(short) * inum);
+    profile_get(aBuf, vqhmm->pprior, sizeof(short) * inum);
+  }
+#endif
+  return aBuf->failed ? eTIesrEngineVQHMMLoad : eTIesrEngineSuccess;
+}
+
 #endif /* USE_ONLINE_REF */
 
 
@@ -1190,6 +1339,8 @@ short rj_clear_obs_scr(gmhmm_type * gv, short *mfcc_feat)
       vqhmm->category[i] = 2; 
     }
     else vqhmm->category[i] = 1; /* intermediate clusters */
+
+    SEARCH_STAT( gv->stats_frm.clusters[ (unsigned char) vqhmm->category[i] ]++ );
   }
 
   /* the correct lowest score is obtained during decoding. 
@@ -1309,6 +1460,10 @@ TIesrEngineStatusType rj_open(ushort u_perc_cor,
 
   pOffline->mem_count = 0;
 
+  pOffline->mu_clean = NULL;
+  pOffline->mu_epoch = NULL;
+  pOffline->epoch = 0;
+
   bSucc = rj_vq(gv);
   if (bSucc == eTIesrEngineVQHMMMemorySize) return bSucc;
 
@@ -1382,6 +1537,16 @@ TIESRENGINECOREAPI_API Boolean rj_set_ORM(short num_frms_gbg,
 #ifdef OFFLINE_CLS
 void rj_close(gmhmm_type* gv)
 {
+#ifdef RAPID_JAC
+  OFFLINE_VQ_HMM_type * vqhmm = (OFFLINE_VQ_HMM_type*) gv->offline_vq;
+
+  if (vqhmm){
+    free(vqhmm->mu_clean);
+    free(vqhmm->mu_epoch);
+    vqhmm->mu_clean = NULL;
+    vqhmm->mu_epoch = NULL;
+  }
+#endif
 
   gv->offline_vq = NULL; 
 
@@ -1731,6 +1896,44 @@ TIESRENGINECOREAPI_API void cm_save(FILE *fp,
 #endif
 }
 
+/* put or get the confidence measure parameters of an adaptation profile
+   snapshot, in the format of cm_save and cm_load */
+TIESRENGINECOREAPI_API void cm_save_profile(TIesrProfileBufType* aBuf,
+					    gmhmm_type* gv)
+{
+#ifdef USE_CONFIDENCE
+  ConfType * pconf = (ConfType*)gv->pConf; 
+
+  profile_put(aBuf, &pconf->H0.mean, sizeof(short));
+  profile_put(aBuf, &pconf->H0.inv, sizeof(short));
+  profile_put(aBuf, &pconf->H0.gconst, sizeof(short));
+  profile_put(aBuf, &pconf->H1.mean, sizeof(short));
+  profile_put(aBuf, &pconf->H1.inv, sizeof(short));
+  profile_put(aBuf, &pconf->H1.gconst, sizeof(short));
+  profile_put(aBuf, &pconf->NSNR, sizeof(short));
+  profile_put(aBuf, &pconf->lgBeta[0], sizeof(short) * CM_NBR_BETA);
+  profile_put(aBuf, &pconf->acc_dif2_beta[0], sizeof(long) * CM_NBR_BETA);
+#endif
+}
+
+TIESRENGINECOREAPI_API void cm_load_profile(TIesrProfileBufType* aBuf,
+					    gmhmm_type* gv)
+{
+#ifdef USE_CONFIDENCE
+  ConfType * pconf = (ConfType*)gv->pConf; 
+
+  profile_get(aBuf, &pconf->H0.mean, sizeof(short));
+  profile_get(aBuf, &pconf->H0.inv, sizeof(short));
+  profile_get(aBuf, &pconf->H0.gconst, sizeof(short));
+  profile_get(aBuf, &pconf->H1.mean, sizeof(short));
+  profile_get(aBuf, &pconf->H1.inv, sizeof(short));
+  profile_get(aBuf, &pconf->H1.gconst, sizeof(short));
+  profile_get(aBuf, &pconf->NSNR, sizeof(short));
+  profile_get(aBuf, &pconf->lgBeta[0], sizeof(short) * CM_NBR_BETA);
+  profile_get(aBuf, &pconf->acc_dif2_beta[0], sizeof(long) * CM_NBR_BETA);
+#endif
+}
+
 void cm_init( gmhmm_type * gv )
 {
 #ifdef USE_CONFIDENCE
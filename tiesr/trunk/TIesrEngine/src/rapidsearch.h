@@ -104,6 +104,12 @@ typedef struct _OFFLINE_VQ_HMM{
   short *vq_bias; /* JAC compensation bias */
   Boolean bCompensated; 
 
+  /* clean means and the compensation epoch of each mean, when means are
+     compensated lazily the first time they are used; NULL otherwise */
+  short *mu_clean;
+  ushort *mu_epoch;
+  ushort epoch;
+
   /* ------------ Gaussian selection ---------------------------------------*/
   short low_score; 
   short max_dist; /* maximum score of Gaussian clusters */
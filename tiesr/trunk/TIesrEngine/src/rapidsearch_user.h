@@ -66,11 +66,24 @@ Windows format export of DLL functions */
 #include "load_user.h"
 #include "pmc_f_user.h"
 #include "rapidsearch.h"
+#include "profile_user.h"
 
 /* --------------- cluster-dependent JAC ------------------------------- */
 TIESRENGINECOREAPI_API void rj_noise_compensation(gmhmm_type *cd_hmms);
 TIESRENGINECOREAPI_API TIesrEngineJACStatusType rj_compensate(gmhmm_type * gv);
 
+/* keep clean means resident and compensate each mean when it is first
+   used after the JAC estimates change */
+TIESRENGINECOREAPI_API TIesrEngineJACStatusType rj_lazy_open(gmhmm_type * gv);
+short* rj_lazy_mean(gmhmm_type * gv, ushort k);
+
+/* compensated mean vector k of the models */
+#define RJ_MEAN(gv, k) \
+  ( ((OFFLINE_VQ_HMM_type*)(gv)->offline_vq)->mu_clean && \
+    ((OFFLINE_VQ_HMM_type*)(gv)->offline_vq)->mu_epoch[k] != \
+    ((OFFLINE_VQ_HMM_type*)(gv)->offline_vq)->epoch ? \
+    rj_lazy_mean((gv), (k)) : (gv)->base_mu + (k) * (gv)->nbr_dim )
+
 
 /*---------------------------------------------------------------------------
  rj_open
@@ -109,6 +122,13 @@ TIESRENGINECOREAPI_API TIesrEngineStatusType rj_load(gmhmm_type * gv, FILE* pf);
 
 TIESRENGINECOREAPI_API TIesrEngineStatusType rj_save(gmhmm_type * gv, FILE* pf);
 
+/* save and load the ORM model adaptation data of an adaptation profile
+   snapshot */
+TIESRENGINECOREAPI_API TIesrEngineStatusType rj_save_profile(gmhmm_type * gv,
+							     TIesrProfileBufType* aBuf);
+TIESRENGINECOREAPI_API TIesrEngineStatusType rj_load_profile(gmhmm_type * gv,
+							     TIesrProfileBufType* aBuf);
+
 short rj_gauss_obs_score_f(short *feature, int pdf_idx, gmhmm_type*gv, long * l_cnter, short * iargmix);
 
 
@@ -304,6 +304,7 @@ short * sbc_rtn_hmm2phone(FeaHLRAccType *sa)
 
  Arguments:
  gdir: Directory containing current HMM models and grammar network
+ aBundle: Model bundle holding the mapping in place of gdir, or NULL
  n_hmms: Number of set-independent HMMs
  sa: Pointer to SBC adaptation structure
  bTriphone: Boolean indicating to used mapping data from file.
@@ -311,14 +312,14 @@ short * sbc_rtn_hmm2phone(FeaHLRAccType *sa)
 ----------------------------------*/
 TIESRENGINECOREAPI_API
 TIesrEngineHLRStatusType sbc_load_hmm2phone(const char gdir[], 
+					    const void *aBundle,
 					    ushort n_hmms, 
 					    FeaHLRAccType *sa,
 					    Boolean bTriphone )
 {
-   char fname[ MAX_STR ];
    size_t nread;
    short si; 
-   FILE *fp;
+   ModelFileType file;
 
 #ifdef _DYN_ALLOC_SBC
    if( sa->pHMM2phone )
@@ -349,9 +350,7 @@ TIesrEngineHLRStatusType sbc_load_hmm2phone(const char gdir[],
 
    /* Open the hmm to phone mapping file */
    if (bTriphone){
-     sprintf(fname,"%s/%s",gdir,"hmm2phone.bin");
-     
-     if (  (fp = fopen( fname, "rb" )) == NULL )
+     if ( !model_file_open( &file, gdir, aBundle, "hmm2phone.bin", "rb" ) )
        {
 #ifdef _DYN_ALLOC_SBC
 	 free( sa->pHMM2phone );
@@ -360,8 +359,8 @@ TIesrEngineHLRStatusType sbc_load_hmm2phone(const char gdir[],
          return eTIesrEngineHLRFail;
        }
 
-     nread = fread( sa->pHMM2phone, sizeof(short), n_hmms, fp );
-     fclose( fp );
+     nread = model_file_read( sa->pHMM2phone, sizeof(short), n_hmms, &file );
+     model_file_close( &file );
 
    /*   if( nread != n_hmms )
 	{
@@ -385,6 +384,48 @@ TIesrEngineHLRStatusType sbc_load_hmm2phone(const char gdir[],
    return eTIesrEngineHLRSuccess;
 }
 
+
+/*----------------------------------------------------------------------------
+ sbc_read_hmm2phone
+
+ Read the mapping from each set-independent HMM of a grammar directory to
+ phone index into allocated memory, as sbc_load_hmm2phone does for a
+ triphone grammar.  Returns NULL if the grammar has no mapping.
+
+ Arguments:
+ gdir: Directory containing the HMMs and grammar network
+ n_hmms: Number of set-independent HMMs
+
+----------------------------------*/
+TIESRENGINECOREAPI_API
+short *sbc_read_hmm2phone( const char gdir[], ushort n_hmms )
+{
+   short *pHMM2phone;
+   size_t nread;
+   ModelFileType file;
+
+   if ( !model_file_open( &file, gdir, NULL, "hmm2phone.bin", "rb" ) )
+      return NULL;
+
+   pHMM2phone = (short*) calloc( n_hmms, sizeof(short) );
+   if( pHMM2phone == NULL )
+   {
+      model_file_close( &file );
+      return NULL;
+   }
+
+   nread = model_file_read( pHMM2phone, sizeof(short), n_hmms, &file );
+   model_file_close( &file );
+
+   if( nread == 0 )
+   {
+      free( pHMM2phone );
+      return NULL;
+   }
+
+   return pHMM2phone;
+}
+
 /*--------------------------------*/
 static FeaHLRAccType* sbc_set_parent_node(ushort inodeidx, ushort parent_node, 
 					  FeaHLRAccType* sa){
@@ -638,6 +679,110 @@ TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_load(FeaHLRAccType* sa, FILE
    return eTIesrEngineHLRLoadTree;
 }
 
+
+/*----------------------------------------------------------------
+ sbc_save_profile
+
+ Put the tree statistics and transforms into an adaptation profile
+ snapshot, in the order written by sbc_save.
+ ---------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_save_profile(FeaHLRAccType* sa,
+							     TIesrProfileBufType* aBuf)
+{
+   short ix, cep_dim = sa->hlr_TRANSFORM_SIZE;
+   sbcTree* tree = (sbcTree *)sa->hlrTreeBase;
+
+   if (tree == NULL) return eTIesrEngineHLRFail;
+
+   profile_put(aBuf, &(tree->n_utt), sizeof(ushort));
+   profile_put(aBuf, &(tree->n_nodes), sizeof(ushort));
+   profile_put(aBuf, &(sa->hlr_TRANSFORM_SIZE), sizeof(ushort));
+
+   for (ix=0;ix<tree->n_nodes;ix++){
+     profile_put(aBuf, &(tree->node[ix]->vector_count), sizeof(ushort));
+     profile_put(aBuf, &(tree->node[ix]->parent_node_and_transform_idx), sizeof(short));
+     profile_put(aBuf, sbc_get_transform_stat_dif1(ix, sa), sizeof(long) * cep_dim);
+     profile_put(aBuf, sbc_get_transform_stat_dif2(ix, sa), sizeof(long) * cep_dim);
+     profile_put(aBuf, sbc_get_transform(ix, sa), sizeof(short) * cep_dim);
+   }
+
+   profile_put(aBuf, &(sa->n_monophones), sizeof(ushort));
+   profile_put(aBuf, sa->hlrTerminal, sizeof(ushort) * sa->n_monophones);
+   profile_put(aBuf, sa->hlrTransformIndex, sizeof(ushort) * tree->n_nodes);
+   profile_put(aBuf, sa->hlrTransforms, sizeof(short) * tree->n_nodes * cep_dim);
+
+   return aBuf->failed ? eTIesrEngineHLRFail : eTIesrEngineHLRSuccess;
+}
+
+
+/*----------------------------------------------------------------
+ sbc_load_profile
+
+ Get the tree statistics and transforms from an adaptation profile
+ snapshot.  As in sbc_load, the count of utterances is incremented.
+ ---------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_load_profile(FeaHLRAccType* sa,
+							     TIesrProfileBufType* aBuf)
+{
+   ushort utmp, sNodes, sCepDim, sMonophones;
+   short ix, cep_dim = sa->hlr_TRANSFORM_SIZE;
+   unsigned int start = aBuf->pos;
+   sbcTree* tree = (sbcTree *)sa->hlrTreeBase;
+   Boolean bOverWrite = TRUE;
+
+   if (tree == NULL) return eTIesrEngineHLRLoadTree;
+
+   /* Check the profile fits the tree before changing anything */
+   profile_get(aBuf, &utmp, sizeof(ushort));
+   profile_get(aBuf, &sNodes, sizeof(ushort));
+   profile_get(aBuf, &sCepDim, sizeof(ushort));
+   if (aBuf->failed || sNodes != tree->n_nodes || sCepDim != sa->hlr_TRANSFORM_SIZE)
+     return eTIesrEngineHLRLoadTree;
+
+   profile_skip(aBuf, tree->n_nodes * (sizeof(ushort) + sizeof(short) +
+				       (sizeof(long) * 2 + sizeof(short)) * cep_dim));
+   profile_get(aBuf, &sMonophones, sizeof(ushort));
+   profile_skip(aBuf, sizeof(ushort) * (sMonophones + tree->n_nodes) +
+		sizeof(short) * tree->n_nodes * cep_dim);
+   if (aBuf->failed || sMonophones != sa->n_monophones)
+     return eTIesrEngineHLRLoadTree;
+   aBuf->pos = start + 3 * sizeof(ushort);
+
+   utmp ++;
+   tree->n_utt = utmp;
+
+#ifdef SBC_REFRESH
+   /* refresh SBC for every 128 utterances */
+   if ((utmp >> 7) != 0){
+     tree->n_utt = 0;
+     bOverWrite = FALSE ;
+   }
+#endif
+
+   if (!bOverWrite){
+     profile_skip(aBuf, tree->n_nodes * (sizeof(ushort) + sizeof(short) +
+					 (sizeof(long) * 2 + sizeof(short)) * cep_dim) +
+		  sizeof(ushort) * (1 + sa->n_monophones + tree->n_nodes) +
+		  sizeof(short) * tree->n_nodes * cep_dim);
+     return eTIesrEngineHLRSuccess;
+   }
+
+   for (ix=0;ix<tree->n_nodes;ix++){
+     profile_get(aBuf, &(tree->node[ix]->vector_count), sizeof(ushort));
+     profile_get(aBuf, &(tree->node[ix]->parent_node_and_transform_idx), sizeof(short));
+     profile_get(aBuf, sbc_get_transform_stat_dif1(ix, sa), sizeof(long) * cep_dim);
+     profile_get(aBuf, sbc_get_transform_stat_dif2(ix, sa), sizeof(long) * cep_dim);
+     profile_get(aBuf, sbc_get_transform(ix, sa), sizeof(short) * cep_dim);
+   }
+
+   profile_skip(aBuf, sizeof(ushort));
+   profile_get(aBuf, sa->hlrTerminal, sizeof(ushort) * sa->n_monophones);
+   profile_get(aBuf, sa->hlrTransformIndex, sizeof(ushort) * tree->n_nodes);
+   profile_get(aBuf, sa->hlrTransforms, sizeof(short) * tree->n_nodes * cep_dim);
+
+   return aBuf->failed ? eTIesrEngineHLRLoadTree : eTIesrEngineHLRSuccess;
+}
+
 #ifdef _SBC_DEBUG
 void sbc_dump_each_transform(FeaHLRAccType *sa, ushort inode)
 {
@@ -835,6 +980,8 @@ static short sbc_prior_invvar(short dim, short n_mfcc )
  Arguments:
  sa: Pointer to SBC adaptation structure
  fnDir: Directory containing current HMM and grammar network data
+ aBundle: Model bundle holding the HMM to phone mapping in place of fnDir,
+ or NULL
  fname: Full name of file containing phontic regression tree,
  load_monophone_only: Do not load regression tree structure
  cep_dim: Size of feature vector
@@ -844,6 +991,7 @@ static short sbc_prior_invvar(short dim, short n_mfcc )
  ----------------------------------------------------------------*/
 TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_init_tree( FeaHLRAccType *sa,
 					const char* fnDir, 
+					const void *aBundle,
 					const char *fname, 
 					short load_monophone_only,
 					ushort cep_dim, ushort n_hmms,
@@ -1085,7 +1233,7 @@ TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_init_tree( FeaHLRAccType *sa
 #endif
 
    /* Load the hmm to phone mapping. This is available from HMM binary model directory. */
-   if(sbc_load_hmm2phone(fnDir, n_hmms, sa, bTriphone) == eTIesrEngineHLRSuccess )
+   if(sbc_load_hmm2phone(fnDir, aBundle, n_hmms, sa, bTriphone) == eTIesrEngineHLRSuccess )
      return eTIesrEngineHLRSuccess;
 
   InitFail:
@@ -66,6 +66,7 @@ Windows format export of DLL functions */
 #include "search_user.h"
 
 #include "sbc_struct_user.h"
+#include "profile_user.h"
 
 /* for debug of SBC */
 //#define _SBC_DEBUG 1
@@ -84,6 +85,18 @@ TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_save(FeaHLRAccType* pSBC , F
 TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_load(FeaHLRAccType* pSBC , FILE* pf );
 
 
+/* save and load the SBC statistics and transforms of an adaptation
+   profile, in the same format as sbc_save and sbc_load.  The tree must
+   already be initialized, and sbc_load_profile changes nothing if the
+   profile does not fit the tree.
+*/
+TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_save_profile(FeaHLRAccType* pSBC,
+							     TIesrProfileBufType* aBuf );
+
+TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_load_profile(FeaHLRAccType* pSBC,
+							     TIesrProfileBufType* aBuf );
+
+
 /* reset sufficient statistics before accumulating statistics for the current utterance.
    @param pSBC pointer to FeaHLRAccType
 */
@@ -114,6 +127,7 @@ TIESRENGINECOREAPI_API void sbc_open( FeaHLRAccType *pSBC );
    initialization of SBC method
    @param pSBC Pointer to FeaHLRAccTYpe structure holding sbc state
    @param fnDir path of network, hmms
+   @param aBundle model bundle holding the hmm to phone map in place of fnDir, or NULL
    @param fname file name of phonenetic clustering tree
    @param load_monophone_only TRUE if only load monophone, FALSE also load clustering tree
    @param cep_dim cepstral feature vector size
@@ -126,6 +140,7 @@ TIESRENGINECOREAPI_API void sbc_open( FeaHLRAccType *pSBC );
 */
 TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_init_tree( FeaHLRAccType* pSBC,
 					const char* fnDir, 
+					const void *aBundle,
 					const char *fname, 
 					short load_monophone_only,
 					ushort cep_dim, 
@@ -142,16 +157,32 @@ TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_init_tree( FeaHLRAccType* pS
 
  Arguments:
  gdir: Diretory containing current HMM models and grammar network
+ aBundle: Model bundle holding the mapping in place of gdir, or NULL
  n_hmms: Number of set-independent HMMs
  sa: Pointer to SBC adaptation structure
  bTriphone: Boolean indicating to use mapping data from file.
 
 ----------------------------------*/
 TIESRENGINECOREAPI_API TIesrEngineHLRStatusType sbc_load_hmm2phone(const char gdir[],
+					    const void *aBundle,
 					    ushort n_hmms, 
 					    FeaHLRAccType *sa,
 					    Boolean bTriphone );
 
+/*----------------------------------------------------------------------------
+ sbc_read_hmm2phone
+
+ Read the mapping from each set-independent HMM of a grammar directory to
+ phone index into memory freed by free.  Returns NULL if the grammar has
+ no mapping.
+
+ Arguments:
+ gdir: Directory containing the HMMs and grammar network
+ n_hmms: Number of set-independent HMMs
+
+----------------------------------*/
+TIESRENGINECOREAPI_API short *sbc_read_hmm2phone( const char gdir[], ushort n_hmms );
+
 /* return the leaf of the triphone HMM indexed by $hmm_idx */
 short sbc_phone2terminalidx(ushort hmm_idx, FeaHLRAccType * sa);
 
@@ -34,6 +34,8 @@
 #include "load_user.h"
 #include "pmc_f_user.h"
 #include "uttdet_user.h"
+#include "gmhmm_type_common_user.h"
+#include "trace_user.h"
 #ifdef USE_NBEST
 #include "nbest_user.h"
 #endif
@@ -415,6 +417,8 @@ compact_beam_cells( BeamType *beam_base, TimeType *time_base,gmhmm_type *gv )
   unsigned short beam_idx, s_next, count=0;
   BeamType *bm = beam_base, *p, *head;
 
+  SEARCH_STAT( gv->stats_frm.compactions++ );
+
   /*label the end of list, should be put out */
   //if (gv->last_beam_cell != UNDEF_CELL) beam_base[gv->last_beam_cell].next =  gv->max_beam_cell;
   
@@ -640,7 +644,11 @@ gauss_obs_score_f(short *feature, int pdf_idx, gmhmm_type *gv)
       {
    
 #ifndef BIT8MEAN
+#ifdef RAPID_JAC
+	mu = RJ_MEAN(gv, k);
+#else
 	mu = get_mean(gv->base_mu, mixture, nbr_dim, i);   
+#endif
 	invvar = get_var(gv->base_var, mixture, nbr_dim, i);
 	gconst = gv->base_gconst[ mixture[ i * 3 + 3 ] ];
 	feat = feature;
@@ -651,11 +659,13 @@ gauss_obs_score_f(short *feature, int pdf_idx, gmhmm_type *gv)
 #endif
 
 	gv->gauss_scr[ k ] = LONG2SHORT(scr); 
+	SEARCH_STAT( gv->stats_frm.gauss_evaluated++ );
 
       }
     else
       {
 	scr=(long) gv->gauss_scr[ k ] ;
+	SEARCH_STAT( gv->stats_frm.gauss_cache_hits++ );
       }	 
 
     scr += p2wgt[ i * 3 ];         /* mixture weight */
@@ -1112,6 +1122,7 @@ static short
 	{
 	  /* a sym is active if any of the state is active */
 	  sym_active = 1;
+	  SEARCH_STAT( gv->stats_frm.active_states++ );
 	
 	  pdf_idx = hmm->pdf_idx[ j ];
 #ifdef USE_GAUSS_SELECT
@@ -1228,6 +1239,7 @@ static short
 
     //gv->avedepth=sumdepth/n_actsym; 
     gv->bestdepth=bestdepth;
+    SEARCH_STAT( gv->stats_frm.active_syms += n_actsym );
     
     //lable the end (was in compact beam)
     if (gv->last_beam_cell != UNDEF_CELL) gv->beam_base[gv->last_beam_cell].next =  gv->max_beam_cell;
@@ -1652,6 +1664,7 @@ search_a_frame(short mfcc_feature[], short not_end,
   short status, prune;
   unsigned short last_frm = 0;
   long  tmp;
+  SEARCH_STAT( unsigned long long stat_ns = 0 );
 
   /* ------------------------------------------------------------------
      first frame, init search, frm_cnt is global, must start from 0
@@ -1700,8 +1713,13 @@ search_a_frame(short mfcc_feature[], short not_end,
 
     /* init search */
 
+    SEARCH_STAT( if( gv->bStats ) stat_ns = stats_clock() );
+
     status = init_search(mfcc_feature, 0, gv, last_frm);
 
+    SEARCH_STAT( gv->stats_frm.frames++ );
+    SEARCH_STAT( if( gv->bStats ) gv->stats_frm.ns_score += stats_clock() - stat_ns );
+
     gv->best_prev_scr = gv->best_cur_scr;
     
     gv->need_compact=FALSE;
@@ -1857,8 +1875,16 @@ search_a_frame(short mfcc_feature[], short not_end,
     last_frm = frm_cnt - 1; /* used in mark_cells, etc. -- should move to 3 lines below. */
     /* HMM transition , and determine best path from Gaussians compution of LAST FRAME*/
 
+    SEARCH_STAT( gv->stats_frm.frames++ );
+    SEARCH_STAT( gv->stats_frm.prune_width += gv->best_prev_scr - prune );
+    SEARCH_STAT( if( gv->bStats ) stat_ns = stats_clock() );
+    TRACE_BEGIN( gv, propagate_start );
+
     status = path_propagation( cur_idx, prev_idx, frm_cnt, gv, prune);
 
+    SEARCH_STAT( if( gv->bStats ) gv->stats_frm.ns_propagate += stats_clock() - stat_ns );
+    TRACE_END( gv, "propagate", propagate_start );
+
     if ( status != eTIesrEngineSuccess ) 
       return status;
 
@@ -1872,7 +1898,14 @@ search_a_frame(short mfcc_feature[], short not_end,
     //if (gv->word_backtrace == HMMFA )  
     // rj_clear_obs_scr(gv, mfcc_feature);
      
+    SEARCH_STAT( if( gv->bStats ) stat_ns = stats_clock() );
+    TRACE_BEGIN( gv, score_start );
+
     status = update_obs_prob(mfcc_feature, cur_idx, frm_cnt, gv, last_frm );
+
+    SEARCH_STAT( if( gv->bStats ) gv->stats_frm.ns_score += stats_clock() - stat_ns );
+    TRACE_END( gv, "score", score_start );
+
     if ( status != eTIesrEngineSuccess ) 
       return status;
 
@@ -1893,7 +1926,9 @@ search_a_frame(short mfcc_feature[], short not_end,
 
     if (gv->need_compact==TRUE )            // || gv->word_backtrace==FALSE ) 
      {
+        TRACE_BEGIN( gv, compact_start );
      	compact_beam_cells(  gv->beam_base, gv->time_base, gv );  
+        TRACE_END( gv, "compact", compact_start );
         gv->need_compact=FALSE;
         //printf("compact beam==%d==frm %d ===",gv->evalstat.beam.cur_pos,  frm_cnt);
      }
@@ -1906,6 +1941,8 @@ search_a_frame(short mfcc_feature[], short not_end,
 #endif
 
     update_time_table(gv->time_table_idx, NN, gv); 
+
+    SEARCH_STAT( gv->stats_frm.beam_cells = gv->evalstat.beam.cur_pos );
     
     gv->cum_best_prev_scr += (long) gv->best_prev_scr;
 
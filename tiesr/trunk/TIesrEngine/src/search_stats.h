@@ -0,0 +1,85 @@
+/*=======================================================================
+
+ *
+ * search_stats.h
+ *
+ * Header defining TIesr search statistics.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This header defines the statistics the TIesr Engine collects while
+ processing an utterance.  The statistics are reported for the
+ utterance, and for the last frame processed, by GetTIesrStats.
+
+======================================================================*/
+
+#ifndef _SEARCH_STATS_H
+#define _SEARCH_STATS_H
+
+#include "tiesr_config.h"
+
+/*
+** Statistics of the search.  In the utterance statistics each count
+** is the sum over all frames, except beam_cells, which is the peak.
+*/
+typedef struct TIesrEngineStats
+{
+      /* frames searched */
+      unsigned long frames;
+
+      /* Gaussians evaluated, found in the Gaussian cache, and scored by
+	 the VQ cluster score due to Gaussian selection */
+      unsigned long gauss_evaluated;
+      unsigned long gauss_cache_hits;
+      unsigned long gauss_cluster_scored;
+
+      /* VQ clusters in the Gaussian selection core, intermediate and
+	 outmost categories */
+      unsigned long clusters[3];
+
+      /* active grammar symbols and HMM states */
+      unsigned long active_syms;
+      unsigned long active_states;
+
+      /* backtrace beam cells in use, and number of beam cell compactions */
+      unsigned long beam_cells;
+      unsigned long compactions;
+
+      /* width of the prune beam below the best score of the prior frame */
+      unsigned long prune_width;
+
+      /* model mean vectors compensated by JAC */
+      unsigned long jac_vectors;
+
+      /* nanoseconds spent in front end processing (including JAC
+	 compensation), Gaussian scoring, path propagation and backtrace.
+	 Only collected while statistics are enabled. */
+      unsigned long long ns_frontend;
+      unsigned long long ns_score;
+      unsigned long long ns_propagate;
+      unsigned long long ns_backtrace;
+
+} TIesrEngineStatsType;
+
+
+/*
+** SEARCH_STAT(statement) compiles the statement only if statistics are
+** configured in tiesr_config.h.
+*/
+#ifdef USE_SEARCH_STATS
+#define SEARCH_STAT(statement) statement
+#else
+#define SEARCH_STAT(statement)
+#endif
+
+#endif /* _SEARCH_STATS_H */
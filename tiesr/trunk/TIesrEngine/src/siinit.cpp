@@ -28,6 +28,10 @@
 #endif
 
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "tiesr_config.h"
 #include "tiesrcommonmacros.h"
 
@@ -37,9 +41,13 @@
 #include "search_user.h"
 #include "uttdet_user.h"
 #include "load_user.h"
+#include "image_user.h"
+#include "bundle_user.h"
 #include "volume_user.h"
 #include "gmhmm_si_api.h"
 #include "jac-estm_user.h"
+#include "jac_one_user.h"
+#include "trace_user.h"
 #include "noise_sub_user.h"
 
 //#ifdef USE_SBC
@@ -89,6 +97,30 @@ void output_network(FILE*, short *base_net);
 #define TIME_Z   2000 
 */
 
+/* A grammar network and its word list, resident with the models.  A
+   grammar directory holding its own hmm.bin has its own list of HMMs
+   over the shared models, and its own map of HMMs to phones for SBC.
+   Either is NULL if the grammar uses that of the OpenASR grammar. */
+typedef struct
+{
+      short *base_net;
+      char **vocabulary;
+      unsigned short *base_hmms;
+      short *hmm2phone;
+} GrammarType;
+
+/* Table of the resident grammars.  Entry 0 is the grammar loaded by
+   OpenASR, which remains owned by the ASR structure. */
+typedef struct
+{
+      GrammarType grammar[ MAX_GRAMMARS ];
+      unsigned short active;
+
+      /* symbol map allocated for a grammar larger than entry 0, or NULL */
+      short *sym2pos_mem;
+} GrammarTableType;
+
+
 const short K_mean[ MAX_DIM_MFCC16 ] = /* {11668, 506, 957, -1425, -472, -668, -2806, 1911};   */
   { 14149,  -4777,  -746,  287,  -2014,  -749,  -773,  -171 , 0,0, 
     0,0,0,0,0,0};
@@ -170,6 +202,8 @@ static void Init_Search(gmhmm_type * gv, const short * p_K_mean)
 #endif
 
   gv->bUseNBest = bUseNBest; 
+  gv->bStats = FALSE;
+  gv->pTrace = NULL;
 #ifdef USE_NBEST
   gv->ptr_nbest_tmp = NULL;
 #endif
@@ -477,6 +511,63 @@ static TIesrEngineStatusType AllocateTIesrMemory( short* memoryPool,
 }
 
 
+/*---------------------------------------------------------------------------
+ open_asr_memory
+
+ Initialize the search and allocate memory structures of an ASR structure
+ whose models and grammar network are loaded.
+
+ Arguments:
+ gv: ASR structure at the start of the memory pool
+ total_words: Number of shorts in the memory pool
+ model_file_name: Directory the models were loaded from, or NULL if they
+ were mapped from an image or read from a bundle
+
+-----------------------------*/
+static TIesrEngineStatusType open_asr_memory( gmhmm_type *gv, int total_words,
+					      char *model_file_name )
+{
+   TIesrEngineStatusType status;
+
+#ifdef _MONOPHONE_NET
+   FILE* fp; 
+#endif
+
+  /* total memory available for gmhmm_type ASR structure,
+   search and mfcc storage */
+  gv->total_words = total_words; 
+
+  /* Initialize search parameters and variables in ASR structure */
+  Init_Search(gv, K_mean); 
+
+#ifdef _MONOPHONE_NET
+  fp = fopen("test.xvcg", "wt");
+  output_network(fp, (short*)((gmhmm_type*)gv->pAux)->trans);
+  fclose(fp);
+  status = AllocateTIesrMemory( (short*) rs_get_decoder(gv), MAX_FRM_NBR, model_file_name);
+  if (status != eTIesrEngineSuccess) return status;
+#endif
+
+  /* Allocate memory in the memory pool above the ASR structure to search and
+   frame processing variables */
+  status = AllocateTIesrMemory( (short*)gv, MAX_FRM_NBR, model_file_name );
+
+  if (status != eTIesrEngineSuccess) 
+    return status; 
+
+  /* Set default values of ASR parameters */
+  SetDefault(gv);
+
+  /* Start background model compensation, if available */
+  jac_bg_open(gv);
+
+  /* Start the JAC EM worker threads, if available */
+  jac_em_open(gv);
+
+  return status;
+}
+
+
 /*---------------------------------------------------------------------------
  OpenASR
 
@@ -496,10 +587,6 @@ TIesrEngineStatusType OpenASR(char model_file_name[], int total_words,
    TIesrEngineStatusType status;
    int gvSize;
 
-#ifdef _MONOPHONE_NET
-   FILE* fp; 
-#endif
-
   /* Size of gmhmm_type in whole shorts */
   gvSize = (sizeof(gmhmm_type) + 1) >> 1;
   if( total_words < gvSize )
@@ -507,45 +594,435 @@ TIesrEngineStatusType OpenASR(char model_file_name[], int total_words,
 
   gv = (gmhmm_type*)memoryPool;
   gv->vocabulary = NULL;
+  gv->pJacBg = NULL;
+  gv->pJacEm = NULL;
+  gv->pGrammars = NULL;
 
   /* Load HMM models and grammar network. Allocates space from heap. */
   status = load_models(model_file_name, gv, FALSE, NULL, NULL); 
   if (status != eTIesrEngineSuccess) return status;
 
-  /* total memory available for gmhmm_type ASR structure,
-   search and mfcc storage */
-  gv->total_words = total_words; 
+  return open_asr_memory( gv, total_words, model_file_name );
+}
 
-  /* Initialize search parameters and variables in ASR structure */
-  Init_Search(gv, K_mean); 
 
-#ifdef _MONOPHONE_NET
-  fp = fopen("test.xvcg", "wt");
-  output_network(fp, (short*)((gmhmm_type*)gv->pAux)->trans);
-  fclose(fp);
-  status = AllocateTIesrMemory( (short*) rs_get_decoder(gv), MAX_FRM_NBR, model_file_name);
+/*---------------------------------------------------------------------------
+ OpenASRImage
+
+ Initialize TIesr state structure as OpenASR does, with the speech HMM and
+ sentence network mapped from an engine image written by WriteTIesrImage.
+
+ Arguments:
+ aImageFile: Engine image file
+ total_words: Number of shorts in memoryPool
+ memoryPool: Pointer to memory, the beginning holds the TIesr state structure
+ 
+-----------------------------*/
+TIesrEngineStatusType OpenASRImage( const char *aImageFile, int total_words,
+				    gmhmm_type* memoryPool )
+{
+   gmhmm_type *gv;
+   TIesrEngineStatusType status;
+   int gvSize;
+
+  /* Size of gmhmm_type in whole shorts */
+  gvSize = (sizeof(gmhmm_type) + 1) >> 1;
+  if( total_words < gvSize )
+     return eTIesrEngineMemorySizeFail;
+
+  gv = (gmhmm_type*)memoryPool;
+  gv->vocabulary = NULL;
+  gv->pJacBg = NULL;
+  gv->pJacEm = NULL;
+  gv->pGrammars = NULL;
+
+  /* Map HMM models and grammar network.  The adapted models are copied
+   to the heap. */
+  status = load_models_image( aImageFile, gv );
+  if (status != eTIesrEngineSuccess) return status;
+
+  return open_asr_memory( gv, total_words, NULL );
+}
+
+
+/*---------------------------------------------------------------------------
+ OpenASRBundle
+
+ Initialize TIesr state structure as OpenASR does, with the speech HMM and
+ sentence network read from a model bundle in memory.
+
+ Arguments:
+ aBundle: Model bundle, kept by the caller until CloseASR
+ total_words: Number of shorts in memoryPool
+ memoryPool: Pointer to memory, the beginning holds the TIesr state structure
+ 
+-----------------------------*/
+TIesrEngineStatusType OpenASRBundle( const void *aBundle, int total_words,
+				     gmhmm_type* memoryPool )
+{
+   gmhmm_type *gv;
+   TIesrEngineStatusType status;
+   int gvSize;
+
+  /* Size of gmhmm_type in whole shorts */
+  gvSize = (sizeof(gmhmm_type) + 1) >> 1;
+  if( total_words < gvSize )
+     return eTIesrEngineMemorySizeFail;
+
+  gv = (gmhmm_type*)memoryPool;
+  gv->vocabulary = NULL;
+  gv->pJacBg = NULL;
+  gv->pJacEm = NULL;
+  gv->pGrammars = NULL;
+
+  /* Load HMM models and grammar network from the bundle. Allocates space
+   from heap. */
+  status = load_models_bundle( aBundle, gv );
   if (status != eTIesrEngineSuccess) return status;
+
+  return open_asr_memory( gv, total_words, NULL );
+}
+
+/*---------------------------------------------------------------------------
+ grammar_same_file
+
+ Compare a model file of a grammar directory with the file loaded by
+ OpenASR.  A file missing from the grammar directory is taken to be the
+ same, so that a grammar directory may hold only a network and word list.
+ ----------------------------------*/
+static Boolean grammar_same_file( const char *aModelDir, const char *aGrammarDir,
+				  const char *aName )
+{
+  char fname[ MAX_STR ];
+  char modelBuf[ 512 ];
+  char grammarBuf[ 512 ];
+  size_t nModel, nGrammar;
+  FILE *fpModel, *fpGrammar;
+  Boolean same;
+
+  sprintf( fname, "%s/%s", aGrammarDir, aName );
+  fpGrammar = fopen( fname, "rb" );
+  if( !fpGrammar )
+    return TRUE;
+
+  sprintf( fname, "%s/%s", aModelDir, aName );
+  fpModel = fopen( fname, "rb" );
+  if( !fpModel )
+  {
+    fclose( fpGrammar );
+    return FALSE;
+  }
+
+  do
+  {
+    nModel = fread( modelBuf, 1, sizeof(modelBuf), fpModel );
+    nGrammar = fread( grammarBuf, 1, sizeof(grammarBuf), fpGrammar );
+    same = nModel == nGrammar && memcmp( modelBuf, grammarBuf, nModel ) == 0;
+  } while( same && nModel == sizeof(modelBuf) );
+
+  fclose( fpModel );
+  fclose( fpGrammar );
+  return same;
+}
+
+
+/*---------------------------------------------------------------------------
+ grammar_free
+
+ Free the network, word list, HMM list and phone map of an added grammar.
+ ----------------------------------*/
+static void grammar_free( GrammarType *aGrammar )
+{
+  free_network( aGrammar->base_net, aGrammar->vocabulary );
+  free( aGrammar->base_hmms );
+  free( aGrammar->hmm2phone );
+
+  aGrammar->base_net = NULL;
+  aGrammar->vocabulary = NULL;
+  aGrammar->base_hmms = NULL;
+  aGrammar->hmm2phone = NULL;
+}
+
+
+/*---------------------------------------------------------------------------
+ grammar_fit_sym2pos
+
+ Ensure the map of symbols to state cells covers the symbols of a
+ network.  The map of OpenASR covers its own grammar only, so a larger
+ map is allocated for a larger grammar.  The map is never shrunk.
+ ----------------------------------*/
+static TIesrEngineStatusType grammar_fit_sym2pos( gmhmm_type *gv, GrammarTableType *aTable,
+						  const TransType *aTrans )
+{
+  unsigned int nbrSyms = (unsigned int) aTrans->n_sym * aTrans->n_set + 1;
+  short *mem;
+  unsigned int k;
+
+  if( nbrSyms <= gv->sym2pos_map.max_nbr_syms )
+    return eTIesrEngineSuccess;
+
+  if( nbrSyms > 0xFFFF )
+    return eTIesrEngineSym2PosMapSize;
+
+  mem = (short*) malloc( 2 * nbrSyms * sizeof(short) );
+  if( !mem )
+    return eTIesrEngineSym2PosMapSize;
+
+  /* The map is reset after each use, so it can be replaced between
+     utterances. */
+  for( k = 0; k < nbrSyms; k++ )
+    mem[ k ] = -1;
+
+  free( aTable->sym2pos_mem );
+  aTable->sym2pos_mem = mem;
+
+  gv->sym2pos_map.sym2pos = mem;
+  gv->sym2pos_map.syms = (unsigned short*)( mem + nbrSyms );
+  gv->sym2pos_map.max_nbr_syms = (unsigned short) nbrSyms;
+  gv->sym2pos_map.nbr_syms = 0;
+
+  return eTIesrEngineSuccess;
+}
+
+
+/*---------------------------------------------------------------------------
+ AddGrammar
+
+ Load the network and word list of a grammar directory and keep them
+ resident with the models loaded by OpenASR.  A grammar directory with
+ its own hmm.bin lists its own HMMs, and its hmm2phone.bin maps them to
+ phones.  The files of the models the HMMs index must match the files
+ loaded by OpenASR.  A grammar without a hmm.bin of its own, such as
+ a grammar of the model pool of the OpenASR grammar, indexes the HMMs
+ of the OpenASR grammar.
+
+ Arguments:
+ aGrammarDir: Directory holding net.bin and word.lis of the grammar
+ gv: Pointer to the ASR structure
+ aIndex: Set to the index of the grammar for SelectGrammar
+ ----------------------------------*/
+TIesrEngineStatusType AddGrammar( const char *aGrammarDir, gmhmm_type *gv,
+				  unsigned short *aIndex )
+{
+  /* Files of the models shared by all grammars, and the name of a
+     model pool holding them */
+  static const char * const sharedFiles[] =
+    { "mu.bin", "var.bin", "tran.bin", "pdf.bin", "mixture.bin", "gconst.bin",
+      "dim.bin", "scale.bin", "config.bin", "o2amidx.bin", "vqcentr.bin",
+      MODEL_POOL_FILE };
+
+  GrammarTableType *table = (GrammarTableType*) gv->pGrammars;
+  GrammarType grammar = { NULL, NULL, NULL, NULL };
+  TransType *trans;
+  const TransType *base;
+  unsigned short g;
+  unsigned short f;
+  TIesrEngineStatusType status;
+
+  if( !gv->chpr_Model_Dir )
+    return eTIesrEngineGrammarMismatch;
+
+  for( f = 0; f < sizeof(sharedFiles) / sizeof(sharedFiles[0]); f++ )
+  {
+    if( !grammar_same_file( gv->chpr_Model_Dir, aGrammarDir, sharedFiles[f] ) )
+      return eTIesrEngineGrammarMismatch;
+  }
+
+  if( !table )
+  {
+    table = (GrammarTableType*) calloc( 1, sizeof(GrammarTableType) );
+    if( !table )
+      return eTIesrEngineMemorySizeFail;
+
+    table->grammar[0].base_net = gv->base_net;
+    table->grammar[0].vocabulary = gv->vocabulary;
+    table->grammar[0].base_hmms = gv->base_hmms;
+#ifdef USE_SBC
+    table->grammar[0].hmm2phone =
+      sbc_read_hmm2phone( gv->chpr_Model_Dir, gv->trans->n_hmm_set );
 #endif
+    table->active = 0;
+    gv->pGrammars = (short*) table;
+  }
 
-  /* Allocate memory in the memory pool above the ASR structure to search and
-   frame processing variables */
-  status = AllocateTIesrMemory( (short*)memoryPool, MAX_FRM_NBR, model_file_name );
+  for( g = 1; g < MAX_GRAMMARS && table->grammar[g].base_net; g++ );
+  if( g == MAX_GRAMMARS )
+    return eTIesrEngineGrammarIndex;
 
-  if (status != eTIesrEngineSuccess) 
-    return status; 
+  status = load_network( (char*) aGrammarDir, &grammar.base_net, &grammar.vocabulary );
+  if( status != eTIesrEngineSuccess )
+    return status;
 
-  /* Set default values of ASR parameters */
-  SetDefault(gv);
+  status = load_hmms( aGrammarDir, &grammar.base_hmms );
+  if( status != eTIesrEngineSuccess )
+  {
+    grammar_free( &grammar );
+    return status;
+  }
 
-  return status;
+  /* A network indexing the HMMs of the OpenASR grammar must have its
+     HMM sets */
+  trans = (TransType*) grammar.base_net;
+  base = (const TransType*) table->grammar[0].base_net;
+  if( !grammar.base_hmms &&
+      ( trans->n_hmm != base->n_hmm ||
+	trans->n_set != base->n_set ||
+	trans->n_hmm_set != base->n_hmm_set ) )
+  {
+    grammar_free( &grammar );
+    return eTIesrEngineGrammarMismatch;
+  }
+
+#ifdef USE_SBC
+  /* A grammar with its own HMMs needs its own phone map if SBC uses one */
+  if( grammar.base_hmms )
+  {
+    grammar.hmm2phone = sbc_read_hmm2phone( aGrammarDir, trans->n_hmm_set );
+    if( !grammar.hmm2phone && table->grammar[0].hmm2phone )
+    {
+      grammar_free( &grammar );
+      return eTIesrEngineGrammarMismatch;
+    }
+  }
+#endif
+
+  status = grammar_fit_sym2pos( gv, table, trans );
+  if( status != eTIesrEngineSuccess )
+  {
+    grammar_free( &grammar );
+    return status;
+  }
+
+  table->grammar[g] = grammar;
+  *aIndex = g;
+
+  return eTIesrEngineSuccess;
+}
+
+
+/*---------------------------------------------------------------------------
+ SelectGrammar
+
+ Make a resident grammar the network searched by the next utterance.
+ Index 0 is the grammar loaded by OpenASR.  The HMM list and phone map
+ of the grammar replace those of the last grammar, and the models and
+ adaptation state are unchanged.  This must not be called during a
+ search, and the answer of the last utterance must be read and its
+ adaptation done before calling it.
+ ----------------------------------*/
+TIesrEngineStatusType SelectGrammar( unsigned short aIndex, gmhmm_type *gv )
+{
+  GrammarTableType *table = (GrammarTableType*) gv->pGrammars;
+  GrammarType *grammar;
+
+  if( !table )
+    return aIndex == 0 ? eTIesrEngineSuccess : eTIesrEngineGrammarIndex;
+
+  if( aIndex >= MAX_GRAMMARS || !table->grammar[ aIndex ].base_net )
+    return eTIesrEngineGrammarIndex;
+
+  grammar = table->grammar[ aIndex ].base_hmms ?
+    &table->grammar[ aIndex ] : &table->grammar[0];
+
+#ifdef USE_SBC
+  /* SBC owns its phone map, which JAC_load may replace, so it gets a
+     copy of the map of the grammar */
+  if( grammar->hmm2phone )
+  {
+    unsigned short nbrHmms = ( (TransType*) grammar->base_net )->n_hmm_set;
+    short *map = (short*) malloc( nbrHmms * sizeof(short) );
+
+    if( !map )
+      return eTIesrEngineMemorySizeFail;
+
+    memcpy( map, grammar->hmm2phone, nbrHmms * sizeof(short) );
+    free( gv->sbcState->pHMM2phone );
+    gv->sbcState->pHMM2phone = map;
+  }
+#endif
+
+  gv->base_hmms = grammar->base_hmms;
+  gv->base_net = table->grammar[ aIndex ].base_net;
+  gv->trans = (TransType*) gv->base_net;
+  gv->vocabulary = table->grammar[ aIndex ].vocabulary;
+  table->active = aIndex;
+
+  return eTIesrEngineSuccess;
+}
+
+
+/*---------------------------------------------------------------------------
+ RemoveGrammar
+
+ Free a grammar added by AddGrammar.  The grammar of OpenASR and the
+ selected grammar can not be removed.
+ ----------------------------------*/
+TIesrEngineStatusType RemoveGrammar( unsigned short aIndex, gmhmm_type *gv )
+{
+  GrammarTableType *table = (GrammarTableType*) gv->pGrammars;
+
+  if( !table || aIndex == 0 || aIndex >= MAX_GRAMMARS ||
+      aIndex == table->active || !table->grammar[ aIndex ].base_net )
+    return eTIesrEngineGrammarIndex;
+
+  grammar_free( &table->grammar[ aIndex ] );
+
+  return eTIesrEngineSuccess;
 }
 
+
+/*---------------------------------------------------------------------------
+ GetActiveGrammar
+
+ Get the index of the selected grammar.
+ ----------------------------------*/
+unsigned short GetActiveGrammar( gmhmm_type const *gv )
+{
+  const GrammarTableType *table = (const GrammarTableType*) gv->pGrammars;
+
+  return table ? table->active : 0;
+}
+
+
+/*---------------------------------------------------------------------------
+ grammar_close
+
+ Restore the grammar and HMM list of OpenASR to the ASR structure, so
+ they are freed with the models, and free all other resident grammars.
+ ----------------------------------*/
+static void grammar_close( gmhmm_type *gv )
+{
+  GrammarTableType *table = (GrammarTableType*) gv->pGrammars;
+  unsigned short g;
+
+  if( !table )
+    return;
+
+  gv->base_net = table->grammar[0].base_net;
+  gv->trans = (TransType*) gv->base_net;
+  gv->vocabulary = table->grammar[0].vocabulary;
+  gv->base_hmms = table->grammar[0].base_hmms;
+
+  for( g = 1; g < MAX_GRAMMARS; g++ )
+    grammar_free( &table->grammar[g] );
+
+  free( table->grammar[0].hmm2phone );
+  free( table->sym2pos_mem );
+  free( table );
+  gv->pGrammars = NULL;
+}
+
+
 /*--------------------------------*/
 /* GMHMM_SI_API */ 
 void CloseASR(gmhmm_type *gvv)
 {
   gmhmm_type *gv = (gmhmm_type *) gvv;
 /*  void free_models(gmhmm_type *);*/
+  jac_bg_close(gv);
+  jac_em_close(gv);
+  SetTIesrTrace(gv, 0);
+  grammar_close(gv);
   free_models(gv);  
 
 #ifdef USE_SBC
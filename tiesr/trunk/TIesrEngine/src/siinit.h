@@ -32,4 +32,8 @@
 #define STATE_R  9209
 #define TIME_Z   200 /* words, MIN 118 */
 
+/* maximum number of grammar networks resident at once, including the
+   network loaded by OpenASR */
+#define MAX_GRAMMARS 16
+
 #endif
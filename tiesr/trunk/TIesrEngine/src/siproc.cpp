@@ -41,6 +41,8 @@
 #include "status.h"
 #include "search_user.h"
 #include "gmhmm_si_api.h"
+#include "gmhmm_type_common_user.h"
+#include "trace_user.h"
 #include "sbc_user.h"
 #ifdef USE_NBEST
 #include <nbest_user.h>
@@ -174,6 +176,8 @@ static TIesrEngineStatusType  rs_CopyAlignFrom( gmhmm_type * src_eng,
 /* GMHMM_SI_API */ TIesrEngineStatusType CloseSearchEngine(TIesrEngineStatusType status, gmhmm_type *gvv)
 {
   gmhmm_type *global_var = (gmhmm_type *) gvv;
+  SEARCH_STAT( unsigned long long start_ns = gvv->bStats ? stats_clock() : 0 );
+  TRACE_BEGIN( gvv, trace_start );
 #ifdef _MONOPHONE_NET
   global_var = (gmhmm_type*) global_var->pAux; 
 #endif
@@ -227,6 +231,9 @@ static TIesrEngineStatusType  rs_CopyAlignFrom( gmhmm_type * src_eng,
   GetSearchInfo(global_var); 
 #endif
 
+  SEARCH_STAT( if( gvv->bStats ) gvv->stats_utt.ns_backtrace += stats_clock() - start_ns );
+  TRACE_END( gvv, "backtrace", trace_start );
+
 #ifdef _MONOPHONE_NET
   rs_CopyAlignFrom( global_var , gvv ); 
 #endif
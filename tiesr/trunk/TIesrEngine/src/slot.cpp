@@ -0,0 +1,553 @@
+/*=======================================================================
+
+ *
+ * slot.cpp
+ *
+ * Linking of grammar slot networks.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ The symbols of a network are ordered so that the symbols following a
+ symbol come before it.  The copy of a slot network takes the place of
+ the slot word in the list of symbols, which keeps this order.  The
+ symbols leading to the slot word lead to the start symbols of the
+ copy instead, and the symbols ending the slot network lead to the
+ symbols that followed the slot word.  Each slot word of the grammar
+ network gets its own copy, since each is followed by different
+ symbols.  The words of a slot are added to the end of the word list
+ once, and are shared by its copies.
+
+======================================================================*/
+
+/* Headers required by Windows OS */
+#if defined (WIN32) || defined (WINCE)
+#include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tiesr_config.h"
+#include "gmhmm.h"
+#include "search_user.h"
+#include "load_user.h"
+#include "slot_user.h"
+
+
+/* A slot network read for linking */
+typedef struct
+{
+      short *net;
+      char **vocabulary;
+
+      /* index of the first word of the slot in the linked word list */
+      unsigned short word_base;
+
+      /* flags of the symbols ending the slot network */
+      unsigned char *final;
+} SlotType;
+
+
+/* The networks being linked */
+typedef struct
+{
+      const short *net;
+      const SlotType *slots;
+
+      /* slot of each symbol of the grammar network, or -1 */
+      const short *slot_of;
+
+      /* index of each symbol in the linked network, or of the first
+	 symbol of its slot copy */
+      const unsigned short *new_index;
+} LinkType;
+
+
+/*--------------------------------*/
+static const SymType* net_sym( const short *aNet, unsigned short aOffset )
+{
+   return (const SymType*) ( aNet + aOffset );
+}
+
+
+/*----------------------------------------------------------------
+ link_next
+
+ Set the linked indices of the symbols following a symbol of the
+ grammar network, and return their number.  A following slot word is
+ replaced by the start symbols of its copy.  aNext may be NULL to only
+ count the symbols.
+ --------------------------------*/
+static unsigned int link_next( const LinkType *aLink, const SymType *aSym,
+			       unsigned short *aNext )
+{
+   unsigned int n = 0;
+   unsigned short i, k, next;
+   const SymType *start;
+   const short *slotNet;
+
+   for( i = 0; i < GET_N_NEXT( aSym->n_next ); i++ )
+   {
+      next = aSym->next[i];
+
+      if( aLink->slot_of[next] < 0 )
+      {
+	 if( aNext )
+	    aNext[n] = aLink->new_index[next];
+	 n++;
+	 continue;
+      }
+
+      slotNet = aLink->slots[ aLink->slot_of[next] ].net;
+      start = net_sym( slotNet, ( (const TransType*) slotNet )->start );
+      for( k = 0; k < GET_N_NEXT( start->n_next ); k++ )
+      {
+	 if( aNext )
+	    aNext[n] = aLink->new_index[next] + start->next[k];
+	 n++;
+      }
+   }
+
+   return n;
+}
+
+
+/*----------------------------------------------------------------
+ link_stop
+
+ As link_next for the symbols ending the grammar network, where a
+ slot word is replaced by the symbols ending its copy.
+ --------------------------------*/
+static unsigned int link_stop( const LinkType *aLink, unsigned short *aNext )
+{
+   const SymType *stop = net_sym( aLink->net, ( (const TransType*) aLink->net )->stop );
+   const SymType *slotStop;
+   const short *slotNet;
+   unsigned int n = 0;
+   unsigned short i, k, sym;
+
+   for( i = 0; i < GET_N_NEXT( stop->n_next ); i++ )
+   {
+      sym = stop->next[i];
+
+      if( aLink->slot_of[sym] < 0 )
+      {
+	 if( aNext )
+	    aNext[n] = aLink->new_index[sym];
+	 n++;
+	 continue;
+      }
+
+      slotNet = aLink->slots[ aLink->slot_of[sym] ].net;
+      slotStop = net_sym( slotNet, ( (const TransType*) slotNet )->stop );
+      for( k = 0; k < GET_N_NEXT( slotStop->n_next ); k++ )
+      {
+	 if( aNext )
+	    aNext[n] = aLink->new_index[sym] + slotStop->next[k];
+	 n++;
+      }
+   }
+
+   return n;
+}
+
+
+/*----------------------------------------------------------------
+ put_sym
+
+ Write a symbol of the linked network at aPos, with the following
+ symbols of a grammar network symbol, and the symbols of a slot
+ network symbol before them.  Returns the position after the symbol.
+ --------------------------------*/
+static unsigned int put_sym( short *aOut, unsigned int aPos, unsigned short aHmm,
+			     unsigned short aWord, const LinkType *aLink,
+			     const SymType *aSym, const SymType *aSlotSym,
+			     unsigned short aSlotBase )
+{
+   unsigned short *sym = (unsigned short*) aOut + aPos;
+   unsigned int n = 0;
+   unsigned short k;
+
+   if( aSlotSym )
+   {
+      for( k = 0; k < GET_N_NEXT( aSlotSym->n_next ); k++ )
+	 sym[ 2 + n++ ] = aSlotBase + aSlotSym->next[k];
+   }
+
+   if( aSym )
+      n += link_next( aLink, aSym, sym + 2 + n );
+
+   sym[0] = aHmm;
+   sym[1] = (unsigned short) n;
+   if( aWord != MCODE )
+   {
+      sym[1] |= 0x8000;
+      sym[ 2 + n++ ] = aWord;
+   }
+
+   return aPos + 2 + n;
+}
+
+
+/*--------------------------------*/
+static unsigned short sym_word( const SymType *aSym )
+{
+   if( !( aSym->n_next & 0x8000 ) )
+      return MCODE;
+   return aSym->next[ GET_N_NEXT( aSym->n_next ) ];
+}
+
+
+/*----------------------------------------------------------------
+ read_slot
+
+ Read the network and word list of a slot.  The slot is left without
+ a network if it has none, or it was made with another set of HMMs.
+ --------------------------------*/
+static TIesrEngineStatusType read_slot( const char *mod_dir, const void *aBundle,
+					const char *aWord, const TransType *aTrans,
+					SlotType *aSlot )
+{
+   char fname[ FILENAME_MAX ];
+   const char *name = aWord + strlen( SLOT_PREFIX );
+   const TransType *trans;
+   const SymType *stop;
+   unsigned short len, k;
+   TIesrEngineStatusType status;
+
+   aSlot->net = NULL;
+   aSlot->vocabulary = NULL;
+   aSlot->final = NULL;
+
+   if( strlen( name ) + strlen( SLOT_NET_EXT ) >= FILENAME_MAX ||
+       strlen( name ) + strlen( SLOT_WORD_EXT ) >= FILENAME_MAX )
+      return eTIesrEngineSuccess;
+
+   sprintf( fname, "%s%s", name, SLOT_NET_EXT );
+   aSlot->net = read_model_file( mod_dir, aBundle, fname, &len );
+   if( !aSlot->net )
+      return eTIesrEngineSuccess;
+
+   trans = (const TransType*) aSlot->net;
+   if( trans->n_set != aTrans->n_set )
+   {
+      free( aSlot->net );
+      aSlot->net = NULL;
+      return eTIesrEngineSuccess;
+   }
+
+   sprintf( fname, "%s%s", name, SLOT_WORD_EXT );
+   status = read_word_list( mod_dir, aBundle, fname, trans->n_word, &aSlot->vocabulary );
+   if( status != eTIesrEngineSuccess )
+      return status;
+
+   aSlot->final = (unsigned char*) calloc( trans->n_sym ? trans->n_sym : 1,
+					   sizeof(unsigned char) );
+   if( !aSlot->final )
+      return eTIesrEngineModelLoadFail;
+
+   stop = net_sym( aSlot->net, trans->stop );
+   for( k = 0; k < GET_N_NEXT( stop->n_next ); k++ )
+      aSlot->final[ stop->next[k] ] = 1;
+
+   return eTIesrEngineSuccess;
+}
+
+
+/*----------------------------------------------------------------
+ link_vocabulary
+
+ Make the linked word list, of the words of the grammar followed by
+ the words of each slot.
+ --------------------------------*/
+static char** link_vocabulary( char **aVocabulary, unsigned short aNumWords,
+			       const SlotType *aSlots, unsigned short aNumSlots,
+			       unsigned short aLinkedWords )
+{
+   char **vocabulary;
+   char *text;
+   unsigned int size = 0;
+   unsigned short w, s, n;
+   char **words;
+
+   for( s = 0; s <= aNumSlots; s++ )
+   {
+      words = s < aNumSlots ? aSlots[s].vocabulary : aVocabulary;
+      n = s < aNumSlots ? ( aSlots[s].net ? ( (const TransType*) aSlots[s].net )->n_word : 0 )
+	 : aNumWords;
+      for( w = 0; w < n; w++ )
+	 size += strlen( words[w] ) + 1;
+   }
+
+   vocabulary = (char**) malloc( aLinkedWords * sizeof(char*) );
+   if( !vocabulary )
+      return NULL;
+
+   text = (char*) malloc( size );
+   if( !text )
+   {
+      free( vocabulary );
+      return NULL;
+   }
+
+   for( w = 0; w < aNumWords; w++ )
+   {
+      vocabulary[w] = text;
+      strcpy( text, aVocabulary[w] );
+      text += strlen( text ) + 1;
+   }
+
+   for( s = 0; s < aNumSlots; s++ )
+   {
+      if( !aSlots[s].net )
+	 continue;
+
+      n = ( (const TransType*) aSlots[s].net )->n_word;
+      for( w = 0; w < n; w++ )
+      {
+	 vocabulary[ aSlots[s].word_base + w ] = text;
+	 strcpy( text, aSlots[s].vocabulary[w] );
+	 text += strlen( text ) + 1;
+      }
+   }
+
+   return vocabulary;
+}
+
+
+/*----------------------------------------------------------------*/
+TIesrEngineStatusType link_slots( const char *mod_dir, const void *aBundle,
+				  short **aNet, char ***aVocabulary )
+{
+   const TransType *trans = (const TransType*) *aNet;
+   char **vocabulary = *aVocabulary;
+   unsigned int prefixLength = strlen( SLOT_PREFIX );
+   SlotType *slots = NULL;
+   short *wordSlot = NULL;
+   short *slotOf = NULL;
+   unsigned short *newIndex = NULL;
+   unsigned short numSlots = 0;
+   unsigned short w, s, i, k;
+   unsigned long numSyms, size, linkedWords;
+   unsigned short nHmm, nHmmSet;
+   unsigned int pos, linked;
+   const SymType *sym, *slotSym;
+   const TransType *slotTrans;
+   short *net = NULL;
+   char **linkedVocabulary;
+   TransType *linkedTrans;
+   LinkType link;
+   TIesrEngineStatusType status = eTIesrEngineSuccess;
+
+
+   /* Find the slot words of the grammar */
+   for( w = 0; w < trans->n_word; w++ )
+   {
+      if( strncmp( vocabulary[w], SLOT_PREFIX, prefixLength ) == 0 )
+	 numSlots++;
+   }
+   if( numSlots == 0 )
+      return eTIesrEngineSuccess;
+
+   slots = (SlotType*) calloc( numSlots, sizeof(SlotType) );
+   wordSlot = (short*) malloc( trans->n_word * sizeof(short) );
+   slotOf = (short*) malloc( trans->n_sym * sizeof(short) );
+   newIndex = (unsigned short*) malloc( trans->n_sym * sizeof(unsigned short) );
+   if( !slots || !wordSlot || ( trans->n_sym && ( !slotOf || !newIndex ) ) )
+   {
+      status = eTIesrEngineModelLoadFail;
+      goto done;
+   }
+
+
+   /* Read the network of each slot, and place its words after those
+      of the grammar and the slots before it */
+   linkedWords = trans->n_word;
+   nHmm = trans->n_hmm;
+   nHmmSet = trans->n_hmm_set;
+   s = 0;
+   for( w = 0; w < trans->n_word; w++ )
+   {
+      wordSlot[w] = -1;
+      if( strncmp( vocabulary[w], SLOT_PREFIX, prefixLength ) != 0 )
+	 continue;
+
+      status = read_slot( mod_dir, aBundle, vocabulary[w], trans, &slots[s] );
+      if( status != eTIesrEngineSuccess )
+	 goto done;
+
+      if( slots[s].net )
+      {
+	 slotTrans = (const TransType*) slots[s].net;
+	 wordSlot[w] = s;
+	 slots[s].word_base = (unsigned short) linkedWords;
+	 linkedWords += slotTrans->n_word;
+	 if( slotTrans->n_hmm > nHmm )
+	    nHmm = slotTrans->n_hmm;
+	 if( slotTrans->n_hmm_set > nHmmSet )
+	    nHmmSet = slotTrans->n_hmm_set;
+      }
+      s++;
+   }
+
+
+   /* Place each symbol of the grammar, or the copy of the slot network
+      of a slot word, in the linked list of symbols */
+   numSyms = 0;
+   linked = 0;
+   for( i = 0; i < trans->n_sym; i++ )
+   {
+      sym = net_sym( *aNet, trans->symlist[i] );
+      w = sym_word( sym );
+
+      slotOf[i] = ( w != MCODE && w < trans->n_word ) ? wordSlot[w] : -1;
+      newIndex[i] = (unsigned short) numSyms;
+
+      if( slotOf[i] < 0 )
+	 numSyms++;
+      else
+      {
+	 numSyms += ( (const TransType*) slots[ slotOf[i] ].net )->n_sym;
+	 linked++;
+      }
+   }
+
+   /* Nothing to link if no slot has a network */
+   if( linked == 0 )
+      goto done;
+
+   link.net = *aNet;
+   link.slots = slots;
+   link.slot_of = slotOf;
+   link.new_index = newIndex;
+
+
+   /* Size of the linked network in shorts.  A symbol is its HMM, its
+      count of following symbols, the following symbols, and the word
+      if it ends a word. */
+   size = 7 + numSyms;
+   size += 2 + link_next( &link, net_sym( *aNet, trans->start ), NULL );
+   size += 2 + link_stop( &link, NULL );
+   for( i = 0; i < trans->n_sym; i++ )
+   {
+      sym = net_sym( *aNet, trans->symlist[i] );
+      if( slotOf[i] < 0 )
+      {
+	 size += 2 + link_next( &link, sym, NULL ) + ( sym_word( sym ) != MCODE );
+	 continue;
+      }
+
+      slotTrans = (const TransType*) slots[ slotOf[i] ].net;
+      for( k = 0; k < slotTrans->n_sym; k++ )
+      {
+	 slotSym = net_sym( slots[ slotOf[i] ].net, slotTrans->symlist[k] );
+	 size += 2 + GET_N_NEXT( slotSym->n_next ) + ( sym_word( slotSym ) != MCODE );
+	 if( slots[ slotOf[i] ].final[k] )
+	    size += link_next( &link, sym, NULL );
+      }
+   }
+
+   /* Symbols are indexed and located by unsigned shorts, and the top
+      bit of a symbol index marks a pruned symbol in the search */
+   if( numSyms >= 0x8000 || size > 0xffff || linkedWords >= MCODE )
+   {
+      status = eTIesrEngineModelLoadFail;
+      goto done;
+   }
+
+   net = (short*) malloc( size * sizeof(short) );
+   if( !net )
+   {
+      status = eTIesrEngineModelLoadFail;
+      goto done;
+   }
+
+   linkedTrans = (TransType*) net;
+   linkedTrans->n_hmm = nHmm;
+   linkedTrans->n_sym = (unsigned short) numSyms;
+   linkedTrans->n_word = (unsigned short) linkedWords;
+   linkedTrans->n_set = trans->n_set;
+   linkedTrans->n_hmm_set = nHmmSet;
+
+   pos = 7 + numSyms;
+   linkedTrans->start = pos;
+   pos = put_sym( net, pos, 0, MCODE, &link, net_sym( *aNet, trans->start ), NULL, 0 );
+
+   linkedTrans->stop = pos;
+   ( (unsigned short*) net )[pos] = 0;
+   ( (unsigned short*) net )[pos + 1] = (unsigned short) link_stop( &link, (unsigned short*) net + pos + 2 );
+   pos += 2 + link_stop( &link, NULL );
+
+   for( i = 0; i < trans->n_sym; i++ )
+   {
+      sym = net_sym( *aNet, trans->symlist[i] );
+      if( slotOf[i] < 0 )
+      {
+	 linkedTrans->symlist[ newIndex[i] ] = pos;
+	 pos = put_sym( net, pos, sym->hmm_code, sym_word( sym ), &link, sym, NULL, 0 );
+	 continue;
+      }
+
+      /* The copy of the slot network, with the words of the slot, and
+	 its ending symbols also followed by those after the slot word */
+      slotTrans = (const TransType*) slots[ slotOf[i] ].net;
+      for( k = 0; k < slotTrans->n_sym; k++ )
+      {
+	 slotSym = net_sym( slots[ slotOf[i] ].net, slotTrans->symlist[k] );
+	 w = sym_word( slotSym );
+	 if( w != MCODE )
+	    w += slots[ slotOf[i] ].word_base;
+
+	 linkedTrans->symlist[ newIndex[i] + k ] = pos;
+	 pos = put_sym( net, pos, slotSym->hmm_code, w, &link,
+			slots[ slotOf[i] ].final[k] ? sym : NULL,
+			slotSym, newIndex[i] );
+      }
+   }
+
+
+   linkedVocabulary = link_vocabulary( vocabulary, trans->n_word, slots, numSlots,
+				       (unsigned short) linkedWords );
+   if( !linkedVocabulary )
+   {
+      free( net );
+      status = eTIesrEngineModelLoadFail;
+      goto done;
+   }
+
+   free_network( *aNet, *aVocabulary );
+   *aNet = net;
+   *aVocabulary = linkedVocabulary;
+
+
+ done:
+   if( slots )
+   {
+      for( s = 0; s < numSlots; s++ )
+      {
+	 free_network( slots[s].net, slots[s].vocabulary );
+	 if( slots[s].final )
+	    free( slots[s].final );
+      }
+      free( slots );
+   }
+   if( wordSlot )
+      free( wordSlot );
+   if( slotOf )
+      free( slotOf );
+   if( newIndex )
+      free( newIndex );
+
+   return status;
+}
@@ -0,0 +1,95 @@
+/*=======================================================================
+
+ *
+ * slot_user.h
+ *
+ * Header for interface of linking grammar slots.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ A grammar may hold slots, which are words named SLOT_PREFIX followed
+ by the slot name, such as "_SLOT_contact".  The network of a slot is
+ made by TIesrFlex separately from the grammar holding it, and is kept
+ in the grammar directory in the files named by the slot name followed
+ by SLOT_NET_EXT and SLOT_WORD_EXT, such as "contact.slot" and
+ "contact.slis".  These have the format of net.bin and word.lis.  The
+ slot and grammar networks use the triphones of the same models.
+
+ When the grammar network is loaded, each slot word of the network is
+ replaced by a copy of the slot network, so the search sees one
+ network.  A slot network can be changed and the grammar loaded again
+ without the grammar network being changed.  A slot without a slot
+ network is left as a word recognized as silence.
+
+======================================================================*/
+
+#ifndef SLOT_USER_H
+#define SLOT_USER_H
+
+
+/*--------------------------------------------------------------
+The Windows method of exporting functions from a DLL.
+---------------------------------------------------------------*/
+#if defined (WIN32) || defined (WINCE)
+
+/* If it is not defined already, define a macro that does
+Windows format export of DLL functions */
+#ifndef TIESRENGINECOREAPI_API
+
+// The following ifdef block is the standard way of creating macros which
+// make exporting from a DLL simpler. All files within this DLL are compiled
+// with the TIESRENGINECOREAPI_EXPORTS symbol defined on the command line.
+// This symbol should not be defined on any project that uses this DLL.
+// This way any other project whose source files include this file see
+// TIESRENGINECOREAPI_API functions as being imported from a DLL,
+// whereas this DLL sees symbols defined with this macro as being exported.
+#ifdef TIESRENGINECOREAPI_EXPORTS
+#define TIESRENGINECOREAPI_API __declspec(dllexport)
+#else
+#define TIESRENGINECOREAPI_API __declspec(dllimport)
+#endif
+#endif
+
+#else
+
+#ifndef TIESRENGINECOREAPI_API
+#define TIESRENGINECOREAPI_API
+#endif
+
+#endif
+/*--------------------------------------------------------------------*/
+
+
+#include "tiesr_config.h"
+#include "status.h"
+
+
+/* Names of slot words and slot files */
+#define SLOT_PREFIX "_SLOT_"
+#define SLOT_NET_EXT ".slot"
+#define SLOT_WORD_EXT ".slis"
+
+
+/*----------------------------------------------------------------
+ link_slots
+
+ Replace the slot words of a network by the networks of their slots,
+ which are read from the model directory mod_dir or the bundle
+ aBundle.  The network and word list are replaced by the linked ones,
+ which are allocated as by load_network and freed by free_network.
+ If the network has no slot words, it is not changed.
+ --------------------------------*/
+TIesrEngineStatusType link_slots( const char *mod_dir, const void *aBundle,
+				  short **aNet, char ***aVocabulary );
+
+#endif
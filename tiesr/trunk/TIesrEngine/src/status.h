@@ -64,6 +64,8 @@ typedef enum {
        eTIesrEngineModelLoadFail = 400,   /* fail to load recognition models */
        eTIesrEngineAlignmentFail,
        eTIesrEngineMemorySizeFail,
+       eTIesrEngineGrammarMismatch,       /* grammar does not use the resident models */
+       eTIesrEngineGrammarIndex,          /* no resident grammar of the index, or it is in use */
 
        eTIesrEngineFailedJAC = 425,
 
@@ -141,12 +141,66 @@ Utilize SVA for variance adaptation of models. Comment out to disable.
 
 
 
+/*------------------------------------------------------------------------
+ Parallel JAC EM. The observation likelihoods and backward variables of
+ each utterance segment are computed by JAC_EM_THREADS threads during the
+ JAC update. The JAC_EM_THREADS-1 pool threads are shared by all
+ recognizers of the process, and run from the first OpenASR until the
+ last CloseASR. Statistics are still accumulated in segment order, so the
+ result does not depend on thread scheduling. Requires POSIX threads and
+ is only used when LINUX is defined. Comment out to disable.
+ ------------------------------------------------------------------------*/
+#define JAC_PARALLEL_EM
+#define JAC_EM_THREADS 4
+
+
+/*------------------------------------------------------------------------
+ Background model compensation. SVA variance compensation and rapid JAC
+ mean compensation are computed by a worker thread into spare model
+ buffers, which the frame processing thread swaps in at the next frame
+ boundary. Frame processing only waits for the worker if speech starts
+ before any compensated means exist. The JAC_BG_THREADS worker threads
+ are shared by all recognizers of the process, and run from the first
+ OpenASR until the last CloseASR. Requires POSIX threads and is only
+ used when LINUX is defined. Comment out to disable.
+ ------------------------------------------------------------------------*/
+#define JAC_BACKGROUND_COMPENSATION
+#define JAC_BG_THREADS 1
+
+
+/*------------------------------------------------------------------------
+ Search statistics. The search counts Gaussian evaluations, cache hits,
+ Gaussian selection categories, active symbols and states, beam cells and
+ JAC compensated vectors for each frame. Timing of the processing stages
+ and summing the utterance statistics is only done while statistics are
+ enabled by SetTIesrStats. Comment out to remove the counters.
+ ------------------------------------------------------------------------*/
+#define USE_SEARCH_STATS
+
+
+/*------------------------------------------------------------------------
+ Processing trace. The engine records the time of front end, search and
+ backtrace events of each frame in a ring buffer while tracing is enabled
+ by SetTIesrTrace, so that the events can be written in Chrome trace
+ format by DumpTIesrTrace. Comment out to disable.
+ ------------------------------------------------------------------------*/
+#define USE_SEARCH_TRACE
+
+
 /*-------------------------------------------------------------------
  Kept for historical reference in code. Now defunct.
  -------------------------------------------------------------------*/
 /*#define REC */
 
 
+/*---------------------------------------------------------------------
+ Table-driven fixed point math. Replaces the per-call polynomial
+ evaluation in hlr_logsum, hlr_expn (Q6 input) and pow_polyfit with
+ constant lookup tables that are bit-exact with the polynomials. Costs
+ about 3k bytes of constant data. Comment out to disable.
+ ----------------------------------------------------------------------*/
+#define USE_FIXED_POINT_TABLES
+
 /*---------------------------------------------------------------------
  Use fast DCT. A fast DCT is only available for a few specific feature
  sizes. Comment out do disable.
@@ -56,6 +56,7 @@
 
 #include "tiesr_config.h"
 #include "status.h"
+#include "search_stats.h"
 
 /* This is only included here, since the user must know how many
    samples per frame to supply to the recognizer. */
@@ -81,6 +82,8 @@ typedef struct TIesrEngineSIRECO {
       // Doers (functions)
       //
       TIesrEngineStatusType (*OpenASR)(char [], int, TIesr_t );
+      TIesrEngineStatusType (*OpenASRImage)(const char* aImageFile, int, TIesr_t );
+      TIesrEngineStatusType (*OpenASRBundle)(const void* aBundle, int, TIesr_t );
       void (*CloseASR)(TIesr_t);
       TIesrEngineStatusType (*OpenSearchEngine)(TIesr_t); 
       TIesrEngineStatusType (*CallSearchEngine)(short [], TIesr_t, unsigned int);
@@ -89,6 +92,14 @@ typedef struct TIesrEngineSIRECO {
       short (*SpeechDetected)( TIesr_t);
       short (*SpeechEnded)( TIesr_t);
 
+      /* grammar networks resident with the models of OpenASR, which
+	 loads grammar 0.  The grammar is selected between utterances. */
+      TIesrEngineStatusType (*AddGrammar)(const char* aGrammarDir, TIesr_t,
+					  unsigned short* aIndex);
+      TIesrEngineStatusType (*SelectGrammar)(unsigned short, TIesr_t);
+      TIesrEngineStatusType (*RemoveGrammar)(unsigned short, TIesr_t);
+      unsigned short (*GetActiveGrammar)(cTIesr_t);
+
       TIesrEngineJACStatusType (*JAC_load)(const char *bias_file, 
 					   TIesr_t, 
 					   const char* pNetDir,
@@ -102,6 +113,21 @@ typedef struct TIesrEngineSIRECO {
 
       TIesrEngineJACStatusType (*JAC_update)(TIesr_t);
 
+      /* store of adaptation profiles keyed by speaker or channel ID.
+	 JAC_save_profile and JAC_load_profile save and load the state
+	 of JAC_save and JAC_load in memory, between utterances. */
+      struct TIesrProfileStore* (*OpenTIesrProfiles)(unsigned int capacity);
+      void (*CloseTIesrProfiles)(struct TIesrProfileStore*);
+      TIesrEngineJACStatusType (*JAC_save_profile)(struct TIesrProfileStore*,
+						   const char* aId, TIesr_t);
+      TIesrEngineJACStatusType (*JAC_load_profile)(struct TIesrProfileStore*,
+						   const char* aId, TIesr_t);
+      void (*RemoveTIesrProfile)(struct TIesrProfileStore*, const char* aId);
+      TIesrEngineJACStatusType (*WriteTIesrProfiles)(const struct TIesrProfileStore*,
+						     const char* aFileName);
+      TIesrEngineJACStatusType (*ReadTIesrProfiles)(struct TIesrProfileStore*,
+						    const char* aFileName);
+
 
       //
       // Getters (queries)
@@ -206,6 +232,22 @@ confidence score of an utterance has to be larger than a threshold to have adapt
 
       void (*GetTIesrVolRange)(TIesr_t, unsigned short *, unsigned short *);
 
+  /* enable collection of search statistics, and get the statistics of
+     the utterance and of the last frame processed.  Either statistics
+     pointer may be NULL.  Statistics are only valid while enabled. */
+  void (*SetTIesrStats)(TIesr_t, short);
+  void (*GetTIesrStats)(cTIesr_t, TIesrEngineStatsType*, TIesrEngineStatsType*);
+
+  /* record the last events of processing in a ring buffer of the given
+     size (0 disables), record an event of the application that started
+     at a time returned by GetTIesrClock, and write the events in Chrome
+     trace format to a file.  The trace must not be written while frames
+     are being processed. */
+  TIesrEngineStatusType (*SetTIesrTrace)(TIesr_t, unsigned int);
+  void (*TraceTIesrEvent)(TIesr_t, const char*, unsigned long long);
+  TIesrEngineStatusType (*DumpTIesrTrace)(cTIesr_t, const char*);
+  unsigned long long (*GetTIesrClock)(void);
+
 } TIesrEngineSIRECOType;
 
 
@@ -0,0 +1,162 @@
+/*=======================================================================
+
+ *
+ * trace.cpp
+ *
+ * Recorder of timed TIesr processing events.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ Events are kept in a fixed size ring buffer allocated when tracing is
+ enabled, so that recording an event only stores a few values and
+ never allocates memory or does I/O.  The events are converted to the
+ Chrome trace event JSON format only when the trace is written.
+
+======================================================================*/
+
+/* Headers required by Windows OS */
+#if defined (WIN32) || defined (WINCE)
+#include <windows.h>
+#endif
+
+#include "tiesr_config.h"
+#include "trace_user.h"
+
+
+/* A recorded event */
+typedef struct
+{
+      /* name of the event, a string constant */
+      const char *name;
+
+      /* start time and duration in nanoseconds */
+      unsigned long long start;
+      unsigned long long duration;
+
+      /* search frame count when the event ended */
+      unsigned short frame;
+
+} TraceEventType;
+
+
+/* The ring buffer of events */
+typedef struct
+{
+      /* number of events in the ring */
+      unsigned int size;
+
+      /* total number of events recorded */
+      unsigned long count;
+
+      TraceEventType events[1];
+
+} TraceType;
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType SetTIesrTrace( gmhmm_type *gv,
+							    unsigned int aNumEvents )
+{
+   TraceType *trace;
+
+   if( gv->pTrace )
+   {
+      free( gv->pTrace );
+      gv->pTrace = NULL;
+   }
+
+   if( aNumEvents == 0 )
+      return eTIesrEngineSuccess;
+
+   trace = (TraceType*) malloc( sizeof(TraceType) +
+				(aNumEvents - 1) * sizeof(TraceEventType) );
+   if( !trace )
+      return eTIesrEngineMemorySizeFail;
+
+   trace->size = aNumEvents;
+   trace->count = 0;
+
+   gv->pTrace = (short*) trace;
+   return eTIesrEngineSuccess;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API void TraceTIesrEvent( gmhmm_type *gv, const char *aName,
+					     unsigned long long aStart )
+{
+   TraceType *trace = (TraceType*) gv->pTrace;
+   TraceEventType *event;
+
+   if( !trace )
+      return;
+
+   event = trace->events + ( trace->count % trace->size );
+   event->name = aName;
+   event->start = aStart;
+   event->duration = stats_clock() - aStart;
+   event->frame = gv->frm_cnt;
+
+   trace->count++;
+}
+
+
+/*----------------------------------------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType DumpTIesrTrace( const gmhmm_type *gv,
+							     const char *aFileName )
+{
+   const TraceType *trace = (const TraceType*) gv->pTrace;
+   const TraceEventType *event;
+   unsigned long first, n;
+   unsigned long long origin;
+   FILE *fp;
+
+   if( !trace )
+      return eTIesrEngineSaveFail;
+
+   fp = fopen( aFileName, "w" );
+   if( !fp )
+      return eTIesrEngineSaveFail;
+
+   /* Oldest event still in the ring */
+   first = trace->count > trace->size ? trace->count - trace->size : 0;
+
+   /* Times are written in microseconds relative to the earliest start.
+      Events are recorded when they end, so an enclosing event may be
+      recorded after the events it contains. */
+   origin = 0;
+   for( n = first; n < trace->count; n++ )
+   {
+      event = trace->events + ( n % trace->size );
+      if( n == first || event->start < origin )
+	 origin = event->start;
+   }
+
+   fprintf( fp, "{\"traceEvents\":[" );
+   for( n = first; n < trace->count; n++ )
+   {
+      event = trace->events + ( n % trace->size );
+      fprintf( fp, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+	       "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+	       n == first ? "" : ",", event->name,
+	       (double) ( event->start - origin ) / 1000.0,
+	       (double) event->duration / 1000.0,
+	       (unsigned int) event->frame );
+   }
+   fprintf( fp, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+
+   if( fclose( fp ) != 0 )
+      return eTIesrEngineSaveFail;
+
+   return eTIesrEngineSuccess;
+}
@@ -0,0 +1,119 @@
+/*=======================================================================
+
+ *
+ * trace_user.h
+ *
+ * Header for interface of the TIesr processing trace recorder.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ The trace recorder keeps the most recent timed processing events of
+ a recognizer instance in a ring buffer.  The events can be written to
+ a file in the Chrome trace event JSON format, which can be viewed with
+ chrome://tracing or Perfetto.
+
+======================================================================*/
+
+#ifndef TRACE_USER_H
+#define TRACE_USER_H
+
+
+/*--------------------------------------------------------------
+The Windows method of exporting functions from a DLL.
+---------------------------------------------------------------*/
+#if defined (WIN32) || defined (WINCE)
+
+/* If it is not defined already, define a macro that does
+Windows format export of DLL functions */
+#ifndef TIESRENGINECOREAPI_API
+
+// The following ifdef block is the standard way of creating macros which
+// make exporting from a DLL simpler. All files within this DLL are compiled
+// with the TIESRENGINECOREAPI_EXPORTS symbol defined on the command line.
+// This symbol should not be defined on any project that uses this DLL.
+// This way any other project whose source files include this file see
+// TIESRENGINECOREAPI_API functions as being imported from a DLL,
+// whereas this DLL sees symbols defined with this macro as being exported.
+#ifdef TIESRENGINECOREAPI_EXPORTS
+#define TIESRENGINECOREAPI_API __declspec(dllexport)
+#else
+#define TIESRENGINECOREAPI_API __declspec(dllimport)
+#endif
+#endif
+
+#else
+
+#ifndef TIESRENGINECOREAPI_API
+#define TIESRENGINECOREAPI_API
+#endif
+
+#endif
+/*--------------------------------------------------------------------*/
+
+
+#include "tiesr_config.h"
+#include "status.h"
+#include "gmhmm_type.h"
+#include "gmhmm_type_common_user.h"
+
+
+/*
+** TRACE_BEGIN( gv, start ) declares and sets the start time of an event
+** if tracing is enabled, and TRACE_END( gv, name, start ) records the
+** event.  They compile to nothing unless tracing is configured in
+** tiesr_config.h.
+*/
+#ifdef USE_SEARCH_TRACE
+#define TRACE_BEGIN( gv, start ) \
+   unsigned long long start = (gv)->pTrace ? stats_clock() : 0
+#define TRACE_END( gv, name, start ) \
+   do { if( (gv)->pTrace ) TraceTIesrEvent( (gv), (name), (start) ); } while( 0 )
+#else
+#define TRACE_BEGIN( gv, start )
+#define TRACE_END( gv, name, start ) do { } while( 0 )
+#endif
+
+
+/*----------------------------------------------------------------
+ SetTIesrTrace
+
+ Allocate a ring buffer holding the last aNumEvents events, discarding
+ any events already recorded.  A value of zero frees the ring buffer
+ and stops tracing.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType SetTIesrTrace( gmhmm_type *gv,
+							    unsigned int aNumEvents );
+
+
+/*----------------------------------------------------------------
+ TraceTIesrEvent
+
+ Record an event named aName that started at time aStart, as returned
+ by stats_clock, and ends now.  aName must be a string constant, since
+ only the pointer is saved.  Events are recorded by one thread at a
+ time.
+ --------------------------------*/
+TIESRENGINECOREAPI_API void TraceTIesrEvent( gmhmm_type *gv, const char *aName,
+					     unsigned long long aStart );
+
+
+/*----------------------------------------------------------------
+ DumpTIesrTrace
+
+ Write the recorded events to file aFileName in Chrome trace event
+ JSON format.  Recording must not be in progress.
+ --------------------------------*/
+TIESRENGINECOREAPI_API TIesrEngineStatusType DumpTIesrTrace( const gmhmm_type *gv,
+							     const char *aFileName );
+
+#endif
@@ -31,7 +31,8 @@ OBJECTDIR=build/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
-	${OBJECTDIR}/_ext/_DOTDOT/src/TIesrFA_ALSA.o
+	${OBJECTDIR}/_ext/_DOTDOT/src/TIesrFA_ALSA.o \
+	${OBJECTDIR}/_ext/_DOTDOT/src/TIesrFA_source.o
 
 # C Compiler Flags
 CFLAGS=-v
@@ -47,7 +48,7 @@ FFLAGS=
 ASFLAGS=
 
 # Link Libraries and Options
-LDLIBSOPTIONS=-lpthread -lasound
+LDLIBSOPTIONS=-lpthread -lasound -lrt
 
 # Build Targets
 .build-conf: ${BUILD_SUBPROJECTS}
@@ -62,6 +63,11 @@ ${OBJECTDIR}/_ext/_DOTDOT/src/TIesrFA_ALSA.o: nbproject/Makefile-${CND_CONF}.mk
 	${RM} $@.d
 	$(COMPILE.c) -g -Wall -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/TIesrFA_ALSA.o ../src/TIesrFA_ALSA.c
 
+${OBJECTDIR}/_ext/_DOTDOT/src/TIesrFA_source.o: nbproject/Makefile-${CND_CONF}.mk ../src/TIesrFA_source.c 
+	${MKDIR} -p ${OBJECTDIR}/_ext/_DOTDOT/src
+	${RM} $@.d
+	$(COMPILE.c) -g -Wall -fPIC  -MMD -MP -MF $@.d -o ${OBJECTDIR}/_ext/_DOTDOT/src/TIesrFA_source.o ../src/TIesrFA_source.c
+
 # Subprojects
 .build-subprojects:
 
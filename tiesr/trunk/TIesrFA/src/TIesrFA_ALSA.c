@@ -100,17 +100,19 @@ TIesrFA_Error_t TIesrFA_init( TIesrFA_t * const aTIesrFAInstance,
     ALSAData->state = TIesrFA_ALSAStateUninit;
 
 
-    /* File mode input parameter initialization */
-    ALSAData->file_pointer = NULL;
-    ALSAData->frame_data = NULL;
-
-
     /* Buffers and data processing initialization */
     ALSAData->circ_buffer = NULL;
     ALSAData->frame_bytes = NULL;
     ALSAData->read_buffer = NULL;
 
 
+    /* No persistent capture by default */
+    ALSAData->preroll_frames = 0;
+    ALSAData->capturing = FALSE;
+    ALSAData->consuming = FALSE;
+    ALSAData->notify = NULL;
+    ALSAData->notify_arg = NULL;
+
 
     /* initialize the circular and read buffers */
     error = TIesrFA_ALSA_initbuf( aTIesrFAInstance );
@@ -124,20 +126,11 @@ TIesrFA_Error_t TIesrFA_init( TIesrFA_t * const aTIesrFAInstance,
     }
 
 
-    /* check if channel_name is a file name, which indicates that
-       audio data will be read from a file, rather than collected
-       from a live hardware audio channel */
-    ALSAData->file_pointer = fopen( channel_name, "rb" );
-    if( ALSAData->file_pointer == NULL )
-    {
-        ALSAData->file_mode = FALSE;
-    }
-    else
-    {
-        ALSAData->file_mode = TRUE;
-        fclose( ALSAData->file_pointer );
-        ALSAData->file_pointer = NULL;
-    }
+    /* check if channel_name is a file name or names another source,
+       which indicates that audio data will be read from the source,
+       rather than collected from a live hardware audio channel */
+    ALSAData->file_mode = TIesrFA_source_select( &ALSAData->source, channel_name,
+            ALSAData->frame_size );
 
 
     /* Initialization completed successfully */
@@ -225,6 +218,75 @@ TIesrFA_ALSA_Error_t TIesrFA_ALSA_initbuf( TIesrFA_t * const aTIesrFAInstance )
     return TIesrFA_ALSAErrNone;
 }
 
+/*----------------------------------------------------------------
+ TIesrFA_preroll
+
+ Set the number of frames captured prior to TIesrFA_start that will be
+ returned once data collection starts.  A non-zero number keeps the PCM
+ and read thread running from the first TIesrFA_start until the channel
+ is closed.  This has no effect if audio data is from a file.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_preroll( TIesrFA_t * const aTIesrFAInstance,
+        const unsigned int aPrerollFrames )
+{
+    TIesrFA_ALSA_t * const ALSAData = (TIesrFA_ALSA_t * const) aTIesrFAInstance->impl_data;
+
+    if( ALSAData->state != TIesrFA_ALSAStateInit )
+    {
+        return TIesrFAErrState;
+    }
+
+    /* At least one circular buffer frame must remain to receive new data */
+    if( aPrerollFrames >= aTIesrFAInstance->num_circular_buffer_frames )
+    {
+        return TIesrFAErrArg;
+    }
+
+    ALSAData->preroll_frames = aPrerollFrames;
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_notify
+
+ Set the function called when a frame is added to the circular buffer.
+ A source other than an ALSA PCM sets it if it can notify.  With
+ pre-roll the read thread may be running, so the function is changed
+ under the buffer mutex.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_notify( TIesrFA_t * const aTIesrFAInstance,
+        TIesrFA_Notify_t aNotify, void* aArg )
+{
+    TIesrFA_ALSA_t * const ALSAData = (TIesrFA_ALSA_t * const) aTIesrFAInstance->impl_data;
+
+    if( ALSAData->state != TIesrFA_ALSAStateInit &&
+            ALSAData->state != TIesrFA_ALSAStateOpen )
+    {
+        return TIesrFAErrState;
+    }
+
+    if( ALSAData->file_mode )
+    {
+        return TIesrFA_source_notify( &ALSAData->source, aNotify, aArg );
+    }
+
+    if( ALSAData->capturing )
+    {
+        pthread_mutex_lock( &( ALSAData->buffer_mutex ) );
+    }
+
+    ALSAData->notify = aNotify;
+    ALSAData->notify_arg = aArg;
+
+    if( ALSAData->capturing )
+    {
+        pthread_mutex_unlock( &( ALSAData->buffer_mutex ) );
+    }
+
+    return TIesrFAErrNone;
+}
+
 /*----------------------------------------------------------------
  TIesrFA_open
 
@@ -243,24 +305,14 @@ TIesrFA_Error_t TIesrFA_open( TIesrFA_t * const aTIesrFAInstance )
         return TIesrFAErrState;
     }
 
-    /* If audio data is from a file, then open the file */
+    /* If audio data is from a file or other source, then connect to it */
     if( ALSAData->file_mode )
     {
-        ALSAData->file_pointer = fopen( aTIesrFAInstance->channel_name, "rb" );
-        if( ALSAData->file_pointer == NULL )
+        if( TIesrFA_source_open( &ALSAData->source, aTIesrFAInstance->channel_name,
+                aTIesrFAInstance->num_circular_buffer_frames ) != TIesrFAErrNone )
         {
             return TIesrFAErrFail;
         }
-
-        /* Make space to hold the frame of data from the file */
-        ALSAData->frame_data =
-                (unsigned char*) malloc( ALSAData->frame_size * sizeof(unsigned char) );
-
-        if( ALSAData->frame_data == NULL )
-        {
-            fclose( ALSAData->file_pointer );
-            return TIesrFAErrFail;
-        }
     }
 
         /* If audio data from an audio channel, then open the channel */
@@ -434,18 +486,33 @@ TIesrFA_Error_t TIesrFA_start( TIesrFA_t * const aTIesrFAInstance )
         return TIesrFAErrState;
     }
 
-    /* If audio data is from a file, just return if file is opened */
+    /* If audio data is from a file or other source, no thread is needed */
     if( ALSAData->file_mode )
     {
-        if( ALSAData->file_pointer == NULL )
+        if( ALSAData->source.ops->start( &ALSAData->source ) != TIesrFAErrNone )
         {
             return TIesrFAErrFail;
         }
-        else
-        {
-            ALSAData->state = TIesrFA_ALSAStateRunning;
-            return TIesrFAErrNone;
-        }
+
+        ALSAData->state = TIesrFA_ALSAStateRunning;
+        return TIesrFAErrNone;
+    }
+
+
+    /* If the read thread is still capturing since the last stop, the
+     circular buffer already holds the pre-roll frames.  Just start
+     returning frames to the user. */
+    if( ALSAData->capturing )
+    {
+        pthread_mutex_lock( &( ALSAData->buffer_mutex ) );
+
+        ALSAData->buffer_overflow = FALSE;
+        ALSAData->consuming = TRUE;
+
+        pthread_mutex_unlock( &( ALSAData->buffer_mutex ) );
+
+        ALSAData->state = TIesrFA_ALSAStateRunning;
+        return TIesrFAErrNone;
     }
 
 
@@ -463,6 +530,7 @@ TIesrFA_Error_t TIesrFA_start( TIesrFA_t * const aTIesrFAInstance )
     ALSAData->buffer_frames_full = 0;
     ALSAData->read_data = TRUE;
     ALSAData->buffer_overflow = FALSE;
+    ALSAData->consuming = TRUE;
 
     /* Initialize all buffers to holding no bytes of data */
     for( frame = 0; frame < aTIesrFAInstance->num_circular_buffer_frames; frame++ )
@@ -512,6 +580,9 @@ TIesrFA_Error_t TIesrFA_start( TIesrFA_t * const aTIesrFAInstance )
         return TIesrFAErrThread;
     }
 
+    /* With pre-roll the thread runs until the channel is closed */
+    ALSAData->capturing = ( ALSAData->preroll_frames > 0 );
+
     ALSAData->state = TIesrFA_ALSAStateRunning;
 
     return TIesrFAErrNone;
@@ -569,7 +640,6 @@ TIesrFA_Error_t TIesrFA_getframe( TIesrFA_t * const aTIesrFAInstance,
     int waitresult;
     unsigned char* bufFrame;
     int bufferOverflow;
-    unsigned int numBytesRead;
 
     TIesrFA_ALSA_t * const ALSAData = (TIesrFA_ALSA_t * const) aTIesrFAInstance->impl_data;
 
@@ -581,41 +651,13 @@ TIesrFA_Error_t TIesrFA_getframe( TIesrFA_t * const aTIesrFAInstance,
     }
 
 
-    /* If audio is coming from the file, just read the samples.
-     If at the end of the file, just continue to output the last frame,
-     but notify calling function by setting EOF return status. */
+    /* If audio is coming from a file or other source, the source returns
+     the frame. At the end of a file the last frame is output again, but
+     the calling function is notified by the EOF return status. */
     if( ALSAData->file_mode )
     {
-        /* No backlogged frames */
-        *aFramesQueued = 0;
-
-        if( !feof( ALSAData->file_pointer ) )
-        {
-            numBytesRead = fread( aFrame, sizeof(unsigned char),
-                    ALSAData->frame_size,
-                    ALSAData->file_pointer );
-
-            if( numBytesRead == ALSAData->frame_size )
-            {
-                /* Save copy of the latest full frame */
-                memcpy( ALSAData->frame_data, aFrame, ALSAData->frame_size );
-            }
-            else
-            {
-                /* Output the copy of the last full frame */
-                memcpy( aFrame, ALSAData->frame_data, ALSAData->frame_size );
-                return(TIesrFAErrEOF );
-
-            }
-        }
-        else
-        {
-            /* Output a copy of the last full frame if no more data. */
-            memcpy( aFrame, ALSAData->frame_data, ALSAData->frame_size );
-            return(TIesrFAErrEOF );
-        }
-
-        return TIesrFAErrNone;
+        return ALSAData->source.ops->getframe( &ALSAData->source, aFrame,
+                aBlock, aFramesQueued );
     }
 
 
@@ -862,6 +904,17 @@ TIesrFA_ALSA_Error_t TIesrFA_ALSA_fillframes( TIesrFA_t * const aTIesrFAInstance
             /* Another frame is available for processing indicated by the semaphore */
             sem_post( &( ALSAData->buffer_semaphore ) );
 
+            /* If the user is not reading frames, keep only the pre-roll
+             frames.  Otherwise tell the user a frame is available. */
+            if( !ALSAData->consuming )
+            {
+                TIesrFA_ALSA_trimframes( aTIesrFAInstance );
+            }
+            else if( ALSAData->notify != NULL )
+            {
+                ALSAData->notify( ALSAData->notify_arg );
+            }
+
             pthread_mutex_unlock( &( ALSAData->buffer_mutex ) );
 
 
@@ -894,6 +947,33 @@ TIesrFA_ALSA_Error_t TIesrFA_ALSA_fillframes( TIesrFA_t * const aTIesrFAInstance
     return TIesrFA_ALSAErrNone;
 }
 
+/*----------------------------------------------------------------
+ TIesrFA_ALSA_trimframes
+
+ Discard the oldest full circular buffer frames until no more than the
+ number of pre-roll frames remain.  The buffer mutex must be held, and
+ the user must not be reading frames.
+ --------------------------------*/
+void TIesrFA_ALSA_trimframes( TIesrFA_t * const aTIesrFAInstance )
+{
+    TIesrFA_ALSA_t * const ALSAData = (TIesrFA_ALSA_t * const) aTIesrFAInstance->impl_data;
+
+    while( ALSAData->buffer_frames_full > ALSAData->preroll_frames )
+    {
+        /* Consume the semaphore count of the discarded frame */
+        sem_trywait( &( ALSAData->buffer_semaphore ) );
+
+        ALSAData->frame_bytes[ ALSAData->output_buffer_frame ] = 0;
+        ALSAData->buffer_frames_full--;
+
+        ALSAData->output_buffer_frame++;
+        if( ALSAData->output_buffer_frame >= aTIesrFAInstance->num_circular_buffer_frames )
+        {
+            ALSAData->output_buffer_frame = 0;
+        }
+    }
+}
+
 /*----------------------------------------------------------------
  TIesrFA_stop
 
@@ -918,10 +998,29 @@ TIesrFA_Error_t TIesrFA_stop( TIesrFA_t * const aTIesrFAInstance )
     }
 
 
-    /* If audio is coming from a file, just rewind it */
+    /* If audio is coming from a file or other source, just stop the
+     source, which rewinds a file */
     if( ALSAData->file_mode )
     {
-        rewind( ALSAData->file_pointer );
+        ALSAData->source.ops->stop( &ALSAData->source );
+
+        ALSAData->state = TIesrFA_ALSAStateOpen;
+
+        return TIesrFAErrNone;
+    }
+
+
+    /* With pre-roll, leave the thread running and only stop returning
+     frames to the user.  Frames not read are discarded down to the
+     pre-roll frames. */
+    if( ALSAData->capturing )
+    {
+        pthread_mutex_lock( &( ALSAData->buffer_mutex ) );
+
+        ALSAData->consuming = FALSE;
+        TIesrFA_ALSA_trimframes( aTIesrFAInstance );
+
+        pthread_mutex_unlock( &( ALSAData->buffer_mutex ) );
 
         ALSAData->state = TIesrFA_ALSAStateOpen;
 
@@ -984,20 +1083,30 @@ TIesrFA_Error_t TIesrFA_close( TIesrFA_t * const aTIesrFAInstance )
     }
 
 
-    /* If data is coming from a file, close the file, and free frame data memory */
+    /* If data is coming from a file or other source, disconnect from it */
     if( ALSAData->file_mode )
     {
-        fclose( ALSAData->file_pointer );
-        ALSAData->file_pointer = NULL;
-
-        free( ALSAData->frame_data );
-        ALSAData->frame_data = NULL;
+        ALSAData->source.ops->close( &ALSAData->source );
 
         ALSAData->state = TIesrFA_ALSAStateInit;
         return TIesrFAErrNone;
     }
 
 
+    /* Shut down a read thread left capturing by TIesrFA_stop */
+    if( ALSAData->capturing )
+    {
+        void *status;
+
+        ALSAData->read_data = FALSE;
+        pthread_join( ALSAData->thread_id, &status );
+
+        TIesrFA_ALSA_resetsync( ALSAData );
+
+        ALSAData->capturing = FALSE;
+    }
+
+
     /* Close the audio channel here, and check for failure */
     rtnStatus = snd_pcm_close( ALSAData->alsa_handle );
     if( rtnStatus < 0 )
@@ -1043,17 +1152,6 @@ TIesrFA_Error_t TIesrFA_destroy( TIesrFA_t * const aTIesrFAInstance )
     }
 
 
-    /* Close file if open.  Should not happen */
-    if( ALSAData->file_mode )
-    {
-        if( ALSAData->file_pointer != NULL )
-        {
-            fclose( ALSAData->file_pointer );
-            ALSAData->file_pointer = NULL;
-        }
-    }
-
-
     /* Free all allocated memory */
     if( ALSAData->circ_buffer != NULL )
     {
@@ -35,6 +35,9 @@
 /* The ALSA library API */
 #include <alsa/asoundlib.h>
 
+/* Frame sources other than ALSA */
+#include "TIesrFA_source.h"
+
 /* Constants that are part of the API */
 #define THREAD_PRIORITY 20
 
@@ -72,11 +75,11 @@ extern "C"
         /* State of the channel */
         TIesrFA_ALSA_State_t state;
 
-        /* File-mode control.Boolean flag indicating if audio channel is a file,
-         file pointer, and buffer pointer to hold file data when read */
+        /* Source control. Boolean flag indicating if audio channel is a
+         file, in-memory, shared memory, pipe or socket source rather than
+         an ALSA PCM, and the source state */
         int file_mode;
-        FILE *file_pointer;
-        unsigned char* frame_data;
+        TIesrFA_Source_t source;
 
 
         /* The ALSA PCM channel */
@@ -108,6 +111,19 @@ extern "C"
         int read_data;
         int buffer_overflow;
 
+        /* Persistent capture.  Number of pre-roll frames kept while the
+         user is not reading frames, flag indicating the read thread is
+         running between recognitions, and flag indicating the user is
+         reading frames. */
+        unsigned int preroll_frames;
+        int capturing;
+        int consuming;
+
+        /* Function called when a frame is added to the circular buffer
+         while the user is reading frames, and its argument */
+        TIesrFA_Notify_t notify;
+        void* notify_arg;
+
     } TIesrFA_ALSA_t;
 
 
@@ -123,6 +139,8 @@ extern "C"
 
     static TIesrFA_ALSA_Error_t TIesrFA_ALSA_resetsync( TIesrFA_ALSA_t * const aFILEData );
 
+    static void TIesrFA_ALSA_trimframes( TIesrFA_t * const aTIesrInstance );
+
     /* The thread function for loading frames of audio */
     static void* TIesrFA_ALSA_thread( void* aArg );
 
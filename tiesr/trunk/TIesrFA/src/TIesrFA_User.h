@@ -191,6 +191,69 @@ typedef struct TIesrFA_Struct
 } TIesrFA_t;
 
 
+/*---------------------------------------------------------------------------
+ Frame sources.  Implementations may accept channel names that select a
+ source other than an audio device.  The Linux implementation accepts:
+
+ "mem:<name>"  A ring created in the same process by TIesrFA_memring_create.
+ "shm:<name>"  A POSIX shared memory object holding a TIesrFA_ShmRing_t.
+ "pipe:<path>" A named pipe carrying raw samples.
+ "unix:<path>" A Unix stream socket carrying raw samples.
+ "<path>"      An existing file of raw samples, mapped into memory.
+
+ A shared memory ring is written by a single producer process.  The
+ shared memory object holds the TIesrFA_ShmRing_t header followed by
+ num_frames frames of frame_bytes bytes each, and is mapped read-write
+ by the reader.  Frame number n is stored at frame index n % num_frames.
+ The producer initializes frame_semaphore with sem_init( sem, 1, 0 )
+ before setting magic.  It writes a frame completely, and only then
+ increments write_count, with a memory barrier between the two.  After
+ another memory barrier, it posts frame_semaphore if waiting is
+ non-zero.  The producer sets closed to a non-zero value when it will
+ write no more frames, and then posts frame_semaphore in the same way.
+ A reader waiting for a frame sets waiting, and after a memory barrier
+ checks write_count again before waiting on frame_semaphore, so no
+ system call is made while frames are available.  The reader starts
+ with the frame written after TIesrFA_start, and reports
+ TIesrFAErrOverflow if the producer overwrote frames that it had not
+ read yet.
+ ---------------------------------------------------------------------------*/
+#if !defined( WIN32 ) && !defined( WINCE )
+
+#include <semaphore.h>
+
+#define TIESRFA_SHM_MAGIC 0x54465352
+
+typedef struct TIesrFA_ShmRing_Struct
+{
+      /* Set to TIESRFA_SHM_MAGIC by the producer once the header is valid */
+      unsigned int magic;
+
+      /* Bytes in a frame, which must match the TIesrFA frame size */
+      unsigned int frame_bytes;
+
+      /* Number of frames in the ring */
+      unsigned int num_frames;
+
+      /* Number of frames written, modulo 2^32 */
+      volatile unsigned int write_count;
+
+      /* Set when the producer will write no more frames */
+      volatile unsigned int closed;
+
+      /* Set by the reader while it may wait on frame_semaphore */
+      volatile unsigned int waiting;
+
+      unsigned int reserved[2];
+
+      /* Process-shared semaphore waking a waiting reader */
+      sem_t frame_semaphore;
+
+} TIesrFA_ShmRing_t;
+
+#endif
+
+
 /*-------------------------------------------------------------------
  TIesrFA_init initializes the TIesrFA_t object for an instance of a
  TIesrFA audio channel.  It must be called prior to using the
@@ -218,6 +281,45 @@ TIesrFA_Error_t TIesrFA_init( TIesrFA_t* const  aTIesrFAInstance,
 			      const int priority );
 
 
+/*--------------------------------------------------------------------
+ TIesrFA_preroll selects persistent capture for a channel.  It may only
+ be called after TIesrFA_init and before TIesrFA_open.  If
+ aPrerollFrames is zero, which is the default, data collection runs
+ only between TIesrFA_start and TIesrFA_stop.  Otherwise, once data
+ collection is started it continues after TIesrFA_stop until the
+ channel is closed, keeping the latest aPrerollFrames frames in the
+ circular buffer.  A following TIesrFA_start does not restart the
+ audio device, and the first frames returned by TIesrFA_getframe are
+ the frames captured up to aPrerollFrames frames before the start.
+ aPrerollFrames must be less than the number of circular buffer
+ frames.  Implementations that do not support persistent capture
+ return TIesrFAErrFail for a non-zero aPrerollFrames.
+ ---------------------------------------------------------------------*/
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_preroll( TIesrFA_t* const aTIesrFAInstance,
+				 const unsigned int aPrerollFrames );
+
+
+/*--------------------------------------------------------------------
+ TIesrFA_notify sets a function that is called with aArg whenever a
+ frame becomes available to TIesrFA_getframe, so that a user reading
+ frames without blocking from several channels can wait until one of
+ them has a frame.  It may be called after TIesrFA_init while data
+ collection is not started, and a NULL aNotify removes the function.
+ The function is called from the thread that captures or writes the
+ frames while the channel holds a lock, so it must return quickly and
+ must not call TIesrFA functions.  Implementations and sources that
+ can not tell when a frame arrives return TIesrFAErrFail, and the user
+ must poll them.  A source that always has frames available, such as a
+ file, accepts the function but never calls it.
+ ---------------------------------------------------------------------*/
+typedef void (*TIesrFA_Notify_t)( void* aArg );
+
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_notify( TIesrFA_t* const aTIesrFAInstance,
+				TIesrFA_Notify_t aNotify, void* aArg );
+
+
 /*--------------------------------------------------------------------
  TIesrFA_open opens an audio channel.  Opening an audio channel does
  not start collection of audio data.  It establishes a connection
@@ -300,6 +402,45 @@ TIesrFA_Error_t TIesrFA_destroy( TIesrFA_t* const aTIesrFAInstance );
 TIESRFA_API
 unsigned int TIesrFA_status( TIesrFA_t* const aTIesrFAInstance );
 
+
+#if !defined( WIN32 ) && !defined( WINCE )
+/*-----------------------------------------------------------------------
+ In-memory frame rings.  An application that produces frames in the
+ same process, for example audio received from the network, creates a
+ ring named aName holding aNumFrames frames of aFrameBytes bytes with
+ TIesrFA_memring_create.  A channel named "mem:<name>" then reads from
+ the ring, as from a shared memory ring.  Only one channel may be open
+ on a ring at a time.
+
+ TIesrFA_memring_write adds a frame to the ring from a single producer
+ thread.  It never blocks, and if the ring is full overwrites the
+ oldest frame, which the reader reports as TIesrFAErrOverflow.  It
+ makes no system call itself unless the reader is blocked waiting for a
+ frame.  A function set for the channel by TIesrFA_notify is called
+ after each frame is written and when the ring is closed.
+ TIesrFA_memring_close marks the end of the frames, after which a
+ reader that has read all frames receives TIesrFAErrEOF.  A ring may be
+ destroyed once no channel is open on it.
+ -----------------------------------------------------------------------*/
+typedef struct TIesrFA_MemRing_Struct* TIesrFA_MemRing_t;
+
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_memring_create( TIesrFA_MemRing_t* aRing,
+					const char* aName,
+					const unsigned int aFrameBytes,
+					const unsigned int aNumFrames );
+
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_memring_write( TIesrFA_MemRing_t aRing,
+				       const unsigned char* const aFrame );
+
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_memring_close( TIesrFA_MemRing_t aRing );
+
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_memring_destroy( TIesrFA_MemRing_t aRing );
+#endif
+
 #if defined( __cplusplus )
 }
 #endif
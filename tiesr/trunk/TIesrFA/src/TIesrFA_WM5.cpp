@@ -328,6 +328,36 @@ TIesrFAWM5_Error_t TIesrFAWM5_destroybuf(TIesrFAWM5_t * const aWM5Data) {
     return TIesrFAWM5ErrNone;
 }
 
+/*----------------------------------------------------------------
+TIesrFA_preroll
+
+Persistent capture is not supported by the WM5 implementation, so
+only the default of no pre-roll frames is accepted.
+----------------------------------------------------------------*/
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_preroll(TIesrFA_t * const aTIesrFAInstance,
+        const unsigned int aPrerollFrames) {
+    TIesrFAWM5_t * const WM5Data = (TIesrFAWM5_t * const) aTIesrFAInstance->impl_data;
+
+    if (WM5Data->state != TIesrFAWM5StateInit) {
+        return TIesrFAErrState;
+    }
+
+    return (aPrerollFrames == 0) ? TIesrFAErrNone : TIesrFAErrFail;
+}
+
+/*----------------------------------------------------------------
+TIesrFA_notify
+
+The WM5 implementation can not notify the user of new frames, so only
+removing the function is accepted.
+----------------------------------------------------------------*/
+TIESRFA_API
+TIesrFA_Error_t TIesrFA_notify(TIesrFA_t * const aTIesrFAInstance,
+        TIesrFA_Notify_t aNotify, void* aArg) {
+    return (aNotify == NULL) ? TIesrFAErrNone : TIesrFAErrFail;
+}
+
 /*----------------------------------------------------------------
 TIesrFA_open
 
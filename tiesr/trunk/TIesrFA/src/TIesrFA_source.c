@@ -0,0 +1,931 @@
+/*=======================================================================
+
+ *
+ * TIesrFA_source.c
+ *
+ * Frame sources of the Linux TIesrFA implementation.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This file contains the sources of frames that TIesrFA_ALSA.c uses in
+ place of an ALSA PCM.  These are a file mapped into memory, a ring in
+ memory of the same process, a POSIX shared memory ring, and a named
+ pipe or Unix socket.
+
+======================================================================*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "TIesrFA_source.h"
+
+#define FALSE 0
+#define TRUE 1
+
+
+/* File source */
+static TIesrFA_Error_t TIesrFA_file_open( TIesrFA_Source_t* aSource, const char* aName );
+static TIesrFA_Error_t TIesrFA_file_start( TIesrFA_Source_t* aSource );
+static TIesrFA_Error_t TIesrFA_file_getframe( TIesrFA_Source_t* aSource,
+        unsigned char* const aFrame, const int aBlock, unsigned int* aFramesQueued );
+static void TIesrFA_file_stop( TIesrFA_Source_t* aSource );
+static void TIesrFA_map_close( TIesrFA_Source_t* aSource );
+static TIesrFA_Error_t TIesrFA_file_notify( TIesrFA_Source_t* aSource,
+        TIesrFA_Notify_t aNotify, void* aArg );
+
+/* In-memory ring source */
+static TIesrFA_Error_t TIesrFA_mem_open( TIesrFA_Source_t* aSource, const char* aName );
+static void TIesrFA_mem_close( TIesrFA_Source_t* aSource );
+static TIesrFA_Error_t TIesrFA_mem_notify( TIesrFA_Source_t* aSource,
+        TIesrFA_Notify_t aNotify, void* aArg );
+
+/* Shared memory ring source */
+static TIesrFA_Error_t TIesrFA_shm_open( TIesrFA_Source_t* aSource, const char* aName );
+static TIesrFA_Error_t TIesrFA_shm_start( TIesrFA_Source_t* aSource );
+static TIesrFA_Error_t TIesrFA_shm_getframe( TIesrFA_Source_t* aSource,
+        unsigned char* const aFrame, const int aBlock, unsigned int* aFramesQueued );
+static void TIesrFA_ring_post( TIesrFA_ShmRing_t* aRing );
+
+/* Pipe and socket sources */
+static TIesrFA_Error_t TIesrFA_pipe_open( TIesrFA_Source_t* aSource, const char* aName );
+static TIesrFA_Error_t TIesrFA_unix_open( TIesrFA_Source_t* aSource, const char* aName );
+static TIesrFA_Error_t TIesrFA_stream_getframe( TIesrFA_Source_t* aSource,
+        unsigned char* const aFrame, const int aBlock, unsigned int* aFramesQueued );
+static void TIesrFA_stream_close( TIesrFA_Source_t* aSource );
+
+static TIesrFA_Error_t TIesrFA_source_none( TIesrFA_Source_t* aSource );
+static void TIesrFA_source_nostop( TIesrFA_Source_t* aSource );
+static TIesrFA_Error_t TIesrFA_source_nonotify( TIesrFA_Source_t* aSource,
+        TIesrFA_Notify_t aNotify, void* aArg );
+
+
+/* The sources, selected by channel name prefix. The file source must be last. */
+static const TIesrFA_SourceOps_t TIesrFA_sources[] =
+{
+    { "mem:", TIesrFA_mem_open, TIesrFA_shm_start, TIesrFA_shm_getframe,
+      TIesrFA_source_nostop, TIesrFA_mem_close, TIesrFA_mem_notify },
+    { "shm:", TIesrFA_shm_open, TIesrFA_shm_start, TIesrFA_shm_getframe,
+      TIesrFA_source_nostop, TIesrFA_map_close, TIesrFA_source_nonotify },
+    { "pipe:", TIesrFA_pipe_open, TIesrFA_source_none, TIesrFA_stream_getframe,
+      TIesrFA_source_nostop, TIesrFA_stream_close, TIesrFA_source_nonotify },
+    { "unix:", TIesrFA_unix_open, TIesrFA_source_none, TIesrFA_stream_getframe,
+      TIesrFA_source_nostop, TIesrFA_stream_close, TIesrFA_source_nonotify },
+    { NULL, TIesrFA_file_open, TIesrFA_file_start, TIesrFA_file_getframe,
+      TIesrFA_file_stop, TIesrFA_map_close, TIesrFA_file_notify }
+};
+
+#define NUM_SOURCES ( sizeof(TIesrFA_sources)/sizeof(TIesrFA_sources[0]) )
+
+
+/* An in-memory ring, holding a TIesrFA_ShmRing_t header followed by the
+ frames, in the list of rings of the process */
+struct TIesrFA_MemRing_Struct
+{
+    char* name;
+    TIesrFA_ShmRing_t* ring;
+    size_t ring_size;
+
+    /* Source of the channel open on the ring, or NULL */
+    TIesrFA_Source_t* reader;
+
+    /* Mutex protecting the function called when a frame is written, set
+     from the source of the channel */
+    pthread_mutex_t notify_mutex;
+    TIesrFA_Notify_t notify;
+    void* notify_arg;
+
+    struct TIesrFA_MemRing_Struct* next;
+};
+
+/* The in-memory rings of the process, and the mutex protecting the list
+ and the reader of each ring */
+static struct TIesrFA_MemRing_Struct* TIesrFA_memrings = NULL;
+static pthread_mutex_t TIesrFA_memring_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*----------------------------------------------------------------
+ TIesrFA_source_select
+
+ Determine the source from the channel name.  A name without a source
+ prefix is a file if a file of that name can be opened.
+ ----------------------------------------------------------------*/
+int TIesrFA_source_select( TIesrFA_Source_t* aSource, const char* aChannelName,
+        unsigned int aFrameSize )
+{
+    unsigned int source;
+    FILE* fp;
+
+    aSource->ops = NULL;
+    aSource->frame_size = aFrameSize;
+    aSource->fd = -1;
+    aSource->map = NULL;
+    aSource->map_size = 0;
+    aSource->offset = 0;
+    aSource->read_count = 0;
+    aSource->mem_ring = NULL;
+    aSource->notify = NULL;
+    aSource->notify_arg = NULL;
+    aSource->stage = NULL;
+    aSource->stage_size = 0;
+    aSource->stage_start = 0;
+    aSource->stage_end = 0;
+
+    for( source = 0; source < NUM_SOURCES - 1; source++ )
+    {
+        const char* prefix = TIesrFA_sources[source].prefix;
+
+        if( strncmp( aChannelName, prefix, strlen( prefix ) ) == 0 )
+        {
+            aSource->ops = &TIesrFA_sources[source];
+            return TRUE;
+        }
+    }
+
+    fp = fopen( aChannelName, "rb" );
+    if( fp == NULL )
+    {
+        return FALSE;
+    }
+    fclose( fp );
+
+    aSource->ops = &TIesrFA_sources[NUM_SOURCES - 1];
+    return TRUE;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_source_open
+
+ Connect to the selected source, and allocate the buffer used by a
+ pipe or socket source.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_source_open( TIesrFA_Source_t* aSource,
+        const char* aChannelName, unsigned int aBufferFrames )
+{
+    const char* name = aChannelName;
+
+    if( aSource->ops->prefix != NULL )
+    {
+        name += strlen( aSource->ops->prefix );
+    }
+
+    aSource->stage_size = aBufferFrames * aSource->frame_size;
+    aSource->stage_start = 0;
+    aSource->stage_end = 0;
+
+    return aSource->ops->open( aSource, name );
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_source_notify
+
+ Set the function called when the source has a frame available, if the
+ source can tell.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_source_notify( TIesrFA_Source_t* aSource,
+        TIesrFA_Notify_t aNotify, void* aArg )
+{
+    return aSource->ops->notify( aSource, aNotify, aArg );
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_source_none, TIesrFA_source_nostop, TIesrFA_source_nonotify
+
+ Start and stop for sources that are not affected by them, and notify
+ for sources that can not tell when a frame arrives.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_source_none( TIesrFA_Source_t* aSource )
+{
+    return TIesrFAErrNone;
+}
+
+void TIesrFA_source_nostop( TIesrFA_Source_t* aSource )
+{
+}
+
+TIesrFA_Error_t TIesrFA_source_nonotify( TIesrFA_Source_t* aSource,
+        TIesrFA_Notify_t aNotify, void* aArg )
+{
+    return ( aNotify == NULL ) ? TIesrFAErrNone : TIesrFAErrFail;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_file_open
+
+ Map the whole file into memory.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_file_open( TIesrFA_Source_t* aSource, const char* aName )
+{
+    struct stat fileStat;
+
+    aSource->fd = open( aName, O_RDONLY );
+    if( aSource->fd < 0 )
+    {
+        return TIesrFAErrFail;
+    }
+
+    if( fstat( aSource->fd, &fileStat ) != 0 )
+    {
+        close( aSource->fd );
+        aSource->fd = -1;
+        return TIesrFAErrFail;
+    }
+
+    aSource->map_size = fileStat.st_size;
+    aSource->map = NULL;
+    aSource->offset = 0;
+
+    /* An empty file can not be mapped, but is a valid source of no frames */
+    if( aSource->map_size > 0 )
+    {
+        void* map = mmap( NULL, aSource->map_size, PROT_READ, MAP_PRIVATE,
+                aSource->fd, 0 );
+        if( map == MAP_FAILED )
+        {
+            close( aSource->fd );
+            aSource->fd = -1;
+            return TIesrFAErrFail;
+        }
+
+        aSource->map = (unsigned char*) map;
+        madvise( map, aSource->map_size, MADV_SEQUENTIAL );
+    }
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_file_start
+
+ A file is read from the beginning each time it is started.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_file_start( TIesrFA_Source_t* aSource )
+{
+    aSource->offset = 0;
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_file_getframe
+
+ Copy the next frame from the mapped file.  At the end of the file the
+ last full frame is returned again with an EOF status.  A file is not
+ real-time data, so no frames are reported as queued.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_file_getframe( TIesrFA_Source_t* aSource,
+        unsigned char* const aFrame, const int aBlock, unsigned int* aFramesQueued )
+{
+    *aFramesQueued = 0;
+
+    if( aSource->offset + aSource->frame_size <= aSource->map_size )
+    {
+        memcpy( aFrame, aSource->map + aSource->offset, aSource->frame_size );
+        aSource->offset += aSource->frame_size;
+        return TIesrFAErrNone;
+    }
+
+    if( aSource->offset >= aSource->frame_size )
+    {
+        memcpy( aFrame, aSource->map + aSource->offset - aSource->frame_size,
+                aSource->frame_size );
+    }
+
+    return TIesrFAErrEOF;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_file_notify
+
+ A file always has a frame available, so the function is never called.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_file_notify( TIesrFA_Source_t* aSource,
+        TIesrFA_Notify_t aNotify, void* aArg )
+{
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_file_stop
+
+ Rewind the file.
+ ----------------------------------------------------------------*/
+void TIesrFA_file_stop( TIesrFA_Source_t* aSource )
+{
+    aSource->offset = 0;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_map_close
+
+ Unmap a file or shared memory object and close it.
+ ----------------------------------------------------------------*/
+void TIesrFA_map_close( TIesrFA_Source_t* aSource )
+{
+    if( aSource->map != NULL )
+    {
+        munmap( aSource->map, aSource->map_size );
+        aSource->map = NULL;
+    }
+
+    if( aSource->fd >= 0 )
+    {
+        close( aSource->fd );
+        aSource->fd = -1;
+    }
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_shm_open
+
+ Map the shared memory ring, and check that it holds frames of the
+ size requested.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_shm_open( TIesrFA_Source_t* aSource, const char* aName )
+{
+    struct stat shmStat;
+    void* map;
+    TIesrFA_ShmRing_t* ring;
+
+    aSource->fd = shm_open( aName, O_RDWR, 0 );
+    if( aSource->fd < 0 )
+    {
+        return TIesrFAErrFail;
+    }
+
+    if( fstat( aSource->fd, &shmStat ) != 0 ||
+            shmStat.st_size < (off_t) sizeof(TIesrFA_ShmRing_t) )
+    {
+        close( aSource->fd );
+        aSource->fd = -1;
+        return TIesrFAErrFail;
+    }
+
+    /* The reader sets the waiting flag and waits on the semaphore of the
+     ring, so maps it writable */
+    map = mmap( NULL, shmStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            aSource->fd, 0 );
+    if( map == MAP_FAILED )
+    {
+        close( aSource->fd );
+        aSource->fd = -1;
+        return TIesrFAErrFail;
+    }
+
+    aSource->map = (unsigned char*) map;
+    aSource->map_size = shmStat.st_size;
+
+    ring = (TIesrFA_ShmRing_t*) map;
+    if( ring->magic != TIESRFA_SHM_MAGIC ||
+            ring->frame_bytes != aSource->frame_size ||
+            ring->num_frames == 0 ||
+            aSource->map_size < sizeof(TIesrFA_ShmRing_t) +
+            (size_t) ring->num_frames * ring->frame_bytes )
+    {
+        TIesrFA_map_close( aSource );
+        return TIesrFAErrFail;
+    }
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_shm_start
+
+ Start reading with the next frame the producer writes.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_shm_start( TIesrFA_Source_t* aSource )
+{
+    TIesrFA_ShmRing_t* ring = (TIesrFA_ShmRing_t*) aSource->map;
+
+    aSource->read_count = ring->write_count;
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_shm_getframe
+
+ Copy the next frame from a shared memory or in-memory ring.  The frame
+ is checked after the copy to ensure the producer did not overwrite it
+ meanwhile.  A blocking request that finds the ring empty sets the
+ waiting flag, checks the ring again, and waits on the ring semaphore
+ that the producer posts when it sees the flag.  The semaphore may have
+ been posted for a frame already read, so the ring is checked again
+ after each wait.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_shm_getframe( TIesrFA_Source_t* aSource,
+        unsigned char* const aFrame, const int aBlock, unsigned int* aFramesQueued )
+{
+    TIesrFA_ShmRing_t* ring = (TIesrFA_ShmRing_t*) aSource->map;
+    const unsigned char* frames = aSource->map + sizeof(TIesrFA_ShmRing_t);
+    int overflow = FALSE;
+    unsigned int available;
+
+    while( TRUE )
+    {
+        available = ring->write_count - aSource->read_count;
+
+        if( available == 0 )
+        {
+            if( ring->closed )
+            {
+                *aFramesQueued = 0;
+                return TIesrFAErrEOF;
+            }
+
+            if( !aBlock )
+            {
+                *aFramesQueued = 0;
+                return TIesrFAErrNoFrame;
+            }
+
+            ring->waiting = TRUE;
+            __sync_synchronize( );
+            if( ring->write_count == aSource->read_count && !ring->closed )
+            {
+                while( sem_wait( &ring->frame_semaphore ) != 0 && errno == EINTR )
+                {
+                }
+            }
+            ring->waiting = FALSE;
+            continue;
+        }
+
+        /* The producer has overwritten frames not read yet.  Skip to the
+         oldest frame that can not be overwritten during the copy. */
+        if( available >= ring->num_frames )
+        {
+            aSource->read_count = ring->write_count - ring->num_frames + 1;
+            overflow = TRUE;
+            continue;
+        }
+
+        /* Read the write count before the frame data */
+        __sync_synchronize( );
+
+        memcpy( aFrame, frames +
+                (size_t) ( aSource->read_count % ring->num_frames ) * aSource->frame_size,
+                aSource->frame_size );
+
+        /* Check the frame was not overwritten during the copy */
+        __sync_synchronize( );
+        available = ring->write_count - aSource->read_count;
+        if( available >= ring->num_frames )
+        {
+            overflow = TRUE;
+            continue;
+        }
+
+        aSource->read_count++;
+        *aFramesQueued = available - 1;
+
+        return overflow ? TIesrFAErrOverflow : TIesrFAErrNone;
+    }
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_ring_post
+
+ Wake the reader of an in-memory ring if it is waiting, after the
+ producer has updated write_count or closed.
+ ----------------------------------------------------------------*/
+void TIesrFA_ring_post( TIesrFA_ShmRing_t* aRing )
+{
+    __sync_synchronize( );
+    if( aRing->waiting )
+    {
+        sem_post( &aRing->frame_semaphore );
+    }
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_mem_open
+
+ Find the in-memory ring of the name, and read from it if no other
+ channel is.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_mem_open( TIesrFA_Source_t* aSource, const char* aName )
+{
+    struct TIesrFA_MemRing_Struct* memRing;
+    TIesrFA_Error_t error = TIesrFAErrFail;
+
+    pthread_mutex_lock( &TIesrFA_memring_mutex );
+
+    for( memRing = TIesrFA_memrings; memRing != NULL; memRing = memRing->next )
+    {
+        if( strcmp( memRing->name, aName ) == 0 )
+        {
+            break;
+        }
+    }
+
+    if( memRing != NULL && memRing->reader == NULL &&
+            memRing->ring->frame_bytes == aSource->frame_size )
+    {
+        memRing->reader = aSource;
+        aSource->mem_ring = memRing;
+        aSource->map = (unsigned char*) memRing->ring;
+        aSource->map_size = memRing->ring_size;
+
+        pthread_mutex_lock( &memRing->notify_mutex );
+        memRing->notify = aSource->notify;
+        memRing->notify_arg = aSource->notify_arg;
+        pthread_mutex_unlock( &memRing->notify_mutex );
+
+        error = TIesrFAErrNone;
+    }
+
+    pthread_mutex_unlock( &TIesrFA_memring_mutex );
+
+    return error;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_mem_close
+
+ Stop reading from an in-memory ring, so it may be destroyed.
+ ----------------------------------------------------------------*/
+void TIesrFA_mem_close( TIesrFA_Source_t* aSource )
+{
+    if( aSource->mem_ring == NULL )
+    {
+        return;
+    }
+
+    pthread_mutex_lock( &aSource->mem_ring->notify_mutex );
+    aSource->mem_ring->notify = NULL;
+    pthread_mutex_unlock( &aSource->mem_ring->notify_mutex );
+
+    pthread_mutex_lock( &TIesrFA_memring_mutex );
+    aSource->mem_ring->reader = NULL;
+    pthread_mutex_unlock( &TIesrFA_memring_mutex );
+
+    aSource->mem_ring = NULL;
+    aSource->map = NULL;
+    aSource->map_size = 0;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_mem_notify
+
+ Set the function the producer calls after writing a frame.  It is
+ passed to the ring when the channel is opened.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_mem_notify( TIesrFA_Source_t* aSource,
+        TIesrFA_Notify_t aNotify, void* aArg )
+{
+    aSource->notify = aNotify;
+    aSource->notify_arg = aArg;
+
+    if( aSource->mem_ring != NULL )
+    {
+        pthread_mutex_lock( &aSource->mem_ring->notify_mutex );
+        aSource->mem_ring->notify = aNotify;
+        aSource->mem_ring->notify_arg = aArg;
+        pthread_mutex_unlock( &aSource->mem_ring->notify_mutex );
+    }
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_memring_create
+
+ Allocate an in-memory ring and add it to the rings of the process.
+ The name must not be that of another ring.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_memring_create( TIesrFA_MemRing_t* aRing,
+        const char* aName, const unsigned int aFrameBytes,
+        const unsigned int aNumFrames )
+{
+    struct TIesrFA_MemRing_Struct* memRing;
+    struct TIesrFA_MemRing_Struct* other;
+
+    if( aRing == NULL || aName == NULL || aFrameBytes == 0 || aNumFrames == 0 )
+    {
+        return TIesrFAErrArg;
+    }
+
+    memRing = (struct TIesrFA_MemRing_Struct*) malloc( sizeof(struct TIesrFA_MemRing_Struct) );
+    if( memRing == NULL )
+    {
+        return TIesrFAErrFail;
+    }
+
+    memRing->ring_size = sizeof(TIesrFA_ShmRing_t) + (size_t) aNumFrames * aFrameBytes;
+    memRing->name = (char*) malloc( strlen( aName ) + 1 );
+    memRing->ring = (TIesrFA_ShmRing_t*) calloc( 1, memRing->ring_size );
+    if( memRing->name == NULL || memRing->ring == NULL ||
+            sem_init( &memRing->ring->frame_semaphore, 0, 0 ) != 0 )
+    {
+        free( memRing->name );
+        free( memRing->ring );
+        free( memRing );
+        return TIesrFAErrFail;
+    }
+
+    if( pthread_mutex_init( &memRing->notify_mutex, NULL ) != 0 )
+    {
+        sem_destroy( &memRing->ring->frame_semaphore );
+        free( memRing->name );
+        free( memRing->ring );
+        free( memRing );
+        return TIesrFAErrFail;
+    }
+
+    strcpy( memRing->name, aName );
+    memRing->ring->frame_bytes = aFrameBytes;
+    memRing->ring->num_frames = aNumFrames;
+    memRing->ring->magic = TIESRFA_SHM_MAGIC;
+    memRing->reader = NULL;
+    memRing->notify = NULL;
+    memRing->notify_arg = NULL;
+
+    pthread_mutex_lock( &TIesrFA_memring_mutex );
+
+    for( other = TIesrFA_memrings; other != NULL; other = other->next )
+    {
+        if( strcmp( other->name, aName ) == 0 )
+        {
+            break;
+        }
+    }
+
+    if( other == NULL )
+    {
+        memRing->next = TIesrFA_memrings;
+        TIesrFA_memrings = memRing;
+    }
+
+    pthread_mutex_unlock( &TIesrFA_memring_mutex );
+
+    if( other != NULL )
+    {
+        pthread_mutex_destroy( &memRing->notify_mutex );
+        sem_destroy( &memRing->ring->frame_semaphore );
+        free( memRing->name );
+        free( memRing->ring );
+        free( memRing );
+        return TIesrFAErrArg;
+    }
+
+    *aRing = memRing;
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_memring_write
+
+ Copy a frame into the ring, overwriting the oldest frame if the ring is
+ full, and wake the reader if it is waiting.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_memring_write( TIesrFA_MemRing_t aRing,
+        const unsigned char* const aFrame )
+{
+    TIesrFA_ShmRing_t* ring = aRing->ring;
+    unsigned char* frames = (unsigned char*) ( ring + 1 );
+
+    if( ring->closed )
+    {
+        return TIesrFAErrState;
+    }
+
+    memcpy( frames + (size_t) ( ring->write_count % ring->num_frames ) * ring->frame_bytes,
+            aFrame, ring->frame_bytes );
+
+    __sync_synchronize( );
+    ring->write_count++;
+
+    TIesrFA_ring_post( ring );
+
+    pthread_mutex_lock( &aRing->notify_mutex );
+    if( aRing->notify != NULL )
+    {
+        aRing->notify( aRing->notify_arg );
+    }
+    pthread_mutex_unlock( &aRing->notify_mutex );
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_memring_close
+
+ Mark the end of the frames of the ring.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_memring_close( TIesrFA_MemRing_t aRing )
+{
+    aRing->ring->closed = TRUE;
+
+    TIesrFA_ring_post( aRing->ring );
+
+    pthread_mutex_lock( &aRing->notify_mutex );
+    if( aRing->notify != NULL )
+    {
+        aRing->notify( aRing->notify_arg );
+    }
+    pthread_mutex_unlock( &aRing->notify_mutex );
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_memring_destroy
+
+ Remove the ring from the rings of the process and free it.  A ring
+ can not be destroyed while a channel is open on it.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_memring_destroy( TIesrFA_MemRing_t aRing )
+{
+    struct TIesrFA_MemRing_Struct** link;
+
+    pthread_mutex_lock( &TIesrFA_memring_mutex );
+
+    if( aRing->reader != NULL )
+    {
+        pthread_mutex_unlock( &TIesrFA_memring_mutex );
+        return TIesrFAErrState;
+    }
+
+    for( link = &TIesrFA_memrings; *link != NULL; link = &( *link )->next )
+    {
+        if( *link == aRing )
+        {
+            *link = aRing->next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &TIesrFA_memring_mutex );
+
+    pthread_mutex_destroy( &aRing->notify_mutex );
+    sem_destroy( &aRing->ring->frame_semaphore );
+    free( aRing->name );
+    free( aRing->ring );
+    free( aRing );
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_pipe_open
+
+ Open a named pipe for reading.  The open waits for a writer.  Reads are
+ then non-blocking, so that a non-blocking frame request can return.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_pipe_open( TIesrFA_Source_t* aSource, const char* aName )
+{
+    aSource->fd = open( aName, O_RDONLY );
+    if( aSource->fd < 0 )
+    {
+        return TIesrFAErrFail;
+    }
+
+    aSource->stage = (unsigned char*) malloc( aSource->stage_size );
+    if( aSource->stage == NULL ||
+            fcntl( aSource->fd, F_SETFL, O_NONBLOCK ) != 0 )
+    {
+        TIesrFA_stream_close( aSource );
+        return TIesrFAErrFail;
+    }
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_unix_open
+
+ Connect to a Unix stream socket.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_unix_open( TIesrFA_Source_t* aSource, const char* aName )
+{
+    struct sockaddr_un address;
+
+    if( strlen( aName ) >= sizeof(address.sun_path) )
+    {
+        return TIesrFAErrArg;
+    }
+
+    memset( &address, 0, sizeof(address) );
+    address.sun_family = AF_UNIX;
+    strcpy( address.sun_path, aName );
+
+    aSource->fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( aSource->fd < 0 )
+    {
+        return TIesrFAErrFail;
+    }
+
+    aSource->stage = (unsigned char*) malloc( aSource->stage_size );
+    if( aSource->stage == NULL ||
+            connect( aSource->fd, (struct sockaddr*) &address, sizeof(address) ) != 0 ||
+            fcntl( aSource->fd, F_SETFL, O_NONBLOCK ) != 0 )
+    {
+        TIesrFA_stream_close( aSource );
+        return TIesrFAErrFail;
+    }
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_stream_getframe
+
+ Return the next frame from the buffer of bytes read from a pipe or
+ socket.  When the buffer does not hold a frame, read as many bytes as
+ are available, up to the size of the buffer.
+ ----------------------------------------------------------------*/
+TIesrFA_Error_t TIesrFA_stream_getframe( TIesrFA_Source_t* aSource,
+        unsigned char* const aFrame, const int aBlock, unsigned int* aFramesQueued )
+{
+    ssize_t numBytesRead;
+    struct pollfd pollFd;
+
+    while( aSource->stage_end - aSource->stage_start < aSource->frame_size )
+    {
+        /* Move a partial frame to the start of the buffer */
+        if( aSource->stage_start > 0 )
+        {
+            memmove( aSource->stage, aSource->stage + aSource->stage_start,
+                    aSource->stage_end - aSource->stage_start );
+            aSource->stage_end -= aSource->stage_start;
+            aSource->stage_start = 0;
+        }
+
+        numBytesRead = read( aSource->fd, aSource->stage + aSource->stage_end,
+                aSource->stage_size - aSource->stage_end );
+
+        if( numBytesRead > 0 )
+        {
+            aSource->stage_end += numBytesRead;
+        }
+        else if( numBytesRead == 0 )
+        {
+            /* Writer has closed the pipe or socket */
+            *aFramesQueued = 0;
+            return TIesrFAErrEOF;
+        }
+        else if( errno == EAGAIN || errno == EWOULDBLOCK )
+        {
+            if( !aBlock )
+            {
+                *aFramesQueued = 0;
+                return TIesrFAErrNoFrame;
+            }
+
+            pollFd.fd = aSource->fd;
+            pollFd.events = POLLIN;
+            poll( &pollFd, 1, -1 );
+        }
+        else if( errno != EINTR )
+        {
+            return TIesrFAErrFail;
+        }
+    }
+
+    memcpy( aFrame, aSource->stage + aSource->stage_start, aSource->frame_size );
+    aSource->stage_start += aSource->frame_size;
+
+    *aFramesQueued = ( aSource->stage_end - aSource->stage_start ) / aSource->frame_size;
+
+    return TIesrFAErrNone;
+}
+
+/*----------------------------------------------------------------
+ TIesrFA_stream_close
+
+ Close a pipe or socket, and free the buffer.
+ ----------------------------------------------------------------*/
+void TIesrFA_stream_close( TIesrFA_Source_t* aSource )
+{
+    if( aSource->fd >= 0 )
+    {
+        close( aSource->fd );
+        aSource->fd = -1;
+    }
+
+    if( aSource->stage != NULL )
+    {
+        free( aSource->stage );
+        aSource->stage = NULL;
+    }
+}
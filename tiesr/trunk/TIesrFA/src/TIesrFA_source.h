@@ -0,0 +1,126 @@
+/*=======================================================================
+
+ *
+ * TIesrFA_source.h
+ *
+ * Header for frame sources of the Linux TIesrFA implementation.
+ *
+ * Copyright (C) 2010 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+
+ This header defines the interface TIesrFA_ALSA.c uses to obtain frames
+ from a source other than an ALSA PCM.  A source is selected by a
+ prefix of the channel name, or is a file if the channel name is the
+ name of an existing file.  All sources deliver frames from memory, so
+ that no system call is made per frame while frames are available.
+
+======================================================================*/
+
+#ifndef _TIesrFA_SOURCE_H
+#define	_TIesrFA_SOURCE_H
+
+#include "TIesrFA_User.h"
+
+#ifdef	__cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct TIesrFA_Source_Struct TIesrFA_Source_t;
+
+    /* Functions implementing a source */
+    typedef struct TIesrFA_SourceOps_Struct
+    {
+        /* Channel name prefix selecting the source.  NULL for a file. */
+        const char* prefix;
+
+        /* Connect to the source.  aName is the channel name following
+         the prefix. */
+        TIesrFA_Error_t (*open)( TIesrFA_Source_t* aSource, const char* aName );
+
+        /* Start returning frames */
+        TIesrFA_Error_t (*start)( TIesrFA_Source_t* aSource );
+
+        /* Return a frame as TIesrFA_getframe does */
+        TIesrFA_Error_t (*getframe)( TIesrFA_Source_t* aSource,
+                unsigned char* const aFrame, const int aBlock,
+                unsigned int* aFramesQueued );
+
+        /* Stop returning frames */
+        void (*stop)( TIesrFA_Source_t* aSource );
+
+        /* Disconnect from the source */
+        void (*close)( TIesrFA_Source_t* aSource );
+
+        /* Set the function called when a frame becomes available, as
+         TIesrFA_notify does */
+        TIesrFA_Error_t (*notify)( TIesrFA_Source_t* aSource,
+                TIesrFA_Notify_t aNotify, void* aArg );
+
+    } TIesrFA_SourceOps_t;
+
+
+    /* State of a source */
+    struct TIesrFA_Source_Struct
+    {
+        /* The source selected by the channel name */
+        const TIesrFA_SourceOps_t* ops;
+
+        /* Bytes in a frame */
+        unsigned int frame_size;
+
+        /* File descriptor of a file, pipe, socket or shared memory object */
+        int fd;
+
+        /* Mapped file or shared memory, its size, and read offset in a file */
+        unsigned char* map;
+        size_t map_size;
+        size_t offset;
+
+        /* Frames of the shared memory or in-memory ring read so far */
+        unsigned int read_count;
+
+        /* In-memory ring the source is reading */
+        struct TIesrFA_MemRing_Struct* mem_ring;
+
+        /* Function called when a frame becomes available, and its argument */
+        TIesrFA_Notify_t notify;
+        void* notify_arg;
+
+        /* Buffer holding bytes read from a pipe or socket, and the
+         range of bytes not yet returned */
+        unsigned char* stage;
+        unsigned int stage_size;
+        unsigned int stage_start;
+        unsigned int stage_end;
+    };
+
+
+    /* Select the source for a channel name.  Returns FALSE if the
+     channel name is not a source, and should be an ALSA PCM. */
+    int TIesrFA_source_select( TIesrFA_Source_t* aSource, const char* aChannelName,
+            unsigned int aFrameSize );
+
+    /* Connect to the source selected for the channel name.  aBufferFrames
+     is the number of frames that may be buffered by the source. */
+    TIesrFA_Error_t TIesrFA_source_open( TIesrFA_Source_t* aSource,
+            const char* aChannelName, unsigned int aBufferFrames );
+
+    /* Set the function called when the source has a frame available */
+    TIesrFA_Error_t TIesrFA_source_notify( TIesrFA_Source_t* aSource,
+            TIesrFA_Notify_t aNotify, void* aArg );
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _TIesrFA_SOURCE_H */
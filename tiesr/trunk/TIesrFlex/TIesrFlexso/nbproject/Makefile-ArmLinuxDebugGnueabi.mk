@@ -47,7 +47,7 @@ FFLAGS=
 ASFLAGS=
 
 # Link Libraries and Options
-LDLIBSOPTIONS=-L../../Dist/${CND_CONF}/lib -Wl,-rpath ${CND_BASEDIR}/../../Dist/${CND_CONF}/lib ../../TIesrDict/TIesrDictso/../../Dist/ArmLinuxDebugGnueabi/lib/libTIesrDict.so.1
+LDLIBSOPTIONS=-L../../Dist/${CND_CONF}/lib -Wl,-rpath ${CND_BASEDIR}/../../Dist/${CND_CONF}/lib ../../TIesrDict/TIesrDictso/../../Dist/ArmLinuxDebugGnueabi/lib/libTIesrDict.so.1 -lpthread
 
 # Build Targets
 .build-conf: ${BUILD_SUBPROJECTS}
@@ -30,6 +30,12 @@
 #include <windows.h>
 #endif
 
+/* Threads looking up pronunciations */
+#if defined (LINUX)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 // C++ include files
 #include <cstdlib>
 #include <new>
@@ -94,6 +100,12 @@ CTIesrFlex::CTIesrFlex( void )
    // initially no allocated data for questions and hmms
    qs_base = NULL;
    qs_offset = NULL;
+   m_numQuestions = 0;
+   m_qsLeft = NULL;
+   m_qsRight = NULL;
+   m_qsWords = 0;
+   m_leftClass = NULL;
+   m_rightClass = NULL;
 
    tree_base = NULL;
    treetbl_base = NULL;
@@ -130,6 +142,13 @@ CTIesrFlex::CTIesrFlex( void )
    sil_hmm = NULL;
    m_dict = NULL;
 
+   // Pronunciations are looked up by the calling thread only
+   m_lookupThreads = 1;
+   m_lookupDictCount = 0;
+   m_dictDir = NULL;
+   m_dictLanguage = NULL;
+   m_dictIdent = NULL;
+
 
 #ifdef OFFLINE_CLS
    vq_centroid = NULL;
@@ -139,6 +158,12 @@ CTIesrFlex::CTIesrFlex( void )
    // initially there is no grammar loaded in this object
    cfg = NULL;
 
+   // No grammar stream being read
+   m_lexReader = NULL;
+   m_lexContext = NULL;
+   m_lexEnd = 0;
+   m_lexDone = 1;
+
    // Allocation for storing pronunciations of words
    m_wordProns = NULL;
 
@@ -147,6 +172,10 @@ CTIesrFlex::CTIesrFlex( void )
    m_tokenMax = 0;
    token_idx = 0;
 
+   // No arena allocated for tokens and next lists
+   m_arena = NULL;
+   m_arenaLast = NULL;
+
    // Initialize dynamic allocation of rules
    rule = NULL;
    m_ruleMax = 0;
@@ -193,6 +222,30 @@ CTIesrFlex::CTIesrFlex( void )
    m_stopMax = 0;
    n_stop_next = 0;
 
+   // No grammar parsed, and no triphones kept for rule edits
+   m_bGrammarParsed = false;
+   m_hmmKept = NULL;
+   m_hmmKeptIdx = 0;
+   m_hmmKeptMax = 0;
+
+   // No models output yet
+   m_outputDir = NULL;
+   m_outputHmmCount = -1;
+   m_memFileIdx = 0;
+   m_slotName = NULL;
+
+   // Initialize pronunciations kept between parses
+   m_pronCache = NULL;
+   m_pronCacheIdx = 0;
+   m_pronCacheMax = 0;
+   FreePronCache( );
+
+   // Initialize cluster indices kept between outputs
+   m_clusterCache = NULL;
+   m_clusterCacheIdx = 0;
+   m_clusterCacheMax = 0;
+   FreeClusterCache( );
+
    return;
 }
 
@@ -214,12 +267,24 @@ CTIesrFlex::~CTIesrFlex( void )
    FreeVQHMM( );
 #endif
 
-   // remove the dictionary
+   // remove the dictionary, and those of the lookup threads
    delete m_dict;
+   free_lookup_dicts( );
+   delete [] m_dictDir;
+   delete [] m_dictLanguage;
+   delete [] m_dictIdent;
 
    // Free all of the grammar structures allocated
    FreeGrammarData( );
 
+   // Free data kept for rule edits and model output
+   if( m_hmmKept )
+      free( m_hmmKept );
+   delete [] m_outputDir;
+   delete [] m_slotName;
+   FreePronCache( );
+   FreeMemFiles( );
+
    return;
 }
 
@@ -309,10 +374,8 @@ FailedLoad:
 
 short CTIesrFlex::SaveVQHMM( const char* dirname )
 {
-   char buf[FILENAME_MAX];
-   FILE *fp;
+   GrammarFile fp;
    unsigned char* pRAM2Cls;
-   short nwrite;
    short i, im;
 
 
@@ -332,10 +395,7 @@ short CTIesrFlex::SaveVQHMM( const char* dirname )
 
 
    /* Open file to save table mapping RAM mean to ROM mean cluster class */
-   strcpy( buf, dirname );
-   strcat( buf, "/o2amidx.bin" );
-   fp = fopen( buf, "wb" );
-   if( !fp )
+   if( open_file( &fp, dirname, "o2amidx.bin", "wb" ) )
       goto SaveFail;
 
    // Write the table
@@ -344,50 +404,47 @@ short CTIesrFlex::SaveVQHMM( const char* dirname )
    // Must write proper endian format
    // fwrite(&i, sizeof(short), 1, fp);
    int failed;
-   failed = output_int16( fp, i );
+   failed = output_int16( &fp, i );
    if( failed )
       goto SaveFail;
 
    // Indices are all unsigned char so don't care about endian format
-   nwrite = fwrite( pRAM2Cls, sizeof (unsigned char), i, fp );
-   if( nwrite != i )
+   failed = write_file( &fp, pRAM2Cls, i );
+   if( failed )
       goto SaveFail;
 
    // Finished writing mean to centroid mapping
-   fclose( fp );
+   close_file( &fp );
    free( pRAM2Cls );
    pRAM2Cls = NULL;
 
 
    /* Open file to hold cluster centriods */
-   strcpy( buf, dirname );
-   strcat( buf, "/vqcentr.bin" );
-   fp = fopen( buf, "wb" );
-   if( !fp )
+   if( open_file( &fp, dirname, "vqcentr.bin", "wb" ) )
       goto SaveFail;
 
    // Write the centroid information
    // Must write in proper endian format
    // nwrite = fwrite(&vq_n_cs, sizeof(short), 1, fp);
-   failed = output_int16( fp, vq_n_cs );
+   failed = output_int16( &fp, vq_n_cs );
    if( failed )
       goto SaveFail;
 
    // nwrite = fwrite(&vq_nbr_dim, sizeof(short), 1, fp);
-   failed = output_int16( fp, vq_nbr_dim );
+   failed = output_int16( &fp, vq_nbr_dim );
    if( failed )
       goto SaveFail;
 
    // nwrite = fwrite(vq_centroid, sizeof(short), vq_n_cs * vq_nbr_dim, fp);
    for( int numEl = 0; numEl < vq_n_cs * vq_nbr_dim; numEl++ )
    {
-      failed = output_int16( fp, vq_centroid[numEl] );
+      failed = output_int16( &fp, vq_centroid[numEl] );
       if( failed )
          goto SaveFail;
    }
 
 
-   fclose( fp );
+   close_file( &fp );
 
    return OK;
 
@@ -395,8 +452,7 @@ short CTIesrFlex::SaveVQHMM( const char* dirname )
    // Failed to save mapping or vq centroids
 SaveFail:
 
-   if( fp )
-      fclose( fp );
+   close_file( &fp );
 
 
    if( pRAM2Cls )
@@ -459,6 +515,26 @@ CTIesrFlex::Errors CTIesrFlex::LoadLanguage( const char *direct,
    // free any existing model data and dynamic structures for model output
    free_codebook( );
 
+   // A new language invalidates pronunciations and triphones of prior
+   // grammars, and any models output
+   FreePronCache( );
+   if( m_hmmKept )
+   {
+      free( m_hmmKept );
+      m_hmmKept = NULL;
+   }
+   m_bGrammarParsed = false;
+   m_outputHmmCount = -1;
+
+   // Lookup threads must load the dictionary of the new language
+   free_lookup_dicts( );
+   delete [] m_dictDir;
+   delete [] m_dictLanguage;
+   delete [] m_dictIdent;
+   m_dictDir = NULL;
+   m_dictLanguage = NULL;
+   m_dictIdent = NULL;
+
 
    // Hold use flags for TIesrDict
    m_useFlags = useFlags;
@@ -485,6 +561,26 @@ CTIesrFlex::Errors CTIesrFlex::LoadLanguage( const char *direct,
    // number of phones in dictionary. Does not include 'sil' model
    n_phone = m_dict->GetPhoneCount( );
 
+   // Keep the dictionary location for lookup threads.  If it can not
+   // be kept, only the calling thread looks up pronunciations.
+   try
+   {
+      m_dictDir = new char[strlen( direct ) + 1];
+      strcpy( m_dictDir, direct );
+      m_dictLanguage = new char[strlen( language ) + 1];
+      strcpy( m_dictLanguage, language );
+      m_dictIdent = new char[strlen( dict_ident ) + 1];
+      strcpy( m_dictIdent, dict_ident );
+   }
+   catch( std::bad_alloc &ex )
+   {
+      delete [] m_dictDir;
+      delete [] m_dictLanguage;
+      m_dictDir = NULL;
+      m_dictLanguage = NULL;
+      m_dictIdent = NULL;
+   }
+
    // directory containing the hmm information
    strcpy( dir, direct );
    strcat( dir, "/" );
@@ -558,6 +654,11 @@ CTIesrFlex::Errors CTIesrFlex::LoadLanguage( const char *direct,
       if( failed )
          goto readfail;
 
+      // answers of each phone to the questions
+      failed = make_qs_answers( );
+      if( failed )
+         goto readfail;
+
       // find pointers to tree
       strcpy( fname, dir );
       strcat( fname, "_tree.bin" );
@@ -679,23 +780,235 @@ CTIesrFlex::Errors CTIesrFlex::ParseGrammar( const char * cfg_string,
         int aIncludeRulePron,
         int aAutoSilence )
 {
-   int result;
+   if( !cfg_string )
+      return ErrFail;
+
+   return parse_grammar( cfg_string, aMaxPronunciations, aIncludeRulePron,
+           aAutoSilence );
+}
+
+
+/*----------------------------------------------------------------
+ ParseGrammarStream
+
+ Parse a grammar read by aReader.  The lexer reads the text into its
+ buffer as the parser asks for tokens.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::ParseGrammarStream( GrammarReader aReader, void *aContext,
+        unsigned int aMaxPronunciations,
+        int aIncludeRulePron,
+        int aAutoSilence )
+{
+   Errors error;
+
+   if( !aReader )
+      return ErrFail;
+
+   m_lexReader = aReader;
+   m_lexContext = aContext;
+
+   error = parse_grammar( NULL, aMaxPronunciations, aIncludeRulePron,
+           aAutoSilence );
+
+   m_lexReader = NULL;
+   m_lexContext = NULL;
+
+   return error;
+}
+
+
+/*----------------------------------------------------------------
+ ParseGrammarFile
+
+ Parse a grammar read from a file.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::ParseGrammarFile( const char *aFileName,
+        unsigned int aMaxPronunciations,
+        int aIncludeRulePron,
+        int aAutoSilence )
+{
+   Errors error;
+   FILE *fp;
+
+   fp = fopen( aFileName, "rb" );
+   if( !fp )
+      return ErrFail;
+
+   error = ParseGrammarStream( read_grammar_file, fp, aMaxPronunciations,
+           aIncludeRulePron, aAutoSilence );
+
+   fclose( fp );
+   return error;
+}
+
+
+//--------------------------------
+
+int CTIesrFlex::read_grammar_file( void *aContext, char *aBuffer, int aSize )
+{
+   FILE *fp = (FILE*) aContext;
+   size_t nread;
+
+   nread = fread( aBuffer, 1, aSize, fp );
+   if( nread == 0 && ferror( fp ) )
+      return -1;
+
+   return (int) nread;
+}
+
+
+/*----------------------------------------------------------------
+ parse_grammar
+
+ Parse a new grammar from a string or from the reader of the lexer,
+ which starts a new triphone list.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::parse_grammar( const char * cfg_string,
+        unsigned int aMaxPronunciations,
+        int aIncludeRulePron,
+        int aAutoSilence )
+{
    CTIesrFlex::Errors error;
 
-   // Free any preexisting data
-   FreeGrammarData( );
+   // A new grammar starts a new triphone list, so models must be
+   // output, and slot files in memory no longer match them
+   if( m_hmmKept )
+   {
+      free( m_hmmKept );
+      m_hmmKept = NULL;
+   }
+   m_outputHmmCount = -1;
+   m_bGrammarParsed = false;
+   delete [] m_slotName;
+   m_slotName = NULL;
+   FreeMemFiles( );
+
+   error = CompileGrammar( cfg_string, aMaxPronunciations, aIncludeRulePron,
+           aAutoSilence );
+
+   // Keep the options for rule edits
+   if( error == ErrNone )
+   {
+      m_bGrammarParsed = true;
+      m_parseMaxPronunciations = aMaxPronunciations;
+      m_parseIncludeRulePron = aIncludeRulePron;
+   }
+
+   return error;
+}
+
+
+/*----------------------------------------------------------------
+ ParseSlotGrammar
+
+ Parse the grammar of a slot, keeping the triphone list of the prior
+ grammar as a rule edit does, so that the slot network uses the models
+ of the grammar.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::ParseSlotGrammar( const char *aSlot,
+        const char *aGrammarString,
+        unsigned int aMaxPronunciations,
+        int aIncludeRulePron,
+        int aAutoSilence )
+{
+   Errors error;
+   char *slotName;
+   unsigned int c;
+
+   if( !aSlot || aSlot[0] == '\0' || strlen( aSlot ) > MAX_SLOT_NAME )
+      return ErrFail;
+
+   for( c = 0; aSlot[c] != '\0'; c++ )
+   {
+      if( !myisalpha( (unsigned char) aSlot[c] ) && aSlot[c] != '_' )
+         return ErrFail;
+   }
 
-   // Allocate a new copy of the grammar text
    try
    {
-      cfg = new char[strlen( cfg_string ) + 1];
+      slotName = new char[strlen( aSlot ) + 1];
    }
    catch( std::bad_alloc &ex )
    {
       return ErrMemory;
    }
+   strcpy( slotName, aSlot );
+
+   // Keep the triphone list of the prior grammar, which the parse adds to
+   if( !m_hmmKept )
+   {
+      m_hmmKept = hmm;
+      m_hmmKeptIdx = hmm_idx;
+      m_hmmKeptMax = m_hmmMax;
+      hmm = NULL;
+      hmm_idx = 0;
+      m_hmmMax = 0;
+   }
+
+   m_bGrammarParsed = false;
+   delete [] m_slotName;
+   m_slotName = NULL;
+
+   error = CompileGrammar( aGrammarString, aMaxPronunciations, aIncludeRulePron,
+           aAutoSilence );
+
+   if( error == ErrNone )
+   {
+      m_bGrammarParsed = true;
+      m_parseMaxPronunciations = aMaxPronunciations;
+      m_parseIncludeRulePron = aIncludeRulePron;
+      m_slotName = slotName;
+   }
+   else
+   {
+      delete [] slotName;
+   }
+
+   return error;
+}
+
+/*----------------------------------------------------------------
+ CompileGrammar
+
+ Parse a grammar and create its network and triphone list.  If
+ triphones are kept from a prior grammar, the triphone list starts
+ with them in the same order.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::CompileGrammar( const char * cfg_string,
+        unsigned int aMaxPronunciations,
+        int aIncludeRulePron,
+        int aAutoSilence )
+{
+   int result;
+   CTIesrFlex::Errors error;
+
+   // Free any preexisting data
+   FreeGrammarData( );
+
+   // Start the triphone list with any triphones kept
+   if( m_hmmKept )
+   {
+      hmm = m_hmmKept;
+      hmm_idx = m_hmmKeptIdx;
+      m_hmmMax = m_hmmKeptMax;
+      m_hmmKept = NULL;
+   }
+
+   // Allocate a new copy of the grammar text, unless it is read from
+   // a stream
+   if( cfg_string )
+   {
+      try
+      {
+         cfg = new char[strlen( cfg_string ) + 1];
+      }
+      catch( std::bad_alloc &ex )
+      {
+         return ErrMemory;
+      }
 
-   strcpy( cfg, cfg_string );
+      strcpy( cfg, cfg_string );
+   }
 
 
    // Maintain a copy of the autosilence request
@@ -718,7 +1031,7 @@ CTIesrFlex::Errors CTIesrFlex::ParseGrammar( const char * cfg_string,
    // checked within yyparse so that if stack memory is allocated then
    // it can be released appropriately when an exception is raised.
    result = yyparse( );
-   if( result != 0 )
+   if( result != 0 || m_lexDone < 0 )
       return ErrFail;
 
 
@@ -927,8 +1240,141 @@ CTIesrFlex::Errors CTIesrFlex::DownloadGrammar( )
  ----------------------------------------------------------------*/
 CTIesrFlex::Errors CTIesrFlex::OutputGrammar( char *aDirName, int aByteMeans, int aByteVars,
         int aOptimize )
+{
+   return output_grammar( aDirName, aByteMeans, aByteVars, aOptimize, NULL );
+}
+
+
+/*----------------------------------------------------------------
+ OutputGrammarBundle
+
+ The files of the grammar are output to memory, and then placed one
+ after the other in a bundle following its header and file table, in
+ the layout defined by bundle_user.h of the engine.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::OutputGrammarBundle( unsigned char **aBundle,
+        unsigned int *aSize, int aByteMeans, int aByteVars )
+{
+   Errors error;
+   unsigned char *bundle;
+   unsigned char *entry;
+   unsigned int size;
+   unsigned int offset;
+   unsigned short value;
+   int f;
+
+   *aBundle = NULL;
+   *aSize = 0;
+
+   error = output_grammar( NULL, aByteMeans, aByteVars, 0, NULL );
+   if( error != ErrNone )
+      return error;
+
+   // Size of the bundle, with each file aligned
+   size = BUNDLE_HEADER_SIZE + m_memFileIdx * BUNDLE_ENTRY_SIZE;
+   for( f = 0; f < m_memFileIdx; f++ )
+   {
+      size = ( size + BUNDLE_ALIGN - 1 ) & ~( BUNDLE_ALIGN - 1 );
+      size += m_memFiles[f].size;
+   }
+
+   // Cleared, so that padding and the ends of file names are zero
+   bundle = (unsigned char*) calloc( size, 1 );
+   if( !bundle )
+      return ErrMemory;
+
+   memcpy( bundle, BUNDLE_MAGIC, sizeof (BUNDLE_MAGIC) );
+   value = BUNDLE_VERSION;
+   memcpy( bundle + 4, &value, sizeof (unsigned short) );
+   value = (unsigned short) m_memFileIdx;
+   memcpy( bundle + 6, &value, sizeof (unsigned short) );
+   memcpy( bundle + 8, &size, sizeof (unsigned int) );
+
+   offset = BUNDLE_HEADER_SIZE + m_memFileIdx * BUNDLE_ENTRY_SIZE;
+   entry = bundle + BUNDLE_HEADER_SIZE;
+   for( f = 0; f < m_memFileIdx; f++, entry += BUNDLE_ENTRY_SIZE )
+   {
+      offset = ( offset + BUNDLE_ALIGN - 1 ) & ~( BUNDLE_ALIGN - 1 );
+
+      strcpy( (char*) entry, m_memFiles[f].name );
+      memcpy( entry + MEMFILE_NAME_SIZE, &offset, sizeof (unsigned int) );
+      memcpy( entry + MEMFILE_NAME_SIZE + sizeof (unsigned int),
+              &m_memFiles[f].size, sizeof (unsigned int) );
+
+      if( m_memFiles[f].size > 0 )
+         memcpy( bundle + offset, m_memFiles[f].data, m_memFiles[f].size );
+      offset += m_memFiles[f].size;
+   }
+
+   *aBundle = bundle;
+   *aSize = size;
+   return ErrNone;
+}
+
+
+/*----------------------------------------------------------------
+ OutputModelPool
+
+ The models and hmm list of the grammar are output to the pool
+ directory, with the map of the input models to the pool, but without
+ the grammar network.  The byte conversion and VQ data are done here,
+ once for all grammars output with OutputGrammarPool.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::OutputModelPool( char *aPoolDir, int aByteMeans, int aByteVars )
+{
+   if( !aPoolDir )
+      return ErrFail;
+
+   if( ( m_bInputByteMeans && !aByteMeans ) ||
+           ( m_bInputByteVars && !aByteVars ) )
+   {
+      return ErrType;
+   }
+
+   if( output_hmm2phone( aPoolDir ) )
+      return ErrFail;
+
+   if( output_models( aPoolDir, aByteMeans, aByteVars, true ) )
+      return ErrFail;
+
+   return ErrNone;
+}
+
+
+/*----------------------------------------------------------------
+ OutputGrammarPool
+
+ Output the files of the grammar that index a model pool output by
+ OutputModelPool, and the file naming the pool directory.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::OutputGrammarPool( char *aDirName, char *aPoolDir )
+{
+   // The engine reads the pool name into a buffer of MAX_POOL_NAME.
+   // Output of the grammar to the pool directory would remove the pool.
+   if( !aDirName || !aPoolDir || strlen( aPoolDir ) + 2 > MAX_POOL_NAME ||
+           strcmp( aDirName, aPoolDir ) == 0 )
+   {
+      return ErrFail;
+   }
+
+   return output_grammar( aDirName, 1, 1, 0, aPoolDir );
+}
+
+
+/*----------------------------------------------------------------
+ output_grammar
+
+ Output the grammar files to the directory aDirName, or to memory if
+ aDirName is NULL.  If aPoolDir is not NULL, the grammar network
+ indexes the hmms of the pool in that directory, and no hmm or model
+ files are output.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::output_grammar( const char *aDirName, int aByteMeans,
+        int aByteVars, int aOptimize, const char *aPoolDir )
 {
    int failed;
+   int* poolHmm = NULL;
+   int poolHmmCount = 0;
 
 
    // TODO: figure out how to construct and download all of the
@@ -948,48 +1394,106 @@ CTIesrFlex::Errors CTIesrFlex::OutputGrammar( char *aDirName, int aByteMeans, in
    }
 
 
-   failed = output_net( aDirName, "/net.bin" );
-
-   if( failed )
-      return ErrFail;
-
-   failed = output_hmm2phone( aDirName );
-   if( failed )
-      return ErrFail;
+   // The hmms of a grammar of a model pool are found in the pool first,
+   // so that nothing is output if the pool does not hold its models
+   if( aPoolDir )
+   {
+      Errors error = pool_hmm_map( aPoolDir, &poolHmm, &poolHmmCount );
+      if( error != ErrNone )
+         return error;
+   }
 
-   failed = output_gtm( aDirName );
-   if( failed )
-      return ErrFail;
 
+   // A slot is output to its own network and word list files
+   if( m_slotName )
+   {
+      char netName[FILENAME_MAX];
+      char wordName[FILENAME_MAX];
 
-   // If input mean or variance are in short, and output is requesting
-   // byte, then convert to byte.
-   if( ( !m_bInputByteMeans && aByteMeans ) ||
-           ( !m_bInputByteVars && aByteVars ) )
+      sprintf( netName, "%s%s", m_slotName, SLOT_NET_EXT );
+      sprintf( wordName, "%s%s", m_slotName, SLOT_WORD_EXT );
+      failed = output_net( aDirName, netName, wordName, poolHmm, poolHmmCount );
+   }
+   else
    {
-      // Note: bias has already been added to short mean vectors in the file
-      failed = model_bit_16_to_8( aDirName, aDirName, true, 0, aByteMeans, aByteVars );
+      failed = output_net( aDirName, "net.bin", "word.lis", poolHmm, poolHmmCount );
    }
-   if( failed )
-      return ErrFail;
 
+   free( poolHmm );
 
-   // Output the configuration file for the models, which specifies
-   // the type of mean and variance vectors, byte or short, and
-   // the endian of the data.
-   failed = output_config( aDirName, aByteMeans, aByteVars );
    if( failed )
       return ErrFail;
 
 
-#ifdef OFFLINE_CLS
-   SaveVQHMM( aDirName );
-#endif
+   // A grammar of a model pool holds no hmms or models
+   if( aPoolDir )
+   {
+      m_outputHmmCount = -1;
 
+      failed = output_pool_name( aDirName, aPoolDir );
+      if( failed )
+         return ErrFail;
 
-#ifdef USE_NET_OPTIMIZE
+      return ErrNone;
+   }
 
-   if( aOptimize )
+
+   // If the models of the triphone list were already output to this
+   // directory, or to memory, with the same options, only the network
+   // and word list have changed.
+   if( m_outputHmmCount == hmm_idx && !aOptimize &&
+           ( aDirName ? m_outputDir && strcmp( m_outputDir, aDirName ) == 0 : !m_outputDir ) &&
+           m_outputByteMeans == aByteMeans && m_outputByteVars == aByteVars )
+   {
+      return ErrNone;
+   }
+   m_outputHmmCount = -1;
+
+   failed = output_hmm2phone( aDirName );
+   if( failed )
+      return ErrFail;
+
+   failed = output_models( aDirName, aByteMeans, aByteVars, false );
+   if( failed )
+      return ErrFail;
+
+   // The directory no longer uses a model pool it may have used before
+   if( aDirName )
+   {
+      char fname[FILENAME_MAX];
+
+      if( strlen( aDirName ) + strlen( MODEL_POOL_FILE ) + 2 <= FILENAME_MAX )
+      {
+         sprintf( fname, "%s/%s", aDirName, MODEL_POOL_FILE );
+         remove( fname );
+      }
+   }
+
+
+   // Remember the models output, so an edit of the grammar that adds
+   // no triphones need not output them again
+   delete [] m_outputDir;
+   m_outputDir = NULL;
+   try
+   {
+      if( aDirName )
+      {
+         m_outputDir = new char[strlen( aDirName ) + 1];
+         strcpy( m_outputDir, aDirName );
+      }
+      m_outputByteMeans = aByteMeans;
+      m_outputByteVars = aByteVars;
+      m_outputHmmCount = hmm_idx;
+   }
+   catch( std::bad_alloc &ex )
+   {
+      m_outputDir = NULL;
+   }
+
+
+#ifdef USE_NET_OPTIMIZE
+
+   if( aOptimize )
    {
       /* The code below was for quick implmentation of network
        * optimization.  These functions are
@@ -1045,6 +1549,207 @@ CTIesrFlex::Errors CTIesrFlex::OutputGrammar( char *aDirName, int aByteMeans, in
 }
 
 
+/*----------------------------------------------------------------
+ AddRuleAlternatives
+
+ Add alternatives to a rule of the grammar last parsed.  Each new
+ alternative is appended to the right side of the rule as a top level
+ alternative, and the changed grammar is parsed keeping the triphone
+ list of the prior grammar.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::AddRuleAlternatives( const char *aRule,
+        const char *aAlternatives )
+{
+   int bodyStart, bodyEnd;
+   int pos, altPos, newEnd, len;
+   int altLen, cfgLen, altMax, numAdded;
+   int found;
+   char *newGrammar = NULL;
+   char *alt = NULL;
+   char *oldAlt = NULL;
+   Errors error;
+
+   if( !m_bGrammarParsed || !cfg )
+      return ErrFail;
+
+   if( !FindRuleBody( cfg, aRule, &bodyStart, &bodyEnd ) )
+      return ErrNoMatch;
+
+   // Normalizing an alternative at most doubles its length, and each
+   // alternative added is preceded by " | ".
+   cfgLen = strlen( cfg );
+   altLen = strlen( aAlternatives );
+   altMax = 2 * ( cfgLen + 4 * altLen ) + 16;
+   try
+   {
+      newGrammar = new char[cfgLen + 4 * altLen + 16];
+      alt = new char[altMax];
+      oldAlt = new char[altMax];
+   }
+   catch( std::bad_alloc &ex )
+   {
+      delete [] alt;
+      delete [] newGrammar;
+      return ErrMemory;
+   }
+
+   // The new grammar is built up to the end of the rule body, so that
+   // alternatives added are checked against those added before them.
+   strncpy( newGrammar, cfg, bodyEnd );
+   newEnd = bodyEnd;
+   numAdded = 0;
+
+   altPos = 0;
+   while( altPos < altLen )
+   {
+      altPos = NextAlternative( aAlternatives, altPos, altLen, alt, altMax );
+      if( alt[0] == '\0' )
+         continue;
+
+      // Skip an alternative already in the rule
+      found = false;
+      pos = bodyStart;
+      while( pos < newEnd && !found )
+      {
+         pos = NextAlternative( newGrammar, pos, newEnd, oldAlt, altMax );
+         found = ( strcmp( oldAlt, alt ) == 0 );
+      }
+      if( found )
+         continue;
+
+      len = strlen( alt );
+      memcpy( newGrammar + newEnd, " | ", 3 );
+      memcpy( newGrammar + newEnd + 3, alt, len );
+      newEnd += len + 3;
+      numAdded++;
+   }
+
+   strcpy( newGrammar + newEnd, cfg + bodyEnd );
+
+   error = ErrNone;
+   if( numAdded > 0 )
+      error = RecompileGrammar( newGrammar );
+
+   delete [] oldAlt;
+   delete [] alt;
+   delete [] newGrammar;
+
+   return error;
+}
+
+/*----------------------------------------------------------------
+ RemoveRuleAlternatives
+
+ Remove alternatives from a rule of the grammar last parsed.  Every
+ alternative to remove must be a top level alternative of the rule,
+ and at least one alternative of the rule must remain.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::RemoveRuleAlternatives( const char *aRule,
+        const char *aAlternatives )
+{
+   int bodyStart, bodyEnd;
+   int pos, altPos, newEnd, len;
+   int altLen, cfgLen, altMax, numKept;
+   int found;
+   char *newGrammar = NULL;
+   char *alt = NULL;
+   char *oldAlt = NULL;
+   Errors error;
+
+   if( !m_bGrammarParsed || !cfg )
+      return ErrFail;
+
+   if( !FindRuleBody( cfg, aRule, &bodyStart, &bodyEnd ) )
+      return ErrNoMatch;
+
+   cfgLen = strlen( cfg );
+   altLen = strlen( aAlternatives );
+   altMax = 2 * ( cfgLen + altLen ) + 16;
+   try
+   {
+      newGrammar = new char[4 * cfgLen + 16];
+      alt = new char[altMax];
+      oldAlt = new char[altMax];
+   }
+   catch( std::bad_alloc &ex )
+   {
+      delete [] alt;
+      delete [] newGrammar;
+      return ErrMemory;
+   }
+
+   // Each alternative to remove must be in the rule
+   error = ErrNone;
+   altPos = 0;
+   while( altPos < altLen && error == ErrNone )
+   {
+      altPos = NextAlternative( aAlternatives, altPos, altLen, alt, altMax );
+      if( alt[0] == '\0' )
+         continue;
+
+      found = false;
+      pos = bodyStart;
+      while( pos < bodyEnd && !found )
+      {
+         pos = NextAlternative( cfg, pos, bodyEnd, oldAlt, altMax );
+         found = ( strcmp( oldAlt, alt ) == 0 );
+      }
+
+      if( !found )
+         error = ErrNoMatch;
+   }
+
+
+   // Rebuild the rule body from the alternatives kept
+   strncpy( newGrammar, cfg, bodyStart );
+   newEnd = bodyStart;
+   numKept = 0;
+
+   pos = bodyStart;
+   while( pos < bodyEnd && error == ErrNone )
+   {
+      pos = NextAlternative( cfg, pos, bodyEnd, oldAlt, altMax );
+      if( oldAlt[0] == '\0' )
+         continue;
+
+      found = false;
+      altPos = 0;
+      while( altPos < altLen && !found )
+      {
+         altPos = NextAlternative( aAlternatives, altPos, altLen, alt, altMax );
+         found = ( strcmp( oldAlt, alt ) == 0 );
+      }
+
+      if( !found )
+      {
+         len = strlen( oldAlt );
+         memcpy( newGrammar + newEnd, numKept ? " | " : " ", numKept ? 3 : 1 );
+         newEnd += numKept ? 3 : 1;
+         memcpy( newGrammar + newEnd, oldAlt, len );
+         newEnd += len;
+         numKept++;
+      }
+   }
+
+   // A rule can not be empty
+   if( error == ErrNone && numKept == 0 )
+      error = ErrFail;
+
+   if( error == ErrNone )
+   {
+      newGrammar[newEnd++] = ' ';
+      strcpy( newGrammar + newEnd, cfg + bodyEnd );
+      error = RecompileGrammar( newGrammar );
+   }
+
+   delete [] oldAlt;
+   delete [] alt;
+   delete [] newGrammar;
+
+   return error;
+}
+
+
 //----------------------------------------------------------------
 //  Private CTIesrFlex class function implementation
 
@@ -1065,8 +1770,20 @@ void CTIesrFlex::init( )
    rule[0].name = NULL;
 
 
-   //for lexical analysis - local replacement for yylex
-   cfg_char = cfg;
+   //for lexical analysis - local replacement for yylex.  Text read
+   //from a stream starts with an empty buffer.
+   if( cfg )
+   {
+      cfg_char = cfg;
+      m_lexDone = 1;
+   }
+   else
+   {
+      m_lexBuffer[0] = '\0';
+      m_lexEnd = 0;
+      m_lexDone = m_lexReader ? 0 : 1;
+      cfg_char = m_lexBuffer;
+   }
 
    // For exception handling
    m_parseFail = false;
@@ -1096,9 +1813,14 @@ int CTIesrFlex::yylex( long *yylval )
    // Find next token
    while( true )
    {
-      while( *cfg_char == ' ' || *cfg_char == '\n' || *cfg_char == '\t' )
+      // Have enough text for any token, if reading a stream
+      if( lex_fill( MAX_WORDLEN ) )
+         return 0;
+
+      if( *cfg_char == ' ' || *cfg_char == '\n' || *cfg_char == '\t' )
       {
          cfg_char++;
+         continue;
       }
 
       if( *cfg_char == '\0' )
@@ -1156,10 +1878,22 @@ int CTIesrFlex::yylex( long *yylval )
       else if( myisalpha( (unsigned int) * cfg_char ) || *cfg_char == '-'
               || *cfg_char == '\'' || *cfg_char == '_' )
       {
+         // A word longer than a token fails the parse, as a failed
+         // read of the text does
          while( myisalpha( (unsigned int) * cfg_char ) || *cfg_char == '-'
                  || *cfg_char == '\'' || *cfg_char == '_' )
          {
-            newtoken[ newtokidx++ ] = *cfg_char++;
+            if( newtokidx == MAX_WORDLEN - 1 )
+            {
+               m_lexDone = -1;
+               return 0;
+            }
+
+            newtoken[ newtokidx++ ] = *cfg_char;
+            cfg_char++;
+
+            if( lex_fill( 1 ) )
+               return 0;
          }
 
          newtoken[newtokidx] = '\0';
@@ -1173,11 +1907,9 @@ int CTIesrFlex::yylex( long *yylval )
                     ( ExpandArray( reinterpret_cast<void*> ( token ), sizeof (char*), TOKEN_ALLOC, &m_tokenMax ) );
          }
 
-         tokensave = (char*) malloc( strlen( newtoken ) + 1 );
-         if( !tokensave )
-            throw ( "Token malloc fail in yylex" );
+         // The token string is released with the arena
+         tokensave = (char*) ArenaAlloc( strlen( newtoken ) + 1 );
 
-         // Save the character string pointer in order to free it later
          token[token_idx] = tokensave;
          token_idx++;
 
@@ -1195,6 +1927,46 @@ int CTIesrFlex::yylex( long *yylval )
 }
 
 
+//-------------------------------------------------------------
+// Keep at least aCount characters of the grammar stream in the lexer
+// buffer after cfg_char, moving the characters not yet used to the
+// start of the buffer and reading after them.  Text of a string is
+// all present, so nothing is done.
+//
+
+int CTIesrFlex::lex_fill( int aCount )
+{
+   int remain;
+   int nread;
+
+   if( !m_lexReader || m_lexDone )
+      return m_lexDone < 0;
+
+   remain = m_lexEnd - (int) ( cfg_char - m_lexBuffer );
+   if( remain >= aCount )
+      return 0;
+
+   memmove( m_lexBuffer, cfg_char, remain );
+   m_lexEnd = remain;
+   cfg_char = m_lexBuffer;
+
+   while( m_lexEnd < LEX_BUFFER_SIZE )
+   {
+      nread = m_lexReader( m_lexContext, m_lexBuffer + m_lexEnd,
+              LEX_BUFFER_SIZE - m_lexEnd );
+      if( nread <= 0 )
+      {
+         m_lexDone = nread < 0 ? -1 : 1;
+         break;
+      }
+      m_lexEnd += nread;
+   }
+
+   m_lexBuffer[m_lexEnd] = '\0';
+   return m_lexDone < 0;
+}
+
+
 //-------------------------------------------------------------------------
 // This is the generated grammar string parse function.
 //--------------------------------------------------------------------------
@@ -1954,6 +2726,8 @@ int CTIesrFlex::read_qstbl( char *fname )
    fread( qs_offset, sizeof (int), size, fp );
    fclose( fp );
 
+   m_numQuestions = size;
+
 
    //   for( idx = 0; idx < size; idx++ )
    //   {
@@ -2614,7 +3388,35 @@ void CTIesrFlex::free_codebook( )
       free( qs_offset );
       qs_offset = NULL;
    }
+   m_numQuestions = 0;
+
+   if( m_qsLeft )
+   {
+      free( m_qsLeft );
+      m_qsLeft = NULL;
+   }
+
+   if( m_qsRight )
+   {
+      free( m_qsRight );
+      m_qsRight = NULL;
+   }
+   m_qsWords = 0;
+
+   if( m_leftClass )
+   {
+      free( m_leftClass );
+      m_leftClass = NULL;
+   }
 
+   if( m_rightClass )
+   {
+      free( m_rightClass );
+      m_rightClass = NULL;
+   }
+
+   // Cluster indices are those of the trees freed
+   FreeClusterCache( );
 
    if( tree_base )
    {
@@ -3957,13 +4759,10 @@ void CTIesrFlex::add_hmm_entry( int c, int l, int r )
  ---------------------------------------------------------------------- */
 void CTIesrFlex::create_hmm( )
 {
-   int j;
-   int c, l, r; /* center, left, right */
-   char pron[ MAX_PRON ];
-
    int baseIndex;
-   // char  pronstr[ MAX_STR ];
-   Errors error;
+   int multiIndex;
+   int *multiStart;
+   Errors *errors;
 
    /* hmm[0] is sil */
    add_hmm_entry( SIL_INDEX, SIL_INDEX, SIL_INDEX );
@@ -3971,126 +4770,104 @@ void CTIesrFlex::create_hmm( )
    // Flag indicating multipronunciations exist
    int doMulti = ( word_idx > m_baseWordIndex );
 
-   // Word index for starting of multiple words, which come after the base words
-   // in the word table
-   int multiIndex = m_baseWordIndex;
-
+   // Multipronunciation words come after the base words in the word
+   // table, in the order of their base words.  Find the multipronunciation
+   // words of each base word.
+   multiStart = (int *) malloc( ( m_baseWordIndex + 1 ) * sizeof (int) );
+   errors = (Errors *) malloc( ( m_baseWordIndex + 1 ) * sizeof (Errors) );
+   if( !multiStart || !errors )
+   {
+      free( multiStart );
+      free( errors );
+      demand( 0, "create_hmm: memory allocation failed\n" );
+   }
 
-   // Loop over all base words, getting their pronunciations and triphone hmms
    int silLen = strlen( SIL );
+   int slotLen = strlen( SLOT );
+   multiIndex = m_baseWordIndex;
    for( baseIndex = 0; baseIndex < m_baseWordIndex; baseIndex++ )
    {
+      multiStart[baseIndex] = multiIndex;
 
-      // Handle "_SIL*" words independently.  It is a synonym for the silence model.
-      if( strncmp( word[baseIndex], SIL, silLen ) == 0 )
-      {
-         // The silence model is already in the hmm list as hmm[0]
-         m_wordProns[baseIndex][0] = 1;
-         m_wordProns[baseIndex][1] = SIL_INDEX;
-
+      if( !doMulti || strncmp( word[baseIndex], SIL, silLen ) == 0 ||
+              strncmp( word[baseIndex], SLOT, slotLen ) == 0 )
          continue;
-      }
-
-
-      // Get base pronunciation, which may be the first dictionary pronunciation
-      // or may be the default rule pronunciation
-      //m_dict->GetPron(word[i], pron, pronstr );
-      error = LookupBasePronunciation( word[baseIndex], pron );
-      demand( error == ErrNone, "create_hmm: lookup pronunciation failed\n" );
-
-      //  For OMAP application, do not allow printing of pronunciations
-      /*  if ( print_pron ) {
-       printf("%s\t", word[i]);
-       for ( j = 0; j < pron[0]; j++ ) {
-       printf("%s ", phone[ pron[ j + 1 ] ]);
-       }
-       printf("\n");
-       }
-       */
-
-
-      // Store size of pronunciation of base word indexed by baseIndex
-      m_wordProns[baseIndex][0] = pron[0];
-
-      /* Add hmms making up the word to the hmm[] list */
-      for( j = 0; j < pron[0]; j++ )
-      {
-
-         c = pron[ j + 1 ];
-
-         // If using monophones, set dummy left and right context to -1,
-         // otherwise, set left and right triphone context.
-         if( m_bInputMonophone )
-         {
-            l = SIL_INDEX;
-            r = SIL_INDEX;
-         }
-         else
-         {
-            l = j == 0 ? n_phone : pron[ j ];
-            r = j == ( pron[0] - 1 ) ? n_phone : pron[ j + 2 ];
-         }
 
-         add_hmm_entry( c, l, r );
+      int baseLen = strlen( word[baseIndex] );
+      while( multiIndex < word_idx &&
+              strncmp( word[multiIndex], word[baseIndex], baseLen ) == 0 &&
+              word[multiIndex][baseLen] == '+' &&
+              strchr( word[multiIndex] + baseLen + 1, '+' ) == NULL )
+         multiIndex++;
+   }
+   multiStart[m_baseWordIndex] = multiIndex;
 
-         // Store pronunciation of base word indexed by baseIndex
-         m_wordProns[baseIndex][j + 1] = c;
-      }
 
+   // Look up the pronunciations of all words.  This may be done by
+   // several threads, but the hmm[] list is made in word order, so it
+   // does not depend on the number of threads.
+   try
+   {
+      lookup_prons( multiStart, errors );
 
-      // If multiple pronunciations exist, and there are still more
-      // to process, get any multipronunciations for the base word
-      // that may have been put in the word table
-      if( doMulti && multiIndex < word_idx )
+      // Loop over all base words, adding their triphone hmms and then
+      // those of their multipronunciation words
+      for( baseIndex = 0; baseIndex < m_baseWordIndex; baseIndex++ )
       {
+         // Handle "_SIL*" words independently.  It is a synonym for the
+         // silence model, which is already in the hmm list as hmm[0].
+         // A "_SLOT_*" word is replaced by a slot network in the engine,
+         // and is silence if the slot has no network.
+         if( strncmp( word[baseIndex], SIL, silLen ) == 0 ||
+                 strncmp( word[baseIndex], SLOT, slotLen ) == 0 )
+            continue;
 
-         // Loop over all multipronunciation words that match this word as long as any
-         // multipronunciation words in the word table remain to be processed
-         error = LookupMultiPronunciation( word[baseIndex], word[multiIndex], pron );
-
-         // Check for failure
-         demand( error != ErrFail, "create_hmm: lookup pronunciation failed\n" );
-
+         demand( errors[baseIndex] == ErrNone, "create_hmm: lookup pronunciation failed\n" );
 
-         while( multiIndex < word_idx && error != ErrNoMatch )
-         {
-            // Store size of pronunciation of multi word indexed by multiIndex
-            m_wordProns[multiIndex][0] = pron[0];
-
-
-            /* add to the hmm[] list */
-            for( j = 0; j < pron[0]; j++ )
-            {
+         add_pron_hmms( m_wordProns[baseIndex] );
 
-               c = pron[ j + 1 ];
-
-
-               // If using monophones, set dummy left and right context to -1,
-               // otherwise, set left and right triphone context.
-               if( m_bInputMonophone )
-               {
-                  l = SIL_INDEX;
-                  r = SIL_INDEX;
-               }
-               else
-               {
-                  l = j == 0 ? n_phone : pron[ j ];
-                  r = j == ( pron[0] - 1 ) ? n_phone : pron[ j + 2 ];
-               }
+         for( multiIndex = multiStart[baseIndex];
+                 multiIndex < multiStart[baseIndex + 1]; multiIndex++ )
+            add_pron_hmms( m_wordProns[multiIndex] );
+      }
+   }
+   catch( ... )
+   {
+      free( multiStart );
+      free( errors );
+      throw;
+   }
 
-               add_hmm_entry( c, l, r );
+   free( multiStart );
+   free( errors );
+}
 
-               // Store pronunciation of multi word indexed by multiIndex
-               m_wordProns[multiIndex][j + 1] = c;
-            }
+/* ---------------------------------------------------------------------------
+ add the triphone hmms of a pronunciation to hmm[]
+ ---------------------------------------------------------------------- */
+void CTIesrFlex::add_pron_hmms( const unsigned char *aPron )
+{
+   int j;
+   int c, l, r; /* center, left, right */
 
+   for( j = 0; j < aPron[0]; j++ )
+   {
+      c = aPron[ j + 1 ];
 
-            // Get next matching multipronunciation as long as any remain
-            multiIndex++;
-            if( multiIndex < word_idx )
-               error = LookupMultiPronunciation( word[baseIndex], word[multiIndex], pron );
-         }
+      // If using monophones, set dummy left and right context to -1,
+      // otherwise, set left and right triphone context.
+      if( m_bInputMonophone )
+      {
+         l = SIL_INDEX;
+         r = SIL_INDEX;
       }
+      else
+      {
+         l = j == 0 ? n_phone : aPron[ j ];
+         r = j == ( aPron[0] - 1 ) ? n_phone : aPron[ j + 2 ];
+      }
+
+      add_hmm_entry( c, l, r );
    }
 }
 
@@ -4409,122 +5186,262 @@ int CTIesrFlex::download_gtm( )
 }
 
 
-//-----------------------------------------
+/*----------------------------------------------------------------
+ open_file
 
-int CTIesrFlex::output_int16( FILE *fp, int i32 )
+ Open a grammar file in the directory aDirName, or in memory if
+ aDirName is NULL.  A file in memory opened for writing is created if
+ it does not exist, and emptied if it does.  Returns nonzero if the
+ file can not be opened.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::open_file( GrammarFile *aFile, const char *aDirName,
+        const char *aName, const char *aMode )
 {
-   // output a 16-bit, big endian or little endian to a file,
-   // checking for overflow
-
-   short i16;
-   int failed;
+   char fname[FILENAME_MAX];
+   int f;
 
-   failed = 0;
+   aFile->fp = NULL;
+   aFile->mem = NULL;
+   aFile->pos = 0;
 
-   if( ( i32 != MCODE ) && /* only exception */
-           ( i32 < -32768 || i32 > 65535 ) )
+   if( aDirName )
    {
-      return -1;
+      if( strlen( aDirName ) + strlen( aName ) + 2 > FILENAME_MAX )
+         return FAIL;
+
+      sprintf( fname, "%s/%s", aDirName, aName );
+      aFile->fp = fopen( fname, aMode );
+      return aFile->fp == NULL;
    }
 
-   i16 = i32;
+   for( f = 0; f < m_memFileIdx; f++ )
+   {
+      if( strcmp( m_memFiles[f].name, aName ) == 0 )
+         break;
+   }
 
-   if( little_endian )
+   if( aMode[0] == 'r' )
    {
-      failed |= ( fputc( 0xff & i16, fp ) == EOF );
-      i16 = i16 >> 8;
-      failed |= ( fputc( 0xff & i16, fp ) == EOF );
+      if( f == m_memFileIdx )
+         return FAIL;
    }
    else
    {
-      failed |= ( fputc( ( i16 >> 8 ) & 0xff, fp ) == EOF );
-      failed |= ( fputc( i16 & 0xff, fp ) == EOF );
+      if( f == m_memFileIdx )
+      {
+         if( m_memFileIdx == MAX_MEMFILE ||
+                 strlen( aName ) >= (unsigned int) MEMFILE_NAME_SIZE )
+            return FAIL;
+
+         strcpy( m_memFiles[f].name, aName );
+         m_memFiles[f].data = NULL;
+         m_memFiles[f].max = 0;
+         m_memFileIdx++;
+      }
+      m_memFiles[f].size = 0;
    }
 
-   return failed;
+   aFile->mem = &m_memFiles[f];
+   return OK;
 }
 
 
-//------------------------------------------------
+//-----------------------------------------
 
-int CTIesrFlex::output_sym( FILE *fp, int hmm_code, int word_code, int n_next, int *next )
+int CTIesrFlex::write_file( GrammarFile *aFile, const void *aData, unsigned int aSize )
 {
-   // output one symbol
-   int i;
+   MemFile *mem = aFile->mem;
+   unsigned char *data;
+   unsigned int max;
 
-   // track if output_sym fails
-   int failed = false;
-
-   failed |= output_int16( fp, hmm_code );
+   if( aFile->fp )
+      return fwrite( aData, 1, aSize, aFile->fp ) != aSize;
 
-   i = word_code == MCODE ? n_next : n_next | 0x8000;
-   failed |= output_int16( fp, i );
+   if( !mem )
+      return FAIL;
 
-   for( i = 0; i < n_next; i++ )
+   // Grow the file by doubling, so writing a file a short at a time
+   // copies it only a few times
+   if( aFile->pos + aSize > mem->max )
    {
-      failed |= output_int16( fp, next[i] );
-   }
+      max = mem->max ? mem->max : 1024;
+      while( max < aFile->pos + aSize )
+         max *= 2;
 
-   if( word_code != MCODE )
-   {
-      failed |= output_int16( fp, word_code );
+      data = (unsigned char*) realloc( mem->data, max );
+      if( !data )
+         return FAIL;
+
+      mem->data = data;
+      mem->max = max;
    }
 
-   return failed;
+   memcpy( mem->data + aFile->pos, aData, aSize );
+   aFile->pos += aSize;
+   if( aFile->pos > mem->size )
+      mem->size = aFile->pos;
+
+   return OK;
+}
+
+
+//-----------------------------------------
+
+unsigned int CTIesrFlex::read_file( GrammarFile *aFile, void *aData, unsigned int aSize )
+{
+   MemFile *mem = aFile->mem;
+
+   if( aFile->fp )
+      return fread( aData, 1, aSize, aFile->fp );
+
+   if( !mem )
+      return 0;
+
+   if( aSize > mem->size - aFile->pos )
+      aSize = mem->size - aFile->pos;
+
+   memcpy( aData, mem->data + aFile->pos, aSize );
+   aFile->pos += aSize;
+   return aSize;
+}
+
+
+//-----------------------------------------
+
+void CTIesrFlex::close_file( GrammarFile *aFile )
+{
+   if( aFile->fp )
+      fclose( aFile->fp );
+
+   aFile->fp = NULL;
+   aFile->mem = NULL;
+}
+
+
+//-----------------------------------------
+
+void CTIesrFlex::FreeMemFiles( )
+{
+   int f;
+
+   for( f = 0; f < m_memFileIdx; f++ )
+      free( m_memFiles[f].data );
+
+   m_memFileIdx = 0;
+}
+
+
+//-----------------------------------------
+
+int CTIesrFlex::output_int16( GrammarFile *fp, int i32 )
+{
+   // output a 16-bit, big endian or little endian to a file,
+   // checking for overflow
+
+   short i16;
+   unsigned char bytes[2];
+
+   if( ( i32 != MCODE ) && /* only exception */
+           ( i32 < -32768 || i32 > 65535 ) )
+   {
+      return -1;
+   }
+
+   i16 = i32;
+
+   if( little_endian )
+   {
+      bytes[0] = 0xff & i16;
+      bytes[1] = 0xff & ( i16 >> 8 );
+   }
+   else
+   {
+      bytes[0] = ( i16 >> 8 ) & 0xff;
+      bytes[1] = i16 & 0xff;
+   }
+
+   return write_file( fp, bytes, 2 );
+}
+
+
+//------------------------------------------------
+
+int CTIesrFlex::output_sym( GrammarFile *fp, int hmm_code, int word_code, int n_next, int *next )
+{
+   // output one symbol
+   int i;
+
+   // track if output_sym fails
+   int failed = false;
+
+   failed |= output_int16( fp, hmm_code );
+
+   i = word_code == MCODE ? n_next : n_next | 0x8000;
+   failed |= output_int16( fp, i );
+
+   for( i = 0; i < n_next; i++ )
+   {
+      failed |= output_int16( fp, next[i] );
+   }
+
+   if( word_code != MCODE )
+   {
+      failed |= output_int16( fp, word_code );
+   }
+
+   return failed;
 }
 
 
 //-------------------------------------
 
-int CTIesrFlex::output_net( char *dirname, char *filename )
+int CTIesrFlex::output_net( const char *dirname, const char *filename,
+        const char *wordfilename, const int *aHmmMap, int aHmmCount )
 {
-   // This function outputs the wordlist and the grammar network
+   // This function outputs the wordlist and the grammar network.  If
+   // aHmmMap is not NULL, the network indexes the aHmmCount hmms of a
+   // model pool, and aHmmMap gives the pool index of each hmm.
 
    int i;
    short cnt = 0;
-   FILE *fp;
-   char fname[FILENAME_MAX];
+   GrammarFile file;
+   GrammarFile *fp = &file;
 
    // track any failure to write correctly
    int failed = false;
 
 
    //output wordlist
-   strcpy( fname, dirname );
-   strcat( fname, "/word.lis" );
-
-   fp = fopen( fname, "w" );
-   if( fp == NULL )
+   if( open_file( fp, dirname, wordfilename, "w" ) )
       return -1;
 
    for( i = 0; i < word_idx; i++ )
    {
       /* loop thru all words */
-      failed |= ( fprintf( fp, "%s\n", word[i] ) < 0 );
+      failed |= write_file( fp, word[i], strlen( word[i] ) );
+      failed |= write_file( fp, "\n", 1 );
    }
 
-   fclose( fp );
+   close_file( fp );
 
    if( failed )
       return failed;
 
 
    // output net
-   strcpy( fname, dirname );
-   //   strcat( fname, "/net.bin" );
-   strcat( fname, filename );
-
-   fp = fopen( fname, "wb" );
-   if( fp == NULL )
+   if( open_file( fp, dirname, filename, "wb" ) )
       return -1;
 
 
    failed |= output_int16( fp, cnt ); // # of short, dummy, fill at end
-   failed |= output_int16( fp, hmm_idx * m_inputSets ); // n_hmm for all genders
+   if( !aHmmMap )
+      aHmmCount = hmm_idx;
+
+   failed |= output_int16( fp, aHmmCount * m_inputSets ); // n_hmm for all genders
    failed |= output_int16( fp, sym_idx ); // n_sym
    failed |= output_int16( fp, word_idx ); // n_word
    failed |= output_int16( fp, m_inputSets ); // n_set
-   failed |= output_int16( fp, hmm_idx ); // n_hmm_set
+   failed |= output_int16( fp, aHmmCount ); // n_hmm_set
 
    cnt = 5 + /* 5 n_* */
            2 + /* offset pointer to start and stop */
@@ -4554,7 +5471,8 @@ int CTIesrFlex::output_net( char *dirname, char *filename )
 
    for( i = 0; i < sym_idx; i++ )
    { /* all */
-      failed |= output_sym( fp, sym[i].hmm, sym[i].word, sym[i].n_next, sym[i].next );
+      failed |= output_sym( fp, aHmmMap ? aHmmMap[ sym[i].hmm ] : sym[i].hmm,
+              sym[i].word, sym[i].n_next, sym[i].next );
    }
 
    rewind( fp );
@@ -4562,7 +5480,7 @@ int CTIesrFlex::output_net( char *dirname, char *filename )
 
    //net_size = cnt;
 
-   fclose( fp );
+   close_file( fp );
 
    return failed;
 
@@ -4571,32 +5489,111 @@ int CTIesrFlex::output_net( char *dirname, char *filename )
 
 //---------------------------------------------
 
-int CTIesrFlex::output_hmm2phone( char *dirname )
+int CTIesrFlex::output_hmm2phone( const char *dirname )
 {
    // output HMM to phone map
 
-   FILE *fp;
+   GrammarFile fp;
    int i;
-   char fname[FILENAME_MAX];
 
    // track any failure to write correctly
    int failed = false;
 
-   strcpy( fname, dirname );
-   strcat( fname, "/hmm2phone.bin" );
-
-   fp = fopen( fname, "wb" );
-   if( fp == NULL )
+   if( open_file( &fp, dirname, "hmm2phone.bin", "wb" ) )
       return -1;
 
    for( i = 0; i < hmm_idx; i++ )
-      failed |= output_int16( fp, hmm[ i ].c );
+      failed |= output_int16( &fp, hmm[ i ].c );
 
-   fclose( fp );
+   close_file( &fp );
+
+   return failed;
+}
+
+/*----------------------------------------------------------------
+ output_models
+
+ Output the model files of the grammar, or of a model pool if aPool is
+ set, converting means and variances to byte as requested.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::output_models( const char *aDirName, int aByteMeans, int aByteVars,
+        int aPool )
+{
+   int failed;
+
+   failed = output_gtm( aDirName, aPool );
+   if( failed )
+      return failed;
+
+
+   // If input mean or variance are in short, and output is requesting
+   // byte, then convert to byte.
+   if( ( !m_bInputByteMeans && aByteMeans ) ||
+           ( !m_bInputByteVars && aByteVars ) )
+   {
+      // Note: bias has already been added to short mean vectors in the file
+      failed = model_bit_16_to_8( aDirName, aDirName, true, 0, aByteMeans, aByteVars );
+   }
+   if( failed )
+      return failed;
+
+
+   // Output the configuration file for the models, which specifies
+   // the type of mean and variance vectors, byte or short, and
+   // the endian of the data.
+   failed = output_config( aDirName, aByteMeans, aByteVars );
+   if( failed )
+      return failed;
+
+
+#ifdef OFFLINE_CLS
+   SaveVQHMM( aDirName );
+#endif
+
+   return failed;
+}
+
+
+/*----------------------------------------------------------------
+ output_pool_name
+
+ Output the file naming the model pool directory of a grammar, and
+ remove the hmm and model files of any prior output from the grammar
+ directory, since the engine reads a file from the pool only if the
+ grammar directory does not hold it.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::output_pool_name( const char *aDirName, const char *aPoolDir )
+{
+   static const char * const poolFiles[] = { "hmm.bin", "hmm2phone.bin",
+      "mu.bin", "var.bin", "tran.bin", "pdf.bin", "mixture.bin", "gconst.bin",
+      "dim.bin", "scale.bin", "config.bin", "o2amidx.bin", "vqcentr.bin" };
+   const int nPoolFiles = sizeof (poolFiles) / sizeof (poolFiles[0]);
+
+   char fname[FILENAME_MAX];
+   GrammarFile fp;
+   int f;
+   int failed;
+
+   for( f = 0; f < nPoolFiles; f++ )
+   {
+      if( strlen( aDirName ) + strlen( poolFiles[f] ) + 2 > FILENAME_MAX )
+         return FAIL;
+
+      sprintf( fname, "%s/%s", aDirName, poolFiles[f] );
+      remove( fname );
+   }
+
+   if( open_file( &fp, aDirName, MODEL_POOL_FILE, "wb" ) )
+      return FAIL;
+
+   failed = write_file( &fp, aPoolDir, strlen( aPoolDir ) );
+   failed |= write_file( &fp, "\n", 1 );
+   close_file( &fp );
 
    return failed;
 }
 
+
 /*----------------------------------------------------------------
  output_gtm
 
@@ -4612,14 +5609,18 @@ int CTIesrFlex::output_hmm2phone( char *dirname )
  possibility of either set-independent or set-dependent transition
  matrices.
 
+ If aPool is set, the files of a model pool are output instead.  The
+ pool holds the hmms and models of the grammar, and its poolmap.bin
+ maps the input models to their places in the pool, so that the
+ network of each grammar output with the pool can index its hmms.
+
  ----------------------------------------------------------------*/
-int CTIesrFlex::output_gtm( char *dirname )
+int CTIesrFlex::output_gtm( const char *dirname, int aPool )
 {
    // Output all of the generalized tied HMM model information for this grammar
 
    int i, j, offset, n_state;
    short *pshort;
-   char buf[ FILENAME_MAX ];
    int tempidx;
 
    short *cluster = NULL;
@@ -4634,13 +5635,25 @@ int CTIesrFlex::output_gtm( char *dirname )
    // Transition set offset
    int tranSetOffset;
 
-   FILE* fp_scale;
+   GrammarFile fp_scale;
    int scaleIndex;
 
+   // GTM files, closed at the end whether output succeeds or not
+   GrammarFile * const gtmFiles[] = { &fp_hmm, &fp_mean, &fp_var, &fp_tran,
+      &fp_pdf, &fp_mixture, &fp_gconst };
+   const int nGtmFiles = sizeof (gtmFiles) / sizeof (gtmFiles[0]);
+
    // track failure to write gtm files
    int failed = false;
 
 
+   for( i = 0; i < nGtmFiles; i++ )
+   {
+      gtmFiles[i]->fp = NULL;
+      gtmFiles[i]->mem = NULL;
+   }
+
+
    // Initialize output array data indices
    mean_idx_cnt = 0;
 
@@ -4703,63 +5716,42 @@ int CTIesrFlex::output_gtm( char *dirname )
     open GTM files
     -------------------------------------------------- */
 
-   strcpy( buf, dirname );
-   strcat( buf, "/hmm.bin" );
-   fp_hmm = fopen( buf, "wb" );
-   failed = ( fp_hmm == NULL );
-   failed |= output_int16( fp_hmm, 0 ); /* # of short, dummy */
+   failed |= open_file( &fp_hmm, dirname, "hmm.bin", "wb" );
+   failed |= output_int16( &fp_hmm, 0 ); /* # of short, dummy */
 
 
    /* Was for male & female.  Now for each HMM set. */
    for( i = 0; i < hmm_idx * m_inputSets; i++ )
    {
       // Will eventually be offset in hmm.bin to each hmm's info
-      failed |= output_int16( fp_hmm, 0 ); /* offset, dummy */
+      failed |= output_int16( &fp_hmm, 0 ); /* offset, dummy */
    }
    if( failed ) goto failure;
 
 
-   strcpy( buf, dirname );
-   strcat( buf, "/mu.bin" );
-   fp_mean = fopen( buf, "wb" );
-   failed |= ( fp_mean == NULL );
-   failed |= output_int16( fp_mean, mean_idx_cnt ); /* dummy */
+   failed |= open_file( &fp_mean, dirname, "mu.bin", "wb" );
+   failed |= output_int16( &fp_mean, mean_idx_cnt ); /* dummy */
    if( failed ) goto failure;
 
 
-   strcpy( buf, dirname );
-   strcat( buf, "/var.bin" );
-   fp_var = fopen( buf, "wb" );
-   failed |= ( fp_var == NULL );
-   failed |= output_int16( fp_var, var_idx_cnt ); /* dummy */
+   failed |= open_file( &fp_var, dirname, "var.bin", "wb" );
+   failed |= output_int16( &fp_var, var_idx_cnt ); /* dummy */
    if( failed ) goto failure;
 
 
-   strcpy( buf, dirname );
-   strcat( buf, "/tran.bin" );
-   fp_tran = fopen( buf, "wb" );
-   failed |= ( fp_tran == NULL );
-   failed |= output_int16( fp_tran, 0 ); /* dummy */
+   failed |= open_file( &fp_tran, dirname, "tran.bin", "wb" );
+   failed |= output_int16( &fp_tran, 0 ); /* dummy */
    if( failed ) goto failure;
 
-   strcpy( buf, dirname );
-   strcat( buf, "/pdf.bin" );
-   fp_pdf = fopen( buf, "wb" );
-   failed |= ( fp_pdf == NULL );
+   failed |= open_file( &fp_pdf, dirname, "pdf.bin", "wb" );
    if( failed ) goto failure;
 
-   strcpy( buf, dirname );
-   strcat( buf, "/mixture.bin" );
-   fp_mixture = fopen( buf, "wb" );
-   failed |= ( fp_mixture == NULL );
-   failed |= output_int16( fp_mixture, 0 ); /* dummy */
+   failed |= open_file( &fp_mixture, dirname, "mixture.bin", "wb" );
+   failed |= output_int16( &fp_mixture, 0 ); /* dummy */
    if( failed ) goto failure;
 
-   strcpy( buf, dirname );
-   strcat( buf, "/gconst.bin" );
-   fp_gconst = fopen( buf, "wb" );
-   failed |= ( fp_gconst == NULL );
-   failed |= output_int16( fp_gconst, var_idx_cnt ); /* dummy */
+   failed |= open_file( &fp_gconst, dirname, "gconst.bin", "wb" );
+   failed |= output_int16( &fp_gconst, var_idx_cnt ); /* dummy */
    if( failed ) goto failure;
 
 
@@ -4770,18 +5762,15 @@ int CTIesrFlex::output_gtm( char *dirname )
    // scale file will be output again after the conversion.
    if( m_bInputByteMeans || m_bInputByteVars )
    {
-      strcpy( buf, dirname );
-      strcat( buf, "/scale.bin" );
-      fp_scale = fopen( buf, "wb" );
-      failed |= ( fp_scale == NULL );
+      failed |= open_file( &fp_scale, dirname, "scale.bin", "wb" );
       if( failed ) goto failure;
 
 
       for( scaleIndex = 0; scaleIndex < 2 * m_inputFeatDim; scaleIndex++ )
       {
-         failed |= output_int16( fp_scale, scale_base[scaleIndex] );
+         failed |= output_int16( &fp_scale, scale_base[scaleIndex] );
       }
-      fclose( fp_scale );
+      close_file( &fp_scale );
       if( failed ) goto failure;
    }
 
@@ -4840,9 +5829,9 @@ int CTIesrFlex::output_gtm( char *dirname )
     output pdf (mixture, cluster) offset
     -------------------------------------------------- */
 
-   failed |= output_int16( fp_pdf, cluster_idx_cnt );
+   failed |= output_int16( &fp_pdf, cluster_idx_cnt );
    for( i = 0; i < cluster_idx_cnt; i++ )
-      failed |= output_int16( fp_pdf, cluster_offset[ i ] );
+      failed |= output_int16( &fp_pdf, cluster_offset[ i ] );
 
    if( failed ) goto failure;
 
@@ -4851,58 +5840,63 @@ int CTIesrFlex::output_gtm( char *dirname )
     -------------------------------------------------- */
 
    // Size in number of mean vectors
-   rewind( fp_mean );
-   failed |= output_int16( fp_mean, mean_idx_cnt );
+   rewind( &fp_mean );
+   failed |= output_int16( &fp_mean, mean_idx_cnt );
 
    // Size in number of variance vectors
-   rewind( fp_var );
-   failed |= output_int16( fp_var, var_idx_cnt );
+   rewind( &fp_var );
+   failed |= output_int16( &fp_var, var_idx_cnt );
 
    // Size in number of gconst values (same as number of variance vectors)
-   rewind( fp_gconst );
-   failed |= output_int16( fp_gconst, var_idx_cnt );
+   rewind( &fp_gconst );
+   failed |= output_int16( &fp_gconst, var_idx_cnt );
 
    // Size of data in int
-   rewind( fp_mixture );
-   failed |= output_int16( fp_mixture, cluster_offset[ cluster_idx_cnt ] );
+   rewind( &fp_mixture );
+   failed |= output_int16( &fp_mixture, cluster_offset[ cluster_idx_cnt ] );
 
    // Size of data in int
-   rewind( fp_tran );
-   failed |= output_int16( fp_tran, tran_offset[ tran_idx_cnt ] );
+   rewind( &fp_tran );
+   failed |= output_int16( &fp_tran, tran_offset[ tran_idx_cnt ] );
 
    // Size of data in int
-   rewind( fp_hmm );
-   failed |= output_int16( fp_hmm, hmm_offset[ hmm_idx * m_inputSets ] );
+   rewind( &fp_hmm );
+   failed |= output_int16( &fp_hmm, hmm_offset[ hmm_idx * m_inputSets ] );
 
    // Output offsets to each hmm in the output hmm binary file
    for( i = 0; i < hmm_idx * m_inputSets; i++ )
    {
-      failed |= output_int16( fp_hmm, hmm_offset[i] );
+      failed |= output_int16( &fp_hmm, hmm_offset[i] );
    }
 
 
    // dim.bin holds the
    // number of static mfcc elements in the feature vector.
-   FILE *fp;
-   strcpy( buf, dirname );
-   strcat( buf, "/dim.bin" );
-   fp = fopen( buf, "wb" );
-   failed |= ( fp == NULL );
-   failed |= output_int16( fp, m_inputStaticDim );
-   fclose( fp );
+   GrammarFile fp;
+   if( open_file( &fp, dirname, "dim.bin", "wb" ) )
+      failed = true;
+   else
+   {
+      failed |= output_int16( &fp, m_inputStaticDim );
+      close_file( &fp );
+   }
 
 #ifdef OFFLINE_CLS
    /* save RAM mean to ROM mean index mapping */
-   strcpy( buf, dirname );
-   strcat( buf, "/o2amidx.bin" );
-   fp = fopen( buf, "wb" );
-   failed |= ( fp == NULL );
-   failed |= output_int16( fp, mean_idx_cnt - 1 );
-   for( i = 0; i < mean_idx_cnt; i++ )
-      failed |= output_int16( fp, mean_idx[i] );
-   fclose( fp );
+   if( open_file( &fp, dirname, "o2amidx.bin", "wb" ) )
+      failed = true;
+   else
+   {
+      failed |= output_int16( &fp, mean_idx_cnt - 1 );
+      for( i = 0; i < mean_idx_cnt; i++ )
+         failed |= output_int16( &fp, mean_idx[i] );
+      close_file( &fp );
+   }
 #endif
 
+   if( aPool && !failed )
+      failed |= output_pool_map( dirname );
+
 
 failure:
 
@@ -4910,13 +5904,8 @@ failure:
     close files
     -------------------------------------------------- */
 
-   fclose( fp_hmm );
-   fclose( fp_mean );
-   fclose( fp_var );
-   fclose( fp_tran );
-   fclose( fp_pdf );
-   fclose( fp_mixture );
-   fclose( fp_gconst );
+   for( i = 0; i < nGtmFiles; i++ )
+      close_file( gtmFiles[i] );
 
    // Free the hmm_offset data
    if( hmm_offset )
@@ -4947,113 +5936,422 @@ failure:
 }
 
 
-//-------------------------------
-
-int CTIesrFlex::process_one_hmm( int n_state, int idx, short *cluster )
+/*----------------------------------------------------------------
+ output_pool_map
+
+ Output poolmap.bin of a model pool.  It holds the number of input
+ transition matrices and pdf clusters, then the offset in the pool
+ tran.bin of each input transition matrix, and the index in the pool
+ pdf.bin of each input cluster, or -1 for those not in the pool.  Then
+ follow the number of hmms of each set of the pool, and the contents of
+ the pool hmm.bin, as pool_hmm_data gives them.  Only TIesrFlex reads
+ it, so it is in the byte order of the machine.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::output_pool_map( const char *dirname )
 {
+   GrammarFile fp;
+   int i;
+   int* poolTran;
+   int* data = NULL;
+   int failed;
 
-   int i, offset, size;
-   int old_cnt; /* if add to idx list, update offset */
-   int new_idx;
-   short *pshort;
-
-   // track any failure
-   int failed = false;
-
-   /* --------------------------------------------------
-    transition
-    -------------------------------------------------- */
-
-   offset = tranoffset_base[ idx ];
-   pshort = &tran_base[ offset ];
-
-   //demand( n_state == *pshort, "Error: tran dim mismatch\n");
-   failed |= !( n_state == *pshort );
-   if( failed ) return failed;
+   poolTran = (int*) malloc( m_numTrans * sizeof (int) );
+   if( !poolTran )
+      return FAIL;
 
-   old_cnt = tran_idx_cnt;
+   for( i = 0; i < m_numTrans; i++ )
+      poolTran[i] = tran_idx_aug[i] == -1 ? -1 : tran_offset[ tran_idx_aug[i] ];
 
-   if( tran_idx_aug[ idx ] == -1 )
+   if( pool_hmm_data( poolTran, cluster_idx_aug, &data ) != ErrNone ||
+           open_file( &fp, dirname, POOL_MAP_FILE, "wb" ) )
    {
-      new_idx = tran_idx_cnt;
-      tran_idx_cnt++;
-      tran_idx_aug[ idx ] = new_idx;
+      free( poolTran );
+      free( data );
+      return FAIL;
    }
-   else
-      new_idx = tran_idx_aug[ idx ];
-
 
-   if( tran_idx_cnt > old_cnt )
-   { /* add, update offset */
+   failed = write_file( &fp, &m_numTrans, sizeof (int) );
+   failed |= write_file( &fp, &m_numClusters, sizeof (int) );
+   failed |= write_file( &fp, poolTran, m_numTrans * sizeof (int) );
+   failed |= write_file( &fp, cluster_idx_aug, m_numClusters * sizeof (int) );
+   failed |= write_file( &fp, &hmm_idx, sizeof (int) );
+   failed |= write_file( &fp, data, ( data[0] + 1 ) * sizeof (int) );
 
-      size = n_state * n_state; /* transition matrix size */
+   close_file( &fp );
+   free( poolTran );
+   free( data );
+   return failed;
+}
 
-      /* output */
 
-      failed |= output_int16( fp_tran, n_state );
-      for( i = 1; i < size; i++ )
-         failed |= output_int16( fp_tran, (int) tran_base[ offset + i ] );
+/*----------------------------------------------------------------
+ pool_hmm_data
+
+ Find the contents of hmm.bin for the hmms of the grammar, with the
+ transition offsets and pdf indices of a model pool given by the map
+ of each input transition matrix and cluster to the pool.  aData[0] is
+ the size of the hmm data, aData[1..] the offset of each hmm and then
+ the transition offset and a pdf index per emitting state of each hmm,
+ as output_gtm outputs them.  ErrNoMatch is returned if the pool does
+ not hold a model of the grammar.  aData is freed by the caller.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::pool_hmm_data( const int *aPoolTran,
+        const int *aPoolCluster, int **aData )
+{
+   int i, j, n_state;
+   int tranIdx;
+   int tempidx;
+   int hmmSet;
+   int nHmms;
+   int maxData;
+   int size;
+   int* data;
 
+   Errors error = ErrNone;
 
-      /* update offset for next tran entry.  The last entry in the tran_offset
-       array points to just past the location of the transitions. */
-      tran_offset[ tran_idx_cnt ] = tran_offset[ old_cnt ] + size;
-   }
+   nHmms = hmm_idx * m_inputSets;
+   maxData = nHmms + 1 + nHmms *
+           ( sil_n_state > m_maxStates + 1 ? sil_n_state : m_maxStates + 1 );
 
-   /* --------------------------------------------------
-    hmm
-    -------------------------------------------------- */
+   data = (int*) malloc( maxData * sizeof (int) );
+   *aData = data;
+   if( !data )
+      return ErrMemory;
 
-   failed |= output_int16( fp_hmm, (int) tran_offset[ new_idx ] ); /* tran offset */
+   size = nHmms;
 
-   for( i = 0; i < n_state - 1; i++ )
+   for( hmmSet = 0; hmmSet < m_inputSets && error == ErrNone; hmmSet++ )
    {
-
-      old_cnt = cluster_idx_cnt;
-
-      if( cluster_idx_aug[ (int) cluster[i] ] == -1 )
-      {
-
-         new_idx = cluster_idx_cnt;
-         cluster_idx_cnt++;
-
-         cluster_idx_aug[ (int) cluster[i] ] = new_idx;
-      }
-      else
-         new_idx = cluster_idx_aug[ (int) cluster[i] ];
-
-      if( cluster_idx_cnt > old_cnt )
+      for( i = 0; i < hmm_idx && error == ErrNone; i++ )
       {
-
-         offset = clusteroffset_base[ cluster[i] ];
-
-         if( m_bPackWtNmix == 1 )
+         /* first hmm of each set is silence */
+         if( i == 0 )
          {
-            size = (int) ( 0xff & cluster_base[ offset ] ); /* n_mix */
+            n_state = sil_n_state;
+            tranIdx = sil_hmm[ sil_n_state - 1 ];
          }
-
          else
          {
-            size = cluster_base[ offset ];
-
+            tranIdx = m_bInputGDTrans ? hmm[i].c * m_inputSets + hmmSet : hmm[i].c;
+            n_state = (int) tran_base[ tranoffset_base[ tranIdx ] ];
          }
 
-         size = size * 3 + 1;
+         data[ 1 + hmmSet * hmm_idx + i ] = size;
 
-         /* output */
+         if( aPoolTran[ tranIdx ] == -1 )
+            error = ErrNoMatch;
+         data[ 1 + size++ ] = aPoolTran[ tranIdx ]; /* tran offset */
 
-         failed |= process_one_cluster( (int) cluster[i] );
-         if( failed ) return failed;
-
-         /* update offset for next cluster entry (i.e. mixture, pdf) */
+         for( j = 0; j < n_state - 1 && error == ErrNone; j++ )
+         {
+            if( i == 0 )
+               tempidx = sil_hmm[j];
+            else if( get_cluster_idx( hmm[i].c, hmm[i].l, hmm[i].r, j,
+                    hmmSet, &tempidx ) )
+            {
+               error = ErrFail;
+               break;
+            }
 
-         cluster_offset[ cluster_idx_cnt ] = cluster_offset[ old_cnt ] + size;
+            if( aPoolCluster[ tempidx ] == -1 )
+               error = ErrNoMatch;
+            data[ 1 + size++ ] = aPoolCluster[ tempidx ]; /* pdf_idx */
+         }
       }
-
-      failed |= output_int16( fp_hmm, new_idx ); /* pdf_idx */
    }
 
-   return failed;
+   data[0] = size;
+   return error;
+}
+
+
+/*----------------------------------------------------------------
+ pool_hmm_map
+
+ Map each hmm of the grammar to the hmm of the model pool in aPoolDir
+ that has the same transition matrix and pdfs in every hmm set, so
+ that the grammar network can index the hmms of the pool.  The pool
+ hmms are read from its poolmap.bin.  ErrNoMatch is returned if the
+ pool is of another language or does not hold a hmm of the grammar.
+ aHmmMap is freed by the caller.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::pool_hmm_map( const char *aPoolDir, int **aHmmMap,
+        int *aPoolHmmCount )
+{
+   int i, p, hmmSet;
+   int counts[2];
+   int poolHmms;
+   int poolSize;
+   int size;
+   int* poolTran = NULL;
+   int* poolCluster = NULL;
+   int* poolData = NULL;
+   int* data = NULL;
+   int* map = NULL;
+   GrammarFile fp;
+
+   Errors error = ErrNone;
+   int failed = false;
+
+   *aHmmMap = NULL;
+   *aPoolHmmCount = 0;
+
+
+   // Map of input models to the pool
+   if( open_file( &fp, aPoolDir, POOL_MAP_FILE, "rb" ) )
+      return ErrFail;
+
+   if( read_file( &fp, counts, sizeof (counts) ) != sizeof (counts) ||
+           counts[0] != m_numTrans || counts[1] != m_numClusters )
+   {
+      close_file( &fp );
+      return ErrNoMatch;
+   }
+
+   poolTran = (int*) malloc( m_numTrans * sizeof (int) );
+   poolCluster = (int*) malloc( m_numClusters * sizeof (int) );
+   if( !poolTran || !poolCluster )
+   {
+      close_file( &fp );
+      error = ErrMemory;
+      goto failure;
+   }
+
+   failed = read_file( &fp, poolTran, m_numTrans * sizeof (int) ) !=
+           m_numTrans * sizeof (int);
+   failed |= read_file( &fp, poolCluster, m_numClusters * sizeof (int) ) !=
+           m_numClusters * sizeof (int);
+   failed |= read_file( &fp, &poolHmms, sizeof (int) ) != sizeof (int);
+   failed |= read_file( &fp, &poolSize, sizeof (int) ) != sizeof (int);
+   if( !failed )
+   {
+      poolData = (int*) malloc( ( poolSize + 1 ) * sizeof (int) );
+      failed = !poolData;
+   }
+   if( !failed )
+   {
+      poolData[0] = poolSize;
+      failed = read_file( &fp, poolData + 1, poolSize * sizeof (int) ) !=
+              poolSize * sizeof (int);
+   }
+   close_file( &fp );
+   if( failed )
+   {
+      error = ErrFail;
+      goto failure;
+   }
+
+
+   // The hmms of the grammar indexing the models of the pool
+   error = pool_hmm_data( poolTran, poolCluster, &data );
+   if( error != ErrNone )
+      goto failure;
+
+   map = (int*) malloc( hmm_idx * sizeof (int) );
+   if( !map )
+   {
+      error = ErrMemory;
+      goto failure;
+   }
+
+
+   // Each hmm of the grammar must be a hmm of the pool in every set.
+   // An hmm is the data from its offset to the offset of the next hmm.
+   for( i = 0; i < hmm_idx && error == ErrNone; i++ )
+   {
+      for( p = 0; p < poolHmms; p++ )
+      {
+         for( hmmSet = 0; hmmSet < m_inputSets; hmmSet++ )
+         {
+            int k = hmmSet * hmm_idx + i;
+            int q = hmmSet * poolHmms + p;
+            int start = data[ 1 + k ];
+            int poolStart = poolData[ 1 + q ];
+
+            size = ( k + 1 < hmm_idx * m_inputSets ? data[ 2 + k ] : data[0] ) - start;
+            if( size != ( q + 1 < poolHmms * m_inputSets ?
+                    poolData[ 2 + q ] : poolData[0] ) - poolStart ||
+                    memcmp( data + 1 + start, poolData + 1 + poolStart,
+                    size * sizeof (int) ) != 0 )
+            {
+               break;
+            }
+         }
+
+         if( hmmSet == m_inputSets )
+            break;
+      }
+
+      if( p == poolHmms )
+         error = ErrNoMatch;
+      map[i] = p;
+   }
+
+   if( error != ErrNone )
+      goto failure;
+
+   *aHmmMap = map;
+   *aPoolHmmCount = poolHmms;
+   map = NULL;
+
+failure:
+   free( poolTran );
+   free( poolCluster );
+   free( poolData );
+   free( data );
+   free( map );
+
+   return error;
+}
+
+
+//-------------------------------
+
+int CTIesrFlex::process_one_hmm( int n_state, int idx, short *cluster )
+{
+
+   int i;
+   int new_idx;
+
+   // track any failure
+   int failed = false;
+
+   /* --------------------------------------------------
+    transition
+    -------------------------------------------------- */
+
+   //demand( n_state == *pshort, "Error: tran dim mismatch\n");
+   failed |= !( n_state == tran_base[ tranoffset_base[ idx ] ] );
+   if( failed ) return failed;
+
+   failed |= add_tran( idx, &new_idx );
+   if( failed ) return failed;
+
+   /* --------------------------------------------------
+    hmm
+    -------------------------------------------------- */
+
+   failed |= output_int16( &fp_hmm, (int) tran_offset[ new_idx ] ); /* tran offset */
+
+   for( i = 0; i < n_state - 1; i++ )
+   {
+      failed |= add_cluster( (int) cluster[i], &new_idx );
+      if( failed ) return failed;
+
+      failed |= output_int16( &fp_hmm, new_idx ); /* pdf_idx */
+   }
+
+   return failed;
+}
+
+
+/*----------------------------------------------------------------
+ add_tran
+
+ Output the transition matrix idx of the input models to tran.bin, if
+ it is not already output, and give its index in the output.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::add_tran( int idx, int *aNewIdx )
+{
+   int i, offset, size, n_state;
+   int old_cnt; /* if add to idx list, update offset */
+
+   // track any failure
+   int failed = false;
+
+   offset = tranoffset_base[ idx ];
+   n_state = (int) tran_base[ offset ];
+
+   old_cnt = tran_idx_cnt;
+
+   if( tran_idx_aug[ idx ] == -1 )
+   {
+      *aNewIdx = tran_idx_cnt;
+      tran_idx_cnt++;
+      tran_idx_aug[ idx ] = *aNewIdx;
+   }
+   else
+      *aNewIdx = tran_idx_aug[ idx ];
+
+
+   if( tran_idx_cnt > old_cnt )
+   { /* add, update offset */
+
+      size = n_state * n_state; /* transition matrix size */
+
+      /* output */
+
+      failed |= output_int16( &fp_tran, n_state );
+      for( i = 1; i < size; i++ )
+         failed |= output_int16( &fp_tran, (int) tran_base[ offset + i ] );
+
+
+      /* update offset for next tran entry.  The last entry in the tran_offset
+       array points to just past the location of the transitions. */
+      tran_offset[ tran_idx_cnt ] = tran_offset[ old_cnt ] + size;
+   }
+
+   return failed;
+}
+
+
+/*----------------------------------------------------------------
+ add_cluster
+
+ Output the pdf cluster aCluster of the input models to mixture.bin,
+ with its means and variances, if it is not already output, and give
+ its index in the output.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::add_cluster( int aCluster, int *aNewIdx )
+{
+   int offset, size;
+   int old_cnt; /* if add to idx list, update offset */
+
+   // track any failure
+   int failed = false;
+
+   old_cnt = cluster_idx_cnt;
+
+   if( cluster_idx_aug[ aCluster ] == -1 )
+   {
+
+      *aNewIdx = cluster_idx_cnt;
+      cluster_idx_cnt++;
+
+      cluster_idx_aug[ aCluster ] = *aNewIdx;
+   }
+   else
+      *aNewIdx = cluster_idx_aug[ aCluster ];
+
+   if( cluster_idx_cnt > old_cnt )
+   {
+
+      offset = clusteroffset_base[ aCluster ];
+
+      if( m_bPackWtNmix == 1 )
+      {
+         size = (int) ( 0xff & cluster_base[ offset ] ); /* n_mix */
+      }
+
+      else
+      {
+         size = cluster_base[ offset ];
+
+      }
+
+      size = size * 3 + 1;
+
+      /* output */
+
+      failed |= process_one_cluster( aCluster );
+      if( failed ) return failed;
+
+      /* update offset for next cluster entry (i.e. mixture, pdf) */
+
+      cluster_offset[ cluster_idx_cnt ] = cluster_offset[ old_cnt ] + size;
+   }
+
+   return failed;
 }
 
 
@@ -5114,7 +6412,7 @@ int CTIesrFlex::process_one_cluster( int idx )
       wt_idx_temp = (int) ( ( 0xff00 & cluster_base[offset] ) >> 8 );
    }
 
-   failed |= output_int16( fp_mixture, n_mix );
+   failed |= output_int16( &fp_mixture, n_mix );
    if( failed ) return failed;
 
    offset++;
@@ -5157,13 +6455,13 @@ int CTIesrFlex::process_one_cluster( int idx )
       {
 
          pshort = &cluster_base[ offset ];
-         failed |= output_int16( fp_mixture, (int) * pshort );
+         failed |= output_int16( &fp_mixture, (int) * pshort );
          if( failed ) return failed;
       }
       else // if weights are codebook entries
       {
          pshort = &weight_base[wt_idx + i];
-         failed |= output_int16( fp_mixture, (int) * pshort );
+         failed |= output_int16( &fp_mixture, (int) * pshort );
          if( failed ) return failed;
       }
 
@@ -5202,11 +6500,11 @@ int CTIesrFlex::process_one_cluster( int idx )
             add_mean( fvector, m_inputStaticDim, 1 );
          }
 
-         failed |= output_feature_vector( fp_mean, mean_base, meanIndex, m_bInputByteMeans );
+         failed |= output_feature_vector( &fp_mean, mean_base, meanIndex, m_bInputByteMeans );
 
       }
 
-      failed |= output_int16( fp_mixture, new_idx );
+      failed |= output_int16( &fp_mixture, new_idx );
       if( failed ) return failed;
 
       /* --------------------------------------------------
@@ -5229,14 +6527,14 @@ int CTIesrFlex::process_one_cluster( int idx )
       {
          unsigned int varIndex = cluster_base[offset + 2];
 
-         failed |= output_feature_vector( fp_var, var_base, varIndex, m_bInputByteVars );
+         failed |= output_feature_vector( &fp_var, var_base, varIndex, m_bInputByteVars );
 
-         failed |= output_int16( fp_gconst, (int) gconst_base[varIndex] );
+         failed |= output_int16( &fp_gconst, (int) gconst_base[varIndex] );
 
          if( failed ) return failed;
       }
 
-      failed |= output_int16( fp_mixture, new_idx );
+      failed |= output_int16( &fp_mixture, new_idx );
    }
 
    return failed;
@@ -5301,6 +6599,14 @@ int CTIesrFlex::get_cluster_idx( int c, int l, int r, int s, int gender, int *in
    }
 
 
+   // A triphone state whose contexts are in the same phone classes as
+   // one found before has the same cluster
+   if( l < 0 || l > n_phone || r < 0 || r > n_phone )
+      return true;
+
+   if( FindCachedCluster( c, m_leftClass[l], m_rightClass[r], s, gender, index ) )
+      return false;
+
    /* triphone state info */
 
    model.c = c; /* center phone idx */
@@ -5328,6 +6634,9 @@ int CTIesrFlex::get_cluster_idx( int c, int l, int r, int s, int gender, int *in
 
    *index = idx;
 
+   if( !failed )
+      AddCachedCluster( c, m_leftClass[l], m_rightClass[r], s, gender, idx );
+
    return failed;
 
    /*
@@ -5601,29 +6910,86 @@ short const* CTIesrFlex::DescendQuestionNode( short const* aQuestionNode )
 //-----------------------------
 
 int CTIesrFlex::yes_to_question( Modelnode const* model, int qs )
+{
+   unsigned int bit = 1u << ( qs & 31 );
+   int word = qs >> 5;
+
+   // The answers were made from the question data by make_qs_answers
+   return ( m_qsLeft[ model->l * m_qsWords + word ] & bit ) ||
+           ( m_qsRight[ model->r * m_qsWords + word ] & bit );
+}
+
+/*----------------------------------------------------------------
+ make_qs_answers
+
+ Each question of the acoustic decision trees is a list of phones,
+ each marked as a left or right context.  Turn the lists into the
+ answer of each phone to each question as left and as right context,
+ so that yes_to_question is a bit test.  Phones, including the
+ boundary context n_phone, whose answers to all questions are the
+ same are put in one class, so the cluster of a triphone state can be
+ kept for all triphones whose contexts are in the same classes.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::make_qs_answers( void )
 {
    unsigned char *c_ptr;
-   int i, lr, idx, qs_len;
+   unsigned int *answers;
+   int i, qs, lr, idx, qs_len;
+   int phn, cls;
+   int numPhones = n_phone + 1;
+
+   m_qsWords = ( m_numQuestions + 31 ) / 32;
+   if( m_qsWords == 0 )
+      m_qsWords = 1;
+
+   m_qsLeft = (unsigned int *) calloc( numPhones * m_qsWords, sizeof (unsigned int) );
+   m_qsRight = (unsigned int *) calloc( numPhones * m_qsWords, sizeof (unsigned int) );
+   m_leftClass = (int *) malloc( numPhones * sizeof (int) );
+   m_rightClass = (int *) malloc( numPhones * sizeof (int) );
+   if( !m_qsLeft || !m_qsRight || !m_leftClass || !m_rightClass )
+      return FAIL;
+
+   for( qs = 0; qs < m_numQuestions; qs++ )
+   {
+      c_ptr = (unsigned char *) ( qs_base + qs_offset[ qs ] );
+
+      qs_len = (int) * c_ptr;
+      c_ptr++;
+      for( i = 0; i < qs_len; i++ )
+      {
+         lr = c_ptr[i] & 0x80; /* right: 0x80, left: 0 */
+         idx = c_ptr[i] & 0x7f; /* phone index */
+
+         // A phone that is not a context can not be asked about
+         if( idx >= numPhones )
+            continue;
 
-   //   c_ptr = (unsigned char *) qs_offset[ qs ];
-   c_ptr = (unsigned char *) ( qs_base + qs_offset[ qs ] );
+         answers = lr ? m_qsRight : m_qsLeft;
+         answers[ idx * m_qsWords + ( qs >> 5 ) ] |= 1u << ( qs & 31 );
+      }
+   }
 
-   qs_len = (int) * c_ptr;
-   c_ptr++;
-   for( i = 0; i < qs_len; i++ )
+   // The class of a phone is the first phone with the same answers
+   for( phn = 0; phn < numPhones; phn++ )
    {
-      lr = c_ptr[i] & 0x80; /* right: 0x80, left: 0 */
-      idx = c_ptr[i] & 0x7f; /* phone index */
-      if( lr )
+      for( cls = 0; cls < phn; cls++ )
       {
-         if( idx == model->r ) return 1;
+         if( memcmp( m_qsLeft + cls * m_qsWords, m_qsLeft + phn * m_qsWords,
+                 m_qsWords * sizeof (unsigned int) ) == 0 )
+            break;
       }
-      else
+      m_leftClass[phn] = cls;
+
+      for( cls = 0; cls < phn; cls++ )
       {
-         if( idx == model->l ) return 1;
+         if( memcmp( m_qsRight + cls * m_qsWords, m_qsRight + phn * m_qsWords,
+                 m_qsWords * sizeof (unsigned int) ) == 0 )
+            break;
       }
+      m_rightClass[phn] = cls;
    }
-   return 0;
+
+   return OK;
 }
 
 /*----------------------------------------------------------------
@@ -5673,10 +7039,14 @@ int CTIesrFlex::myisalpha( int c )
 // rewind.
 //
 
-void CTIesrFlex::rewind( FILE *fp )
+void CTIesrFlex::rewind( GrammarFile *fp )
 {
-   fseek( fp, 0L, SEEK_SET );
-   clearerr( fp );
+   if( fp->fp )
+   {
+      fseek( fp->fp, 0L, SEEK_SET );
+      clearerr( fp->fp );
+   }
+   fp->pos = 0;
 }
 
 
@@ -5698,13 +7068,12 @@ void CTIesrFlex::rewind( FILE *fp )
 
 
  ----------------------------------------------------------------*/
-int CTIesrFlex::model_bit_16_to_8( char *source_dir, char *dest_dir,
+int CTIesrFlex::model_bit_16_to_8( const char *source_dir, const char *dest_dir,
         short endien, short add_mean_vec,
         int aByteMeans, int aByteVars )
 {
    short *max_scale;
    short n_mfcc, n_dim, *vec, nbr;
-   char fname[ FILENAME_MAX ];
    int failed;
    short dim;
 
@@ -5712,8 +7081,7 @@ int CTIesrFlex::model_bit_16_to_8( char *source_dir, char *dest_dir,
    //little_endian = endien;
 
    /* read the dimension of mfcc  */
-   sprintf( fname, "%s/%s", source_dir, "dim.bin" );
-   n_mfcc = load_n_mfcc( fname );
+   n_mfcc = load_n_mfcc( source_dir, "dim.bin" );
    if( n_mfcc == 0 )
       return FAIL;
 
@@ -5725,8 +7093,7 @@ int CTIesrFlex::model_bit_16_to_8( char *source_dir, char *dest_dir,
       return FAIL;
 
    /* Initialize scale memory by reading from memory or setting to zeros. */
-   sprintf( fname, "%s/%s", source_dir, "scale.bin" );
-   failed = load_scales( fname, max_scale, n_dim );
+   failed = load_scales( source_dir, "scale.bin", max_scale, n_dim );
    if( failed )
       goto failure;
 
@@ -5736,8 +7103,7 @@ int CTIesrFlex::model_bit_16_to_8( char *source_dir, char *dest_dir,
    if( aByteMeans && !m_bInputByteMeans )
    {
       /* load all mean vectors */
-      sprintf( fname, "%s/%s", source_dir, "mu.bin" );
-      vec = load_16( fname, n_mfcc, &nbr );
+      vec = load_16( source_dir, "mu.bin", n_mfcc, &nbr );
       if( vec == NULL )
          goto failure;
 
@@ -5745,8 +7111,7 @@ int CTIesrFlex::model_bit_16_to_8( char *source_dir, char *dest_dir,
       if( add_mean_vec ) add_mean( vec, n_mfcc, nbr );
 
       // Convert to byte mean vectors and output them */
-      sprintf( fname, "%s/%s", dest_dir, "mu.bin" );
-      failed = output_obs( vec, nbr, n_dim, n_mfcc, max_scale, fname );
+      failed = output_obs( vec, nbr, n_dim, n_mfcc, max_scale, dest_dir, "mu.bin" );
       free( vec );
       if( failed )
          goto failure;
@@ -5769,15 +7134,13 @@ int CTIesrFlex::model_bit_16_to_8( char *source_dir, char *dest_dir,
    if( aByteVars && !m_bInputByteVars )
    {
       /* load all variance vectors */
-      sprintf( fname, "%s/%s", source_dir, "var.bin" );
-      vec = load_16( fname, n_mfcc, &nbr );
+      vec = load_16( source_dir, "var.bin", n_mfcc, &nbr );
       if( vec == NULL )
          goto failure;
 
 
       /* Convert to byte variances and output them */
-      sprintf( fname, "%s/%s", dest_dir, "var.bin" );
-      failed = output_obs( vec, nbr, n_dim, n_mfcc, max_scale + n_dim, fname );
+      failed = output_obs( vec, nbr, n_dim, n_mfcc, max_scale + n_dim, dest_dir, "var.bin" );
       free( vec );
       if( failed )
          goto failure;
@@ -5796,8 +7159,7 @@ int CTIesrFlex::model_bit_16_to_8( char *source_dir, char *dest_dir,
 
 
    /* Output the scale information */
-   sprintf( fname, "%s/%s", dest_dir, "scale.bin" );
-   failed = save_scales( fname, max_scale, n_dim );
+   failed = save_scales( dest_dir, "scale.bin", max_scale, n_dim );
    if( failed )
       goto failure;
 
@@ -5814,21 +7176,20 @@ failure:
 // Find MFCC dimension
 //
 
-short CTIesrFlex::load_n_mfcc( char *fname )
+short CTIesrFlex::load_n_mfcc( const char *dirname, const char *fname )
 {
-   FILE *fp;
-   short n_mfcc;
+   GrammarFile fp;
+   short n_mfcc = 0;
 
-   fp = fopen( fname, "rb" );
-   if( !fp )
+   if( open_file( &fp, dirname, fname, "rb" ) )
    {
       return 0;
       //fprintf(stderr,"can't open %s\n",fname);
       //exit(0);
    }
 
-   fread( &n_mfcc, sizeof (short), 1, fp );
-   fclose( fp );
+   read_file( &fp, &n_mfcc, sizeof (short) );
+   close_file( &fp );
    return n_mfcc;
 }
 
@@ -5836,28 +7197,28 @@ short CTIesrFlex::load_n_mfcc( char *fname )
 // Read all vectors from file into memory
 //
 
-short * CTIesrFlex::load_16( char *fname, short n_mfcc, short *nbr )
+short * CTIesrFlex::load_16( const char *dirname, const char *fname, short n_mfcc, short *nbr )
 {
-   FILE *fp;
+   GrammarFile fp;
    int n_dim = 2 * n_mfcc;
    short *b;
 
    //printf("reading from \"%s\"\n", fname);
-   fp = fopen( fname, "rb" );
-   if( fp == NULL )
+   if( open_file( &fp, dirname, fname, "rb" ) )
       return NULL;
 
-   fread( nbr, sizeof (short), 1, fp );
+   *nbr = 0;
+   read_file( &fp, nbr, sizeof (short) );
    //printf("size = %d\n", *nbr);
    b = (short *) malloc( *nbr * n_dim * sizeof (short) );
    if( b == NULL )
    {
-      fclose( fp );
+      close_file( &fp );
       return NULL;
    }
 
-   fread( b, sizeof (short), *nbr * n_dim, fp );
-   fclose( fp );
+   read_file( &fp, b, *nbr * n_dim * sizeof (short) );
+   close_file( &fp );
    return b;
 }
 
@@ -5889,16 +7250,17 @@ void CTIesrFlex::add_mean( short *vec, int n_mfcc, int nbr )
 // Output 8-bit observations
 //
 
-int CTIesrFlex::output_obs( short obs[], short size, int n_dim, int n_mfcc, short max_scale[], char fname[] )
+int CTIesrFlex::output_obs( short obs[], short size, int n_dim, int n_mfcc, short max_scale[],
+        const char *dirname, const char *fname )
 {
    short *mu, i;
-   FILE *pf;
+   GrammarFile file;
+   GrammarFile *pf = &file;
    int failed;
 
    calc_max( obs, size, n_dim, n_mfcc, max_scale );
 
-   pf = fopen( fname, "wb" );
-   if( !pf )
+   if( open_file( pf, dirname, fname, "wb" ) )
    {
       return FAIL;
       //printf("failed to open %s\n",  fname);
@@ -5914,7 +7276,7 @@ int CTIesrFlex::output_obs( short obs[], short size, int n_dim, int n_mfcc, shor
    failed = write_vec( &size, 1, pf );
    if( failed )
    {
-      fclose( pf );
+      close_file( pf );
       return failed;
    }
 
@@ -5924,11 +7286,11 @@ int CTIesrFlex::output_obs( short obs[], short size, int n_dim, int n_mfcc, shor
       failed = write_vec( mu, n_mfcc, pf );
       if( failed )
       {
-         fclose( pf );
+         close_file( pf );
          return failed;
       }
    }
-   fclose( pf );
+   close_file( pf );
    return OK;
 }
 
@@ -5989,7 +7351,7 @@ void CTIesrFlex::scale_max( short max_mu[], int n_mfcc, int n_dim )
 //--------------------------------
 //
 
-int CTIesrFlex::write_vec( short *vec, short nbr, FILE *fp )
+int CTIesrFlex::write_vec( short *vec, short nbr, GrammarFile *fp )
 {
    int i;
    int failed;
@@ -6007,7 +7369,7 @@ int CTIesrFlex::write_vec( short *vec, short nbr, FILE *fp )
 //--------------------------------------------
 //
 
-int CTIesrFlex::output_word( short value, FILE *fp )
+int CTIesrFlex::output_word( short value, GrammarFile *fp )
 {
    int failed;
 
@@ -6080,20 +7442,19 @@ short CTIesrFlex::nbr_coding( short o_mu, short max_mu, int prt )
 //-----------------------------------------
 //
 
-int CTIesrFlex::save_scales( char *fname, short scale[], short n_dim )
+int CTIesrFlex::save_scales( const char *dirname, const char *fname, short scale[], short n_dim )
 {
-   FILE *fp;
+   GrammarFile fp;
    int failed;
 
-   fp = fopen( fname, "wb" );
-   if( !fp )
+   if( open_file( &fp, dirname, fname, "wb" ) )
    {
       return FAIL;
       //fprintf(stderr,"can't open %s\n",fname);
       //exit(0);
    }
-   failed = write_vec( scale, n_dim * 2, fp );
-   fclose( fp );
+   failed = write_vec( scale, n_dim * 2, &fp );
+   close_file( &fp );
 
    if( failed )
       return failed;
@@ -6108,16 +7469,15 @@ int CTIesrFlex::save_scales( char *fname, short scale[], short n_dim )
  initialize scale with all zeros.  Otherwise read from file, and
  report if failure to do so.
  ----------------------------------------------------------------*/
-int CTIesrFlex::load_scales( char *fname, short scale[], short n_dim )
+int CTIesrFlex::load_scales( const char *dirname, const char *fname, short scale[], short n_dim )
 {
-   FILE *fp;
+   GrammarFile fp;
    int dim;
-   size_t nread;
+   unsigned int nread;
 
 
    /* Open file and initialize scales if no file */
-   fp = fopen( fname, "rb" );
-   if( !fp )
+   if( open_file( &fp, dirname, fname, "rb" ) )
    {
       for( dim = 0; dim < 2 * n_dim; dim++ )
          scale[dim] = 0;
@@ -6127,10 +7487,10 @@ int CTIesrFlex::load_scales( char *fname, short scale[], short n_dim )
 
 
    /* Read scales */
-   nread = fread( scale, sizeof (short), 2 * n_dim, fp );
-   fclose( fp );
+   nread = read_file( &fp, scale, 2 * n_dim * sizeof (short) );
+   close_file( &fp );
 
-   if( nread != (unsigned int) 2 * n_dim )
+   if( nread != 2 * n_dim * sizeof (short) )
       return FAIL;
 
    return OK;
@@ -6142,7 +7502,7 @@ int CTIesrFlex::load_scales( char *fname, short scale[], short n_dim )
  This function outputs a single feature vector based on its index in
  the input data.
  ----------------------------------------------------------------*/
-int CTIesrFlex::output_feature_vector( FILE* fp, void *aFeatures,
+int CTIesrFlex::output_feature_vector( GrammarFile* fp, void *aFeatures,
         unsigned int aIndex,
         int aByteFeatureVector )
 {
@@ -6195,23 +7555,19 @@ int CTIesrFlex::output_feature_vector( FILE* fp, void *aFeatures,
  ----------------------------------------------------------------*/
 int CTIesrFlex::output_config( const char* aDirName, short aByteMeans, short aByteVars )
 {
-   FILE* fp;
-   char buf[ FILENAME_MAX ];
+   GrammarFile fp;
    int failed = 0;
 
    /* Open config file */
-   strcpy( buf, aDirName );
-   strcat( buf, "/config.bin" );
-   fp = fopen( buf, "wb" );
-   if( !fp )
+   if( open_file( &fp, aDirName, "config.bin", "wb" ) )
       return FAIL;
 
-   failed |= output_int16( fp, aByteMeans );
-   failed |= output_int16( fp, aByteVars );
-   failed |= output_int16( fp, little_endian );
+   failed |= output_int16( &fp, aByteMeans );
+   failed |= output_int16( &fp, aByteVars );
+   failed |= output_int16( &fp, little_endian );
 
 
-   fclose( fp );
+   close_file( &fp );
 
    if( failed )
       return FAIL;
@@ -6264,8 +7620,10 @@ CTIesrFlex::Errors CTIesrFlex::AddMultiplePronunciations( )
 
 
       // If the word is a _SIL* word, then continue, since this is a dummy for the
-      // silence model, and it does not have more pronunciations.
-      if( strncmp( word[wrdIndex], SIL, strlen( SIL ) ) == 0 )
+      // silence model, and it does not have more pronunciations.  The same
+      // holds for a _SLOT_* word.
+      if( strncmp( word[wrdIndex], SIL, strlen( SIL ) ) == 0 ||
+              strncmp( word[wrdIndex], SLOT, strlen( SLOT ) ) == 0 )
       {
          continue;
       }
@@ -6298,9 +7656,13 @@ CTIesrFlex::Errors CTIesrFlex::AddMultiplePronunciations( )
          char suffix[MAX_WORDLEN];
          int newWordIndex;
 
-         // Create the new "word"
-         strcpy( newWord, word[wrdIndex] );
+         // Create the new "word", which must fit a word as the parsed
+         // words do
          sprintf( suffix, "+%d", newPron );
+         if( strlen( word[wrdIndex] ) + strlen( suffix ) >= MAX_WORDLEN )
+            return ErrFail;
+
+         strcpy( newWord, word[wrdIndex] );
          strcat( newWord, suffix );
 
          // Try to add the new word to the word list
@@ -6376,10 +7738,12 @@ CTIesrFlex::Errors CTIesrFlex::AddMultiplePronunciations( )
  same word.
 
  ----------------------------------------------------------------*/
-CTIesrFlex::Errors CTIesrFlex::LookupBasePronunciation( const char* aWord, char* aPron )
+CTIesrFlex::Errors CTIesrFlex::LookupBasePronunciation( CTIesrDict *aDict,
+        const char* aWord, char* aPron )
 {
    char* plusChr;
    char wrd[MAX_WORDLEN];
+   char pron[CTIesrDict::MAXPHONESPERWORD + 1];
    CTIesrDict::Errors dictError;
 
    // Modifiable copy of word
@@ -6404,41 +7768,47 @@ CTIesrFlex::Errors CTIesrFlex::LookupBasePronunciation( const char* aWord, char*
    // User wants rule pronunciation for base word
    if( m_maxPronunciations == 0 || m_bIncludeRulePron )
    {
-      dictError = m_dict->GetPronEntry( wrd, 0, aPron );
+      dictError = aDict->GetPronEntry( wrd, 0, pron );
    }
 
    // User wants first dictionary pronunciation for base word
    else
    {
-      dictError = m_dict->GetPronEntry( wrd, 1, aPron );
+      dictError = aDict->GetPronEntry( wrd, 1, pron );
 
       // TIesrFlex may want the first dictionary pronunciation,
       // but no dictionary pronunciation exists.  This may not be
       // an error, since we just have to use the rule pronunciation,
       // if it is available.
-      if( dictError == CTIesrDict::ErrNotInDictionary && aPron[0] != 0 )
+      if( dictError == CTIesrDict::ErrNotInDictionary && pron[0] != 0 )
          dictError = CTIesrDict::ErrNone;
    }
 
-   // This is the base word.  No "+N" suffix implies multiCount=0.
-   // The next N for this base word, if it exists, should be N=1.
-   m_multiCount = 0;
+   if( dictError != CTIesrDict::ErrNone )
+      return ErrDict;
 
+   // A pronunciation with more phones than a Pron_t holds fails the word
+   if( (unsigned char) pron[0] >= MAX_PRON )
+      return ErrFail;
 
-   return (dictError == CTIesrDict::ErrNone ) ? ErrNone : ErrDict;
+   memcpy( aPron, pron, (unsigned char) pron[0] + 1 );
+   return ErrNone;
 }
 
 /*----------------------------------------------------------------
  LookupMultiPronunciation
 
  ----------------------------------------------------------------*/
-CTIesrFlex::Errors CTIesrFlex::LookupMultiPronunciation( const char* aWord,
+CTIesrFlex::Errors CTIesrFlex::LookupMultiPronunciation( CTIesrDict *aDict,
+        const char* aWord,
         const char* aMultiWord,
+        int aMultiCount,
         char* aPron )
 {
    char* plusChr;
    int multiCount;
    char wrd[MAX_WORDLEN];
+   char pron[CTIesrDict::MAXPHONESPERWORD + 1];
    CTIesrDict::Errors dictError;
 
    // Modifiable copy of multiword
@@ -6464,7 +7834,7 @@ CTIesrFlex::Errors CTIesrFlex::LookupMultiPronunciation( const char* aWord,
       }
 
       // Ensure this is the next word in multi-word order
-      if( multiCount != m_multiCount + 1 )
+      if( multiCount != aMultiCount + 1 )
          return ErrFail;
    }
    else
@@ -6489,53 +7859,690 @@ CTIesrFlex::Errors CTIesrFlex::LookupMultiPronunciation( const char* aWord,
    // multi-pronunciation words were put in the senttran transitions.  So
    // there should not be a request for an instance of the word not in the
    // dictionary.
-   dictError = m_dict->GetNextEntry( aPron );
-
-   // Successfully looked up next sequential multiword for base word
-   if( dictError == CTIesrDict::ErrNone )
-      m_multiCount++;
+   dictError = aDict->GetNextEntry( pron );
+   if( dictError != CTIesrDict::ErrNone )
+   {
+      aPron[0] = 0;
+      return ErrDict;
+   }
 
+   // A pronunciation with more phones than a Pron_t holds fails the word
+   if( (unsigned char) pron[0] >= MAX_PRON )
+      return ErrFail;
 
-   return (dictError == CTIesrDict::ErrNone ) ? ErrNone : ErrDict;
+   memcpy( aPron, pron, (unsigned char) pron[0] + 1 );
+   return ErrNone;
 }
 
 /*----------------------------------------------------------------
- ExpandArray
-
- Expand the size of an array of items which may be either structures
- or simple types. This function may also be called to do the initial
- allocation.  aArray is a pointer to the present allocation.
- aItemSize is the size of an item in the array.  aNumAlloc is the
- number by which the array should be increased, and aNumInArray is a
- pointer to a counter that holds the present number of items.
+ lookup_prons, lookup_worker
+
+ Look up the pronunciations of the words of the grammar into
+ m_wordProns, and the status of each base word and its
+ multi-pronunciation words into aErrors.  Pronunciations kept from
+ prior parses are used first.  The remaining base words are shared by
+ the lookup threads, the calling thread among them, each taking every
+ n-th word with its multi-pronunciation words and looking them up in
+ its own dictionary.  Each word is looked up by one thread only, into
+ its own entry of m_wordProns, so the pronunciations are the same for
+ any number of threads.
  ----------------------------------------------------------------*/
-void* CTIesrFlex::ExpandArray( void* aArray, int aItemSize, int aNumAlloc, int* aNumInArray )
+struct CTIesrFlex::LookupWorker
 {
-   void* newArray;
-   int newNumInArray;
-
-   // Number of array objects to allocate
-   newNumInArray = aNumAlloc + *aNumInArray;
+   CTIesrFlex *flex;
+   CTIesrDict *dict;
+   const int *words;       /* base words to look up */
+   int numWords;
+   int first;              /* first of words looked up, and step to the next */
+   int step;
+   const int *multiStart;
+   Errors *errors;
+#if defined (LINUX)
+   pthread_t thread;
+#elif defined (WIN32) || defined (WINCE)
+   HANDLE thread;
+#endif
+};
 
-   // Check if this is the first allocation
-   if( *aNumInArray == 0 )
-   {
-      newArray = malloc( aItemSize * newNumInArray );
-   }
-   else
-   {
-      newArray = realloc( aArray, aItemSize * newNumInArray );
-   }
+void CTIesrFlex::lookup_prons( const int *aMultiStart, Errors *aErrors )
+{
+   int *words;
+   int numWords = 0;
+   int baseIndex;
+   int entry;
+   int numThreads;
+   int w;
+   int started;
+   LookupWorker workers[MAX_LOOKUP_THREADS];
 
-   // If allocation was unsuccessful, throw a memory error
-   if( !newArray )
-      throw "Memory Allocation Error";
+   words = (int *) malloc( ( m_baseWordIndex + 1 ) * sizeof (int) );
+   demand( words != NULL, "create_hmm: memory allocation failed\n" );
 
-   // Allocation was successfull, so update number of objects in array,
-   // and provide a pointer to the newly allocated array.
-   *aNumInArray = newNumInArray;
-   return newArray;
-}
+   // The dictionary entry wanted, where 0 is the rule pronunciation
+   entry = ( m_maxPronunciations == 0 || m_bIncludeRulePron ) ? 0 : 1;
+
+   int silLen = strlen( SIL );
+   int slotLen = strlen( SLOT );
+   for( baseIndex = 0; baseIndex < m_baseWordIndex; baseIndex++ )
+   {
+      aErrors[baseIndex] = ErrNone;
+
+      // "_SIL*" and "_SLOT_*" words have the pronunciation of silence
+      if( strncmp( word[baseIndex], SIL, silLen ) == 0 ||
+              strncmp( word[baseIndex], SLOT, slotLen ) == 0 )
+      {
+         m_wordProns[baseIndex][0] = 1;
+         m_wordProns[baseIndex][1] = SIL_INDEX;
+         continue;
+      }
+
+      // A pronunciation kept from a prior parse can be used if no further
+      // dictionary entries of the word will be looked up
+      if( m_maxPronunciations <= 1 &&
+              FindCachedPron( word[baseIndex], entry, (char *) m_wordProns[baseIndex] ) )
+         continue;
+
+      words[numWords++] = baseIndex;
+   }
+
+
+   // Use only as many threads as there are words for
+   numThreads = numWords / LOOKUP_THREAD_WORDS;
+   if( numThreads > m_lookupThreads )
+      numThreads = m_lookupThreads;
+   if( numThreads > 1 )
+      numThreads = open_lookup_dicts( numThreads );
+   if( numThreads < 1 )
+      numThreads = 1;
+
+   for( w = 0; w < numThreads; w++ )
+   {
+      workers[w].flex = this;
+      workers[w].dict = w == 0 ? m_dict : m_lookupDicts[w - 1];
+      workers[w].words = words;
+      workers[w].numWords = numWords;
+      workers[w].first = w;
+      workers[w].step = numThreads;
+      workers[w].multiStart = aMultiStart;
+      workers[w].errors = aErrors;
+   }
+
+   // Start the other threads, and look up the words of the calling
+   // thread.  Words of a thread that can not be started are looked up
+   // by the calling thread after its own.
+   for( started = 1; started < numThreads; started++ )
+   {
+#if defined (LINUX)
+      if( pthread_create( &workers[started].thread, NULL, LookupThread, &workers[started] ) )
+         break;
+#elif defined (WIN32) || defined (WINCE)
+      workers[started].thread = CreateThread( NULL, 0, LookupThread, &workers[started], 0, NULL );
+      if( workers[started].thread == NULL )
+         break;
+#else
+      break;
+#endif
+   }
+
+   lookup_worker( &workers[0] );
+
+   for( w = 1; w < numThreads; w++ )
+   {
+      if( w < started )
+      {
+#if defined (LINUX)
+         pthread_join( workers[w].thread, NULL );
+#elif defined (WIN32) || defined (WINCE)
+         WaitForSingleObject( workers[w].thread, INFINITE );
+         CloseHandle( workers[w].thread );
+#endif
+      }
+      else
+      {
+         workers[w].dict = m_dict;
+         lookup_worker( &workers[w] );
+      }
+   }
+
+
+   // Keep the pronunciations looked up for later parses, in word order
+   if( m_maxPronunciations <= 1 )
+   {
+      for( w = 0; w < numWords; w++ )
+      {
+         baseIndex = words[w];
+         if( aErrors[baseIndex] == ErrNone )
+            AddCachedPron( word[baseIndex], entry, (char *) m_wordProns[baseIndex] );
+      }
+   }
+
+   free( words );
+}
+
+void CTIesrFlex::lookup_worker( LookupWorker *aWorker )
+{
+   int w;
+   int baseIndex;
+   int multiIndex;
+   int multiCount;
+   Errors error;
+
+   for( w = aWorker->first; w < aWorker->numWords; w += aWorker->step )
+   {
+      baseIndex = aWorker->words[w];
+
+      // Get base pronunciation, which may be the first dictionary pronunciation
+      // or may be the default rule pronunciation
+      error = LookupBasePronunciation( aWorker->dict, word[baseIndex],
+              (char *) m_wordProns[baseIndex] );
+      if( error != ErrNone )
+         error = ErrFail;
+
+      // Get the multipronunciations of the base word in order.  A
+      // multipronunciation the dictionary does not have is empty.
+      multiCount = 0;
+      for( multiIndex = aWorker->multiStart[baseIndex];
+              error == ErrNone && multiIndex < aWorker->multiStart[baseIndex + 1];
+              multiIndex++ )
+      {
+         error = LookupMultiPronunciation( aWorker->dict, word[baseIndex],
+                 word[multiIndex], multiCount, (char *) m_wordProns[multiIndex] );
+         if( error == ErrNone )
+            multiCount++;
+         else if( error != ErrFail )
+            error = ErrNone;
+      }
+
+      aWorker->errors[baseIndex] = error;
+   }
+}
+
+#if defined (WIN32) || defined (WINCE)
+unsigned long __stdcall CTIesrFlex::LookupThread( void *aWorker )
+{
+   LookupWorker *worker = (LookupWorker *) aWorker;
+
+   worker->flex->lookup_worker( worker );
+   return 0;
+}
+#else
+void *CTIesrFlex::LookupThread( void *aWorker )
+{
+   LookupWorker *worker = (LookupWorker *) aWorker;
+
+   worker->flex->lookup_worker( worker );
+   return NULL;
+}
+#endif
+
+/*----------------------------------------------------------------
+ open_lookup_dicts, free_lookup_dicts
+
+ Each lookup thread other than the calling thread has a dictionary
+ of its own, since a dictionary keeps the state of its lookups.  The
+ dictionaries are loaded as threads need them, and kept until the
+ language or number of threads changes.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::open_lookup_dicts( int aThreads )
+{
+   CTIesrDict *dict;
+
+   if( !m_dictDir )
+      return 1;
+
+   while( m_lookupDictCount < aThreads - 1 )
+   {
+      try
+      {
+         dict = new CTIesrDict( );
+      }
+      catch( std::bad_alloc &ex )
+      {
+         break;
+      }
+
+      if( dict->LoadDictionary( m_dictDir, m_dictLanguage, m_dictIdent,
+              m_useFlags ) != CTIesrDict::ErrNone )
+      {
+         delete dict;
+         break;
+      }
+
+      m_lookupDicts[m_lookupDictCount++] = dict;
+   }
+
+   return m_lookupDictCount + 1 < aThreads ? m_lookupDictCount + 1 : aThreads;
+}
+
+void CTIesrFlex::free_lookup_dicts( void )
+{
+   while( m_lookupDictCount > 0 )
+      delete m_lookupDicts[--m_lookupDictCount];
+}
+
+/*----------------------------------------------------------------
+ SetLookupThreads
+
+ Set the number of threads looking up pronunciations, freeing any
+ dictionaries of threads no longer used.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::SetLookupThreads( unsigned int aThreads )
+{
+   if( aThreads == 0 )
+   {
+#if defined (LINUX)
+      long processors = sysconf( _SC_NPROCESSORS_ONLN );
+      aThreads = processors > 0 ? (unsigned int) processors : 1;
+#elif defined (WIN32) || defined (WINCE)
+      SYSTEM_INFO info;
+      GetSystemInfo( &info );
+      aThreads = info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+      aThreads = 1;
+#endif
+   }
+
+   if( aThreads > (unsigned int) MAX_LOOKUP_THREADS )
+      aThreads = MAX_LOOKUP_THREADS;
+
+   m_lookupThreads = aThreads;
+
+   while( m_lookupDictCount > m_lookupThreads - 1 )
+      delete m_lookupDicts[--m_lookupDictCount];
+
+   return ErrNone;
+}
+
+/*----------------------------------------------------------------
+ RecompileGrammar
+
+ Parse a grammar changed by a rule edit with the options of the last
+ parse, starting the triphone list with the triphones of the prior
+ grammar.  If the changed grammar fails to parse, the prior grammar is
+ parsed again so that the object still holds it.
+ ----------------------------------------------------------------*/
+CTIesrFlex::Errors CTIesrFlex::RecompileGrammar( const char *aNewGrammar )
+{
+   char *oldGrammar;
+   int oldHmmIdx;
+   Errors error;
+
+   // Take the prior grammar text and triphone list, so they are not
+   // freed by the parse
+   oldGrammar = cfg;
+   cfg = NULL;
+
+   oldHmmIdx = hmm_idx;
+   m_hmmKept = hmm;
+   m_hmmKeptIdx = hmm_idx;
+   m_hmmKeptMax = m_hmmMax;
+   hmm = NULL;
+   hmm_idx = 0;
+   m_hmmMax = 0;
+
+   error = CompileGrammar( aNewGrammar, m_parseMaxPronunciations,
+           m_parseIncludeRulePron, m_bAutoSilence );
+
+   if( error != ErrNone )
+   {
+      // Triphones are only added after those kept, so the prior list
+      // is the start of the list of the failed parse
+      if( !m_hmmKept )
+      {
+         m_hmmKept = hmm;
+         m_hmmKeptMax = m_hmmMax;
+         hmm = NULL;
+         hmm_idx = 0;
+         m_hmmMax = 0;
+      }
+      m_hmmKeptIdx = oldHmmIdx;
+
+      if( CompileGrammar( oldGrammar, m_parseMaxPronunciations,
+              m_parseIncludeRulePron, m_bAutoSilence ) != ErrNone )
+      {
+         m_bGrammarParsed = false;
+      }
+   }
+
+   delete [] oldGrammar;
+   return error;
+}
+
+/*----------------------------------------------------------------
+ FindRuleBody
+
+ Locate the right side of rule aRule in the grammar text, from the
+ character after the arrow to the period ending the rule.  Returns
+ false if the grammar does not define the rule.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::FindRuleBody( const char *aGrammar, const char *aRule,
+        int *aStart, int *aEnd )
+{
+   const char *arrow;
+   const char *nameEnd;
+   const char *nameStart;
+   const char *period;
+   int ruleLen = strlen( aRule );
+
+   arrow = strstr( aGrammar, "--->" );
+   while( arrow )
+   {
+      // The rule name is the token before the arrow
+      nameEnd = arrow;
+      while( nameEnd > aGrammar &&
+              ( nameEnd[-1] == ' ' || nameEnd[-1] == '\n' || nameEnd[-1] == '\t' ) )
+      {
+         nameEnd--;
+      }
+
+      nameStart = nameEnd;
+      while( nameStart > aGrammar &&
+              ( myisalpha( (unsigned char) nameStart[-1] ) || nameStart[-1] == '-' ||
+              nameStart[-1] == '\'' || nameStart[-1] == '_' ) )
+      {
+         nameStart--;
+      }
+
+      if( nameEnd - nameStart == ruleLen && strncmp( nameStart, aRule, ruleLen ) == 0 )
+      {
+         period = strchr( arrow + 4, '.' );
+         if( !period )
+            return false;
+
+         *aStart = arrow + 4 - aGrammar;
+         *aEnd = period - aGrammar;
+         return true;
+      }
+
+      arrow = strstr( arrow + 4, "--->" );
+   }
+
+   return false;
+}
+
+/*----------------------------------------------------------------
+ NextAlternative
+
+ Copy the top level alternative of a rule body starting at aPos into
+ aAlt, as its tokens separated by single spaces, so that alternatives
+ can be compared regardless of spacing.  Tokens are found as yylex
+ finds them.  Returns the position after the '|' ending the
+ alternative, or aEnd.
+ ----------------------------------------------------------------*/
+int CTIesrFlex::NextAlternative( const char *aBody, int aPos, int aEnd,
+        char *aAlt, int aMaxAlt )
+{
+   int depth = 0;
+   int len = 0;
+   int isName;
+   char c;
+
+   while( aPos < aEnd )
+   {
+      c = aBody[aPos];
+
+      if( c == '|' && depth == 0 )
+      {
+         aPos++;
+         break;
+      }
+
+      isName = myisalpha( (unsigned char) c ) || c == '-' || c == '\'' || c == '_';
+
+      if( isName || c == '(' || c == ')' || c == '[' || c == ']' || c == '|' )
+      {
+         if( len > 0 && len < aMaxAlt - 1 )
+            aAlt[len++] = ' ';
+
+         if( isName )
+         {
+            while( aPos < aEnd && ( myisalpha( (unsigned char) aBody[aPos] ) ||
+                    aBody[aPos] == '-' || aBody[aPos] == '\'' || aBody[aPos] == '_' ) )
+            {
+               if( len < aMaxAlt - 1 )
+                  aAlt[len++] = aBody[aPos];
+               aPos++;
+            }
+            continue;
+         }
+
+         if( c == '(' || c == '[' )
+            depth++;
+         else if( c == ')' || c == ']' )
+            depth--;
+
+         if( len < aMaxAlt - 1 )
+            aAlt[len++] = c;
+      }
+
+      aPos++;
+   }
+
+   aAlt[len] = '\0';
+   return aPos;
+}
+
+/*----------------------------------------------------------------
+ FindCachedPron, AddCachedPron, FreePronCache
+
+ Pronunciations of base words are kept between parses, keyed by the
+ word and the dictionary entry used, so that a grammar changed by a
+ rule edit only looks up the words new to it.  When the cache is full
+ it is emptied and filled again.
+ ----------------------------------------------------------------*/
+static unsigned int pron_hash( const char *aWord )
+{
+   unsigned int hash = 2166136261u;
+
+   while( *aWord )
+   {
+      hash ^= (unsigned char) *aWord++;
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+int CTIesrFlex::FindCachedPron( const char *aWord, int aEntry, char *aPron )
+{
+   int idx = m_pronHash[ pron_hash( aWord ) % PRONCACHE_HASH ];
+
+   while( idx >= 0 )
+   {
+      if( m_pronCache[idx].entry == aEntry && strcmp( m_pronCache[idx].word, aWord ) == 0 )
+      {
+         memcpy( aPron, m_pronCache[idx].pron, m_pronCache[idx].pron[0] + 1 );
+         return true;
+      }
+      idx = m_pronCache[idx].next;
+   }
+
+   return false;
+}
+
+void CTIesrFlex::AddCachedPron( const char *aWord, int aEntry, const char *aPron )
+{
+   int bucket;
+
+   if( m_pronCacheIdx >= PRONCACHE_MAX )
+      FreePronCache( );
+
+   if( m_pronCacheIdx >= m_pronCacheMax )
+   {
+      // A pronunciation that can not be kept is looked up again
+      try
+      {
+         m_pronCache = reinterpret_cast<PronCache*>
+                 ( ExpandArray( reinterpret_cast<void*> ( m_pronCache ),
+                 sizeof (PronCache ), PRONCACHE_ALLOC, &m_pronCacheMax ) );
+      }
+      catch( char const* exc )
+      {
+         return;
+      }
+   }
+
+   bucket = pron_hash( aWord ) % PRONCACHE_HASH;
+
+   strcpy( m_pronCache[m_pronCacheIdx].word, aWord );
+   m_pronCache[m_pronCacheIdx].entry = aEntry;
+   memcpy( m_pronCache[m_pronCacheIdx].pron, aPron, (unsigned char) aPron[0] + 1 );
+   m_pronCache[m_pronCacheIdx].next = m_pronHash[bucket];
+   m_pronHash[bucket] = m_pronCacheIdx;
+
+   m_pronCacheIdx++;
+}
+
+void CTIesrFlex::FreePronCache( void )
+{
+   int bucket;
+
+   if( m_pronCache )
+   {
+      free( m_pronCache );
+      m_pronCache = NULL;
+   }
+   m_pronCacheIdx = 0;
+   m_pronCacheMax = 0;
+
+   for( bucket = 0; bucket < PRONCACHE_HASH; bucket++ )
+      m_pronHash[bucket] = -1;
+}
+
+/*----------------------------------------------------------------
+ FindCachedCluster, AddCachedCluster, FreeClusterCache
+
+ Cluster indices found by descending the acoustic decision trees are
+ kept for the language loaded, keyed by the center phone, state and
+ gender of a triphone state and the classes of its contexts.  Models
+ output again after a rule edit only descend the trees for triphone
+ states with contexts not seen before.  When the cache is full it is
+ emptied and filled again.
+ ----------------------------------------------------------------*/
+static unsigned int cluster_hash( int c, int l, int r, int s, int gender )
+{
+   unsigned int hash = 2166136261u;
+
+   hash = ( hash ^ (unsigned int) c ) * 16777619u;
+   hash = ( hash ^ (unsigned int) l ) * 16777619u;
+   hash = ( hash ^ (unsigned int) r ) * 16777619u;
+   hash = ( hash ^ (unsigned int) s ) * 16777619u;
+   hash = ( hash ^ (unsigned int) gender ) * 16777619u;
+   return hash;
+}
+
+int CTIesrFlex::FindCachedCluster( int c, int l, int r, int s, int gender, int *aIndex )
+{
+   int idx = m_clusterHash[ cluster_hash( c, l, r, s, gender ) % CLUSTERCACHE_HASH ];
+   ClusterCache *entry;
+
+   while( idx >= 0 )
+   {
+      entry = &m_clusterCache[idx];
+      if( entry->c == c && entry->l == l && entry->r == r &&
+              entry->s == s && entry->gender == gender )
+      {
+         *aIndex = entry->index;
+         return true;
+      }
+      idx = entry->next;
+   }
+
+   return false;
+}
+
+void CTIesrFlex::AddCachedCluster( int c, int l, int r, int s, int gender, int aIndex )
+{
+   int bucket;
+   ClusterCache *entry;
+
+   if( m_clusterCacheIdx >= CLUSTERCACHE_MAX )
+      FreeClusterCache( );
+
+   if( m_clusterCacheIdx >= m_clusterCacheMax )
+   {
+      // A cluster that can not be kept is found from the tree again
+      try
+      {
+         m_clusterCache = reinterpret_cast<ClusterCache*>
+                 ( ExpandArray( reinterpret_cast<void*> ( m_clusterCache ),
+                 sizeof (ClusterCache ), CLUSTERCACHE_ALLOC, &m_clusterCacheMax ) );
+      }
+      catch( char const* exc )
+      {
+         return;
+      }
+   }
+
+   bucket = cluster_hash( c, l, r, s, gender ) % CLUSTERCACHE_HASH;
+
+   entry = &m_clusterCache[m_clusterCacheIdx];
+   entry->c = c;
+   entry->l = l;
+   entry->r = r;
+   entry->s = s;
+   entry->gender = gender;
+   entry->index = aIndex;
+   entry->next = m_clusterHash[bucket];
+   m_clusterHash[bucket] = m_clusterCacheIdx;
+
+   m_clusterCacheIdx++;
+}
+
+void CTIesrFlex::FreeClusterCache( void )
+{
+   int bucket;
+
+   if( m_clusterCache )
+   {
+      free( m_clusterCache );
+      m_clusterCache = NULL;
+   }
+   m_clusterCacheIdx = 0;
+   m_clusterCacheMax = 0;
+
+   for( bucket = 0; bucket < CLUSTERCACHE_HASH; bucket++ )
+      m_clusterHash[bucket] = -1;
+}
+
+/*----------------------------------------------------------------
+ ExpandArray
+
+ Expand the size of an array of items which may be either structures
+ or simple types. This function may also be called to do the initial
+ allocation.  aArray is a pointer to the present allocation.
+ aItemSize is the size of an item in the array.  aNumAlloc is the
+ least number by which the array should be increased, and aNumInArray
+ is a pointer to a counter that holds the present number of items.
+ The array is doubled if that adds more items, so that the number of
+ reallocations grows only with the log of the array size.
+ ----------------------------------------------------------------*/
+void* CTIesrFlex::ExpandArray( void* aArray, int aItemSize, int aNumAlloc, int* aNumInArray )
+{
+   void* newArray;
+   int newNumInArray;
+
+   // Number of array objects to allocate
+   newNumInArray = *aNumInArray + ( *aNumInArray > aNumAlloc ? *aNumInArray : aNumAlloc );
+
+   // Check if this is the first allocation
+   if( *aNumInArray == 0 )
+   {
+      newArray = malloc( (size_t) aItemSize * newNumInArray );
+   }
+   else
+   {
+      newArray = realloc( aArray, (size_t) aItemSize * newNumInArray );
+   }
+
+   // If allocation was unsuccessful, throw a memory error
+   if( !newArray )
+      throw "Memory Allocation Error";
+
+   // Allocation was successfull, so update number of objects in array,
+   // and provide a pointer to the newly allocated array.
+   *aNumInArray = newNumInArray;
+   return newArray;
+}
 
 /*----------------------------------------------------------------
  FreeGrammarData
@@ -6550,12 +8557,10 @@ void CTIesrFlex::FreeGrammarData( void )
    delete [] cfg;
    cfg = NULL;
 
-   // Free any preexisting parse word tokens and token array data
+   // Free any preexisting parse word tokens and token array data.  The
+   // token strings are in the arena.
    if( token )
    {
-      for( int tok = 0; tok < token_idx; tok++ )
-         free( token[tok] );
-
       free( token );
       token = NULL;
       token_idx = 0;
@@ -6589,20 +8594,10 @@ void CTIesrFlex::FreeGrammarData( void )
       m_dependMax = 0;
    }
 
-   // Free any preexisting sentnode structures
+   // Free any preexisting sentnode structures, whose next lists are
+   // in the arena
    if( sentnode )
    {
-      // Free any existing array of next nodes
-      int snode;
-      for( snode = 0; snode < sentnode_idx; snode++ )
-      {
-         if( sentnode[snode].next )
-         {
-            free( sentnode[snode].next );
-         }
-      }
-
-      // Free all the sentnodes
       free( sentnode );
       sentnode = NULL;
       sentnode_idx = 0;
@@ -6636,90 +8631,150 @@ void CTIesrFlex::FreeGrammarData( void )
       m_hmmMax = 0;
    }
 
-   // Free any symbol structure array
+   // Free any symbol structure array, whose next lists are in the arena
    if( sym )
    {
-      // Free any existing array of next symbols in the sym structure
-      int idxsym;
-      for( idxsym = 0; idxsym < sym_idx; idxsym++ )
-      {
-         if( sym[idxsym].next )
-         {
-            free( sym[idxsym].next );
-         }
-      }
-
-      // Free all sym structures
       free( sym );
       sym = NULL;
       sym_idx = 0;
       m_symMax = 0;
    }
 
-   // Free stop symbol list
-   if( stop_next )
+   // Stop symbol list, in the arena
+   stop_next = NULL;
+   n_stop_next = 0;
+   m_stopMax = 0;
+
+   // Release the tokens and next lists all at once
+   FreeArena( );
+}
+
+/*----------------------------------------------------------------
+ ArenaAlloc
+
+ Allocate aSize bytes in the arena of the grammar being compiled.
+ Allocations are taken in order from the last block, and a new block
+ twice the size of the last is added when it is full.  As with
+ ExpandArray, a failed allocation throws a memory error.
+ ----------------------------------------------------------------*/
+void* CTIesrFlex::ArenaAlloc( size_t aSize )
+{
+   const size_t header = ( sizeof (ArenaBlock) + ARENA_ALIGN - 1 ) & ~( (size_t) ARENA_ALIGN - 1 );
+   ArenaBlock *block;
+   size_t blockSize;
+   void *ptr;
+
+   aSize = ( aSize + ARENA_ALIGN - 1 ) & ~( (size_t) ARENA_ALIGN - 1 );
+
+   if( !m_arena || m_arena->used + aSize > m_arena->size )
    {
-      free( stop_next );
-      n_stop_next = 0;
-      m_stopMax = 0;
+      blockSize = m_arena ? 2 * m_arena->size : ARENA_BLOCK;
+      if( blockSize > ARENA_BLOCK_MAX )
+         blockSize = ARENA_BLOCK_MAX;
+      if( blockSize < aSize )
+         blockSize = aSize;
+
+      block = (ArenaBlock*) malloc( header + blockSize );
+      if( !block )
+         throw "Memory Allocation Error";
+
+      block->prev = m_arena;
+      block->size = blockSize;
+      block->used = 0;
+      m_arena = block;
    }
+
+   ptr = (char*) m_arena + header + m_arena->used;
+   m_arena->used += aSize;
+   m_arenaLast = ptr;
+
+   return ptr;
+}
+
+/*----------------------------------------------------------------
+ ArenaExpand
+
+ Expand an arena allocation from aOldSize to aNewSize bytes.  The last
+ allocation grows in place if its block has room, otherwise the data
+ is copied to a new allocation and the old one is left unused until
+ the arena is released.
+ ----------------------------------------------------------------*/
+void* CTIesrFlex::ArenaExpand( void* aOld, size_t aOldSize, size_t aNewSize )
+{
+   size_t oldSize = ( aOldSize + ARENA_ALIGN - 1 ) & ~( (size_t) ARENA_ALIGN - 1 );
+   size_t newSize = ( aNewSize + ARENA_ALIGN - 1 ) & ~( (size_t) ARENA_ALIGN - 1 );
+   void *ptr;
+
+   if( aOld && aOld == m_arenaLast &&
+           m_arena->used - oldSize + newSize <= m_arena->size )
+   {
+      m_arena->used = m_arena->used - oldSize + newSize;
+      return aOld;
+   }
+
+   ptr = ArenaAlloc( aNewSize );
+   if( aOld && aOldSize > 0 )
+      memcpy( ptr, aOld, aOldSize );
+
+   return ptr;
+}
+
+/*----------------------------------------------------------------
+ FreeArena
+
+ Free all blocks of the arena.
+ ----------------------------------------------------------------*/
+void CTIesrFlex::FreeArena( void )
+{
+   ArenaBlock *block;
+
+   while( m_arena )
+   {
+      block = m_arena;
+      m_arena = block->prev;
+      free( block );
+   }
+
+   m_arenaLast = NULL;
 }
 
 /*----------------------------------------------------------------
  AddNext
 
  Add integers to the end of an integer list, expanding the list
- size if necessary.
+ size if necessary.  Lists are in the arena, and are doubled in size
+ when they are expanded, starting with NEXT_ALLOC integers.
  ----------------------------------------------------------------*/
 void CTIesrFlex::AddNext( int **apList, int *apNumUsed, int* apNumMax,
         int aNumToAdd, int* aAddList )
 {
-   int idxAdd;
-
-   int numUsed = *apNumUsed;
-   int numMax = *apNumMax;
-   int *aList = *apList;
-
+   int numMax;
 
    // Initial allocation if called when the list is empty
    // if aList is NULL numUsed should be zero.
-   if( aList == NULL )
+   if( *apList == NULL )
    {
-      // Allocate NEXT_ALLOC more integers to the list
-      // This will throw an exception if the expansion fails.
-      *apList = reinterpret_cast<int*>
-              ( ExpandArray( reinterpret_cast<void*> ( *apList ),
-              sizeof (int), NEXT_ALLOC, apNumMax ) );
-
       *apNumUsed = 0;
-
-      aList = *apList;
-      numMax = *apNumMax;
-      numUsed = 0;
+      *apNumMax = 0;
    }
 
 
-   // Add new integers to the list, expanding the list as necessary
-   for( idxAdd = 0; idxAdd < aNumToAdd; idxAdd++ )
+   // Expand the list to hold the new integers.  This will throw an
+   // exception if the expansion fails.
+   if( *apNumUsed + aNumToAdd > *apNumMax || *apList == NULL )
    {
+      numMax = *apNumMax > 0 ? 2 * *apNumMax : NEXT_ALLOC;
+      if( numMax < *apNumUsed + aNumToAdd )
+         numMax = *apNumUsed + aNumToAdd;
 
-      if( numUsed >= numMax )
-      {
-         // Allocate NEXT_ALLOC more integers to the list
-         // This will throw an exception if the expansion fails.
-         *apList = reinterpret_cast<int*>
-                 ( ExpandArray( reinterpret_cast<void*> ( *apList ),
-                 sizeof (int), NEXT_ALLOC, apNumMax ) );
-
-         aList = *apList;
-         numMax = *apNumMax;
-      }
-
-      aList[numUsed] = *aAddList++;
-      numUsed++;
+      *apList = reinterpret_cast<int*>
+              ( ArenaExpand( *apList, *apNumMax * sizeof (int), numMax * sizeof (int) ) );
+      *apNumMax = numMax;
    }
 
-   *apNumUsed = numUsed;
+   if( aNumToAdd > 0 )
+      memcpy( *apList + *apNumUsed, aAddList, aNumToAdd * sizeof (int) );
+   *apNumUsed += aNumToAdd;
 }
 
 
@@ -63,6 +63,10 @@
  and ensure that the grammar string actually defines a finite length
  regular grammar.
 
+ A large grammar, such as a list of many names, need not be held in
+ one string.  ParseGrammarStream reads the grammar text in pieces from
+ a reader function, and ParseGrammarFile reads it from a file.
+
  After parsing the grammar, call OutputGrammar to have TIesrFlex
  determine and output TIesr format HMM models and associated
  parameters files, a TIesr grammar network file, and a word list.
@@ -70,6 +74,29 @@
  user may select byte or word mean and variance outputs for HMMs, if
  the original HMM data loaded was in word format.
 
+ Alternatively, call OutputGrammarBundle to have the same files output
+ to one block of memory, which the TIesr engine opens with
+ OpenASRBundle without writing or reading any file.
+
+ Where many grammars use the same words, call OutputModelPool once,
+ after parsing a grammar covering their words, to output its models to
+ a shared pool directory, and then OutputGrammarPool for each grammar.
+ A grammar output this way holds only its network, which indexes the
+ hmms of the pool, and its word list.  The engine reads the hmms and
+ models from the pool when it loads the grammar.
+
+ A parsed grammar may be changed a few alternatives at a time with
+ AddRuleAlternatives and RemoveRuleAlternatives.  These keep the
+ triphone list of the prior grammar, so an output that needs no new
+ triphones rewrites only the network and word list.
+
+ A grammar may refer to classes of words, such as contact names, that
+ are compiled on their own by ParseSlotGrammar.  The grammar holds a
+ slot word "_SLOT_name" where the class is spoken, and the engine links
+ the slot network output for the class in place of the word when it
+ loads the grammar.  A slot can be compiled and output again without
+ changing the grammar that uses it.
+
 ======================================================================*/
 
 #ifndef _TIESRFLEX_H
@@ -148,6 +175,11 @@ class TIESRFLEX_API CTIesrFlex
           AddClosure = 0x1,
           NoDTLookup = 0x2
       };
+
+      // Function that reads up to aSize characters of grammar text into
+      // aBuffer, as fread does, and returns the number read.  It returns
+      // zero at the end of the grammar, or a negative value on error.
+      typedef int (*GrammarReader)( void *aContext, char *aBuffer, int aSize );
       
    public:
 
@@ -209,11 +241,39 @@ class TIESRFLEX_API CTIesrFlex
        such as "_SIL_A" or _SIL_B".  These will all be interpreted as the
        _SIL word.  This can be advantageous in tagging when different phrases
        are recognized.
+
+       Words and rule names may be at most 31 characters, and a word with
+       more than one pronunciation must leave room for its "+N" suffix.
+       A longer word or name fails the parse, which returns ErrFail, as
+       does a word whose pronunciation has more than 31 phones.
        ----------------------------------------------------------------*/
       Errors ParseGrammar( const char * cfg_string,
       unsigned int aMaxPronunciations = 1,
       int aIncludeRulePron = 0,
       int aAutoSilence = 1 );
+
+
+      /*----------------------------------------------------------------
+       ParseGrammarStream, ParseGrammarFile
+
+       Parse a grammar as ParseGrammar does, reading the grammar text
+       from aReader, which is called with aContext, or from the file
+       aFileName.  The text is read in pieces as it is parsed, and no
+       copy of the whole text is kept, so the memory used does not
+       depend on the length of the text, but only on the words and
+       rules of the grammar.  Since the text is not kept, the rules of
+       a grammar read this way cannot be edited with
+       AddRuleAlternatives or RemoveRuleAlternatives.
+       ----------------------------------------------------------------*/
+      Errors ParseGrammarStream( GrammarReader aReader, void *aContext,
+      unsigned int aMaxPronunciations = 1,
+      int aIncludeRulePron = 0,
+      int aAutoSilence = 1 );
+
+      Errors ParseGrammarFile( const char *aFileName,
+      unsigned int aMaxPronunciations = 1,
+      int aIncludeRulePron = 0,
+      int aAutoSilence = 1 );
       
       /*----------------------------------------------------------------
        DownloadGrammar
@@ -235,6 +295,119 @@ class TIESRFLEX_API CTIesrFlex
               int aByteMeans=1, int aByteVars=1, int aOptimize = 0  );
 
 
+      /*----------------------------------------------------------------
+       OutputGrammarBundle
+
+       Output HMMs and grammar network to a model bundle in memory,
+       rather than to files in a directory.  The bundle holds the same
+       files OutputGrammar writes, and is opened by the engine with
+       OpenASRBundle without any file being written or read.  The
+       bundle is allocated with malloc, and the caller must free it
+       after the recognizer using it is closed.  The byte mean and
+       variance options are those of OutputGrammar.
+       ----------------------------------------------------------------*/
+      Errors OutputGrammarBundle( unsigned char **aBundle, unsigned int *aSize,
+              int aByteMeans=1, int aByteVars=1 );
+
+
+      /*----------------------------------------------------------------
+       OutputModelPool, OutputGrammarPool
+
+       Output models once, to a model pool directory shared by many
+       grammars, and then output each grammar without models.
+       OutputModelPool writes the hmms and models of the grammar last
+       parsed, so that grammar should cover the words of all grammars to
+       be output with the pool.  It takes the byte mean and variance
+       options of OutputGrammar, so conversion to byte is done once for
+       all grammars.  OutputGrammarPool writes only the network and word
+       list of the grammar, with the network indexing the hmms of the
+       pool, and a file naming the pool directory.  The engine reads the
+       hmm and model files of the grammar from the pool, so all grammars
+       of a pool share one hmm list.  The pool directory name is used by
+       the engine as given, and must be at most 254 characters.
+
+       OutputGrammarPool returns ErrNoMatch if the pool is of another
+       language or lacks an hmm of the grammar, with the same transition
+       matrix and pdfs in every hmm set.  Any hmm or model file a prior
+       OutputGrammar left in the grammar directory is removed.  A
+       recognizer opened from the grammar loads all of the models of the
+       pool, not only those the grammar uses.
+       ----------------------------------------------------------------*/
+      Errors OutputModelPool( char *aPoolDir, int aByteMeans=1, int aByteVars=1 );
+
+      Errors OutputGrammarPool( char *aDirName, char *aPoolDir );
+
+
+      /*----------------------------------------------------------------
+       AddRuleAlternatives, RemoveRuleAlternatives
+
+       Add alternatives to, or remove alternatives from, the rule aRule
+       of the grammar last parsed, and parse the changed grammar with the
+       same options.  aAlternatives holds one or more alternatives
+       separated by '|', such as "john smith | mary jones".  An
+       alternative already in the rule is not added again.  An
+       alternative removed must match a top level alternative of the
+       rule word for word.  If aRule is not defined, or an alternative
+       to remove is not in the rule, ErrNoMatch is returned and the
+       grammar is not changed.
+
+       The triphones of the prior grammar keep their place in the
+       triphone list, and new triphones are added after them.  If no
+       triphone is added, OutputGrammar to the same directory with the
+       same options only writes the network and word list.  Triphones no
+       longer used stay in the list until the next ParseGrammar.
+
+       Word pronunciations are kept between parses, so only words new
+       to the grammar are looked up, unless multiple pronunciations are
+       used.
+       ----------------------------------------------------------------*/
+      Errors AddRuleAlternatives( const char *aRule, const char *aAlternatives );
+
+      Errors RemoveRuleAlternatives( const char *aRule, const char *aAlternatives );
+
+
+      /*----------------------------------------------------------------
+       ParseSlotGrammar
+
+       Parse the grammar of the slot aSlot, with the options of
+       ParseGrammar.  A grammar parsed before uses the slot with the
+       word "_SLOT_" followed by the slot name, such as "_SLOT_contact".
+       The slot name is at most ten letters or '_', as grammar words are.
+
+       OutputGrammar and OutputGrammarBundle then write the slot
+       network and word list as "<slot>.slot" and "<slot>.slis", and
+       do not write the network of the grammar.  The engine links the
+       slot network in place of each slot word of the grammar network
+       output to the same directory or bundle, and treats a slot word
+       without a slot network as silence.
+
+       The slot starts its triphone list with that of the prior
+       grammar or slot, so the slot network uses the same models.  If
+       the slot adds triphones, the models are output again with it
+       and still serve the prior grammar and slots.  ParseGrammar
+       starts a new triphone list, so slots must be parsed and output
+       again after it.  Rule edits of a slot keep it a slot.
+       ----------------------------------------------------------------*/
+      Errors ParseSlotGrammar( const char *aSlot, const char *aGrammarString,
+              unsigned int aMaxPronunciations = 1,
+              int aIncludeRulePron = 0,
+              int aAutoSilence = 0 );
+
+
+      /*----------------------------------------------------------------
+       SetLookupThreads
+
+       Set the number of threads that look up the pronunciations of
+       the words of a grammar when it is parsed.  Each thread other
+       than the calling thread uses its own copy of the dictionary and
+       decision trees, loaded the first time it is needed after
+       LoadLanguage.  If aThreads is zero, one thread per processor is
+       used.  The default is one thread.  The network and models output
+       are the same for any number of threads.
+       ----------------------------------------------------------------*/
+      Errors SetLookupThreads( unsigned int aThreads );
+
+
       enum ErrorCodes { OK, FAIL };
       enum ExceptionCodes { STATUS_FAIL_PARSE = 0xE0000001 };
 
@@ -246,6 +419,10 @@ class TIESRFLEX_API CTIesrFlex
       // manually within the grammar.
       static char const *const SIL;
 
+      // The prefix of a word that is replaced by the network of a slot
+      // when the engine loads the grammar.
+      static char const *const SLOT;
+
 
       // Private constants used in the processing of a grammar within
       // the TIesrFlex class.  It would be better to be able to
@@ -266,6 +443,12 @@ class TIESRFLEX_API CTIesrFlex
       // at a time
       static int const NODE_ALLOC = 20;
 
+      // Maximum files of a grammar and its slots output to memory, and
+      // the size of their names, which is that of the bundle file table
+      // of the engine
+      static const int MAX_MEMFILE = 32;
+      static const int MEMFILE_NAME_SIZE = 16;
+
       // Maximum number of rules in the grammar
       // static const int  MAX_RULE =  128;
       // Now implemented to dynamically allocate RULE_ALLOC rule structures
@@ -289,6 +472,25 @@ class TIESRFLEX_API CTIesrFlex
       // Maximum number of characters in a word, including +N and \0
       static const int MAX_WORDLEN = 32;
 
+      // Pronunciations kept between parses are dynamically allocated
+      // PRONCACHE_ALLOC at a time, up to PRONCACHE_MAX, and found by
+      // a hash of PRONCACHE_HASH buckets.
+      static const int PRONCACHE_ALLOC = 50;
+      static const int PRONCACHE_MAX = 4096;
+      static const int PRONCACHE_HASH = 512;
+
+      // Cluster indices found from the acoustic decision trees are kept
+      // in the same way, CLUSTERCACHE_ALLOC at a time up to
+      // CLUSTERCACHE_MAX, in a hash of CLUSTERCACHE_HASH buckets.
+      static const int CLUSTERCACHE_ALLOC = 256;
+      static const int CLUSTERCACHE_MAX = 65536;
+      static const int CLUSTERCACHE_HASH = 4096;
+
+      // Pronunciations are looked up by at most MAX_LOOKUP_THREADS
+      // threads, each given at least LOOKUP_THREAD_WORDS words
+      static const int MAX_LOOKUP_THREADS = 16;
+      static const int LOOKUP_THREAD_WORDS = 32;
+
       typedef char Word_t[MAX_WORDLEN];
 
       // Now implemented to dynamically allocate SENTTRAN_ALLOC structures
@@ -317,6 +519,17 @@ class TIESRFLEX_API CTIesrFlex
       // dynamically allocated
       // static const int  MAX_NEXT = 256;
       static int const NEXT_ALLOC = 5;
+
+      // Arrays grow by their *_ALLOC count or by their size, whichever
+      // is larger, so large grammars are not reallocated for every few
+      // entries.  Tokens and next lists are placed in an arena of blocks
+      // of ARENA_BLOCK bytes at first, doubling up to ARENA_BLOCK_MAX.
+      static const unsigned int ARENA_BLOCK = 16384;
+      static const unsigned int ARENA_BLOCK_MAX = 1048576;
+      static const unsigned int ARENA_ALIGN = 8;
+
+      // Size of the buffer of grammar text read from a stream
+      static const int LEX_BUFFER_SIZE = 4096;
             
       // string lengths - no longer used
       // static const int MAX_STR = 256;
@@ -410,6 +623,59 @@ class TIESRFLEX_API CTIesrFlex
       } Depend;
 
 
+      typedef struct prncch
+      {
+         char  word[MAX_WORDLEN];
+         int   entry;             /* dictionary entry, 0 is the rule pronunciation */
+         unsigned char pron[MAX_PRON];
+         int   next;              /* next entry in hash bucket, -1 ends */
+      } PronCache;
+
+
+      // A cluster index of a triphone state.  The contexts are phone
+      // classes, phones that answer all tree questions alike.
+      typedef struct clstrcch
+      {
+         int   c;
+         int   l;                 /* left context class */
+         int   r;                 /* right context class */
+         int   s;
+         int   gender;
+         int   index;
+         int   next;              /* next entry in hash bucket, -1 ends */
+      } ClusterCache;
+
+
+      // A grammar file output to memory by OutputGrammarBundle
+      typedef struct memfl
+      {
+         char  name[MEMFILE_NAME_SIZE];
+         unsigned char *data;
+         unsigned int size;
+         unsigned int max;
+      } MemFile;
+
+
+      // A grammar file being written or read, which is either a file
+      // in a directory or a file in memory
+      typedef struct grmfl
+      {
+         FILE  *fp;
+         MemFile *mem;
+         unsigned int pos;
+      } GrammarFile;
+
+
+      // A block of the arena holding the tokens and next lists of the
+      // grammar being compiled.  Its data follows the block header.
+      typedef struct arenablk
+      {
+         struct arenablk *prev;
+         size_t size;
+         size_t used;
+      } ArenaBlock;
+
+
       // Treenode structure no longer used.  Decision tree parsing now
       // is done directly using encoded tree data in memory.
       // These structures are used within the question list processing
@@ -442,6 +708,12 @@ class TIESRFLEX_API CTIesrFlex
       // Dynamic structure array allocation support for parsing
       void* ExpandArray( void* aArray, int aItemSize, int aNumAlloc, int* aNumInArray );
 
+      // Arena allocation of the grammar being compiled, released at
+      // once by FreeGrammarData
+      void* ArenaAlloc( size_t aSize );
+      void* ArenaExpand( void* aOld, size_t aOldSize, size_t aNewSize );
+      void FreeArena( void );
+
       // file input - for device, data would be in ROM.
       // we would just want to get pointers to data
       int read_config( char *fname );
@@ -468,6 +740,10 @@ class TIESRFLEX_API CTIesrFlex
       // If codebook data loaded to memory, this will remove allocation
       void free_codebook();
 
+      // Make the answers of each phone to the tree questions, and the
+      // phone classes, from the question data
+      int make_qs_answers( void );
+
       // priviate functions to implement grammar/model creation
 
       // initialize a grammar parse
@@ -480,12 +756,25 @@ class TIESRFLEX_API CTIesrFlex
       //int yylex(int *yylval);
       int yylex(long *yylval);
 
+      // Read more grammar text from a reader into the lexer buffer, so
+      // that at least aCount characters follow cfg_char unless the text
+      // ends.  Returns nonzero if the reader fails.
+      int lex_fill( int aCount );
+
+      // Reader of a grammar file for ParseGrammarFile
+      static int read_grammar_file( void *aContext, char *aBuffer, int aSize );
+
+      // Parse a grammar from a string, or from the reader of the lexer
+      // if the string is NULL, starting a new triphone list.
+      Errors parse_grammar( const char *cfg_string, unsigned int aMaxPronunciations,
+      int aIncludeRulePron, int aAutoSilence );
+
       void yyerror(const char *msg);
       int yywrap();
       
       // support functions
-      int output_int16( FILE *fp, int i32 );
-      int output_sym( FILE * fp, int hmm_code, int word_code, int n_next, int *next );
+      int output_int16( GrammarFile *fp, int i32 );
+      int output_sym( GrammarFile *fp, int hmm_code, int word_code, int n_next, int *next );
       int download_gtm();
       int download_hmm2phone();
       int download_net();
@@ -495,6 +784,7 @@ class TIESRFLEX_API CTIesrFlex
       void check_unreferenced();
       void create_dependency_list();
       void create_hmm();
+      void add_pron_hmms( const unsigned char *aPron );
       void add_hmm_entry(int c, int l, int r);
       int find_hmm_idx(int c, int l, int r);
       void expand_sym_net(int  n_next, int  *next, char *buf, int  phone_or_word);
@@ -542,12 +832,20 @@ class TIESRFLEX_API CTIesrFlex
       void attach_at_end_sub( int aNode1, int aNode2 );
       int create_node(char *name, int aNextNode, int aParaNextNode, int flag);
       int process_optional( int aNode );
-      int output_gtm( char *dirname );
-      int output_hmm2phone( char *dirname );
-      int output_net( char *dirname, char* filename );
+      int output_gtm( const char *dirname, int aPool );
+      int output_pool_map( const char *dirname );
+      Errors pool_hmm_data( const int *aPoolTran, const int *aPoolCluster, int **aData );
+      Errors pool_hmm_map( const char *aPoolDir, int **aHmmMap, int *aPoolHmmCount );
+      int output_pool_name( const char *aDirName, const char *aPoolDir );
+      int output_models( const char *aDirName, int aByteMeans, int aByteVars, int aPool );
+      int output_hmm2phone( const char *dirname );
+      int output_net( const char *dirname, const char* filename,
+              const char *wordfilename, const int *aHmmMap, int aHmmCount );
       int process_one_cluster( int idx);
       int find_idx_idx( int *list, int *n_list, int max, int idx, int *new_idx);
       int process_one_hmm( int n_state, int idx, short *cluster );
+      int add_tran( int idx, int *aNewIdx );
+      int add_cluster( int aCluster, int *aNewIdx );
 
       /*
        No longer used, since tree parsing occurs directly using encoded
@@ -562,26 +860,41 @@ class TIESRFLEX_API CTIesrFlex
       void demand( int condition, char *msg );
  
       // functions to convert from 16-bit to 8-bit features
-      int model_bit_16_to_8( char *source_dir, char *dest_dir, short endien, short add_mean_vec, 
+      int model_bit_16_to_8( const char *source_dir, const char *dest_dir, short endien, short add_mean_vec, 
 			     int aByteMeans, int aByteVars);
-      short load_n_mfcc( char *fname );
-      short * load_16( char *fname, short n_mfcc, short *nbr);
+      short load_n_mfcc( const char *dirname, const char *fname );
+      short * load_16( const char *dirname, const char *fname, short n_mfcc, short *nbr);
       void add_mean(short *vec, int n_mfcc, int nbr);
-      int output_obs(short obs[], short size, int n_dim, int n_mfcc, short max_scale[], char fname[]);
+      int output_obs(short obs[], short size, int n_dim, int n_mfcc, short max_scale[],
+		     const char *dirname, const char *fname);
       void calc_max(short mu[], int nbr, int n_dim, int n_mfcc, short max_mu[]);
       void scale_max(short max_mu[], int n_mfcc, int n_dim);
-      int write_vec(short *vec, short nbr, FILE *fp);
-      int output_word( short value, FILE *fp );
+      int write_vec(short *vec, short nbr, GrammarFile *fp);
+      int output_word( short value, GrammarFile *fp );
       void vector_packing(short v_in[], unsigned short v_out[], short max_scale[], short D);
       short nbr_coding(short o_mu, short max_mu, int prt);
-      int save_scales(char *fname, short scale[], short n_dim);
+      int save_scales(const char *dirname, const char *fname, short scale[], short n_dim);
 
       // Handling for byte/word feature outputs
-      int load_scales(char *fname, short scale[], short n_dim);
-      int output_feature_vector( FILE* fp, void *aFeatures, 
+      int load_scales(const char *dirname, const char *fname, short scale[], short n_dim);
+      int output_feature_vector( GrammarFile* fp, void *aFeatures, 
 				 unsigned int aIndex, int aByteFeatureVector );
       int output_config( const char* aDirName, short aByteMeans, short aByteVars );
 
+      // Output of the grammar to a directory, or to memory if aDirName
+      // is NULL, indexing the model pool in aPoolDir if it is not NULL
+      Errors output_grammar( const char *aDirName, int aByteMeans, int aByteVars,
+			     int aOptimize, const char *aPoolDir );
+
+      // Grammar files in a directory or in memory.  A NULL directory
+      // name selects the files in memory.
+      int open_file( GrammarFile *aFile, const char *aDirName, const char *aName,
+		     const char *aMode );
+      int write_file( GrammarFile *aFile, const void *aData, unsigned int aSize );
+      unsigned int read_file( GrammarFile *aFile, void *aData, unsigned int aSize );
+      void close_file( GrammarFile *aFile );
+      void FreeMemFiles( );
+
 
       // Functions for implementing multiple pronunciations
 
@@ -605,7 +918,8 @@ class TIESRFLEX_API CTIesrFlex
       // words is that the lookup of pronunciations is faster if the
       // pronunciation of the base word is looked up followed immediately
       // by looking up pronunciations of all multi-pronunciations of the same word.
-      Errors LookupBasePronunciation( const char* aWord, char* aPron );
+      // The word is looked up in aDict, the dictionary of the calling thread.
+      Errors LookupBasePronunciation( CTIesrDict *aDict, const char* aWord, char* aPron );
 
 
       // This function looks up the pronunciation of multi-pronunciation
@@ -619,8 +933,56 @@ class TIESRFLEX_API CTIesrFlex
       // word.  If the multi-word does not match the base word, this function
       // returns with a status indicating the mismatch.  Also, if the "+N" is out
       // of order, this function will return status indicating the lack of order.
-      Errors LookupMultiPronunciation( const char* aWord, const char* aMultiWord, char* aPron );
+      // aMultiCount is the number of multi-words of the base word looked up
+      // so far.
+      Errors LookupMultiPronunciation( CTIesrDict *aDict, const char* aWord,
+      const char* aMultiWord, int aMultiCount, char* aPron );
+
+
+      // Parse a grammar, with the triphone list started from any
+      // triphones kept from the prior grammar.  If cfg_string is NULL,
+      // the text is read with the reader of the lexer.
+      Errors CompileGrammar( const char * cfg_string,
+      unsigned int aMaxPronunciations, int aIncludeRulePron, int aAutoSilence );
+
+      // Parse the grammar changed by an edit of its rules, keeping the
+      // triphone list.  The prior grammar is restored on failure.
+      Errors RecompileGrammar( const char *aNewGrammar );
+
+      // Locate the right side of a rule within the grammar text, from
+      // after the arrow up to the ending period.
+      int FindRuleBody( const char *aGrammar, const char *aRule,
+      int *aStart, int *aEnd );
+
+      // Copy the next top level alternative of a rule body in normalized
+      // form, with tokens separated by single spaces.  Returns the
+      // position after the alternative.
+      int NextAlternative( const char *aBody, int aPos, int aEnd,
+      char *aAlt, int aMaxAlt );
+
+      // Find a pronunciation kept from a prior parse, or keep one
+      int FindCachedPron( const char *aWord, int aEntry, char *aPron );
+      void AddCachedPron( const char *aWord, int aEntry, const char *aPron );
+      void FreePronCache( void );
+
+      // Look up the pronunciations of the words of the grammar into
+      // m_wordProns, over the threads set by SetLookupThreads.  The
+      // multi-pronunciation words of base word i are aMultiStart[i]
+      // up to aMultiStart[i+1].
+      struct LookupWorker;
+      void lookup_prons( const int *aMultiStart, Errors *aErrors );
+      void lookup_worker( LookupWorker *aWorker );
+#if defined (WIN32) || defined (WINCE)
+      static unsigned long __stdcall LookupThread( void *aWorker );
+#else
+      static void *LookupThread( void *aWorker );
+#endif
 
+      // Load or free the dictionaries of the lookup threads other than
+      // the calling thread.  Returns the number of threads that can be
+      // used, up to aThreads.
+      int open_lookup_dicts( int aThreads );
+      void free_lookup_dicts( void );
 
       // Helper function that frees data structures created during parse and model output.
       void FreeGrammarData( void );
@@ -639,10 +1001,15 @@ class TIESRFLEX_API CTIesrFlex
 
       short const* DescendQuestionNode( short const* aQuestionNode );
 
+      // Find a cluster index kept from a prior tree descent, or keep one
+      int FindCachedCluster( int c, int l, int r, int s, int gender, int *aIndex );
+      void AddCachedCluster( int c, int l, int r, int s, int gender, int aIndex );
+      void FreeClusterCache( void );
+
 
       // WCE compatibility functions
       int myisalpha( int c);
-      void rewind( FILE *fp );
+      void rewind( GrammarFile *fp );
 
 #ifdef OFFLINE_CLS
       short LoadVQHMM(const char* dirname);
@@ -664,6 +1031,16 @@ class TIESRFLEX_API CTIesrFlex
       // Flags for using TiesrDict
       int m_useFlags;
 
+      // Threads looking up pronunciations, and the dictionaries of
+      // those other than the calling thread, loaded from the dictionary
+      // location given to LoadLanguage
+      int m_lookupThreads;
+      CTIesrDict *m_lookupDicts[MAX_LOOKUP_THREADS];
+      int m_lookupDictCount;
+      char *m_dictDir;
+      char *m_dictLanguage;
+      char *m_dictIdent;
+
       // Output format should be little endian
       int little_endian;
 
@@ -722,6 +1099,16 @@ class TIESRFLEX_API CTIesrFlex
       // Loaded from files in this implementation.
       char * qs_base;
       int * qs_offset;
+      int m_numQuestions;
+
+      // Answers of each phone as left and right context to the
+      // questions, one bit per question and m_qsWords words per phone,
+      // and the class of each phone as left and right context
+      unsigned int * m_qsLeft;
+      unsigned int * m_qsRight;
+      int m_qsWords;
+      int * m_leftClass;
+      int * m_rightClass;
       short * tree_base;
       int * treetbl_base;
 
@@ -758,6 +1145,17 @@ class TIESRFLEX_API CTIesrFlex
       
       char * cfg_char;
       char * cfg;
+
+      // Reader of grammar text parsed from a stream, and the buffer of
+      // text read, which holds m_lexEnd characters.  cfg_char points
+      // into the buffer, and cfg is NULL, when a stream is parsed.
+      // m_lexDone is 1 at the end of the text, and -1 if the text can
+      // not be read or holds a word too long for a token.
+      GrammarReader m_lexReader;
+      void *m_lexContext;
+      char m_lexBuffer[LEX_BUFFER_SIZE + 1];
+      int m_lexEnd;
+      int m_lexDone;
      
       static const short yycheck[];
       static const short yytable[];
@@ -800,6 +1198,11 @@ class TIESRFLEX_API CTIesrFlex
       int token_idx;
       int m_tokenMax;
 
+      // Arena of the grammar being compiled, and its last allocation,
+      // which can grow in place
+      ArenaBlock *m_arena;
+      void *m_arenaLast;
+
       // Dynamically allocate stop_next array now
       int *stop_next;
       int m_stopMax;
@@ -882,13 +1285,13 @@ class TIESRFLEX_API CTIesrFlex
       short *vq_centroid; /* centroid */
 #endif
 
-      FILE  *fp_hmm;
-      FILE  *fp_mean;
-      FILE  *fp_var;
-      FILE  *fp_tran;
-      FILE  *fp_pdf;
-      FILE  *fp_mixture;
-      FILE  *fp_gconst;
+      GrammarFile  fp_hmm;
+      GrammarFile  fp_mean;
+      GrammarFile  fp_var;
+      GrammarFile  fp_tran;
+      GrammarFile  fp_pdf;
+      GrammarFile  fp_mixture;
+      GrammarFile  fp_gconst;
 
       // These are global variables associated with processing
       // output_gtm that are part of the tree processing.  
@@ -912,12 +1315,47 @@ class TIESRFLEX_API CTIesrFlex
       // word_idx prior to adding multiple pronunciations
       int m_baseWordIndex;
 
-      // Variable to verify sequence of next multi-pronunciation word
-      int m_multiCount;
-
       // Pointer to struct that holds pronunciations
       Pron_t* m_wordProns;
 
+      // Options of the last grammar parse, used when a rule is edited
+      int m_bGrammarParsed;
+      unsigned int m_parseMaxPronunciations;
+      int m_parseIncludeRulePron;
+
+      // Triphone list kept from the prior grammar when a rule is edited
+      Hmmtbl *m_hmmKept;
+      int m_hmmKeptIdx;
+      int m_hmmKeptMax;
+
+      // Directory and options of the last model output, and the number
+      // of triphones output.  The count is -1 if models must be output.
+      // The directory is NULL if the models were output to memory.
+      char *m_outputDir;
+      int m_outputByteMeans;
+      int m_outputByteVars;
+      int m_outputHmmCount;
+
+      // Name of the slot parsed by ParseSlotGrammar, or NULL if the
+      // grammar parsed is not a slot
+      char *m_slotName;
+
+      // Grammar files output to memory by OutputGrammarBundle
+      MemFile m_memFiles[MAX_MEMFILE];
+      int m_memFileIdx;
+
+      // Pronunciations kept between parses
+      PronCache *m_pronCache;
+      int m_pronCacheIdx;
+      int m_pronCacheMax;
+      int m_pronHash[PRONCACHE_HASH];
+
+      // Cluster indices kept between model outputs
+      ClusterCache *m_clusterCache;
+      int m_clusterCacheIdx;
+      int m_clusterCacheMax;
+      int m_clusterHash[CLUSTERCACHE_HASH];
+
 };
 
 
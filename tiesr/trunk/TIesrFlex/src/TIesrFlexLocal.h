@@ -52,9 +52,37 @@ static short mean_bias[] = {14951, -2789, -811, 1563, -3013, -1346, 973, -884, 3
 // manually insert silence words within the grammar.
 char const *const CTIesrFlex::SIL = "_SIL";
 
+// The prefix of slot words, and the extensions of the slot network and
+// word list files, which must agree with slot_user.h of the TIesr engine.
+char const *const CTIesrFlex::SLOT = "_SLOT_";
+static const char SLOT_NET_EXT[] = ".slot";
+static const char SLOT_WORD_EXT[] = ".slis";
+
+// Longest slot name, so that its file names fit a bundle file table entry
+static const unsigned int MAX_SLOT_NAME = 10;
+
+// The file of a grammar naming its model pool directory, and the size
+// of the name with its newline and '\0', which must agree with
+// filename.h of the TIesr engine.
+static const char MODEL_POOL_FILE[] = "modelpool.txt";
+static const unsigned int MAX_POOL_NAME = 256;
+
+// The map of input models to their places in a model pool
+static const char POOL_MAP_FILE[] = "poolmap.bin";
+
 //  phone index, used to indicate silence
 static const int SIL_INDEX = 255;
 
+// Layout of a model bundle output by OutputGrammarBundle, which must
+// agree with bundle_user.h of the TIesr engine.  The header is the
+// magic, version, number of files and total size; each file table
+// entry is a name of MEMFILE_NAME_SIZE bytes, an offset and a size.
+static const char BUNDLE_MAGIC[4] = { 'T', 'I', 'M', 'B' };
+static const unsigned short BUNDLE_VERSION = 1;
+static const unsigned int BUNDLE_ALIGN = 8;
+static const unsigned int BUNDLE_HEADER_SIZE = 12;
+static const unsigned int BUNDLE_ENTRY_SIZE = 24;
+
 //--------------------------------
 // These are the arrays for executing parsing of the ascii input string
 // according to the parser.
@@ -23,6 +23,11 @@
 
 ======================================================================*/
 
+/* Worker processor affinity requires GNU extensions of POSIX threads */
+#if defined (LINUX)
+#define _GNU_SOURCE
+#endif
+
 /* Windows OS specific includes */
 #if defined (WIN32) || defined (WINCE)
 #include <windows.h>
@@ -34,6 +39,10 @@
 
 #if defined(LINUX)
 #include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <limits.h>
 #endif
 
 /* 
@@ -91,17 +100,6 @@ TIesrSI_Error_t TIesrSI_create( TIesrSI_t* aPtrToTIesrSI )
       aTIesrSI = *aPtrToTIesrSI;
    }
 
-#if defined (TIESRSI_DEBUG_LOG)
-   aTIesrSI->threadfp = NULL;
-
-   aTIesrSI->logfp = fopen(LOGFILE, "w" );
-   if( aTIesrSI->logfp == NULL )
-      return TIesrSIErrFail;
-
-   fprintf( aTIesrSI->logfp, "SICreate\n" );
-   fflush( aTIesrSI->logfp );
-#endif
-
 
    /* Set status tracking variables, just in case TIesrSI_status is called
    immediately after TIesrSI_create. */
@@ -121,10 +119,17 @@ TIesrSI_Error_t TIesrSI_create( TIesrSI_t* aPtrToTIesrSI )
    aTIesrSI->jacfile = NULL;
    aTIesrSI->sbcfile = NULL;
    aTIesrSI->audiofp = NULL;
+   aTIesrSI->resultwords = NULL;
+   aTIesrSI->resultsize = 0;
+   aTIesrSI->tracefile = NULL;
 
 
-
-#if defined (WIN32) || defined (WINCE)
+#if defined (LINUX)
+   /* Recognition runs in its own thread until attached to a server */
+   aTIesrSI->server = NULL;
+   aTIesrSI->serverpolled = FALSE;
+   aTIesrSI->next = NULL;
+#elif defined (WIN32) || defined (WINCE)
    /* Windows synchronization objects initialized to NULL for bookkeeping */
    aTIesrSI->threadid = NULL;
    aTIesrSI->recomutex = NULL;
@@ -134,17 +139,18 @@ TIesrSI_Error_t TIesrSI_create( TIesrSI_t* aPtrToTIesrSI )
    /* Default settings just to be safe */
    aTIesrSI->startok = FALSE;
    aTIesrSI->stopreco = FALSE;
+   aTIesrSI->resultready = FALSE;
+   aTIesrSI->jacpending = FALSE;
+   aTIesrSI->pushmode = FALSE;
+   aTIesrSI->traceevents = 0;
+   aTIesrSI->tracelag = 0;
+   aTIesrSI->tracepreroll = 0;
 
 
    /* Recognizer created ok, now in closed state */
    aTIesrSI->state = TIesrSIStateClosed;
 
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SICreate success\n" );
-   fflush( aTIesrSI->logfp );
-#endif
-
    return TIesrSIErrNone;
 }
 
@@ -180,11 +186,6 @@ TIesrSI_Error_t TIesrSI_open( TIesrSI_t aTIesrSI,
       return TIesrSIErrState;
    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIOpen\n" );
-   fflush( aTIesrSI->logfp );
-#endif
-
 
    /* Set callback functions */
    aTIesrSI->speakcb = speakCallback;
@@ -198,6 +199,8 @@ TIesrSI_Error_t TIesrSI_open( TIesrSI_t aTIesrSI,
    aTIesrSI->audioreadrate = AUDIO_READ_RATE;
    aTIesrSI->audioframes = AUDIO_FRAMES;
    aTIesrSI->audiopriority = AUDIO_PRIORITY;
+   aTIesrSI->audiopreroll = AUDIO_PREROLL;
+   aTIesrSI->audioopen = FALSE;
 
 
    /* Set status tracking variables */
@@ -208,6 +211,9 @@ TIesrSI_Error_t TIesrSI_open( TIesrSI_t aTIesrSI,
    /* Set default conditions of variables */
    aTIesrSI->startok = FALSE;
    aTIesrSI->stopreco = FALSE;
+   aTIesrSI->resultready = FALSE;
+   aTIesrSI->jacpending = FALSE;
+   aTIesrSI->asyncjac = FALSE;
 
 
    /* Allocate search memory */
@@ -334,14 +340,18 @@ TIesrSI_Error_t TIesrSI_open( TIesrSI_t aTIesrSI,
    }
 
 
+   /* Start recording the trace requested by TIesrSI_trace.  The trace is
+   a diagnostic, so failure to allocate it does not fail the open. */
+   if( aTIesrSI->traceevents > 0 )
+   {
+      (aTIesrSI->engine).SetTIesrTrace( aTIesrSI->srchmemory,
+         aTIesrSI->traceevents );
+   }
+
+
    /* Successfully opened the recognizer and audio channel */
    aTIesrSI->state = TIesrSIStateOpen;
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIOpen success\n" );
-   fflush( aTIesrSI->logfp );
-#endif
-
    return TIesrSIErrNone;
 }
 
@@ -389,6 +399,13 @@ TIesrSIL_Error_t TIesrSIL_freeopen( TIesrSI_t aTIesrSI )
       aTIesrSI->grammardir = NULL;
    }
 
+   if(  aTIesrSI->resultwords != NULL )
+   {
+      free( aTIesrSI->resultwords );
+      aTIesrSI->resultwords = NULL;
+      aTIesrSI->resultsize = 0;
+   }
+
    return TIesrSILErrNone;
 }
 
@@ -409,10 +426,8 @@ TIesrSI_Error_t TIesrSI_getparams( TIesrSI_t aTIesrSI, TIesrSI_Params_t* aParams
       return TIesrSIErrState;
    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIGetparams\n" );
-   fflush( aTIesrSI->logfp );
-#endif
+   /* Engine parameters may not be read while a JAC update is running */
+   TIesrSIL_waitjac( aTIesrSI );
 
    /* Recognizer settings */
    (aTIesrSI->engine).GetTIesrPrune( aTIesrSI->srchmemory, &aParams->pruneFactor );
@@ -491,12 +506,10 @@ TIesrSI_Error_t TIesrSI_getparams( TIesrSI_t aTIesrSI, TIesrSI_Params_t* aParams
    aParams->audioReadRate = aTIesrSI->audioreadrate;
    aParams->audioFrames = aTIesrSI->audioframes;
    aParams->audioPriority = aTIesrSI->audiopriority;
+   aParams->audioPreRoll = aTIesrSI->audiopreroll;
 
+   aParams->asyncJAC = (short)aTIesrSI->asyncjac;
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIGetparams success\n" );
-   fflush( aTIesrSI->logfp );
-#endif
 
    return TIesrSIErrNone;
 }
@@ -516,10 +529,10 @@ TIesrSI_Error_t TIesrSI_setparams( TIesrSI_t aTIesrSI, const TIesrSI_Params_t* a
       return TIesrSIErrState;
    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SISetparams\n" );
-   fflush( aTIesrSI->logfp );
-#endif
+   /* Engine parameters may not be changed while a JAC update is running */
+   TIesrSIL_waitjac( aTIesrSI );
+
+   aTIesrSI->asyncjac = aParams->asyncJAC ? TRUE : FALSE;
 
    /* Set TIesr recognizer settings */
    (aTIesrSI->engine).SetTIesrPrune( aTIesrSI->srchmemory, aParams->pruneFactor );
@@ -601,8 +614,16 @@ TIesrSI_Error_t TIesrSI_setparams( TIesrSI_t aTIesrSI, const TIesrSI_Params_t* a
             aParams->circularFrames != aTIesrSI->circularframes ||
             aParams->audioFrames != aTIesrSI->audioframes ||
             aParams->audioPriority != aTIesrSI->audiopriority ||
-            aParams->audioReadRate != aTIesrSI->audioreadrate )
+            aParams->audioReadRate != aTIesrSI->audioreadrate ||
+            (unsigned int)aParams->audioPreRoll != aTIesrSI->audiopreroll )
     {
+        /* Stop any capture left running for pre-roll */
+        if( aTIesrSI->audioopen )
+        {
+            TIesrFA_close( &aTIesrSI->audiodevice );
+            aTIesrSI->audioopen = FALSE;
+        }
+
         faError = TIesrFA_destroy( &aTIesrSI->audiodevice );
         aTIesrSI->audiostatus = faError;
         if( faError != TIesrFAErrNone )
@@ -615,6 +636,7 @@ TIesrSI_Error_t TIesrSI_setparams( TIesrSI_t aTIesrSI, const TIesrSI_Params_t* a
         aTIesrSI->audioreadrate = aParams->audioReadRate;
         aTIesrSI->audioframes = aParams->audioFrames;
         aTIesrSI->audiopriority = aParams->audioPriority;
+        aTIesrSI->audiopreroll = aParams->audioPreRoll;
 
 
         faError = TIesrFA_init( &aTIesrSI->audiodevice,
@@ -632,12 +654,20 @@ TIesrSI_Error_t TIesrSI_setparams( TIesrSI_t aTIesrSI, const TIesrSI_Params_t* a
         {
             return TIesrSIErrAudio;
         }
-    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SISetparams success\n" );
-   fflush( aTIesrSI->logfp );
-#endif
+        if( aTIesrSI->audiopreroll > 0 )
+        {
+            faError = TIesrFA_preroll( &aTIesrSI->audiodevice,
+                    aTIesrSI->audiopreroll );
+
+            aTIesrSI->audiostatus = faError;
+            if( faError != TIesrFAErrNone )
+            {
+                aTIesrSI->audiopreroll = 0;
+                return TIesrSIErrAudio;
+            }
+        }
+    }
 
    return TIesrSIErrNone;
 }
@@ -674,17 +704,12 @@ TIesrSI_Error_t TIesrSI_start( TIesrSI_t aTIesrSI, int aPriority, char* aCapture
    }
 
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIStart\n" );
-   fflush( aTIesrSI->logfp );
-#endif
+   /* The JAC update of the prior utterance must be in place before the
+   next recognition starts */
+   TIesrSIL_waitjac( aTIesrSI );
 
+   aTIesrSI->pushmode = FALSE;
 
-#ifdef TIESRSI_DEBUG_LOG
-   aTIesrSI->threadfp = fopen( THREADFILE, "w" );
-   if( aTIesrSI->threadfp == NULL )
-      return TIesrSIErrFail;
-#endif
 
 
    /* If the audio file name exists, try to open it for writing
@@ -695,14 +720,6 @@ TIesrSI_Error_t TIesrSI_start( TIesrSI_t aTIesrSI, int aPriority, char* aCapture
       if( !aTIesrSI->audiofp )
       {
 
-#ifdef TIESRSI_DEBUG_LOG
-         if( aTIesrSI->threadfp )
-         {
-            fclose(aTIesrSI->threadfp );
-            aTIesrSI->threadfp = NULL;
-         }
-#endif          
-
          return TIesrSIErrCapture;
       }
    }
@@ -722,14 +739,6 @@ TIesrSI_Error_t TIesrSI_start( TIesrSI_t aTIesrSI, int aPriority, char* aCapture
          aTIesrSI->audiofp = NULL;
       }
 
-#if defined (TIESRSI_DEBUG_LOG)
-      if( aTIesrSI->threadfp )
-      {
-         fclose( aTIesrSI->threadfp );
-         aTIesrSI->threadfp = NULL;
-      }
-#endif
-
       return TIesrSIErrFail;
    }
 
@@ -737,15 +746,67 @@ TIesrSI_Error_t TIesrSI_start( TIesrSI_t aTIesrSI, int aPriority, char* aCapture
    /* Reset variables for the recognition */
    aTIesrSI->startok = FALSE;
    aTIesrSI->stopreco = FALSE;
+   aTIesrSI->resultready = FALSE;
+   aTIesrSI->jacstatus = eTIesrEngineJACSuccess;
+
+
+#if defined (LINUX)
+   /* A recognizer attached to a server is started here and then handed
+   to the server workers instead of to its own thread */
+   if( aTIesrSI->server != NULL )
+   {
+      TIesrSI_Server_t server = aTIesrSI->server;
+      unsigned int w;
+
+      /* Have the channel wake the server workers when it has a frame.
+      Idle workers poll a channel that can not. */
+      aTIesrSI->serverpolled = ( TIesrFA_notify( &aTIesrSI->audiodevice,
+         TIesrSIL_wakeserver, server ) != TIesrFAErrNone );
+
+      silError = TIesrSIL_startreco( aTIesrSI );
+      if( silError != TIesrSILErrNone )
+      {
+         TIesrFA_notify( &aTIesrSI->audiodevice, NULL, NULL );
+         TIesrSIL_resetsync( aTIesrSI );
+
+         if( aTIesrSI->audiofp )
+         {
+            fclose( aTIesrSI->audiofp );
+            aTIesrSI->audiofp = NULL;
+         }
+
+         return TIesrSIErrThread;
+      }
+
+      aTIesrSI->startok = TRUE;
+
+      pthread_mutex_lock( &server->mutex );
+      server->numrunning++;
+      if( aTIesrSI->serverpolled )
+      {
+         server->numpolled++;
+      }
+      w = server->nextworker;
+      server->nextworker = ( w + 1 ) % server->numworkers;
+      pthread_mutex_unlock( &server->mutex );
+
+      /* A worker may complete the recognition and call the done
+      callback as soon as the recognizer is queued */
+      aTIesrSI->state = TIesrSIStateRunning;
+
+      TIesrSIL_enqueue( &server->worker[w].queue, aTIesrSI );
+
+      TIesrSIL_wakeserver( server );
+
+      return TIesrSIErrNone;
+   }
+#endif
 
 
    /* Start the recognition thread running */
 
 #if defined (LINUX)
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIStart create thread\n" );
-#endif
    /* Set thread attributes - the requested priority is the only changed attribute */
    result = pthread_attr_init(&attr);
    result = pthread_attr_getschedparam( &attr, &sparam );
@@ -770,23 +831,11 @@ TIesrSI_Error_t TIesrSI_start( TIesrSI_t aTIesrSI, int aPriority, char* aCapture
          aTIesrSI->audiofp = NULL;
       }
 
-#if defined (TIESRSI_DEBUG_LOG)
-      if( aTIesrSI->threadfp )
-      {
-         fclose( aTIesrSI->threadfp );
-         aTIesrSI->threadfp = NULL;
-      }
-#endif
-
       return TIesrSIErrThread;
    }
 
 #elif defined (WIN32) || defined (WINCE)
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIStart create thread\n" );
-#endif
-
    aTIesrSI->threadid = CreateThread( NULL, 0,
            (LPTHREAD_START_ROUTINE)TIesrSIL_thread, aTIesrSI,
       CREATE_SUSPENDED, NULL );
@@ -800,24 +849,12 @@ TIesrSI_Error_t TIesrSI_start( TIesrSI_t aTIesrSI, int aPriority, char* aCapture
          fclose( aTIesrSI->audiofp );
          aTIesrSI->audiofp = NULL;
       }
-#if defined (TIESRSI_DEBUG_LOG)
-      if( aTIesrSI->threadfp )
-      {
-         fclose( aTIesrSI->threadfp );
-         aTIesrSI->logfp = NULL;
-      }
-#endif
 
       return TIesrSIErrThread;
    }
 
    SetThreadPriority( aTIesrSI->threadid, aPriority );
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIStart run thread\n" );
-   fflush( aTIesrSI->logfp );
-#endif   
-   
    ResumeThread( aTIesrSI->threadid );
 
 #endif
@@ -854,24 +891,12 @@ TIesrSI_Error_t TIesrSI_start( TIesrSI_t aTIesrSI, int aPriority, char* aCapture
          aTIesrSI->audiofp = NULL;
       }
 
-#if defined (TIESRSI_DEBUG_LOG)
-      if( aTIesrSI->threadfp )
-      {
-         fclose( aTIesrSI->threadfp );
-         aTIesrSI->threadfp = NULL;
-      }
-#endif
-
       return TIesrSIErrThread;
    }
 
    /* The recognizer started ok, and a recognition thread started ok */
    aTIesrSI->state = TIesrSIStateRunning;
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIStart success\n" );
-   fflush( aTIesrSI->logfp );
-#endif
    return TIesrSIErrNone;
 }
 
@@ -901,6 +926,15 @@ TIesrSIL_Error_t TIesrSIL_initsync( TIesrSI_t aTIesrSI )
       return TIesrSILErrFail;
    }
 
+   error = sem_init( &(aTIesrSI->donesemaphore), 0, 0 );   
+   if( error )
+   {
+      error = sem_destroy( &(aTIesrSI->startsemaphore) );
+      error = pthread_mutex_destroy( &(aTIesrSI->recomutex) );
+
+      return TIesrSILErrFail;
+   }
+
 #elif defined (WIN32) || defined (WINCE)
 
    aTIesrSI->recomutex = CreateMutex( NULL, FALSE, NULL );
@@ -946,6 +980,12 @@ static TIesrSIL_Error_t TIesrSIL_resetsync( TIesrSI_t aTIesrSI )
       silError = TIesrSILErrFail;
    }
 
+   error = sem_destroy( &(aTIesrSI->donesemaphore) );   
+   if( error != 0 )
+   {
+      silError = TIesrSILErrFail;
+   }
+
 #elif defined (WIN32) || defined (WINCE)
    if( ! CloseHandle( aTIesrSI->recomutex ) )
    {
@@ -977,85 +1017,29 @@ DWORD TIesrSIL_thread( LPVOID aArg )
 #endif
 {
    TIesrFA_Error_t faError;
-   TIesrFA_Error_t faStopError;
-   TIesrFA_Error_t faCloseError;
-   TIesrEngineStatusType engStatus;
-   TIesrEngineJACStatusType jacStatus;
-   TIesrSI_Error_t siError;
+   TIesrSIL_Error_t silError;
 
    TIesrSI_t aTIesrSI = (TIesrSI_t)aArg;
 
    unsigned int framesQueued;
 
-   int recoEnded = FALSE;
-   int startCalled = FALSE;
-
-
-#ifdef TIESRSI_DEBUG_LOG
-   int frame = 0;
-   fprintf( aTIesrSI->threadfp, "SIThread\n" );
-   fflush( aTIesrSI->threadfp );
-#endif
 
 
    /* Ensure that initially flag set to indicate thread did not start ok */
    aTIesrSI->startok = FALSE;
 
 
-   /* Open the search engine, which prepares it for recognition. On failure
-   inform the start function via the start semaphore and exit the thread. */
-   engStatus = (aTIesrSI->engine).OpenSearchEngine( aTIesrSI->srchmemory );
-   aTIesrSI->recostatus = engStatus;
-   if( engStatus != eTIesrEngineSuccess )
-   {
-#if defined (LINUX)
-      sem_post( &aTIesrSI->startsemaphore );
-      return (void*)TIesrSILErrReco;
-#elif defined (WIN32) || defined (WINCE)
-      SetEvent( aTIesrSI->startevent );
-      return TIesrSILErrReco;
-#endif
-   }
-
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->threadfp, "SIThread opening FA\n" );
-   fflush( aTIesrSI->threadfp );
-#endif
-
-   /* Open an audio channel which connects to the audio device.  On failure
+   /* Open the search engine and start audio collection.  On failure
    inform the start function via the start semaphore and exit the thread. */
-   faError = TIesrFA_open( &aTIesrSI->audiodevice );
-   aTIesrSI->audiostatus = faError;
-   if( faError != TIesrFAErrNone )
-   {
-#if defined (LINUX)
-      sem_post( &aTIesrSI->startsemaphore );
-      return (void*)TIesrSILErrAudio;
-#elif defined (WIN32) || defined (WINCE)
-      SetEvent( aTIesrSI->startevent );
-      return TIesrSILErrAudio;
-#endif
-   }
-
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->threadfp, "SIThread starting FA\n" );
-   fflush( aTIesrSI->threadfp );
-#endif
-
-   /* Start collection of audio samples into the circular frame buffer. On
-   failure, close the audio channel, inform the start function via the
-   start semaphore and exit the thread. */
-   faError = TIesrFA_start( &aTIesrSI->audiodevice );
-   aTIesrSI->audiostatus = faError;
-   if( faError != TIesrFAErrNone )
+   silError = TIesrSIL_startreco( aTIesrSI );
+   if( silError != TIesrSILErrNone )
    {
-      faCloseError = TIesrFA_close( &aTIesrSI->audiodevice );
 #if defined (LINUX)
       sem_post( &aTIesrSI->startsemaphore );
-      return (void*)TIesrSILErrAudio;
+      return (void*)silError;
 #elif defined (WIN32) || defined (WINCE)
       SetEvent( aTIesrSI->startevent );
-      return TIesrSILErrAudio;
+      return silError;
 #endif
    }
 
@@ -1070,11 +1054,6 @@ DWORD TIesrSIL_thread( LPVOID aArg )
    SetEvent( aTIesrSI->startevent );
 #endif
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->threadfp, "SIThread start loop\n" );
-   fflush( aTIesrSI->threadfp );
-#endif
-
    /* Get the first frame of data, blocking until it is received */
    faError = TIesrFA_getframe( &aTIesrSI->audiodevice, (unsigned char*)aTIesrSI->framedata, 
       BLOCKING, &framesQueued );
@@ -1084,76 +1063,11 @@ DWORD TIesrSIL_thread( LPVOID aArg )
    a request to terminate recognition, or failure */
    while( faError == TIesrFAErrNone && !aTIesrSI->stopreco )
    {
-      /* If user wants to save audio data, write to a file */
-      if( aTIesrSI->audiofp )
+      if( ! TIesrSIL_frame( aTIesrSI, framesQueued ) )
       {
-         fwrite( (void*)aTIesrSI->framedata, sizeof(short),
-            FRAME_LEN, aTIesrSI->audiofp );
-      }
-
-#if defined (TIESRSI_DEBUG_LOG)
-      /* If debug logging, capture number of frames queued */
-      if( aTIesrSI->threadfp )
-      {
-         fprintf( aTIesrSI->threadfp, "Queued: %d\n", framesQueued );
-         fflush( aTIesrSI->threadfp );
-      }
-#endif
-
-#ifdef TIESRSI_DEBUG_LOG
-      fprintf( aTIesrSI->threadfp, "SIThread calling engine %d\n", frame );
-      fflush( aTIesrSI->threadfp );
-#endif
-
-      /* Process the frame of data in the TIesr Engine */
-      engStatus = (aTIesrSI->engine).CallSearchEngine( aTIesrSI->framedata,
-         aTIesrSI->srchmemory, framesQueued );
-
-#ifdef TIESRSI_DEBUG_LOG
-      fprintf( aTIesrSI->threadfp, "SIThread engine done %d %d\n", frame, engStatus );
-      fflush( aTIesrSI->threadfp );
-#endif
-      aTIesrSI->recostatus = engStatus;
-
-      /* Catch recognition engine error and exit loop immediately */
-      if( engStatus != eTIesrEngineSuccess )
-      {
-         break;
-      }
-
-      /* If LIVEMODE defined in tieser_config.h then when the utterance end is detected
-      the recognizer should stop processing frames of data */
-
-#ifdef LIVEMODE
-
-      recoEnded = (aTIesrSI->engine).SpeechEnded( aTIesrSI->srchmemory );
-      if( recoEnded )
-      {  
-         /* Can't print in an API.  Protect this with a debug define macro.
-         printf("reco ended \n"); */
          break;
       }
 
-#endif
-
-
-      /* Determine if speech started early or if the JAC has completed one pass */
-      if( !startCalled && aTIesrSI->speakcb != NULL &&
-         (  (aTIesrSI->engine).GetCycleCount( aTIesrSI->srchmemory ) > 0  || 
-         (aTIesrSI->engine).SpeechDetected( aTIesrSI->srchmemory ) ) )
-      {
-         startCalled = TRUE;
-
-         if( (aTIesrSI->engine).GetCycleCount( aTIesrSI->srchmemory ) > 0 )
-         {
-            (aTIesrSI->speakcb)(aTIesrSI->cbdata, TIesrSIErrNone );
-         }
-         else
-         {
-            (aTIesrSI->speakcb)(aTIesrSI->cbdata, TIesrSIErrSpeechEarly );
-         }
-      }   
-
       /* Get next frame of data */
       faError = TIesrFA_getframe( &aTIesrSI->audiodevice, 
          (unsigned char*)aTIesrSI->framedata, BLOCKING,
@@ -1163,142 +1077,856 @@ DWORD TIesrSIL_thread( LPVOID aArg )
       condition returned */
       if ( faError == TIesrFAErrEOF )
       { 
-         recoEnded = 1; 
+         aTIesrSI->recoended = TRUE; 
          break;
       }
    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->threadfp, "SIThread exit loop\n" );
-   fflush( aTIesrSI->threadfp );
-#endif
+   aTIesrSI->frameerror = faError;
+   TIesrSIL_endreco( aTIesrSI );
 
-   /* The loop has been exited. Stop data collection and disconnect from the channel.
-   Determine audio status at end of recognition */
-   faStopError = TIesrFA_stop( &aTIesrSI->audiodevice );   
-   faCloseError = TIesrFA_close( &aTIesrSI->audiodevice );
-   if( faError != TIesrFAErrNone && faError != TIesrFAErrEOF )
-      aTIesrSI->audiostatus = faError;
-   else if( faStopError != TIesrFAErrNone )
-      aTIesrSI->audiostatus = faStopError;
-   else if( faCloseError != TIesrFAErrNone )
-      aTIesrSI->audiostatus = faCloseError;
-   else
-      aTIesrSI->audiostatus = faError;
+   /* Terminate the thread after a recognition process. */
 
+#if defined (LINUX)
+   return (void*)TIesrSILErrNone;
+#elif defined (WIN32) || defined (WINCE)
+   return TIesrSILErrNone;
+#endif
+}
 
-   /* Close the search engine, which among other things does a backtrace
-   for the recognition result and sets volume status */
-   if( recoEnded )
-   {
-      engStatus = (aTIesrSI->engine).CloseSearchEngine( engStatus, 
-         aTIesrSI->srchmemory );
 
-      aTIesrSI->recostatus = engStatus;
-   }
+/*----------------------------------------------------------------
+TIesrSIL_startreco
 
-   /* If recognition ended successfully, and user is not trying to shut down
-   the recognizer, do JAC update */
+Open the search engine and the audio channel, and start audio collection
+for a recognition.  On failure nothing is left open.
+--------------------------------*/
+static TIesrSIL_Error_t TIesrSIL_startreco( TIesrSI_t aTIesrSI )
+{
+   TIesrFA_Error_t faError;
+   TIesrEngineStatusType engStatus;
 
-   /*  Now recommend doing JAC update all the time, since
-   modifications to JAC ensure all means updated if speech starts.  Thus there
-   is not a need to check if at least one JAC cycle completed.
+   aTIesrSI->recoended = FALSE;
+   aTIesrSI->speakcalled = FALSE;
+   aTIesrSI->frameerror = TIesrFAErrNone;
 
-   if( recoEnded && engStatus == eTIesrEngineSuccess && !aTIesrSI->stopreco &&
-   (aTIesrSI->engine).GetCycleCount( aTIesrSI->srchmemory ) > 0 )
-   */
-   if( recoEnded && engStatus == eTIesrEngineSuccess && !aTIesrSI->stopreco )        
+   if( aTIesrSI->traceevents > 0 )
    {
-      jacStatus = (aTIesrSI->engine).JAC_update( aTIesrSI->srchmemory );
+      aTIesrSI->tracestart = (aTIesrSI->engine).GetTIesrClock();
+   }
 
-      aTIesrSI->jacstatus = jacStatus;
+   /* Open the search engine, which prepares it for recognition. */
+   engStatus = (aTIesrSI->engine).OpenSearchEngine( aTIesrSI->srchmemory );
+   aTIesrSI->recostatus = engStatus;
+   if( engStatus != eTIesrEngineSuccess )
+   {
+      return TIesrSILErrReco;
    }
 
-   /* Notify the application of recognition thread completion */
-   if( aTIesrSI->donecb != NULL )
-   {
-      if( ( aTIesrSI->audiostatus != TIesrFAErrNone && 
-         aTIesrSI->audiostatus != TIesrFAErrEOF ) &&
-         ( aTIesrSI->recostatus != eTIesrEngineSuccess || 
-         ( (aTIesrSI->jacstatus != eTIesrEngineJACSuccess) && 
-         (aTIesrSI->jacstatus != eTIesrEngineJACNoAlignment ) ) ) )
-         siError = TIesrSIErrBoth;
-      else if( aTIesrSI->audiostatus != TIesrFAErrNone && 
-         aTIesrSI->audiostatus != TIesrFAErrEOF )
-         siError = TIesrSIErrAudio;
-      else if( aTIesrSI->recostatus != eTIesrEngineSuccess ||
-         ( (aTIesrSI->jacstatus != eTIesrEngineJACSuccess) && 
-         (aTIesrSI->jacstatus != eTIesrEngineJACNoAlignment ) ))
-         siError = TIesrSIErrReco;
-      else
-         siError = TIesrSIErrNone;
+   /* Open an audio channel which connects to the audio device, unless it
+   was left open and capturing for pre-roll by the last recognition. */
+   if( !aTIesrSI->audioopen )
+   {
+      faError = TIesrFA_open( &aTIesrSI->audiodevice );
+      aTIesrSI->audiostatus = faError;
+      if( faError != TIesrFAErrNone )
+      {
+         return TIesrSILErrAudio;
+      }
 
-      (aTIesrSI->donecb)( aTIesrSI->cbdata, siError );
+      aTIesrSI->audioopen = TRUE;
    }
 
-   /* Can't print in an API.  Protect this with a debug macro
-   if( aTIesrSI->recostatus ==  eTIesrEngineBeamCellOverflow)  printf ("---BEAM OVER FLOW\n"); */
-
-   /* Terminate the thread after a recognition process. */
+   /* Start collection of audio samples into the circular frame buffer. On
+   failure, close the audio channel. */
+   faError = TIesrFA_start( &aTIesrSI->audiodevice );
+   aTIesrSI->audiostatus = faError;
+   if( faError != TIesrFAErrNone )
+   {
+      TIesrFA_close( &aTIesrSI->audiodevice );
+      aTIesrSI->audioopen = FALSE;
+      return TIesrSILErrAudio;
+   }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->threadfp, "SIThread ended\n" );
-   fflush( aTIesrSI->threadfp );
-#endif
+   if( aTIesrSI->traceevents > 0 )
+   {
+      aTIesrSI->traceaudio = (aTIesrSI->engine).GetTIesrClock();
+      aTIesrSI->tracepreroll = 0;
+   }
 
-#if defined (LINUX)
-   return (void*)TIesrSILErrNone;
-#elif defined (WIN32) || defined (WINCE)
    return TIesrSILErrNone;
-#endif
 }
 
 
 /*----------------------------------------------------------------
-TIesrSI_stop
+TIesrSIL_frame
 
-This function stops recognition.  It may stop recognition in the middle
-of the task, or after the recognition is complete and has signaled it
-is done by calling the callback function.  This function ensures that
-the threads have shut down appropriately.
----------------------------------------------------------------------*/
-TIESRSI_API
-TIesrSI_Error_t TIesrSI_stop( TIesrSI_t aTIesrSI )
+Process the frame of data in framedata.  Returns FALSE if no more frames
+should be processed, either because the engine failed or the end of the
+utterance was detected, in which case recoended is set.
+--------------------------------*/
+static int TIesrSIL_frame( TIesrSI_t aTIesrSI, unsigned int aFramesQueued )
 {
-#if defined(LINUX)
-   TIesrSIL_Error_t threadError;
-   void* threadReturn;
-#endif
+   TIesrEngineStatusType engStatus;
 
-   /* Check state to ensure a recognizer thread is running */
-   if( aTIesrSI->state != TIesrSIStateRunning )
+   /* If user wants to save audio data, write to a file */
+   if( aTIesrSI->audiofp )
    {
-      return TIesrSIErrState;
+      fwrite( (void*)aTIesrSI->framedata, sizeof(short),
+         FRAME_LEN, aTIesrSI->audiofp );
    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIStop\n" );
-   fflush( aTIesrSI->logfp );
-#endif
+   if( aTIesrSI->traceevents > 0 && aTIesrSI->audiopreroll > 0 &&
+      ! aTIesrSI->pushmode &&
+      (aTIesrSI->engine).GetFrameCount( aTIesrSI->srchmemory ) == 0 )
+   {
+      TIesrSIL_tracepreroll( aTIesrSI, aFramesQueued );
+   }
 
-   /* Set flag to force the recognizer thread to terminate, if that has
-   not happened already due to normal end of recognition.  */
-   aTIesrSI->stopreco = TRUE;
+   /* Process the frame of data in the TIesr Engine */
+   engStatus = (aTIesrSI->engine).CallSearchEngine( aTIesrSI->framedata,
+      aTIesrSI->srchmemory, aFramesQueued );
+
+   aTIesrSI->recostatus = engStatus;
+
+   /* Mark the processing of the pre-roll frames in the trace */
+   if( aTIesrSI->traceevents > 0 && aTIesrSI->tracepreroll > 0 &&
+      (aTIesrSI->engine).GetFrameCount( aTIesrSI->srchmemory ) ==
+      aTIesrSI->tracepreroll )
+   {
+      (aTIesrSI->engine).TraceTIesrEvent( aTIesrSI->srchmemory,
+         "preroll", aTIesrSI->traceaudio );
+   }
+
+   /* Catch recognition engine error and exit loop immediately */
+   if( engStatus != eTIesrEngineSuccess )
+   {
+      return FALSE;
+   }
+
+   /* If LIVEMODE defined in tieser_config.h then when the utterance end is detected
+   the recognizer should stop processing frames of data */
+
+#ifdef LIVEMODE
+
+   aTIesrSI->recoended = (aTIesrSI->engine).SpeechEnded( aTIesrSI->srchmemory );
+   if( aTIesrSI->recoended )
+   {  
+      /* Can't print in an API.  Protect this with a debug define macro.
+      printf("reco ended \n"); */
+      return FALSE;
+   }
+
+#endif
+
+
+   /* Determine if speech started early or if the JAC has completed one pass */
+   if( !aTIesrSI->speakcalled && aTIesrSI->speakcb != NULL &&
+      (  (aTIesrSI->engine).GetCycleCount( aTIesrSI->srchmemory ) > 0  || 
+      (aTIesrSI->engine).SpeechDetected( aTIesrSI->srchmemory ) ) )
+   {
+      aTIesrSI->speakcalled = TRUE;
+
+      if( (aTIesrSI->engine).GetCycleCount( aTIesrSI->srchmemory ) > 0 )
+      {
+         (aTIesrSI->speakcb)(aTIesrSI->cbdata, TIesrSIErrNone );
+      }
+      else
+      {
+         (aTIesrSI->speakcb)(aTIesrSI->cbdata, TIesrSIErrSpeechEarly );
+      }
+   }   
+
+   return TRUE;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_endreco
+
+Complete a recognition once the frame loop has exited.  This stops
+audio collection, closes the search engine, does the JAC update and
+calls the done callback.
+--------------------------------*/
+static void TIesrSIL_endreco( TIesrSI_t aTIesrSI )
+{
+   TIesrFA_Error_t faError = aTIesrSI->frameerror;
+   TIesrFA_Error_t faStopError;
+   TIesrFA_Error_t faCloseError;
+   TIesrEngineStatusType engStatus = aTIesrSI->recostatus;
+   TIesrSI_Error_t siError;
+
+   /* Stop data collection and disconnect from the channel.  With pre-roll
+   the channel stays open and capturing until the next recognition.
+   Determine audio status at end of recognition.  A push mode recognition
+   does not use the audio channel. */
+   if( ! aTIesrSI->pushmode )
+   {
+      faStopError = TIesrFA_stop( &aTIesrSI->audiodevice );   
+      faCloseError = TIesrFAErrNone;
+      if( aTIesrSI->audiopreroll == 0 )
+      {
+         faCloseError = TIesrFA_close( &aTIesrSI->audiodevice );
+         aTIesrSI->audioopen = FALSE;
+      }
+      if( faError != TIesrFAErrNone && faError != TIesrFAErrEOF )
+         aTIesrSI->audiostatus = faError;
+      else if( faStopError != TIesrFAErrNone )
+         aTIesrSI->audiostatus = faStopError;
+      else if( faCloseError != TIesrFAErrNone )
+         aTIesrSI->audiostatus = faCloseError;
+      else
+         aTIesrSI->audiostatus = faError;
+   }
+
+
+   /* Close the search engine, which among other things does a backtrace
+   for the recognition result and sets volume status */
+   if( aTIesrSI->recoended )
+   {
+      engStatus = (aTIesrSI->engine).CloseSearchEngine( engStatus, 
+         aTIesrSI->srchmemory );
+
+      aTIesrSI->recostatus = engStatus;
+
+      if( aTIesrSI->traceevents > 0 )
+      {
+         (aTIesrSI->engine).TraceTIesrEvent( aTIesrSI->srchmemory,
+            "utterance", aTIesrSI->tracestart );
+         aTIesrSI->traceresult = (aTIesrSI->engine).GetTIesrClock();
+      }
+   }
+
+   /* If recognition ended successfully, and user is not trying to shut down
+   the recognizer, do JAC update */
+
+   /*  Now recommend doing JAC update all the time, since
+   modifications to JAC ensure all means updated if speech starts.  Thus there
+   is not a need to check if at least one JAC cycle completed.
+
+   if( recoEnded && engStatus == eTIesrEngineSuccess && !aTIesrSI->stopreco &&
+   (aTIesrSI->engine).GetCycleCount( aTIesrSI->srchmemory ) > 0 )
+   */
+   if( aTIesrSI->recoended && engStatus == eTIesrEngineSuccess && !aTIesrSI->stopreco )        
+   {
+      /* If JAC is asynchronous, save the result for the application and
+      notify it before doing the JAC update. TIesrSI_stop checks
+      resultready under the mutex to decide whether to wait for the
+      thread, so the snapshot is only taken if no stop was requested.
+      A push mode recognition runs in the application thread, so needs
+      no mutex. */
+      if( aTIesrSI->asyncjac && aTIesrSI->pushmode )
+      {
+         if( TIesrSIL_saveresult( aTIesrSI ) == TIesrSILErrNone )
+         {
+            aTIesrSI->resultready = TRUE;
+         }
+      }
+      else if( aTIesrSI->asyncjac )
+      {
+#if defined (LINUX)
+         pthread_mutex_lock( &aTIesrSI->recomutex );
+#elif defined (WIN32) || defined (WINCE)
+         WaitForSingleObject( aTIesrSI->recomutex, INFINITE );
+#endif
+         if( !aTIesrSI->stopreco &&
+            TIesrSIL_saveresult( aTIesrSI ) == TIesrSILErrNone )
+         {
+            aTIesrSI->resultready = TRUE;
+         }
+#if defined (LINUX)
+         pthread_mutex_unlock( &aTIesrSI->recomutex );
+#elif defined (WIN32) || defined (WINCE)
+         ReleaseMutex( aTIesrSI->recomutex );
+#endif
+      }
+
+      if( aTIesrSI->resultready )
+      {
+         if( aTIesrSI->donecb != NULL )
+         {
+            siError = TIesrSIL_donestatus( aTIesrSI );
+            (aTIesrSI->donecb)( aTIesrSI->cbdata, siError );
+         }
+
+      }
+
+      /* In push mode an asynchronous JAC update is left for
+      TIesrSI_completejac */
+      if( ! ( aTIesrSI->pushmode && aTIesrSI->resultready ) )
+      {
+         TIesrSIL_jacupdate( aTIesrSI );
+      }
+   }
+
+   /* Notify the application of recognition thread completion, if not
+   already done prior to the JAC update */
+   if( aTIesrSI->donecb != NULL && !aTIesrSI->resultready )
+   {
+      siError = TIesrSIL_donestatus( aTIesrSI );
+      (aTIesrSI->donecb)( aTIesrSI->cbdata, siError );
+   }
+
+   /* Can't print in an API.  Protect this with a debug macro
+   if( aTIesrSI->recostatus ==  eTIesrEngineBeamCellOverflow)  printf ("---BEAM OVER FLOW\n"); */
+
+   TIesrSIL_tracereco( aTIesrSI );
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_jacupdate
+
+Do the JAC update of the utterance just recognized, recording it in the
+trace.
+--------------------------------*/
+static void TIesrSIL_jacupdate( TIesrSI_t aTIesrSI )
+{
+   unsigned long long start = 0;
+
+   if( aTIesrSI->traceevents > 0 )
+   {
+      start = (aTIesrSI->engine).GetTIesrClock();
+   }
+
+   aTIesrSI->jacstatus = (aTIesrSI->engine).JAC_update( aTIesrSI->srchmemory );
+
+   if( aTIesrSI->traceevents > 0 )
+   {
+      (aTIesrSI->engine).TraceTIesrEvent( aTIesrSI->srchmemory,
+         "jac_update", start );
+   }
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_tracepreroll
+
+Find the number of frames of a recognition that were captured before
+audio collection started, from the frames available when the first frame
+is processed less those captured since the start.
+--------------------------------*/
+static void TIesrSIL_tracepreroll( TIesrSI_t aTIesrSI, unsigned int aFramesQueued )
+{
+   unsigned long long captured;
+   unsigned int available = aFramesQueued + 1;
+
+   captured = ( (aTIesrSI->engine).GetTIesrClock() - aTIesrSI->traceaudio ) *
+      SAM_FREQ / ( (unsigned long long)FRAME_LEN * 1000000000 );
+
+   if( available > captured )
+   {
+      aTIesrSI->tracepreroll = available - (unsigned int)captured;
+      if( aTIesrSI->tracepreroll > aTIesrSI->audiopreroll )
+      {
+         aTIesrSI->tracepreroll = aTIesrSI->audiopreroll;
+      }
+   }
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_tracereco
+
+Write the trace to the file requested by TIesrSI_trace if the result of
+the recognition just completed lagged the end of its audio by more than
+the requested time.  The result is available when the backtrace
+completes, before any JAC update.  The audio ends one frame time per
+frame processed after audio collection started, not counting pre-roll
+frames captured before it started.  This runs after the last frame is
+processed, so the trace is not being recorded.
+--------------------------------*/
+static void TIesrSIL_tracereco( TIesrSI_t aTIesrSI )
+{
+   unsigned long long elapsed;
+   unsigned long long audio;
+   unsigned int frames;
+
+   if( aTIesrSI->traceevents == 0 || aTIesrSI->tracefile == NULL ||
+      ! aTIesrSI->recoended )
+   {
+      return;
+   }
+
+   frames = (aTIesrSI->engine).GetFrameCount( aTIesrSI->srchmemory );
+   frames = frames > aTIesrSI->tracepreroll ? frames - aTIesrSI->tracepreroll : 0;
+
+   /* Times in microseconds */
+   elapsed = ( aTIesrSI->traceresult - aTIesrSI->traceaudio ) / 1000;
+   audio = (unsigned long long)frames * FRAME_LEN * 1000000 / SAM_FREQ;
+
+   if( elapsed > audio + (unsigned long long)aTIesrSI->tracelag * 1000 )
+   {
+      (aTIesrSI->engine).DumpTIesrTrace( aTIesrSI->srchmemory,
+         aTIesrSI->tracefile );
+   }
+}
 
 
-   /* Wait for the recognizer thread to stop */
+/*----------------------------------------------------------------
+TIesrSIL_join
+
+Wait for the recognition started by TIesrSI_start to complete.  This
+joins the recognition thread, or waits for the server to post that it
+has completed the recognition.
+--------------------------------*/
+static TIesrSIL_Error_t TIesrSIL_join( TIesrSI_t aTIesrSI )
+{
 #if defined (LINUX)
+   void* threadReturn;
+   int result;
+
+   if( aTIesrSI->server != NULL )
+   {
+      do
+      {
+         result = sem_wait( &aTIesrSI->donesemaphore );
+      }
+      while( result && errno == EINTR );
+
+      return TIesrSILErrNone;
+   }
+
    pthread_join( aTIesrSI->threadid, &threadReturn );
-   threadError = (TIesrSIL_Error_t)threadReturn;
+   return (TIesrSIL_Error_t)threadReturn;
+
 #elif defined (WIN32) || defined (WINCE)
    WaitForSingleObject( aTIesrSI->threadid, INFINITE );
    CloseHandle( aTIesrSI->threadid );
    aTIesrSI->threadid = NULL;
+
+   return TIesrSILErrNone;
 #endif
+}
+
+
+#if defined (LINUX)
+/*----------------------------------------------------------------
+TIesrSIL_enqueue
+
+Add a running recognizer to the tail of a worker queue.
+--------------------------------*/
+static void TIesrSIL_enqueue( TIesrSIL_Queue_t* aQueue, TIesrSI_t aTIesrSI )
+{
+   aTIesrSI->next = NULL;
+
+   pthread_mutex_lock( &aQueue->mutex );
+   if( aQueue->tail != NULL )
+      aQueue->tail->next = aTIesrSI;
+   else
+      aQueue->head = aTIesrSI;
+   aQueue->tail = aTIesrSI;
+   pthread_mutex_unlock( &aQueue->mutex );
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_dequeue
+
+Remove the recognizer at the head of a worker queue.  Returns NULL if
+the queue is empty.
+--------------------------------*/
+static TIesrSI_t TIesrSIL_dequeue( TIesrSIL_Queue_t* aQueue )
+{
+   TIesrSI_t aTIesrSI;
+
+   pthread_mutex_lock( &aQueue->mutex );
+   aTIesrSI = aQueue->head;
+   if( aTIesrSI != NULL )
+   {
+      aQueue->head = aTIesrSI->next;
+      if( aQueue->head == NULL )
+         aQueue->tail = NULL;
+   }
+   pthread_mutex_unlock( &aQueue->mutex );
+
+   return aTIesrSI;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_serve
+
+Process the frames available for a server recognizer, up to
+TIESRSI_SERVER_BATCH frames, without blocking.  The number of frames
+processed is returned in aFrames.  Returns TRUE when the frame loop of
+the recognition has ended, the same way as in TIesrSIL_thread.
+--------------------------------*/
+static int TIesrSIL_serve( TIesrSI_t aTIesrSI, int* aFrames )
+{
+   TIesrFA_Error_t faError;
+   unsigned int framesQueued;
+
+   for( *aFrames = 0; *aFrames < TIESRSI_SERVER_BATCH; (*aFrames)++ )
+   {
+      if( aTIesrSI->stopreco )
+      {
+         return TRUE;
+      }
+
+      faError = TIesrFA_getframe( &aTIesrSI->audiodevice,
+         (unsigned char*)aTIesrSI->framedata, !BLOCKING, &framesQueued );
+
+      if( faError == TIesrFAErrNoFrame )
+      {
+         return FALSE;
+      }
+
+      aTIesrSI->frameerror = faError;
+
+      if( faError == TIesrFAErrEOF )
+      {
+         aTIesrSI->recoended = TRUE;
+         return TRUE;
+      }
+
+      if( faError != TIesrFAErrNone || ! TIesrSIL_frame( aTIesrSI, framesQueued ) )
+      {
+         return TRUE;
+      }
+   }
+
+   return FALSE;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_worker
+
+Server worker thread.  The worker takes a recognizer from the head of
+its own queue, or from another worker queue if its own is empty,
+processes the frames that are available, and puts the recognizer back
+on the tail of its own queue.  A recognizer is in at most one queue, so
+only one worker processes it at a time.  Once the worker has found no
+frame available as many times in a row as there are running
+recognizers, it waits for a channel to notify the server of a frame.
+--------------------------------*/
+static void* TIesrSIL_worker( void* aWorker )
+{
+   TIesrSIL_Worker_t* worker = (TIesrSIL_Worker_t*)aWorker;
+   TIesrSI_Server_t server = worker->server;
+   TIesrSI_t aTIesrSI;
+   unsigned int idle = 0;
+   unsigned long events = 0;
+   unsigned int w;
+   int frames;
+   int ended;
+
+   while( TRUE )
+   {
+      pthread_mutex_lock( &server->mutex );
+
+      /* At the end of a run of idle recognizers, wait unless there has
+      been a frame notification or a recognition start since it began */
+      if( idle >= server->numrunning )
+      {
+         if( server->numevents == events && !server->exitworkers )
+         {
+            TIesrSIL_waitserver( server );
+         }
+         idle = 0;
+      }
+
+      if( idle == 0 )
+      {
+         events = server->numevents;
+      }
+
+      if( server->exitworkers )
+      {
+         pthread_mutex_unlock( &server->mutex );
+         break;
+      }
+
+      pthread_mutex_unlock( &server->mutex );
+
+      aTIesrSI = TIesrSIL_dequeue( &worker->queue );
+      for( w = 1; aTIesrSI == NULL && w < server->numworkers; w++ )
+      {
+         aTIesrSI = TIesrSIL_dequeue( 
+            &server->worker[ (worker->index + w) % server->numworkers ].queue );
+      }
+
+      /* All running recognizers are held by other workers, or none
+      are running */
+      if( aTIesrSI == NULL )
+      {
+         idle = UINT_MAX;
+         continue;
+      }
+
+      ended = TIesrSIL_serve( aTIesrSI, &frames );
+
+      if( ended )
+      {
+         TIesrSIL_endreco( aTIesrSI );
+         TIesrFA_notify( &aTIesrSI->audiodevice, NULL, NULL );
+
+         pthread_mutex_lock( &server->mutex );
+         server->numrunning--;
+         if( aTIesrSI->serverpolled )
+         {
+            server->numpolled--;
+         }
+         pthread_mutex_unlock( &server->mutex );
+
+         /* The recognizer may be stopped and closed once this is posted */
+         sem_post( &aTIesrSI->donesemaphore );
+         idle = 0;
+         continue;
+      }
+
+      TIesrSIL_enqueue( &worker->queue, aTIesrSI );
+
+      idle = ( frames > 0 ) ? 0 : idle + 1;
+   }
+
+   return NULL;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_wakeserver
+
+Notify the server workers that a channel has a frame available, or that
+a recognition started.  All idle workers are woken, since the worker
+woken by a signal may not be the one holding the recognizer.  This is
+called by TIesrFA from the thread capturing frames.
+--------------------------------*/
+static void TIesrSIL_wakeserver( void* aServer )
+{
+   TIesrSI_Server_t server = (TIesrSI_Server_t)aServer;
+
+   pthread_mutex_lock( &server->mutex );
+   server->numevents++;
+   pthread_cond_broadcast( &server->cond );
+   pthread_mutex_unlock( &server->mutex );
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_waitserver
+
+Wait with the server mutex held for a notification, or for at most
+TIESRSI_SERVER_IDLE microseconds if a running channel must be polled.
+--------------------------------*/
+static void TIesrSIL_waitserver( TIesrSI_Server_t aServer )
+{
+   struct timespec deadline;
+
+   if( aServer->numpolled == 0 )
+   {
+      pthread_cond_wait( &aServer->cond, &aServer->mutex );
+      return;
+   }
+
+   clock_gettime( CLOCK_MONOTONIC, &deadline );
+   deadline.tv_nsec += TIESRSI_SERVER_IDLE * 1000L;
+   if( deadline.tv_nsec >= 1000000000L )
+   {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+   }
+
+   pthread_cond_timedwait( &aServer->cond, &aServer->mutex, &deadline );
+}
+#endif
+
+
+/*----------------------------------------------------------------
+TIesrSIL_donestatus
+
+Determine the error value reported by the done callback from the audio,
+recognizer and JAC status of the recognition.
+--------------------------------*/
+static TIesrSI_Error_t TIesrSIL_donestatus( TIesrSI_t aTIesrSI )
+{
+   int audioFail;
+   int recoFail;
+
+   audioFail = ( aTIesrSI->audiostatus != TIesrFAErrNone && 
+      aTIesrSI->audiostatus != TIesrFAErrEOF );
+
+   recoFail = ( aTIesrSI->recostatus != eTIesrEngineSuccess ||
+      ( (aTIesrSI->jacstatus != eTIesrEngineJACSuccess) && 
+      (aTIesrSI->jacstatus != eTIesrEngineJACNoAlignment ) ) );
+
+   if( audioFail && recoFail )
+      return TIesrSIErrBoth;
+   else if( audioFail )
+      return TIesrSIErrAudio;
+   else if( recoFail )
+      return TIesrSIErrReco;
+   else
+      return TIesrSIErrNone;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_saveresult
+
+Save a copy of the recognition result so that it can be provided to the
+application while the recognizer thread does the JAC update.  The word
+pointers refer to the grammar vocabulary, which does not change while the
+recognizer is open.
+--------------------------------*/
+static TIesrSIL_Error_t TIesrSIL_saveresult( TIesrSI_t aTIesrSI )
+{
+   short hyp;
+   unsigned short word;
+   unsigned int numWords;
+   const char** words;
+
+   aTIesrSI->resultnbests = (short)(aTIesrSI->engine).GetNumNbests( aTIesrSI->srchmemory );
+   if( aTIesrSI->resultnbests > TIESRSI_MAX_HYPS )
+      aTIesrSI->resultnbests = TIESRSI_MAX_HYPS;
+
+   numWords = 0;
+   for( hyp = 0; hyp < aTIesrSI->resultnbests; hyp++ )
+   {
+      aTIesrSI->resultbase[hyp] = (unsigned short)numWords;
+      aTIesrSI->resultcount[hyp] = 
+         (aTIesrSI->engine).GetAnswerCount( aTIesrSI->srchmemory, hyp );
+      numWords += aTIesrSI->resultcount[hyp];
+   }
+
+   /* Grow the word pointer array if needed */
+   if( numWords > aTIesrSI->resultsize )
+   {
+      words = (const char**)realloc( (void*)aTIesrSI->resultwords, 
+         numWords*sizeof(const char*) );
+      if( words == NULL )
+      {
+         return TIesrSILErrFail;
+      }
+
+      aTIesrSI->resultwords = words;
+      aTIesrSI->resultsize = numWords;
+   }
+
+   for( hyp = 0; hyp < aTIesrSI->resultnbests; hyp++ )
+   {
+      for( word = 0; word < aTIesrSI->resultcount[hyp]; word++ )
+      {
+         aTIesrSI->resultwords[ aTIesrSI->resultbase[hyp] + word ] =
+            (aTIesrSI->engine).GetAnswerWord( word, aTIesrSI->srchmemory, hyp );
+      }
+   }
+
+   aTIesrSI->resultscore = (aTIesrSI->engine).GetTotalScore( aTIesrSI->srchmemory );
+   aTIesrSI->resultframes = (aTIesrSI->engine).GetFrameCount( aTIesrSI->srchmemory );
+   aTIesrSI->resultvolume = (aTIesrSI->engine).GetVolumeStatus( aTIesrSI->srchmemory );
+
+   return TIesrSILErrNone;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSIL_waitjac
+
+If TIesrSI_stop returned while the recognizer thread was doing an
+asynchronous JAC update, wait for the thread to complete and release
+the synchronization objects.  After this the engine search space holds
+the updated JAC estimate and may be used again.  For a push mode
+recognition the deferred JAC update is done here.
+--------------------------------*/
+static TIesrSIL_Error_t TIesrSIL_waitjac( TIesrSI_t aTIesrSI )
+{
+   if( ! aTIesrSI->jacpending )
+   {
+      return TIesrSILErrNone;
+   }
+
+   if( aTIesrSI->pushmode )
+   {
+      TIesrSIL_jacupdate( aTIesrSI );
+      aTIesrSI->jacpending = FALSE;
+      return TIesrSILErrNone;
+   }
+
+   TIesrSIL_join( aTIesrSI );
 
-   /* Reset sync objects since they are no longer needed for the thread */
    TIesrSIL_resetsync( aTIesrSI );
 
+   aTIesrSI->jacpending = FALSE;
+
+   return TIesrSILErrNone;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSI_stop
+
+This function stops recognition.  It may stop recognition in the middle
+of the task, or after the recognition is complete and has signaled it
+is done by calling the callback function.  This function ensures that
+the threads have shut down appropriately.
+---------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_stop( TIesrSI_t aTIesrSI )
+{
+   /* Check state to ensure a recognizer thread is running */
+   if( aTIesrSI->state != TIesrSIStateRunning )
+   {
+      return TIesrSIErrState;
+   }
+
+   /* A push mode recognition that has not ended is abandoned here.  There
+   is no thread to wait for. */
+   if( aTIesrSI->pushmode )
+   {
+      if( ! aTIesrSI->pushdone )
+      {
+         aTIesrSI->stopreco = TRUE;
+         TIesrSIL_endreco( aTIesrSI );
+         aTIesrSI->pushdone = TRUE;
+      }
+
+      aTIesrSI->jacpending = aTIesrSI->resultready;
+
+      aTIesrSI->state = TIesrSIStateOpen;
+      return TIesrSIErrNone;
+   }
+
+   /* Set flag to force the recognizer thread to terminate, if that has
+   not happened already due to normal end of recognition.  If the thread
+   has already saved a result and is doing the JAC update asynchronously,
+   do not wait for it here. */
+#if defined (LINUX)
+   pthread_mutex_lock( &aTIesrSI->recomutex );
+#elif defined (WIN32) || defined (WINCE)
+   WaitForSingleObject( aTIesrSI->recomutex, INFINITE );
+#endif
+
+   aTIesrSI->stopreco = TRUE;
+   aTIesrSI->jacpending = aTIesrSI->resultready;
+
+#if defined (LINUX)
+   pthread_mutex_unlock( &aTIesrSI->recomutex );
+#elif defined (WIN32) || defined (WINCE)
+   ReleaseMutex( aTIesrSI->recomutex );
+#endif
+
+#if defined (LINUX)
+   /* A server worker only sees the stop request when it takes the
+   recognizer from its queue.  Wake the workers, since the channel may
+   deliver no more frames to do so. */
+   if( aTIesrSI->server != NULL )
+   {
+      TIesrSIL_wakeserver( aTIesrSI->server );
+   }
+#endif
+
+
+   if( ! aTIesrSI->jacpending )
+   {
+      /* Wait for the recognizer thread to stop */
+      TIesrSIL_join( aTIesrSI );
+
+      /* Reset sync objects since they are no longer needed for the thread */
+      TIesrSIL_resetsync( aTIesrSI );
+   }
+
 
    /* If the user wanted audio capture, close the capture file */
    if( aTIesrSI->audiofp )
@@ -1307,24 +1935,167 @@ TIesrSI_Error_t TIesrSI_stop( TIesrSI_t aTIesrSI )
       aTIesrSI->audiofp = NULL;
    }
 
-#if defined (TIESRSI_DEBUG_LOG)
-   if( aTIesrSI->threadfp )
+   /* Recognizer has successfully stopped running */
+   aTIesrSI->state = TIesrSIStateOpen;
+
+   return TIesrSIErrNone;
+}
+
+/*----------------------------------------------------------------
+TIesrSI_startpush
+
+This function starts speech recognition of an utterance whose samples
+are supplied by TIesrSI_pushsamples.  It only opens the search engine,
+since frames are processed in the thread supplying the samples.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_startpush( TIesrSI_t aTIesrSI )
+{
+   TIesrEngineStatusType engStatus;
+
+   if( aTIesrSI->state != TIesrSIStateOpen )
    {
-      fclose( aTIesrSI->threadfp );
-      aTIesrSI->threadfp = NULL;
+      return TIesrSIErrState;
    }
-#endif
 
-   /* Recognizer has successfully stopped running */
-   aTIesrSI->state = TIesrSIStateOpen;
+   /* The JAC update of the prior utterance must be in place before the
+   next recognition starts */
+   TIesrSIL_waitjac( aTIesrSI );
+
+   /* Reset variables for the recognition */
+   aTIesrSI->pushmode = TRUE;
+   aTIesrSI->pushfill = 0;
+   aTIesrSI->pushdone = FALSE;
+   aTIesrSI->pushstatus = TIesrSIErrNone;
+   aTIesrSI->audiofp = NULL;
+   aTIesrSI->audiostatus = TIesrFAErrNone;
+   aTIesrSI->startok = FALSE;
+   aTIesrSI->stopreco = FALSE;
+   aTIesrSI->resultready = FALSE;
+   aTIesrSI->jacstatus = eTIesrEngineJACSuccess;
+   aTIesrSI->recoended = FALSE;
+   aTIesrSI->speakcalled = FALSE;
+   aTIesrSI->frameerror = TIesrFAErrNone;
+
+   if( aTIesrSI->traceevents > 0 )
+   {
+      aTIesrSI->tracestart = (aTIesrSI->engine).GetTIesrClock();
+      aTIesrSI->traceaudio = aTIesrSI->tracestart;
+      aTIesrSI->tracepreroll = 0;
+   }
+
+   /* Open the search engine, which prepares it for recognition. */
+   engStatus = (aTIesrSI->engine).OpenSearchEngine( aTIesrSI->srchmemory );
+   aTIesrSI->recostatus = engStatus;
+   if( engStatus != eTIesrEngineSuccess )
+   {
+      return TIesrSIErrReco;
+   }
+
+   aTIesrSI->startok = TRUE;
+   aTIesrSI->state = TIesrSIStateRunning;
+
+   return TIesrSIErrNone;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSI_pushsamples
+
+Assemble the samples into frames and process each complete frame.  When
+the recognition ends, complete it as the recognition thread would and
+report the end in the returned status.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_pushsamples( TIesrSI_t aTIesrSI,
+   const short* aSamples, const unsigned int aNumSamples )
+{
+   unsigned int used = 0;
+   unsigned int copy;
+
+   if( aTIesrSI->state != TIesrSIStateRunning || ! aTIesrSI->pushmode )
+   {
+      return TIesrSIErrState;
+   }
+
+   if( aTIesrSI->pushdone )
+   {
+      return aTIesrSI->pushstatus;
+   }
+
+   /* No samples indicates the end of the audio, which ends the utterance
+   as the end of an audio file would. Partial frame samples are dropped. */
+   if( aNumSamples == 0 )
+   {
+      aTIesrSI->recoended = TRUE;
+   }
+
+   while( ! aTIesrSI->recoended )
+   {
+      copy = FRAME_LEN - aTIesrSI->pushfill;
+      if( copy > aNumSamples - used )
+      {
+         copy = aNumSamples - used;
+      }
+
+      memcpy( aTIesrSI->framedata + aTIesrSI->pushfill, aSamples + used,
+         copy*sizeof(short) );
+      aTIesrSI->pushfill += copy;
+      used += copy;
+
+      if( aTIesrSI->pushfill < FRAME_LEN )
+      {
+         return TIesrSIErrNone;
+      }
+
+      /* Process the complete frame.  Frames remaining in the caller's
+      buffer are reported as queued, for the real time guard. */
+      aTIesrSI->pushfill = 0;
+      if( ! TIesrSIL_frame( aTIesrSI, ( aNumSamples - used )/FRAME_LEN ) )
+      {
+         break;
+      }
+   }
+
+   TIesrSIL_endreco( aTIesrSI );
+
+   aTIesrSI->pushdone = TRUE;
+   aTIesrSI->pushstatus = TIesrSIL_donestatus( aTIesrSI );
+   if( aTIesrSI->pushstatus == TIesrSIErrNone )
+   {
+      aTIesrSI->pushstatus = TIesrSIErrEnd;
+   }
+
+   return aTIesrSI->pushstatus;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSI_completejac
+
+Complete a pending asynchronous JAC update, either by waiting for the
+recognition thread or, for push mode, by doing the update here.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_completejac( TIesrSI_t aTIesrSI )
+{
+   if( aTIesrSI->state != TIesrSIStateOpen )
+   {
+      return TIesrSIErrState;
+   }
+
+   TIesrSIL_waitjac( aTIesrSI );
+
+   if( aTIesrSI->jacstatus != eTIesrEngineJACSuccess &&
+      aTIesrSI->jacstatus != eTIesrEngineJACNoAlignment )
+   {
+      return TIesrSIErrJAC;
+   }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIStop success\n" );
-   fflush( aTIesrSI->logfp );
-#endif
    return TIesrSIErrNone;
 }
 
+
 /*----------------------------------------------------------------
 TIesrSI_nbcount
 
@@ -1339,7 +2110,10 @@ TIesrSI_Error_t TIesrSI_nbcount( TIesrSI_t aTIesrSI, short* aNumHyp)
       return TIesrSIErrState;
    }
 
-   *aNumHyp = (aTIesrSI->engine).GetNumNbests(aTIesrSI->srchmemory );
+   if( aTIesrSI->jacpending )
+      *aNumHyp = aTIesrSI->resultnbests;
+   else
+      *aNumHyp = (aTIesrSI->engine).GetNumNbests(aTIesrSI->srchmemory );
 
    return TIesrSIErrNone;
 }
@@ -1359,7 +2133,15 @@ TIesrSI_Error_t TIesrSI_wdcount( TIesrSI_t aTIesrSI, unsigned short* aNumWords ,
       return TIesrSIErrState;
    }
 
-   *aNumWords = (aTIesrSI->engine).GetAnswerCount( aTIesrSI->srchmemory, iHypIdx);
+   if( aTIesrSI->jacpending )
+   {
+      if( iHypIdx < 0 || iHypIdx >= aTIesrSI->resultnbests )
+         *aNumWords = 0;
+      else
+         *aNumWords = aTIesrSI->resultcount[iHypIdx];
+   }
+   else
+      *aNumWords = (aTIesrSI->engine).GetAnswerCount( aTIesrSI->srchmemory, iHypIdx);
 
    return TIesrSIErrNone;
 }
@@ -1383,14 +2165,20 @@ TIesrSI_Error_t TIesrSI_word( TIesrSI_t aTIesrSI, unsigned short aWordNum,
    }
 
 
-   numHyp = (aTIesrSI->engine).GetNumNbests(aTIesrSI->srchmemory );
+   if( aTIesrSI->jacpending )
+      numHyp = aTIesrSI->resultnbests;
+   else
+      numHyp = (aTIesrSI->engine).GetNumNbests(aTIesrSI->srchmemory );
    if( iHypIdx < 0 || iHypIdx >= numHyp )
    {
       *aWord = NULL;
       return TIesrSIErrFail;
    }
 
-   numWords = (aTIesrSI->engine).GetAnswerCount( aTIesrSI->srchmemory , iHypIdx);
+   if( aTIesrSI->jacpending )
+      numWords = aTIesrSI->resultcount[iHypIdx];
+   else
+      numWords = (aTIesrSI->engine).GetAnswerCount( aTIesrSI->srchmemory , iHypIdx);
    if( aWordNum >= numWords )
    {
       *aWord = NULL;
@@ -1398,7 +2186,10 @@ TIesrSI_Error_t TIesrSI_word( TIesrSI_t aTIesrSI, unsigned short aWordNum,
    }
 
 
-   *aWord = (aTIesrSI->engine).GetAnswerWord( aWordNum, aTIesrSI->srchmemory , iHypIdx);
+   if( aTIesrSI->jacpending )
+      *aWord = aTIesrSI->resultwords[ aTIesrSI->resultbase[iHypIdx] + aWordNum ];
+   else
+      *aWord = (aTIesrSI->engine).GetAnswerWord( aWordNum, aTIesrSI->srchmemory , iHypIdx);
 
    return TIesrSIErrNone;
 }
@@ -1439,7 +2230,10 @@ better likelihood.
 TIESRSI_API
 TIesrSI_Error_t TIesrSI_score( TIesrSI_t aTIesrSI, long* aScore )
 {
-   *aScore = (aTIesrSI->engine).GetTotalScore( aTIesrSI->srchmemory );
+   if( aTIesrSI->jacpending )
+      *aScore = aTIesrSI->resultscore;
+   else
+      *aScore = (aTIesrSI->engine).GetTotalScore( aTIesrSI->srchmemory );
 
    return TIesrSIErrNone;
 }
@@ -1456,7 +2250,10 @@ application.  However, it may be helpful for diagnosing some problems.
 TIESRSI_API
 TIesrSI_Error_t TIesrSI_frmcount( TIesrSI_t aTIesrSI, short* aNumFrames )
 {
-   *aNumFrames = (aTIesrSI->engine).GetFrameCount( aTIesrSI->srchmemory );
+   if( aTIesrSI->jacpending )
+      *aNumFrames = aTIesrSI->resultframes;
+   else
+      *aNumFrames = (aTIesrSI->engine).GetFrameCount( aTIesrSI->srchmemory );
 
    return TIesrSIErrNone;
 }
@@ -1474,7 +2271,10 @@ maximum sample value in the speech utterance signal.
 TIESRSI_API
 TIesrSI_Error_t TIesrSI_volume( TIesrSI_t aTIesrSI, short* aVolume )
 {
-   *aVolume = (aTIesrSI->engine).GetVolumeStatus( aTIesrSI->srchmemory );
+   if( aTIesrSI->jacpending )
+      *aVolume = aTIesrSI->resultvolume;
+   else
+      *aVolume = (aTIesrSI->engine).GetVolumeStatus( aTIesrSI->srchmemory );
 
    return TIesrSIErrNone;
 }
@@ -1490,12 +2290,97 @@ recognition was correct.
 TIESRSI_API
 TIesrSI_Error_t TIesrSI_confidence(  TIesrSI_t aTIesrSI, short* aConfidence )
 {
+   /* The confidence score is computed during the JAC update */
+   TIesrSIL_waitjac( aTIesrSI );
+
    *aConfidence = (aTIesrSI->engine).GetConfidenceScore( aTIesrSI->srchmemory );
 
    return TIesrSIErrNone;
 }
 
 
+/*----------------------------------------------------------------
+TIesrSI_trace
+
+Set the trace recording of the recognizer.  If the recognizer is open
+the engine trace is started now, otherwise when it is opened.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_trace( TIesrSI_t aTIesrSI, unsigned int aNumEvents,
+   unsigned int aLagMs, const char* aTraceFile )
+{
+   char* traceFile = NULL;
+   TIesrEngineStatusType engStatus;
+
+   if( aTIesrSI->state == TIesrSIStateRunning )
+   {
+      return TIesrSIErrState;
+   }
+
+   if( aTraceFile != NULL && aNumEvents > 0 )
+   {
+      traceFile = strdup( aTraceFile );
+      if( traceFile == NULL )
+      {
+         return TIesrSIErrNoMemory;
+      }
+   }
+
+   if( aTIesrSI->tracefile != NULL )
+   {
+      free( aTIesrSI->tracefile );
+   }
+
+   aTIesrSI->traceevents = aNumEvents;
+   aTIesrSI->tracelag = aLagMs;
+   aTIesrSI->tracefile = traceFile;
+
+   if( aTIesrSI->state == TIesrSIStateOpen )
+   {
+      /* An asynchronous JAC update may still be recording events */
+      TIesrSIL_waitjac( aTIesrSI );
+
+      engStatus = (aTIesrSI->engine).SetTIesrTrace( aTIesrSI->srchmemory,
+         aNumEvents );
+      if( engStatus != eTIesrEngineSuccess )
+      {
+         aTIesrSI->traceevents = 0;
+         return TIesrSIErrNoMemory;
+      }
+   }
+
+   return TIesrSIErrNone;
+}
+
+
+/*----------------------------------------------------------------
+TIesrSI_tracedump
+
+Write the engine trace to a file.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_tracedump( TIesrSI_t aTIesrSI, const char* aTraceFile )
+{
+   TIesrEngineStatusType engStatus;
+
+   if( aTIesrSI->state != TIesrSIStateOpen )
+   {
+      return TIesrSIErrState;
+   }
+
+   TIesrSIL_waitjac( aTIesrSI );
+
+   engStatus = (aTIesrSI->engine).DumpTIesrTrace( aTIesrSI->srchmemory,
+      aTraceFile );
+   if( engStatus != eTIesrEngineSuccess )
+   {
+      return TIesrSIErrFail;
+   }
+
+   return TIesrSIErrNone;
+}
+
+
 /*----------------------------------------------------------------
 TIesrSI_close
 
@@ -1514,10 +2399,8 @@ TIesrSI_Error_t TIesrSI_close( TIesrSI_t aTIesrSI )
       return TIesrSIErrState;
    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIClose\n" );
-   fflush( aTIesrSI->logfp );
-#endif
+   /* Complete any JAC update so that the latest estimate is saved */
+   TIesrSIL_waitjac( aTIesrSI );
 
    /* Save JAC  estimate and close the recognizer. */
    jacStatus = (aTIesrSI->engine).JAC_save(aTIesrSI->jacfile, aTIesrSI->srchmemory );
@@ -1526,6 +2409,13 @@ TIesrSI_Error_t TIesrSI_close( TIesrSI_t aTIesrSI )
 
    (aTIesrSI->engine).CloseASR( aTIesrSI->srchmemory );
 
+   /* Close an audio channel left capturing for pre-roll */
+   if( aTIesrSI->audioopen )
+   {
+      TIesrFA_close( &aTIesrSI->audiodevice );
+      aTIesrSI->audioopen = FALSE;
+   }
+
    /* Destroy the audio channel resources */
    faError = TIesrFA_destroy( &aTIesrSI->audiodevice );
 
@@ -1538,11 +2428,6 @@ TIesrSI_Error_t TIesrSI_close( TIesrSI_t aTIesrSI )
    /* State is now closed, regardless of failures */
    aTIesrSI->state = TIesrSIStateClosed;
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIClose end %d\n", faError );
-   fflush( aTIesrSI->logfp );
-#endif
-
    if( faError != TIesrFAErrNone && jacStatus != eTIesrEngineJACSuccess )
       return TIesrSIErrBoth;
    else if(  faError != TIesrFAErrNone )
@@ -1576,24 +2461,193 @@ TIesrSI_Error_t TIesrSI_destroy( TIesrSI_t aTIesrSI )
       return TIesrSIErrState;
    }
 
-#ifdef TIESRSI_DEBUG_LOG
-   fprintf( aTIesrSI->logfp, "SIDestroy\n" );
-   fflush( aTIesrSI->logfp );
-#endif
-
    /* Close the engine instance */
    TIesrEngineClose( &(aTIesrSI->engine) );
 
-#ifdef TIESRSI_DEBUG_LOG
-   if( aTIesrSI->logfp )
-      fclose( aTIesrSI->logfp );
-    
-   if( aTIesrSI->threadfp )
-      fclose( aTIesrSI->threadfp );
-#endif
+   if( aTIesrSI->tracefile != NULL )
+   {
+      free( aTIesrSI->tracefile );
+   }
 
    /* deallocate the TIesrSI instance */
    free( aTIesrSI );
 
    return TIesrSIErrNone;
 }
+
+
+/*----------------------------------------------------------------
+TIesrSI_setserver
+
+Attach a recognizer to a recognition server, or detach it from its server
+if aServer is NULL.  This may only be done while the recognizer is not
+running.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_setserver( TIesrSI_t aTIesrSI, TIesrSI_Server_t aServer )
+{
+   if( aTIesrSI->state == TIesrSIStateRunning )
+   {
+      return TIesrSIErrState;
+   }
+
+   /* A prior recognition must be complete before changing how the
+   recognition is run */
+   TIesrSIL_waitjac( aTIesrSI );
+
+#if defined (LINUX)
+   aTIesrSI->server = aServer;
+   return TIesrSIErrNone;
+#else
+   return ( aServer == NULL ) ? TIesrSIErrNone : TIesrSIErrFail;
+#endif
+}
+
+
+/*----------------------------------------------------------------
+TIesrSI_server_create
+
+Create a recognition server and start its worker threads.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_server_create( TIesrSI_Server_t* aPtrToServer,
+                                       const unsigned int aNumWorkers,
+                                       const int aPinWorkers )
+{
+#if defined (LINUX)
+   TIesrSI_Server_t server;
+   TIesrSIL_Worker_t* worker;
+   unsigned int w;
+   long numCpus;
+   cpu_set_t cpus;
+   pthread_condattr_t condAttr;
+   int result;
+
+   *aPtrToServer = NULL;
+
+   if( aNumWorkers == 0 || aNumWorkers > TIESRSI_MAX_WORKERS )
+   {
+      return TIesrSIErrFail;
+   }
+
+   server = (TIesrSI_Server_t)malloc( sizeof(TIesrSI_Server_Object_t) );
+   if( server == NULL )
+   {
+      return TIesrSIErrNoMemory;
+   }
+
+   server->numworkers = 0;
+   server->numstarted = 0;
+   server->numrunning = 0;
+   server->numpolled = 0;
+   server->numevents = 0;
+   server->nextworker = 0;
+   server->exitworkers = FALSE;
+
+   if( pthread_mutex_init( &server->mutex, NULL ) )
+   {
+      free( server );
+      return TIesrSIErrFail;
+   }
+
+   /* Polling waits are timed by the monotonic clock */
+   pthread_condattr_init( &condAttr );
+   pthread_condattr_setclock( &condAttr, CLOCK_MONOTONIC );
+   result = pthread_cond_init( &server->cond, &condAttr );
+   pthread_condattr_destroy( &condAttr );
+   if( result )
+   {
+      pthread_mutex_destroy( &server->mutex );
+      free( server );
+      return TIesrSIErrFail;
+   }
+
+   numCpus = sysconf( _SC_NPROCESSORS_ONLN );
+
+   /* Worker queues must all exist before any worker looks for work */
+   for( w = 0; w < aNumWorkers; w++ )
+   {
+      worker = &server->worker[w];
+      worker->server = server;
+      worker->index = w;
+      worker->queue.head = NULL;
+      worker->queue.tail = NULL;
+      pthread_mutex_init( &worker->queue.mutex, NULL );
+   }
+   server->numworkers = aNumWorkers;
+
+   for( w = 0; w < aNumWorkers; w++ )
+   {
+      worker = &server->worker[w];
+
+      if( pthread_create( &worker->threadid, NULL, TIesrSIL_worker, worker ) )
+      {
+         /* Stop the workers already started */
+         TIesrSI_server_destroy( server );
+         return TIesrSIErrThread;
+      }
+
+      /* Pinning is best effort, a worker that can not be pinned still runs */
+      if( aPinWorkers && numCpus > 0 )
+      {
+         CPU_ZERO( &cpus );
+         CPU_SET( w % numCpus, &cpus );
+         pthread_setaffinity_np( worker->threadid, sizeof(cpu_set_t), &cpus );
+      }
+
+      server->numstarted++;
+   }
+
+   *aPtrToServer = server;
+   return TIesrSIErrNone;
+
+#else
+   *aPtrToServer = NULL;
+   return TIesrSIErrFail;
+#endif
+}
+
+
+/*----------------------------------------------------------------
+TIesrSI_server_destroy
+
+Stop the worker threads of a recognition server and free the server. No
+recognizer may be running on the server.
+-------------------------------------------------------------------*/
+TIESRSI_API
+TIesrSI_Error_t TIesrSI_server_destroy( TIesrSI_Server_t aServer )
+{
+#if defined (LINUX)
+   unsigned int w;
+
+   pthread_mutex_lock( &aServer->mutex );
+   if( aServer->numrunning > 0 )
+   {
+      pthread_mutex_unlock( &aServer->mutex );
+      return TIesrSIErrState;
+   }
+
+   aServer->exitworkers = TRUE;
+   pthread_cond_broadcast( &aServer->cond );
+   pthread_mutex_unlock( &aServer->mutex );
+
+   /* Fewer worker threads than queues were started if creation failed */
+   for( w = 0; w < aServer->numstarted; w++ )
+   {
+      pthread_join( aServer->worker[w].threadid, NULL );
+   }
+
+   for( w = 0; w < aServer->numworkers; w++ )
+   {
+      pthread_mutex_destroy( &aServer->worker[w].queue.mutex );
+   }
+
+   pthread_cond_destroy( &aServer->cond );
+   pthread_mutex_destroy( &aServer->mutex );
+   free( aServer );
+
+   return TIesrSIErrNone;
+#else
+   return TIesrSIErrFail;
+#endif
+}
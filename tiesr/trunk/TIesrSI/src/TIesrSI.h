@@ -45,34 +45,6 @@
 #endif
 
 
-/* Debug logging flag.  This results in output debug logging to files
-   for each thread. This line should normally be commented out in order
-   to build a version of TIESRSI that does not do debug logging. Debug
-   logging is not an option that the user sees within the API. */
-
-/* #define TIESRSI_DEBUG_LOG */
-
-#ifdef TIESRSI_DEBUG_LOG
-
-#if defined (WINCE)
-
-#if ( _WIN32_WCE >= 0x500 )
-/* Log file locations for WindowsMobile 5.0 Smartphone */
-  #define LOGFILE "\\Application Data\\TIesr\\SIlog.txt"
-  #define THREADFILE "\\Application Data\\TIesr\\SIthread.txt"
-#else
-/* Log file locations for WindowsMobile 2003SE Smartphone */
-#define LOGFILE "\\Storage\\Application Data\\TIesr\\SIlog.txt"
-#define THREADFILE "\\Storage\\Application Data\\TIesr\\SIthread.txt"
-#endif
-
-#else
-/* Define location of log files for other platforms. */
-#endif
-
-#endif
-
-
 /* Audio default constants */
 
 
@@ -93,6 +65,9 @@
 #define AUDIO_FRAMES 10
 /* Audio priority of the frame audio thread */
 #define  AUDIO_PRIORITY 20
+/* Frames captured prior to start of recognition. If non-zero, audio
+capture continues between recognitions. */
+#define AUDIO_PREROLL 0
 
 #elif defined (WIN32) || defined (WINCE)
 
@@ -105,10 +80,28 @@
 /* For Windows TIesrFA this is the number of frames of audio data that
 each audio buffer returned from the audio device driver will hold */
 #define AUDIO_READ_RATE 2
+/* Persistent capture is not supported by the Windows TIesrFA */
+#define AUDIO_PREROLL 0
 
 #endif
 
 
+/* Maximum number of N-best hypotheses held in the result snapshot taken
+while JAC adaptation runs asynchronously after recognition. */
+#define TIESRSI_MAX_HYPS 30
+
+
+/* Recognition server constants.  A server worker processes at most
+TIESRSI_SERVER_BATCH frames of a recognizer before moving on to the next
+recognizer.  A worker that finds no frames available from any of its
+recognizers waits until a channel notifies the server of a frame.  If a
+running channel can not notify, the worker waits at most
+TIESRSI_SERVER_IDLE microseconds before polling again. */
+#define TIESRSI_MAX_WORKERS 64
+#define TIESRSI_SERVER_BATCH 4
+#define TIESRSI_SERVER_IDLE 5000
+
+
 /* Define TRUE/FALSE */
 #ifndef TRUE
 #define TRUE 1
@@ -168,9 +161,14 @@ typedef struct TIesrSI_Object
     unsigned int audioreadrate;
     unsigned int audioframes;
     int audiopriority;
+    unsigned int audiopreroll;
     char* devicename;
     TIesrFA_Error_t audiostatus;
 
+    /* The audio channel is open. With pre-roll it remains open and
+    capturing between recognitions. */
+    int audioopen;
+
 
       /* TIesrSI API recognizer parameters */
       int state; /* State of the recognizer */
@@ -181,13 +179,6 @@ typedef struct TIesrSI_Object
       FILE* audiofp;
      
 
-      /* log output file pointer, allowing capture of
-	 debug logging data */
-#if defined (TIESRSI_DEBUG_LOG)
-      FILE* logfp;
-      FILE* threadfp;
-#endif
-
 #if defined (LINUX)
       /* Recognizer thread while running recognition */
       pthread_t threadid; 
@@ -203,6 +194,17 @@ typedef struct TIesrSI_Object
 
       /* Flag to indicate a request to stop recognition thread */
       int stopreco;
+
+      /* Recognition server running this recognizer, if any, and flag
+      indicating its channel can not notify the server of frames */
+      struct TIesrSI_Server* server;
+      int serverpolled;
+
+      /* Next recognizer in the server worker queue */
+      struct TIesrSI_Object* next;
+
+      /* Semaphore posted when the server completes a recognition */
+      sem_t donesemaphore;
 #elif defined (WIN32) || defined (WINCE)
       /* Recognizer thread while running recognition */
       HANDLE threadid; 
@@ -228,10 +230,125 @@ typedef struct TIesrSI_Object
   
       /* Recognizer variables */
 
+      /* State of the frame loop, kept here since a server recognition
+      is processed a few frames at a time */
+      int recoended;
+      int speakcalled;
+      TIesrFA_Error_t frameerror;
+
+      /* Push mode recognition started by TIesrSI_startpush.  Samples
+      are assembled into framedata, which holds pushfill samples.  Once
+      the recognition ends, pushdone is set and pushstatus holds the
+      status returned by TIesrSI_pushsamples. */
+      int pushmode;
+      unsigned int pushfill;
+      int pushdone;
+      TIesrSI_Error_t pushstatus;
+
+      /* Flag indicating JAC update runs after the done callback, while
+      the application retrieves the result */
+      int asyncjac;
+
+      /* Flag set by the recognizer thread once the result snapshot is
+      taken and the JAC update will follow */
+      int resultready;
+
+      /* Flag indicating TIesrSI_stop returned while the recognizer thread
+      is still doing the JAC update */
+      int jacpending;
+
+      /* Snapshot of the recognition result used while jacpending is set,
+      since the JAC update re-uses the engine search space */
+      short resultnbests;
+      unsigned short resultcount[TIESRSI_MAX_HYPS];
+      unsigned short resultbase[TIESRSI_MAX_HYPS];
+      const char** resultwords;
+      unsigned int resultsize;
+      long resultscore;
+      short resultframes;
+      short resultvolume;
+
+      /* Trace recording requested by TIesrSI_trace.  The engine trace is
+      written to tracefile when the result of an utterance lags the end of
+      its audio by more than tracelag milliseconds.  tracestart is the
+      engine clock time the recognition started, traceaudio the time audio
+      collection started and traceresult the time the backtrace completed.
+      tracepreroll is the number of frames of the recognition captured
+      before audio collection started. */
+      unsigned int traceevents;
+      unsigned int tracelag;
+      char* tracefile;
+      unsigned long long tracestart;
+      unsigned long long traceaudio;
+      unsigned long long traceresult;
+      unsigned int tracepreroll;
+
 
 } TIesrSI_Object_t;
 
 
+#if defined (LINUX)
+/*--------------------------------*/
+/*
+   Queue of running recognizers belonging to one server worker.
+*/
+typedef struct TIesrSIL_Queue
+{
+      pthread_mutex_t mutex;
+      TIesrSI_Object_t* head;
+      TIesrSI_Object_t* tail;
+} TIesrSIL_Queue_t;
+
+
+/*--------------------------------*/
+/*
+   A server worker thread and its recognizer queue.
+*/
+typedef struct TIesrSIL_Worker
+{
+      struct TIesrSI_Server* server;
+      unsigned int index;
+      pthread_t threadid;
+      TIesrSIL_Queue_t queue;
+} TIesrSIL_Worker_t;
+
+
+/*--------------------------------*/
+/*
+   The TIesrSI_Server object holding the worker pool.
+*/
+typedef struct TIesrSI_Server
+{
+      unsigned int numworkers;
+      TIesrSIL_Worker_t worker[TIESRSI_MAX_WORKERS];
+
+      /* Number of worker threads started */
+      unsigned int numstarted;
+
+      /* Mutex and condition protecting the variables below. Idle workers
+      wait on the condition when no recognizers are running, or none
+      has a frame available. */
+      pthread_mutex_t mutex;
+      pthread_cond_t cond;
+
+      /* Number of recognizers running on the server, and the number of
+      those whose channel must be polled for frames */
+      unsigned int numrunning;
+      unsigned int numpolled;
+
+      /* Count of frame notifications and recognition starts, which
+      tells an idle worker there may be work */
+      unsigned long numevents;
+
+      /* Worker queue receiving the next started recognizer */
+      unsigned int nextworker;
+
+      /* Flag requesting the workers to exit */
+      int exitworkers;
+} TIesrSI_Server_Object_t;
+#endif
+
+
 /*--------------------------------*/
 /* Local function prototypes */
 static TIesrSIL_Error_t TIesrSIL_freeopen( TIesrSI_t aTIesrSI );
@@ -240,6 +357,40 @@ static TIesrSIL_Error_t TIesrSIL_initsync( TIesrSI_t aTIesrSI );
 
 static TIesrSIL_Error_t TIesrSIL_resetsync( TIesrSI_t aTIesrSI );
 
+static TIesrSIL_Error_t TIesrSIL_saveresult( TIesrSI_t aTIesrSI );
+
+static TIesrSIL_Error_t TIesrSIL_waitjac( TIesrSI_t aTIesrSI );
+
+static void TIesrSIL_jacupdate( TIesrSI_t aTIesrSI );
+
+static void TIesrSIL_tracepreroll( TIesrSI_t aTIesrSI, unsigned int aFramesQueued );
+
+static void TIesrSIL_tracereco( TIesrSI_t aTIesrSI );
+
+static TIesrSI_Error_t TIesrSIL_donestatus( TIesrSI_t aTIesrSI );
+
+static TIesrSIL_Error_t TIesrSIL_startreco( TIesrSI_t aTIesrSI );
+
+static int TIesrSIL_frame( TIesrSI_t aTIesrSI, unsigned int aFramesQueued );
+
+static void TIesrSIL_endreco( TIesrSI_t aTIesrSI );
+
+static TIesrSIL_Error_t TIesrSIL_join( TIesrSI_t aTIesrSI );
+
+#if defined (LINUX)
+static void TIesrSIL_enqueue( TIesrSIL_Queue_t* aQueue, TIesrSI_t aTIesrSI );
+
+static TIesrSI_t TIesrSIL_dequeue( TIesrSIL_Queue_t* aQueue );
+
+static int TIesrSIL_serve( TIesrSI_t aTIesrSI, int* aFrames );
+
+static void* TIesrSIL_worker( void* aWorker );
+
+static void TIesrSIL_wakeserver( void* aServer );
+
+static void TIesrSIL_waitserver( TIesrSI_Server_t aServer );
+#endif
+
 #if defined (LINUX)
 static void* TIesrSIL_thread( void* aTIesrSI );
 #elif defined (WIN32) || defined (WINCE)
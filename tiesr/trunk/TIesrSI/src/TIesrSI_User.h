@@ -106,6 +106,9 @@
    TIesrSIErrThread = The recognizer thread could not start successfully.
 
    TIesrSIErrCapture = The recognizer failed to open file or capture audio data.
+
+   TIesrSIErrEnd = Recognition of samples supplied by TIesrSI_pushsamples
+   has ended, and no more samples are needed.
 ------------------------------------------------------------------------*/
 typedef enum TIesrSI_Errors
 {
@@ -119,7 +122,8 @@ typedef enum TIesrSI_Errors
    TIesrSIErrBoth,
    TIesrSIErrSpeechEarly,
    TIesrSIErrThread,
-   TIesrSIErrCapture
+   TIesrSIErrCapture,
+   TIesrSIErrEnd
 } TIesrSI_Error_t;
 
 
@@ -133,6 +137,15 @@ typedef enum TIesrSI_Errors
 typedef struct TIesrSI_Object* TIesrSI_t;
 
 
+/*-------------------------------------------------------------------------
+   The TIesrSI_Server defines a recognition server, which is a fixed pool of
+   worker threads that run the recognition of many TIesrSI recognizer
+   instances.  A pointer to this object is defined as TIesrSI_Server_t.  As
+   with TIesrSI_t, the application only uses the pointer.
+---------------------------------------------------------------------------*/
+typedef struct TIesrSI_Server* TIesrSI_Server_t;
+
+
 /*-------------------------------------------------------------------------
   TIesrSI provides results by calling two callback functions.  One function is
   called when the recognizer has been started, has performed adaptation to the
@@ -217,10 +230,22 @@ typedef struct TIesrSI_Parameters
       int audioFrames;
       int audioPriority;
 
+      /* Number of frames of audio captured just prior to TIesrSI_start
+      that are included in the recognition.  If non-zero, audio capture
+      keeps running between recognitions until TIesrSI_close, so that no
+      speech is lost while starting.  Must be less than circularFrames. */
+      int audioPreRoll;
+
       short bNBest; 
   
       short useTwoPass; 
 
+      /* Run the JAC update after the done callback is called, so that
+      results are available without waiting for adaptation.  The done
+      callback then can not report a JAC failure, which is instead
+      returned by TIesrSI_completejac.  Off by default. */
+      short asyncJAC;
+
 } TIesrSI_Params_t;
 
     
@@ -358,11 +383,66 @@ extern "C"
   functions that the recognizer might make prior to termination of the
   recognition thread.  Once the recognizer has stopped, it may be started
   again simply by another call to TIesrSI_start.
+
+  If the asyncJAC parameter is set and recognition completed successfully,
+  this function returns without waiting for the JAC update that follows
+  the recognition result.  The recognition result may be obtained
+  immediately.  The JAC update is completed by the next call to
+  TIesrSI_start, TIesrSI_getparams, TIesrSI_setparams, TIesrSI_confidence
+  or TIesrSI_close, and its status is then available from TIesrSI_status.
+  A JAC failure is not reported to the done callback in this case.
 ---------------------------------------------------------------------------*/
     TIESRSI_API
         TIesrSI_Error_t TIesrSI_stop( TIesrSI_t aTIesrSI );
 
 
+/*--------------------------------------------------------------------------
+  Start a TIesrSI recognition in push mode.  In push mode the application
+  supplies the audio samples by calling TIesrSI_pushsamples, and each frame
+  is processed by the TIesr Engine in the calling thread.  No audio channel
+  is used, and no thread, synchronization object or file is created, so
+  push mode can be driven from an application event loop.  The speak and
+  done callbacks are called from within TIesrSI_pushsamples.
+
+  As with TIesrSI_start, each successful call of TIesrSI_startpush must be
+  accompanied by a single call to TIesrSI_stop, which may be called before
+  the recognition has ended to abandon it.
+--------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_startpush( TIesrSI_t aTIesrSI );
+
+
+/*--------------------------------------------------------------------------
+  Supply aNumSamples 16-bit linear audio samples to a push mode recognition.
+  The samples may be supplied in buffers of any size.  They are assembled
+  into frames, and each complete frame is processed before this function
+  returns.  Supplying zero samples indicates the end of the audio, and
+  completes the recognition as if the end of the utterance was detected.
+
+  Returns TIesrSIErrNone if more samples are needed.  Once the recognition
+  has ended, this returns TIesrSIErrEnd, or the error that ended the
+  recognition, and any samples not yet processed are discarded.  Further
+  calls return the same status until TIesrSI_stop is called.
+--------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_pushsamples( TIesrSI_t aTIesrSI,
+        const short* aSamples, const unsigned int aNumSamples );
+
+
+/*--------------------------------------------------------------------------
+  Complete the JAC update following a recognition that used the asyncJAC
+  parameter.  If the recognition ran in a recognition thread, this waits
+  for the thread.  If the recognition was in push mode, the JAC update is
+  not done by TIesrSI_pushsamples, and this function performs it in the
+  calling thread.  This allows an application to run the JAC update on its
+  own worker thread, provided no other TIesrSI function is called for the
+  recognizer meanwhile.  If not called, the JAC update is completed by the
+  functions listed for TIesrSI_stop.
+--------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_completejac( TIesrSI_t aTIesrSI );
+
+
 /*----------------------------------------------------------------
 TIesrSI_nbcount
 
@@ -422,7 +502,9 @@ result has completed.
 
 /*----------------------------------------------------------------
   Get the confidence measure of the last recognized utterance  This is a measure
-  that indicates how confident the measure of the last utterance is.
+  that indicates how confident the measure of the last utterance is.  The
+  confidence is computed during the JAC update, so this function waits for
+  an asynchronous JAC update to complete.
 ----------------------------------------------------------------*/
    TIESRSI_API
    TIesrSI_Error_t TIesrSI_confidence( TIesrSI_t aTIesrSI, short* aConfidence );
@@ -445,6 +527,35 @@ result has completed.
         int* aRecoStatus, int* aAudioStatus, int* aJacStatus );
 
 
+/*---------------------------------------------------------------------------
+  Record a trace of the last aNumEvents timed processing events of the
+  recognizer, such as the front end, Gaussian scoring, path propagation,
+  backtrace and JAC update of each frame and utterance.  If aTraceFile is
+  not NULL, the trace is written to it whenever the result of an
+  utterance is available more than aLagMs milliseconds after the end of
+  its audio.  The result is available when its backtrace completes,
+  before any JAC update, and pre-roll frames captured before the
+  recognition started are not counted as its audio.  The processing of
+  pre-roll frames is marked by a "preroll" event in the trace.  A value
+  of zero for aNumEvents stops tracing.  This may be
+  called at any time the recognizer is not running, and applies to all
+  later recognitions.  The trace is written in Chrome trace event JSON
+  format, which can be viewed with chrome://tracing or Perfetto.
+-----------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_trace( TIesrSI_t aTIesrSI,
+        unsigned int aNumEvents, unsigned int aLagMs, const char* aTraceFile );
+
+
+/*---------------------------------------------------------------------------
+  Write the trace recorded since TIesrSI_trace was called to the file
+  aTraceFile.  The recognizer must be open and not running.
+-----------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_tracedump( TIesrSI_t aTIesrSI,
+        const char* aTraceFile );
+
+
 /*---------------------------------------------------------------------------
   Close the TIesrSI recognizer.  This will deallocate any resources that 
   were created when the recognizer was opened.  The recognizer can then
@@ -455,6 +566,42 @@ result has completed.
         TIesrSI_Error_t TIesrSI_close( TIesrSI_t aTIesrSI );
 
 
+/*---------------------------------------------------------------------------
+  Create a recognition server with aNumWorkers worker threads.  Recognizers
+  attached to the server by TIesrSI_setserver do not start a thread of their
+  own in TIesrSI_start.  Instead, the server workers take turns processing
+  the frames available from each running recognizer, so that many
+  recognizers share a fixed number of threads.  A worker with no
+  recognizers left to process takes one from another worker.  If aPinWorkers
+  is non-zero each worker is bound to one processor, cycling over the
+  processors that are online.  The server is only available on LINUX.
+-----------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_server_create( TIesrSI_Server_t* aPtrToServer,
+        const unsigned int aNumWorkers, const int aPinWorkers );
+
+
+/*---------------------------------------------------------------------------
+  Attach a recognizer to a recognition server, or detach it if aServer is
+  NULL.  The recognizer must not be running.  When attached, TIesrSI_start
+  opens the recognizer and audio channel in the calling thread and then
+  hands the recognizer to the server, so the aPriority argument is not
+  used.  All other TIesrSI functions behave the same, and the callback
+  functions are called from a server worker thread.
+-----------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_setserver( TIesrSI_t aTIesrSI,
+        TIesrSI_Server_t aServer );
+
+
+/*---------------------------------------------------------------------------
+  Destroy a recognition server, stopping its worker threads.  All attached
+  recognizers must have been stopped with TIesrSI_stop first.
+-----------------------------------------------------------------------------*/
+    TIESRSI_API
+        TIesrSI_Error_t TIesrSI_server_destroy( TIesrSI_Server_t aServer );
+
+
 /*--------------------------------------------------------------------------- 
    Destruct the instance of the recognizer.  This completely removes the 
    TIesrSI object that was created with TIesrSI_create, and frees all resources